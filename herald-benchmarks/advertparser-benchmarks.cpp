@@ -0,0 +1,63 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+TEST_CASE("advertparser-benchmark", "[benchmark][ble][advert]") {
+  // Apple TV style advert, which exercises the Apple sub segment filter
+  const std::uint8_t appleBytes[] {
+    0x02, 0x01, 0x1a,
+    0x02, 0x0a, 0x08,
+    0x0c, 0xff, 0x4c, 0x00,
+    0x10, 0x07, 0x33,
+    0x1f, 0x2c, 0x30, 0x2f, 0x92,
+    0x58
+  };
+  // Herald Android advert, carrying a pseudo device address
+  const std::uint8_t heraldBytes[] {
+    0x02, 0x01, 0x1a,
+    0x02, 0x0a, 0x08,
+    0x09, 0xff, 0xff, 0xfa,
+    0x10, 0x07, 0x33, 0x1f, 0x2c, 0x30
+  };
+  const herald::datatype::Data apple(appleBytes, sizeof(appleBytes));
+  const herald::datatype::Data heraldAdvert(heraldBytes, sizeof(heraldBytes));
+  const std::uint16_t heraldCode =
+    herald::ble::filter::to_integral(herald::ble::filter::BLEAdvertManufacturers::heraldUnregistered);
+
+  // Previous path through ConcreteBLEDatabase::device(mac,advert) for an unknown device
+  BENCHMARK("BLEAdvertParser pseudo address lookup") {
+    auto segments = herald::ble::filter::BLEAdvertParser::extractSegments(heraldAdvert,0);
+    auto manuData = herald::ble::filter::BLEAdvertParser::extractManufacturerData(segments);
+    auto heraldData = herald::ble::filter::BLEAdvertParser::extractHeraldManufacturerData(manuData);
+    return heraldData.size();
+  };
+
+  BENCHMARK("BLEAdvertView pseudo address lookup") {
+    herald::ble::filter::BLEAdvertView view(heraldAdvert);
+    herald::ble::filter::BLEAdvertManufacturerDataView heraldData;
+    return view.manufacturerData(heraldCode, heraldData);
+  };
+
+  BENCHMARK("BLEAdvertParser apple segments") {
+    auto segments = herald::ble::filter::BLEAdvertParser::extractSegments(apple,0);
+    auto manuData = herald::ble::filter::BLEAdvertParser::extractManufacturerData(segments);
+    auto appleSegments = herald::ble::filter::BLEAdvertParser::extractAppleManufacturerSegments(manuData);
+    return appleSegments.size();
+  };
+
+  BENCHMARK("BLEAdvertView apple segments") {
+    herald::ble::filter::BLEAdvertView view(apple);
+    herald::ble::filter::BLEAdvertManufacturerDataView manu;
+    std::size_t count = 0;
+    if (view.manufacturerData(0x004c, manu)) {
+      for (const auto& segment : herald::ble::filter::BLEAdvertAppleSegments(manu.data)) {
+        count += segment.data.size();
+      }
+    }
+    return count;
+  };
+}
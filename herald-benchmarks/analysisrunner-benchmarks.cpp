@@ -0,0 +1,107 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <string>
+
+using namespace herald::analysis;
+using namespace herald::datatype;
+
+/// Averages each source's recent RSSI values. Returns true (output generated) without
+/// publishing, so only the runner and list access costs are measured.
+struct MeanRSSIAnalyser {
+  using input_value_type = RSSI;
+  using output_value_type = Distance;
+
+  template <std::size_t SrcSz, std::size_t DstSz, typename CallableForNewSample>
+  bool analyse(Date timeNow, SampledID sampled, SampleList<Sample<RSSI>,SrcSz>& src, SampleList<Sample<Distance>,DstSz>& dst, CallableForNewSample& callable) {
+    double total = 0.0;
+    for (std::size_t idx = 0;idx < src.size();++idx) {
+      total += src[idx].value.intValue();
+    }
+    lastMean = src.size() > 0 ? total / src.size() : 0.0;
+    return true;
+  }
+
+  double lastMean = 0.0;
+};
+
+struct NoOpDistanceDelegate {
+  using value_type = Distance;
+
+  void newSample(SampledID sampled, Sample<Distance> sample) {}
+};
+
+/// Interleaves samples from many sources, as RSSI readings arrive from nearby devices
+template <typename ListManagerT>
+std::size_t pushInterleaved(ListManagerT& lists, std::size_t sources, std::size_t rounds) {
+  std::size_t total = 0;
+  for (std::size_t round = 0;round < rounds;++round) {
+    for (std::size_t source = 0;source < sources;++source) {
+      auto& list = lists.list(SampledID(source * 2654435761u));
+      list.push(Sample<RSSI>(Date(long(round)), RSSI(-50 - int(source % 40))));
+      total += list.size();
+    }
+  }
+  return total;
+}
+
+TEST_CASE("listmanager-benchmark", "[benchmark][analysis][listmanager]") {
+  const std::size_t sources = 300;
+  const std::size_t rounds = 10;
+  const std::string suffix = ", " + std::to_string(sources) + " sources";
+
+  BENCHMARK_ADVANCED("ListManager push" + suffix)(Catch::Benchmark::Chronometer meter) {
+    ListManager<RSSI,25> lists;
+    meter.measure([&lists, sources, rounds] { return pushInterleaved(lists, sources, rounds); });
+  };
+
+  BENCHMARK_ADVANCED("FlatListManager push" + suffix)(Catch::Benchmark::Chronometer meter) {
+    FlatListManager<RSSI,25,512> lists;
+    meter.measure([&lists, sources, rounds] { return pushInterleaved(lists, sources, rounds); });
+  };
+}
+
+/// Runs with changed of sources receiving a new sample before each run
+template <typename RunnerT>
+void benchmarkRun(const std::string& name, RunnerT& runner, std::size_t sources, std::size_t changed) {
+  for (std::size_t source = 0;source < sources;++source) {
+    for (long t = 0;t < 10;++t) {
+      runner.newSample(SampledID(source + 1), Sample<RSSI>(Date(t), RSSI(-50 - int(source % 40))));
+    }
+  }
+  runner.run(Date(10));
+  long now = 10;
+  std::size_t next = 0;
+  BENCHMARK(name + ", " + std::to_string(sources) + " sources, " + std::to_string(changed) + " changed") {
+    ++now;
+    for (std::size_t c = 0;c < changed;++c) {
+      runner.newSample(SampledID((next++ % sources) + 1), Sample<RSSI>(Date(now), RSSI(-60)));
+    }
+    runner.run(Date(now));
+    return now;
+  };
+}
+
+TEST_CASE("analysisrunner-benchmark", "[benchmark][analysis][analysisrunner]") {
+  for (std::size_t sources : {100, 500}) {
+    herald::analysis::AnalysisDelegateManager adm(NoOpDistanceDelegate{});
+    herald::analysis::AnalysisProviderManager apm(MeanRSSIAnalyser{});
+    using RunnerT = herald::analysis::AnalysisRunner<
+      herald::analysis::AnalysisDelegateManager<NoOpDistanceDelegate>,
+      herald::analysis::AnalysisProviderManager<MeanRSSIAnalyser>,
+      RSSI,Distance
+    >;
+
+    RunnerT everySource(adm, apm);
+    everySource.analyseUnchanged(true);
+    benchmarkRun("AnalysisRunner run every source", everySource, sources, 5);
+
+    RunnerT changedOnly(adm, apm);
+    benchmarkRun("AnalysisRunner run changed only", changedOnly, sources, 5);
+  }
+}
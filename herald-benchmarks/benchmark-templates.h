@@ -0,0 +1,77 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_BENCHMARK_TEMPLATES_H
+#define HERALD_BENCHMARK_TEMPLATES_H
+
+#include "herald/herald.h"
+
+#include <string>
+
+/// \brief Discards all log output so that logging cost is not measured
+struct NullLoggingSink {
+  void log(const std::string& sub,const std::string& cat,herald::data::SensorLoggerLevel level, std::string message) {
+    ;
+  }
+};
+
+class NullBluetoothStateManager : public herald::ble::BluetoothStateManager {
+public:
+  NullBluetoothStateManager() = default;
+  ~NullBluetoothStateManager() = default;
+
+  void add(herald::ble::BluetoothStateManagerDelegate& delegate) override {
+    ;
+  }
+
+  herald::ble::BluetoothState state() override {
+    return herald::ble::BluetoothState::poweredOn;
+  }
+
+  bool addCustomService(const herald::ble::BluetoothUUID& serviceId) override {
+    return true;
+  }
+
+  void removeCustomService(const herald::ble::BluetoothUUID& serviceId) override {
+    ;
+  }
+
+  bool addCustomServiceCharacteristic(const herald::ble::BluetoothUUID& serviceId, const herald::ble::BluetoothUUID& charId, const herald::ble::BLECharacteristicType& charType, const herald::ble::BLECallbacks& callbacks) override {
+    return true;
+  }
+
+  void removeCustomServiceCharacteristic(const herald::ble::BluetoothUUID& serviceId, const herald::ble::BluetoothUUID& charId) override {
+    ;
+  }
+
+  void notifyAllSubscribers(const herald::ble::BluetoothUUID& serviceId, const herald::ble::BluetoothUUID& charId, const herald::datatype::Data& newValue) override {
+    ;
+  }
+
+  void notifySubscriber(const herald::ble::BluetoothUUID& serviceId, const herald::ble::BluetoothUUID& charId, const herald::datatype::Data& newValue, const herald::ble::BLEMacAddress& toNotify) override {
+    ;
+  }
+};
+
+using BenchmarkContext = herald::Context<herald::DefaultPlatformType,NullLoggingSink,NullBluetoothStateManager>;
+
+/// \brief Holds the objects a BenchmarkContext refers to
+struct BenchmarkEnvironment {
+  BenchmarkEnvironment() : platform(), sink(), bsm(), ctx(platform,sink,bsm) {}
+
+  herald::DefaultPlatformType platform;
+  NullLoggingSink sink;
+  NullBluetoothStateManager bsm;
+  BenchmarkContext ctx;
+};
+
+/// \brief Returns a 6 byte mac-like identifier unique for each value of n
+inline herald::datatype::Data benchmarkMac(std::uint32_t n) {
+  herald::datatype::Data mac;
+  mac.append(std::uint16_t(0xbeef));
+  mac.append(n);
+  return mac;
+}
+
+#endif
@@ -0,0 +1,79 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+template <std::size_t DeviceCount>
+void benchmarkDatabase() {
+  using DatabaseT = herald::ble::ConcreteBLEDatabase<BenchmarkContext,DeviceCount>;
+  BenchmarkEnvironment env;
+  auto db = std::make_unique<DatabaseT>(env.ctx);
+
+  std::vector<herald::datatype::TargetIdentifier> known;
+  std::vector<herald::ble::BLEMacAddress> knownMacs;
+  std::vector<herald::datatype::TargetIdentifier> unknown;
+  known.reserve(DeviceCount);
+  knownMacs.reserve(DeviceCount);
+  unknown.reserve(DeviceCount);
+  for (std::uint32_t i = 0;i < DeviceCount;++i) {
+    known.emplace_back(benchmarkMac(i));
+    knownMacs.emplace_back(benchmarkMac(i));
+    unknown.emplace_back(benchmarkMac(i + DeviceCount));
+  }
+  for (auto& ti : known) {
+    db->device(ti);
+  }
+  REQUIRE(db->size() == DeviceCount);
+  const herald::datatype::Data advert;
+
+  const std::string suffix = ", " + std::to_string(DeviceCount) + " devices";
+
+  BENCHMARK_ADVANCED("device(TargetIdentifier) indexed lookup" + suffix)(Catch::Benchmark::Chronometer meter) {
+    meter.measure([&db,&known](int i) {
+      return &db->device(known[i % DeviceCount]);
+    });
+  };
+
+  // The previous implementation's lookup: a full scan via matches()
+  BENCHMARK_ADVANCED("matches() linear scan lookup" + suffix)(Catch::Benchmark::Chronometer meter) {
+    meter.measure([&db,&known](int i) {
+      const auto& ti = known[i % DeviceCount];
+      return db->matches([&ti](const herald::ble::BLEDevice& d) {
+        return d.identifier() == ti;
+      }).size();
+    });
+  };
+
+  BENCHMARK_ADVANCED("device(mac,advert) known device" + suffix)(Catch::Benchmark::Chronometer meter) {
+    meter.measure([&db,&knownMacs,&advert](int i) {
+      return &db->device(knownMacs[i % DeviceCount],advert);
+    });
+  };
+
+  // Database is full, so every new identifier evicts the least recently used device
+  BENCHMARK_ADVANCED("device(TargetIdentifier) insert with eviction" + suffix)(Catch::Benchmark::Chronometer meter) {
+    meter.measure([&db,&known,&unknown](int i) {
+      const auto& ti = (0 == (i / DeviceCount) % 2) ? unknown[i % DeviceCount] : known[i % DeviceCount];
+      return &db->device(ti);
+    });
+  };
+}
+
+TEST_CASE("bledatabase-benchmark-10", "[benchmark][ble][database]") {
+  benchmarkDatabase<10>();
+}
+
+TEST_CASE("bledatabase-benchmark-100", "[benchmark][ble][database]") {
+  benchmarkDatabase<100>();
+}
+
+TEST_CASE("bledatabase-benchmark-1000", "[benchmark][ble][database]") {
+  benchmarkDatabase<1000>();
+}
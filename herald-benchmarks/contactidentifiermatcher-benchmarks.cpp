@@ -0,0 +1,63 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace herald::payload::simple;
+
+TEST_CASE("matcher-benchmark", "[benchmark][matcher]") {
+  const std::size_t keyCount = 64;
+  const std::size_t keyLength = 2048;
+  const int fromDay = 14;
+  const int toDay = 15;
+  std::vector<std::uint8_t> keys(keyCount * keyLength);
+  for (std::size_t i = 0;i < keys.size();++i) {
+    keys[i] = std::uint8_t(i * 13 + i / keyLength);
+  }
+  const std::string suffix = ", " + std::to_string(keyCount) + " keys x " +
+    std::to_string(toDay - fromDay + 1) + " days";
+
+  // The per-call API, one K::contactIdentifier at a time (one key only, to keep run time sane)
+  BENCHMARK("K::contactIdentifier per call, 1 key x 2 days") {
+    K k;
+    SecretKey secretKey(keys.data(), keyLength);
+    std::size_t total = 0;
+    for (int day = fromDay;day <= toDay;++day) {
+      for (int period = 0;period < 240;++period) {
+        total += k.contactIdentifier(secretKey, day, period).size();
+      }
+    }
+    return total;
+  };
+
+  BENCHMARK("ContactIdentifierMatcher build, 1 thread" + suffix) {
+    ContactIdentifierMatcher matcher(2000, 240, 1);
+    matcher.build(keys.data(), keyLength, keyCount, fromDay, toDay);
+    return matcher.size();
+  };
+
+  BENCHMARK("ContactIdentifierMatcher build, all threads" + suffix) {
+    ContactIdentifierMatcher matcher;
+    matcher.build(keys.data(), keyLength, keyCount, fromDay, toDay);
+    return matcher.size();
+  };
+
+  ContactIdentifierMatcher matcher;
+  matcher.build(keys.data(), keyLength, keyCount, fromDay, toDay);
+  std::vector<ContactIdentifierMatcher::Identifier> observed(100000);
+  for (std::size_t i = 0;i < observed.size();++i) {
+    for (std::size_t b = 0;b < ContactIdentifierMatcher::IdentifierLength;++b) {
+      observed[i][b] = std::uint8_t(i * 7 + b * 131 + i / 256);
+    }
+  }
+
+  BENCHMARK("ContactIdentifierMatcher match, 100000 observations" + suffix) {
+    return matcher.match(observed).size();
+  };
+}
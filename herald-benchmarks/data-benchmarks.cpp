@@ -0,0 +1,122 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using herald::datatype::Data;
+
+using BaselineArena = herald::datatype::MemoryArena<8192,8>;
+
+/// Copies an arena entry using the per-byte get/set access that DataRef used before bulk copies
+void bytewiseCopy(BaselineArena& arena, const herald::datatype::MemoryArenaEntry& from, herald::datatype::MemoryArenaEntry& to) {
+  for (std::size_t i = 0;i < from.byteLength;++i) {
+    arena.set(to, i, arena.get(from, i));
+  }
+}
+
+void benchmarkData(std::size_t length) {
+  std::vector<std::uint8_t> raw(length);
+  for (std::size_t i = 0;i < length;++i) {
+    raw[i] = std::uint8_t(i * 31);
+  }
+  const Data source(raw.data(), raw.size());
+  const std::string hex = source.hexEncodedString();
+  const std::string suffix = ", " + std::to_string(length) + " bytes";
+
+  auto baseline = std::make_unique<BaselineArena>();
+  auto baselineFrom = baseline->allocate(length);
+  auto baselineTo = baseline->allocate(length);
+
+  BENCHMARK("arena bytewise get/set copy (previous DataRef copy)" + suffix) {
+    bytewiseCopy(*baseline, baselineFrom, baselineTo);
+    return baseline->get(baselineTo, 0);
+  };
+
+  BENCHMARK("arena bulk copy" + suffix) {
+    std::memcpy(baseline->rawStartAddress(baselineTo), baseline->rawStartAddress(baselineFrom), length);
+    return baseline->get(baselineTo, 0);
+  };
+
+  BENCHMARK("copy constructor" + suffix) {
+    Data copy(source);
+    return copy.size();
+  };
+
+  BENCHMARK("construct from uint8_t array" + suffix) {
+    Data copy(raw.data(), raw.size());
+    return copy.size();
+  };
+
+  BENCHMARK("append DataRef x4" + suffix) {
+    Data result;
+    result.append(source);
+    result.append(source);
+    result.append(source);
+    result.append(source);
+    return result.size();
+  };
+
+  BENCHMARK("append uint16_t x" + std::to_string(length / 2)) {
+    Data result;
+    for (std::size_t i = 0;i < length / 2;++i) {
+      result.append(std::uint16_t(i));
+    }
+    return result.size();
+  };
+
+  BENCHMARK("subdata" + suffix) {
+    return source.subdata(1, length - 2).size();
+  };
+
+  BENCHMARK("reversed" + suffix) {
+    return source.reversed().size();
+  };
+
+  BENCHMARK("hexEncodedString" + suffix) {
+    return source.hexEncodedString().size();
+  };
+
+  BENCHMARK("fromHexEncodedString" + suffix) {
+    return Data::fromHexEncodedString(hex).size();
+  };
+
+  BENCHMARK("hashCode" + suffix) {
+    return source.hashCode();
+  };
+
+  const Data same(raw.data(), raw.size());
+  BENCHMARK("operator== equal" + suffix) {
+    return source == same;
+  };
+
+  BENCHMARK("uint32 reads" + suffix) {
+    std::uint32_t total = 0;
+    std::uint32_t value = 0;
+    for (std::size_t i = 0;i + 4 <= length;i += 4) {
+      source.uint32(i, value);
+      total += value;
+    }
+    return total;
+  };
+
+  BENCHMARK("SHA256 digest" + suffix) {
+    herald::datatype::SHA256 sha;
+    return sha.digest(source).size();
+  };
+}
+
+TEST_CASE("data-benchmark-32", "[benchmark][data]") {
+  benchmarkData(32);
+}
+
+TEST_CASE("data-benchmark-512", "[benchmark][data]") {
+  benchmarkData(512);
+}
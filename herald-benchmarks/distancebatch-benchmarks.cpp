@@ -0,0 +1,70 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace herald::analysis::algorithms::distance;
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+namespace {
+
+using RSSIList = SampleList<Sample<RSSI>,25>;
+
+/// One full window of RSSI per source, around a per source mean, as a busy gateway sees
+std::vector<RSSIList> makeSources(std::size_t sources) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> centres(-90, -30);
+  std::uniform_int_distribution<int> spread(-5, 5);
+  std::vector<RSSIList> lists(sources);
+  for (auto& list : lists) {
+    const int centre = centres(random);
+    for (std::size_t t = 0;t < RSSIList::max_size;++t) {
+      list.push(Date(1000 + t), RSSI(centre + spread(random)));
+    }
+  }
+  return lists;
+}
+
+}
+
+TEST_CASE("distancebatch-benchmark", "[benchmark][analysis][distancebatch]") {
+  const std::size_t sources = 1000;
+  const std::string suffix = ", " + std::to_string(sources) + " sources";
+  auto lists = makeSources(sources);
+
+  BENCHMARK_ADVANCED("FowlerBasicAnalyser per source" + suffix)(Catch::Benchmark::Chronometer meter) {
+    FowlerBasicAnalyser analyser(10, -11, -0.4);
+    SampleList<Sample<Distance>,5> dst;
+    double total = 0.0;
+    auto callable = [&total](SampledID, const Sample<Distance>& sample) { total += sample.value.value; };
+    meter.measure([&] {
+      for (std::size_t source = 0;source < sources;++source) {
+        // A fresh analyser each time, as its last run time is shared by every source
+        analyser = FowlerBasicAnalyser(10, -11, -0.4);
+        analyser.analyse(Date(2000), SampledID(source), lists[source], dst, callable);
+      }
+      return total;
+    });
+  };
+
+  BENCHMARK_ADVANCED("FowlerBatch" + suffix)(Catch::Benchmark::Chronometer meter) {
+    FowlerBatch batch(-11, -0.4);
+    std::vector<FowlerEstimate> estimates;
+    meter.measure([&] {
+      batch.clear();
+      for (auto& list : lists) {
+        batch.add(list, Date(0));
+      }
+      batch.estimate(estimates);
+      return estimates.size();
+    });
+  };
+}
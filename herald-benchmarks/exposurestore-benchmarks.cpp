@@ -0,0 +1,79 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+
+using namespace herald::datatype;
+
+namespace {
+
+constexpr std::size_t Sources = 8;
+constexpr std::size_t ExposuresPerSource = 64;
+constexpr std::uint64_t Period = 60;
+
+Agent numberedAgent(std::size_t number) {
+  char id[37];
+  std::snprintf(id, sizeof(id), "11111111-1111-4011-8011-%012zu", number);
+  return UUID::fromString(std::string(id));
+}
+
+/// A full store of contiguous one minute exposures per source, as the ExposureManager writes them
+template <typename StoreT>
+void fill(StoreT& store) {
+  for (std::size_t source = 0;source < Sources;++source) {
+    const ExposureMetadata meta{
+      .agentId = numberedAgent(source),
+      .sensorClassId = sensorClass::bluetoothProximityHerald,
+      .sensorInstanceId = numberedAgent(100 + source),
+      .modelClassId = numberedAgent(200 + source)
+    };
+    store.add(meta);
+    auto& contents = store.getContents(store.findMeta(meta));
+    for (std::size_t idx = 0;idx < ExposuresPerSource;++idx) {
+      contents.add(Exposure{
+        .periodStart = Date(Period * idx),
+        .periodEnd = Date(Period * (idx + 1)),
+        .value = double(idx)
+      });
+    }
+  }
+}
+
+/// Aggregates every source over every period, as a risk model refresh over a day's periods does
+template <typename StoreT>
+double aggregateAll(const StoreT& store) {
+  double total = 0.0;
+  for (std::size_t source = 0;source < Sources;++source) {
+    const Agent agent = numberedAgent(source);
+    for (std::size_t idx = 0;idx < ExposuresPerSource;++idx) {
+      store.aggregate(agent, Date(Period * idx), Date(Period * (idx + 1)),
+        herald::analysis::aggregates::Sum{}, [&total] (const Exposure& e) { total += e.value; });
+    }
+  }
+  return total;
+}
+
+}
+
+TEST_CASE("exposurestore-benchmark", "[benchmark][exposure][exposurestore]") {
+  const std::string suffix = ", " + std::to_string(Sources) + " sources of "
+    + std::to_string(ExposuresPerSource) + " exposures";
+
+  BENCHMARK_ADVANCED("FixedMemoryExposureStore aggregate" + suffix)(Catch::Benchmark::Chronometer meter) {
+    herald::exposure::FixedMemoryExposureStore<ExposuresPerSource> store;
+    fill(store);
+    meter.measure([&store] { return aggregateAll(store); });
+  };
+
+  BENCHMARK_ADVANCED("IndexedExposureStore aggregate" + suffix)(Catch::Benchmark::Chronometer meter) {
+    herald::exposure::IndexedExposureStore<Sources,ExposuresPerSource> store;
+    fill(store);
+    meter.measure([&store] { return aggregateAll(store); });
+  };
+}
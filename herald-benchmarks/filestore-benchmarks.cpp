@@ -0,0 +1,108 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+using namespace herald::datatype;
+
+namespace {
+
+constexpr std::size_t Sources = 8;
+constexpr std::size_t MinutesPerWeek = 7 * 24 * 60;
+using StoreT = herald::exposure::FileExposureStore<Sources>;
+
+std::string benchmarkFile(const std::string& name) {
+  const std::string path = (std::filesystem::temp_directory_path() / ("herald-benchmark-" + name)).string();
+  std::remove(path.c_str());
+  return path;
+}
+
+ExposureMetadata sourceMeta(std::size_t source) {
+  char id[37];
+  std::snprintf(id, sizeof(id), "11111111-1111-4011-8011-%012zu", source);
+  const UUID uuid = UUID::fromString(std::string(id));
+  return ExposureMetadata{
+    .agentId = Agent{uuid},
+    .sensorClassId = sensorClass::bluetoothProximityHerald,
+    .sensorInstanceId = uuid,
+    .modelClassId = uuid
+  };
+}
+
+/// Appends one minute exposures to every source, as the ExposureManager writes them
+void appendMinutes(StoreT& store, std::uint64_t fromMinute, std::size_t minutes) {
+  for (std::size_t minute = 0;minute < minutes;++minute) {
+    const std::uint64_t start = 60 * (fromMinute + minute);
+    for (std::size_t pos = 0;pos < store.size();++pos) {
+      auto& contents = store.getContents(pos);
+      if (0 != contents.size()) {
+        contents[contents.size() - 1].periodEnd = Date(start);
+      }
+      contents.add(Exposure{.periodStart = start, .periodEnd = start, .value = double(minute % 60)});
+    }
+  }
+}
+
+}
+
+TEST_CASE("filestore-benchmark", "[benchmark][exposure][filestore]") {
+  const std::string suffix = ", " + std::to_string(Sources) + " sources";
+
+  BENCHMARK_ADVANCED("FileExposureStore append 1 day of minutes" + suffix)(Catch::Benchmark::Chronometer meter) {
+    const std::string path = benchmarkFile("append.bin");
+    StoreT store(path);
+    store.open();
+    for (std::size_t source = 0;source < Sources;++source) {
+      store.add(sourceMeta(source));
+    }
+    std::uint64_t minute = 0;
+    meter.measure([&] {
+      appendMinutes(store, minute, 24 * 60);
+      minute += 24 * 60;
+      return store.flush();
+    });
+    store.close();
+    std::remove(path.c_str());
+  };
+
+  // A week of history, mostly only in the file
+  const std::string path = benchmarkFile("history.bin");
+  {
+    StoreT writer(path);
+    writer.open();
+    for (std::size_t source = 0;source < Sources;++source) {
+      writer.add(sourceMeta(source));
+    }
+    appendMinutes(writer, 0, MinutesPerWeek);
+  }
+  StoreT store(path);
+  store.open();
+
+  BENCHMARK("FileExposureStore open 1 week of minutes" + suffix) {
+    StoreT reader(path);
+    return reader.open();
+  };
+
+  BENCHMARK("FileExposureStore aggregate 24 hourly periods of 1 week" + suffix) {
+    double total = 0.0;
+    for (std::size_t source = 0;source < Sources;++source) {
+      const Agent agent = sourceMeta(source).agentId;
+      for (std::uint64_t hour = 0;hour < 24;++hour) {
+        const std::uint64_t start = 60 * 60 * (24 * 3 + hour); // within the fourth day
+        store.aggregate(agent, Date(start), Date(start + 60 * 60),
+          herald::analysis::aggregates::Sum{}, [&total] (const Exposure& e) { total += e.value; });
+      }
+    }
+    return total;
+  };
+
+  store.close();
+  std::remove(path.c_str());
+}
@@ -0,0 +1,8 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+// Build with -DCMAKE_BUILD_TYPE=Release for representative numbers.
+// Run a subset with, for example: herald-benchmarks "[ble]"
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
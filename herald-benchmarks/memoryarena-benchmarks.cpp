@@ -0,0 +1,42 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+
+/// Fragments the arena (every other small allocation freed) then times allocating
+/// and releasing a block that only fits at the end of the arena.
+template <typename AllocationPolicy>
+void benchmarkArena(const std::string& name) {
+  using ArenaT = herald::datatype::MemoryArena<8192,8,AllocationPolicy>;
+  auto arena = std::make_unique<ArenaT>();
+  std::array<herald::datatype::MemoryArenaEntry,400> entries;
+  for (auto& entry : entries) {
+    entry = arena->allocate(16); // 2 pages each
+  }
+  for (std::size_t i = 0;i < entries.size();i += 2) {
+    arena->deallocate(entries[i]);
+  }
+
+  BENCHMARK(name + " allocate in fragmented arena") {
+    auto entry = arena->allocate(64);
+    const auto start = entry.startPageIndex;
+    arena->deallocate(entry);
+    return start;
+  };
+
+  BENCHMARK(name + " largestFreeRun") {
+    return arena->largestFreeRun();
+  };
+}
+
+TEST_CASE("memoryarena-benchmark", "[benchmark][memoryarena]") {
+  benchmarkArena<herald::datatype::FirstFitAllocation>("FirstFitAllocation");
+  benchmarkArena<herald::datatype::WordScanAllocation>("WordScanAllocation");
+}
@@ -0,0 +1,90 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <array>
+#include <string>
+
+using namespace herald::datatype;
+
+namespace {
+
+constexpr std::size_t Instances = 8;
+constexpr std::uint64_t Minutes = 24 * 60;
+
+using ExposureStoreT = herald::exposure::IndexedExposureStore<2,Minutes>;
+using RiskManagerT = herald::exposure::RiskManager<
+  herald::exposure::RiskModels<herald::exposure::model::SampleDiseaseScreeningRiskModel>,
+  herald::exposure::RiskParameters<8>,
+  Instances,
+  herald::exposure::FixedMemoryRiskStore<Instances>
+>;
+
+UUID numberedInstance(std::size_t number) {
+  std::array<std::uint8_t,16> data{};
+  data[15] = std::uint8_t(number);
+  return UUID(data);
+}
+
+/// A day of one minute proximity and light exposures
+void fill(ExposureStoreT& store) {
+  for (const auto& agent : {agent::humanProximity, agent::lightBrightness}) {
+    const ExposureMetadata meta{
+      .agentId = agent,
+      .sensorClassId = sensorClass::bluetoothProximityHerald,
+      .sensorInstanceId = agent,
+      .modelClassId = agent
+    };
+    store.add(meta);
+    auto& contents = store.getContents(store.findMeta(meta));
+    for (std::uint64_t minute = 0;minute < Minutes;++minute) {
+      contents.add(Exposure{
+        .periodStart = Date(60 * minute),
+        .periodEnd = Date(60 * (minute + 1)),
+        .value = double(minute % 60)
+      });
+    }
+  }
+}
+
+/// Marks every model instance dirty for the whole day, then recalculates their risk scores per minute
+void refreshDay(RiskManagerT& rm, const ExposureStoreT& store, const ExposureMetadata& proxMeta) {
+  auto& contents = store.getContents(store.findMeta(proxMeta));
+  auto iter = contents.begin();
+  auto end = contents.end();
+  rm.injectExposureChanges(store, proxMeta, iter, end);
+  rm.refreshDirtyScores(store);
+}
+
+}
+
+TEST_CASE("riskmanager-benchmark", "[benchmark][exposure][riskmanager]") {
+  ExposureStoreT exposures;
+  fill(exposures);
+  const ExposureMetadata proxMeta = exposures.getTag(exposures.findMetaByAgentId(agent::humanProximity));
+  herald::exposure::model::SampleDiseaseScreeningRiskModel sampleRM;
+  herald::exposure::RefreshPool pool;
+
+  const std::string suffix = ", " + std::to_string(Instances) + " model instances over a day of minutes";
+
+  for (auto mode : {herald::exposure::RiskRefreshExecution::serial, herald::exposure::RiskRefreshExecution::parallel}) {
+    herald::exposure::FixedMemoryRiskStore<Instances> riskStore;
+    RiskManagerT rm{herald::exposure::RiskModels{sampleRM}, herald::exposure::RiskParameters<8>{}, riskStore};
+    rm.setGlobalPeriodInterval(Date{0}, TimeInterval::seconds(60));
+    rm.execution(mode, &pool);
+    for (std::size_t instance = 0;instance < Instances;++instance) {
+      rm.addRiskModel(numberedInstance(instance + 1), Agent{55}, sampleRM);
+    }
+    const std::string name = herald::exposure::RiskRefreshExecution::serial == mode ?
+      "RiskManager serial refresh" : "RiskManager parallel refresh (" + std::to_string(pool.threads()) + " threads)";
+
+    BENCHMARK(name + suffix) {
+      refreshDay(rm, exposures, proxMeta);
+      return rm.getRiskScoreCount(numberedInstance(1));
+    };
+  }
+}
@@ -0,0 +1,50 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "benchmark-templates.h"
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+using herald::datatype::Data;
+using herald::datatype::SHA256;
+
+void benchmarkSHA256(std::size_t length, std::size_t count) {
+  std::vector<std::uint8_t> messages(length * count);
+  for (std::size_t i = 0;i < messages.size();++i) {
+    messages[i] = std::uint8_t(i * 31);
+  }
+  std::vector<std::uint8_t> digests(count * SHA256::DigestLength);
+  const std::string suffix = ", " + std::to_string(count) + " x " + std::to_string(length) + " bytes";
+
+  BENCHMARK("SHA256 digest per call" + suffix) {
+    SHA256 sha;
+    std::size_t total = 0;
+    for (std::size_t m = 0;m < count;++m) {
+      Data message(messages.data() + m * length, length);
+      total += sha.digest(message).size();
+    }
+    return total;
+  };
+
+  BENCHMARK("SHA256 digestBatch" + suffix) {
+    SHA256::digestBatch(messages.data(), length, count, digests.data());
+    return digests[0];
+  };
+}
+
+// 16 bytes is the truncated seed hashed at every step of the simple payload key chains
+TEST_CASE("sha256-benchmark-16", "[benchmark][sha256]") {
+  benchmarkSHA256(16, 1024);
+}
+
+TEST_CASE("sha256-benchmark-64", "[benchmark][sha256]") {
+  benchmarkSHA256(64, 1024);
+}
+
+TEST_CASE("sha256-benchmark-512", "[benchmark][sha256]") {
+  benchmarkSHA256(512, 64);
+}
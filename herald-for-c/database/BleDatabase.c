@@ -6,44 +6,14 @@
 
 #include "database/BleDatabase.h"
 
-/**
- * \brief Create a new device and add it to the database
- * 
- * \param self 
- * \param addr 
- * \return Pointer to the device in the database, NULL if it could not be created 
- */
-static BleDevice_t * prv_create_device(BleDatabase_t * self, const BleAddress_t * addr)
-{
-    assert(self);
-
-    /* Create the new device */
-    BleDevice_t * dev = BleDbDataStruct_add_entry(&self->deviceList, addr);
-
-    /* Check success */
-    if(dev == NULL)
-    {
-        LOG_ERR("Error creating device");
-        return NULL;
-    }
-
-    /* Initialize the data structure */
-    BleDevice_init(dev);
-
-    /* Success, call the didCreate callback */
-    DatabaseDelegate_didCreate(&self->delegate, addr);
-
-    return dev;
-}
-
 /**
  * \brief Find or create a device with the given address
  * 
  * If a device with the address already exists, return it
  * Otherwise, create a new one and add it to the database
  * 
- * In the future this should be made more efficient by searching the ordered list
- * and if not found, instert it right there, currently we are doing two passes
+ * The search and the creation are one step of the data structure,
+ * so the same address cannot be added twice from different threads
  * 
  * @param self 
  * @param addr 
@@ -53,16 +23,27 @@ static BleDevice_t * prv_create_device(BleDatabase_t * self, const BleAddress_t
 BleDevice_t * BleDatabase_find_create_device(BleDatabase_t * self, const BleAddress_t * addr)
 {
     BleDevice_t * dev;
+    int created;
 
     assert(self);
 
-    /* Attempt to find it in the database */
-    dev = BleDbDataStruct_find(&self->deviceList, addr);
+    /* Attempt to find it in the database, adding it if not found */
+    dev = BleDbDataStruct_find_or_add(&self->deviceList, addr, &created);
 
-    /* If not found then create a new one */
+    /* Check success */
     if(dev == NULL)
     {
-        dev = prv_create_device(self, addr);
+        LOG_ERR("Error creating device");
+        return NULL;
+    }
+
+    if(created)
+    {
+        /* Initialize the data structure */
+        BleDevice_init(dev);
+
+        /* Success, call the didCreate callback */
+        DatabaseDelegate_didCreate(&self->delegate, addr);
     }
 
     return dev;
@@ -6,6 +6,8 @@
 
 #include "database/BleDbDataStruct.h"
 
+/* Only built when selected, see CONFIG_HERALD_DB_BACKEND */
+#ifndef CONFIG_HERALD_DB_BACKEND_HASH
 
 void BleDbDataStruct_init(BleDbArray_t * self)
 {
@@ -25,11 +27,43 @@ static inline void prv_unlock(BleDbArray_t * self)
     k_mutex_unlock(&self->mutex);
 }
 
-BleDevice_t * BleDbDataStruct_add_entry(BleDbArray_t * self, const BleAddress_t * addr)
+/**
+ * \brief Find the entry at the given address, must be called locked
+ * 
+ * \return The entry, NULL if not found
+ */
+static BleDbArray_entry_t * prv_find(BleDbArray_t * self, const BleAddress_t * addr)
 {
     size_t i;
 
-    if(prv_lock(self) != 0) return NULL;
+    for(i=0;i<CONFIG_HERALD_MAX_DEVS_IN_DB;i++)
+    {
+        /* Only look for used entries */
+        if(self->entryPool[i].used == 0)
+        {
+            continue;
+        }
+
+        /* Compare the addresses */
+        if(BleAddress_cmp(&self->entryPool[i].addr, addr) != 0)
+        {
+            continue;
+        }
+
+        /* It was found */
+        return &self->entryPool[i];
+    }
+    return NULL;
+}
+
+/**
+ * \brief Allocate an entry for the given address, must be called locked
+ * 
+ * \return The entry, NULL if there is no space
+ */
+static BleDbArray_entry_t * prv_add(BleDbArray_t * self, const BleAddress_t * addr)
+{
+    size_t i;
 
     /* Find next available device */
     for(i=0;i<CONFIG_HERALD_MAX_DEVS_IN_DB;i++)
@@ -49,46 +83,59 @@ BleDevice_t * BleDbDataStruct_add_entry(BleDbArray_t * self, const BleAddress_t
         /* Increment the size counter */
         self->size++;
 
-        prv_unlock(self);
-        return &self->entryPool[i].dev;
+        return &self->entryPool[i];
     }
-    prv_unlock(self);
     return NULL;
 }
 
-BleDevice_t * BleDbDataStruct_find(BleDbArray_t * self, const BleAddress_t * addr)
+BleDevice_t * BleDbDataStruct_add_entry(BleDbArray_t * self, const BleAddress_t * addr)
 {
-    size_t i;
+    BleDbArray_entry_t * entry;
 
     if(prv_lock(self) != 0) return NULL;
+    entry = prv_add(self, addr);
+    prv_unlock(self);
 
-    for(i=0;i<CONFIG_HERALD_MAX_DEVS_IN_DB;i++)
-    {
-        /* Only look for used entries */
-        if(self->entryPool[i].used == 0)
-        {
-            continue;
-        }
+    return entry == NULL ? NULL : &entry->dev;
+}
 
-        /* Compare the addresses */
-        if(BleAddress_cmp(&self->entryPool[i].addr, addr) != 0)
-        {
-            continue;
-        }
+BleDevice_t * BleDbDataStruct_find_or_add(BleDbArray_t * self, const BleAddress_t * addr,
+    int * created)
+{
+    BleDbArray_entry_t * entry;
 
-        /* It was found */
-        prv_unlock(self);
-        return &self->entryPool[i].dev;
+    *created = 0;
+    if(prv_lock(self) != 0) return NULL;
+    entry = prv_find(self, addr);
+    if(entry == NULL)
+    {
+        entry = prv_add(self, addr);
+        *created = (entry != NULL);
     }
     prv_unlock(self);
-    return NULL;
+
+    return entry == NULL ? NULL : &entry->dev;
+}
+
+BleDevice_t * BleDbDataStruct_find(BleDbArray_t * self, const BleAddress_t * addr)
+{
+    BleDbArray_entry_t * entry;
+
+    if(prv_lock(self) != 0) return NULL;
+    entry = prv_find(self, addr);
+    prv_unlock(self);
+
+    return entry == NULL ? NULL : &entry->dev;
 }
 
 size_t BleDbDataStruct_get_size(BleDbArray_t * self)
 {
+    size_t size;
+
     if(prv_lock(self) != 0) return 0;
-    return self->size;
+    size = self->size;
     prv_unlock(self);
+    return size;
 }
 
 void BleDbDataStruct_loop_devs(BleDbArray_t * self, BleDbDataStruct_loop_cb_t cb,
@@ -122,3 +169,5 @@ void BleDbDataStruct_loop_devs(BleDbArray_t * self, BleDbDataStruct_loop_cb_t cb
     }
     prv_unlock(self);
 }
+
+#endif /* CONFIG_HERALD_DB_BACKEND_HASH */
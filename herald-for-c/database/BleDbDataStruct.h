@@ -9,7 +9,13 @@
 
 #include "data_type/DataTypes.h"
 #include "ble/BleDevice.h"
+
+/* Select the data structure, see CONFIG_HERALD_DB_BACKEND */
+#ifdef CONFIG_HERALD_DB_BACKEND_HASH
+#include "database/BleDbHash.h"
+#else
 #include "database/BleDbArray.h"
+#endif
 
 /**
  * \brief callback when looping through device list
@@ -26,7 +32,7 @@ typedef int (*BleDbDataStruct_loop_cb_t)(const BleAddress_t * addr,  BleDevice_t
  * 
  * \param self 
  */
-void BleDbDataStruct_init(BleDbArray_t * self);
+void BleDbDataStruct_init(BleDbDataStruct_t * self);
 
 /**
  * \brief Allocates memory for the device at the given address
@@ -37,6 +43,19 @@ void BleDbDataStruct_init(BleDbArray_t * self);
  */
 BleDevice_t * BleDbDataStruct_add_entry(BleDbDataStruct_t * self, const BleAddress_t * address);
 
+/**
+ * \brief Get the device at the given address, allocating memory for it if it is not in the DB
+ * 
+ * The find and the allocation are one operation, so a device is never added twice
+ * 
+ * \param self 
+ * \param address 
+ * \param created Set to not 0 if the device was added, 0 if it was found
+ * \return The device memory, NULL if it was not found and could not be added
+ */
+BleDevice_t * BleDbDataStruct_find_or_add(BleDbDataStruct_t * self, const BleAddress_t * address,
+    int * created);
+
 /**
  * \brief Get a device from the DB at the given address 
  * 
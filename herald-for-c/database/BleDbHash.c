@@ -0,0 +1,249 @@
+/*
+ * Copyright 2020-2021 Herald Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include "database/BleDbDataStruct.h"
+
+/* Only built when selected, see CONFIG_HERALD_DB_BACKEND */
+#ifdef CONFIG_HERALD_DB_BACKEND_HASH
+
+_Static_assert(CONFIG_HERALD_MAX_DEVS_IN_DB < BleDbHash_NONE,
+    "CONFIG_HERALD_MAX_DEVS_IN_DB is too large for 16 bit entry indexes");
+_Static_assert((CONFIG_HERALD_DB_HASH_BUCKETS & (CONFIG_HERALD_DB_HASH_BUCKETS - 1)) == 0,
+    "CONFIG_HERALD_DB_HASH_BUCKETS must be a power of two");
+
+/*
+ * The index is guarded by a spin lock, held only while the index itself
+ * is read or changed, never while a callback runs.
+ * Host builds (unit tests and benchmarks) are single threaded, so do not lock.
+ */
+#ifdef __ZEPHYR__
+typedef k_spinlock_key_t prv_key_t;
+
+static inline prv_key_t prv_lock(BleDbHash_t * self)
+{
+    return k_spin_lock(&self->lock);
+}
+
+static inline void prv_unlock(BleDbHash_t * self, prv_key_t key)
+{
+    k_spin_unlock(&self->lock, key);
+}
+#else
+typedef int prv_key_t;
+
+static inline prv_key_t prv_lock(BleDbHash_t * self)
+{
+    (void) self;
+    return 0;
+}
+
+static inline void prv_unlock(BleDbHash_t * self, prv_key_t key)
+{
+    (void) self;
+    (void) key;
+}
+#endif
+
+/**
+ * \brief FNV-1a hash of the address, reduced to a bucket index
+ */
+static inline uint16_t prv_bucket(const BleAddress_t * addr)
+{
+    uint32_t hash = 2166136261UL;
+    int i;
+
+    for(i=0; i<6; i++)
+    {
+        hash ^= addr->val[i];
+        hash *= 16777619UL;
+    }
+    /* Fold the high bits in, as the low bits of FNV-1a mix less well */
+    hash ^= hash >> 16;
+
+    return (uint16_t) (hash & (CONFIG_HERALD_DB_HASH_BUCKETS - 1));
+}
+
+/**
+ * \brief Find the entry at the given address, must be called locked
+ *
+ * \return The entry index, BleDbHash_NONE if not found
+ */
+static uint16_t prv_find(BleDbHash_t * self, const BleAddress_t * addr, uint16_t bucket)
+{
+    uint16_t i = self->buckets[bucket];
+
+    while(i != BleDbHash_NONE)
+    {
+        if(memcmp(&self->entryPool[i].addr, addr, sizeof(BleAddress_t)) == 0)
+        {
+            return i;
+        }
+        i = self->entryPool[i].next;
+    }
+    return BleDbHash_NONE;
+}
+
+/**
+ * \brief Take an entry from the free list and add it to the bucket, must be called locked
+ *
+ * \return The entry index, BleDbHash_NONE if the pool is full
+ */
+static uint16_t prv_add(BleDbHash_t * self, const BleAddress_t * addr, uint16_t bucket)
+{
+    uint16_t i = self->freeHead;
+
+    if(i == BleDbHash_NONE)
+    {
+        return BleDbHash_NONE;
+    }
+    self->freeHead = self->entryPool[i].next;
+
+    /* Set to used */
+    self->entryPool[i].used = 1;
+
+    /* Copy the address */
+    BleAddress_copy(&self->entryPool[i].addr, addr);
+
+    /* Push to the front of the bucket */
+    self->entryPool[i].next = self->buckets[bucket];
+    self->buckets[bucket] = i;
+
+    /* Increment the size counter */
+    self->size++;
+
+    return i;
+}
+
+/**
+ * \brief Remove the entry from its bucket and return it to the free list, must be called locked
+ */
+static void prv_remove(BleDbHash_t * self, uint16_t index)
+{
+    uint16_t * link = &self->buckets[prv_bucket(&self->entryPool[index].addr)];
+
+    /* Find the link to this entry, chains are short */
+    while(*link != index)
+    {
+        assert(*link != BleDbHash_NONE);
+        link = &self->entryPool[*link].next;
+    }
+    *link = self->entryPool[index].next;
+
+    self->entryPool[index].used = 0;
+    self->entryPool[index].next = self->freeHead;
+    self->freeHead = index;
+    self->size--;
+}
+
+void BleDbDataStruct_init(BleDbHash_t * self)
+{
+    size_t i;
+
+    /* Wipe the whole thing */
+    memset(self->entryPool, 0, sizeof(BleDbHash_entry_t) * CONFIG_HERALD_MAX_DEVS_IN_DB);
+    self->size = 0;
+
+    /* Empty buckets */
+    for(i=0;i<CONFIG_HERALD_DB_HASH_BUCKETS;i++)
+    {
+        self->buckets[i] = BleDbHash_NONE;
+    }
+
+    /* Every entry is free, in order */
+    for(i=0;i<CONFIG_HERALD_MAX_DEVS_IN_DB;i++)
+    {
+        self->entryPool[i].next = (i + 1 < CONFIG_HERALD_MAX_DEVS_IN_DB) ? (uint16_t) (i + 1) : BleDbHash_NONE;
+    }
+    self->freeHead = 0;
+}
+
+BleDevice_t * BleDbDataStruct_add_entry(BleDbHash_t * self, const BleAddress_t * addr)
+{
+    const uint16_t bucket = prv_bucket(addr);
+    prv_key_t key = prv_lock(self);
+    uint16_t i = prv_add(self, addr, bucket);
+    prv_unlock(self, key);
+
+    return (i == BleDbHash_NONE) ? NULL : &self->entryPool[i].dev;
+}
+
+BleDevice_t * BleDbDataStruct_find_or_add(BleDbHash_t * self, const BleAddress_t * addr,
+    int * created)
+{
+    const uint16_t bucket = prv_bucket(addr);
+    uint16_t i;
+    prv_key_t key = prv_lock(self);
+
+    *created = 0;
+    i = prv_find(self, addr, bucket);
+    if(i == BleDbHash_NONE)
+    {
+        i = prv_add(self, addr, bucket);
+        *created = (i != BleDbHash_NONE);
+    }
+    prv_unlock(self, key);
+
+    return (i == BleDbHash_NONE) ? NULL : &self->entryPool[i].dev;
+}
+
+BleDevice_t * BleDbDataStruct_find(BleDbHash_t * self, const BleAddress_t * addr)
+{
+    const uint16_t bucket = prv_bucket(addr);
+    prv_key_t key = prv_lock(self);
+    uint16_t i = prv_find(self, addr, bucket);
+    prv_unlock(self, key);
+
+    return (i == BleDbHash_NONE) ? NULL : &self->entryPool[i].dev;
+}
+
+size_t BleDbDataStruct_get_size(BleDbHash_t * self)
+{
+    size_t size;
+    prv_key_t key = prv_lock(self);
+    size = self->size;
+    prv_unlock(self, key);
+    return size;
+}
+
+void BleDbDataStruct_loop_devs(BleDbHash_t * self, BleDbDataStruct_loop_cb_t cb,
+    void * param1, void * param2)
+{
+    size_t i;
+    uint8_t used;
+    prv_key_t key;
+
+    assert(self);
+    assert(cb);
+
+    /*
+     * Only this function removes entries, and it is only called from one thread,
+     * so an entry seen as used stays in place while its callback runs unlocked.
+     * Entries added meanwhile may or may not be visited.
+     */
+    for(i=0;i<CONFIG_HERALD_MAX_DEVS_IN_DB; i++)
+    {
+        key = prv_lock(self);
+        used = self->entryPool[i].used;
+        prv_unlock(self, key);
+
+        /* Only interested in devices that are in use */
+        if(used == 0)
+        {
+            continue;
+        }
+
+        /* Call the callback */
+        if(cb(&self->entryPool[i].addr, &self->entryPool[i].dev, param1, param2) != 0)
+        {
+            /* Delete the device */
+            key = prv_lock(self);
+            prv_remove(self, (uint16_t) i);
+            prv_unlock(self, key);
+        }
+    }
+}
+
+#endif /* CONFIG_HERALD_DB_BACKEND_HASH */
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020-2021 Herald Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#ifndef __BLE_DB_HASH_H__
+#define __BLE_DB_HASH_H__
+
+#include <stdint.h>
+#include "data_type/DataTypes.h"
+#include "ble/BleDevice.h"
+
+#ifdef __ZEPHYR__
+#include <zephyr.h>
+#endif
+
+#ifndef CONFIG_HERALD_DB_HASH_BUCKETS
+#define CONFIG_HERALD_DB_HASH_BUCKETS 1024
+#endif
+
+/** Marks the end of a bucket chain or of the free list */
+#define BleDbHash_NONE UINT16_MAX
+
+/* BleDbDataStruct_init must be called before use, to set up the index and free list */
+#define BleDbHash_DEF() {0}
+
+typedef struct BleDbHash_entry_s
+{
+    uint16_t next;
+    /**<
+     * The next entry in the same bucket if used,
+     * the next free entry if not used
+     */
+    uint8_t used;
+    /**<
+     * Marks if this data is currently used
+     * 0 for NOT used, not zero if used
+     */
+    BleAddress_t addr;
+    /**< The device address */
+    BleDevice_t dev;
+    /**< The BLE device stored */
+}
+BleDbHash_entry_t;
+
+typedef struct ble_db_hash_s
+{
+    size_t size;
+    /**< The total number of devices used */
+    uint16_t buckets[CONFIG_HERALD_DB_HASH_BUCKETS];
+    /**< The first entry of each bucket's chain, indexed by address hash */
+    uint16_t freeHead;
+    /**< The first entry of the free list */
+    BleDbHash_entry_t entryPool[CONFIG_HERALD_MAX_DEVS_IN_DB];
+    /**< The memory pool of entries */
+#ifdef __ZEPHYR__
+    struct k_spinlock lock;
+    /**< Guards the index only, and is never held while calling out */
+#endif
+}
+BleDbHash_t;
+
+/* Define the type of DB data structure as a hash index */
+typedef BleDbHash_t BleDbDataStruct_t;
+
+/* Make the static definition */
+#define BleDbDataStruct_DEF() BleDbHash_DEF()
+
+#endif /* __BLE_DB_HASH_H__ */
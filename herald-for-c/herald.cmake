@@ -32,6 +32,7 @@ set(HERALD_SOURCES
 
     "${HERALD_BASE}/database/BleDatabase.c"
     "${HERALD_BASE}/database/BleDbArray.c"
+    "${HERALD_BASE}/database/BleDbHash.c"
 
     "${HERALD_BASE}/sys/Timestamp.c"
 
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020-2021 Herald Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+/*
+ * Times the device database data structure selected at compile time
+ * (see CMakeLists.txt) with 32, 256 and 1024 devices:
+ * adding every device, finding every device, and searching for absent devices
+ */
+
+#include "database/BleDbDataStruct.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define MAX_ROUNDS 1000
+
+static BleDbDataStruct_t db;
+static BleAddress_t addrs[CONFIG_HERALD_MAX_DEVS_IN_DB];
+static BleAddress_t absent[CONFIG_HERALD_MAX_DEVS_IN_DB];
+
+static uint64_t prv_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+/* Random, as for resolvable private addresses. Fixed seed, so runs are comparable */
+static void prv_random_addresses(BleAddress_t * into, size_t count, uint32_t seed)
+{
+    size_t i;
+    int j;
+
+    for(i=0; i<count; i++)
+    {
+        for(j=0; j<6; j++)
+        {
+            seed = seed * 1664525UL + 1013904223UL;
+            into[i].val[j] = (uint8_t) (seed >> 24);
+        }
+    }
+}
+
+static void prv_run(size_t devices)
+{
+    size_t i;
+    size_t round;
+    size_t found = 0;
+    size_t rounds = MAX_ROUNDS * 32 / devices;
+    int created;
+    uint64_t start;
+    uint64_t add_ns = 0;
+    uint64_t find_ns;
+    uint64_t miss_ns;
+
+    for(round=0; round<rounds; round++)
+    {
+        BleDbDataStruct_init(&db);
+        start = prv_now_ns();
+        for(i=0; i<devices; i++)
+        {
+            found += BleDbDataStruct_find_or_add(&db, &addrs[i], &created) != NULL;
+        }
+        add_ns += prv_now_ns() - start;
+    }
+
+    start = prv_now_ns();
+    for(round=0; round<rounds; round++)
+    {
+        for(i=0; i<devices; i++)
+        {
+            found += BleDbDataStruct_find(&db, &addrs[i]) != NULL;
+        }
+    }
+    find_ns = prv_now_ns() - start;
+
+    start = prv_now_ns();
+    for(round=0; round<rounds; round++)
+    {
+        for(i=0; i<devices; i++)
+        {
+            found += BleDbDataStruct_find(&db, &absent[i]) != NULL;
+        }
+    }
+    miss_ns = prv_now_ns() - start;
+
+    printf("%-6s %5zu devices: add %8.1f ns, find %8.1f ns, absent %8.1f ns per device (%zu)\n",
+        BENCHMARK_NAME, devices,
+        (double) add_ns / (double) (rounds * devices),
+        (double) find_ns / (double) (rounds * devices),
+        (double) miss_ns / (double) (rounds * devices),
+        found);
+}
+
+int main(void)
+{
+    prv_random_addresses(addrs, CONFIG_HERALD_MAX_DEVS_IN_DB, 1);
+    prv_random_addresses(absent, CONFIG_HERALD_MAX_DEVS_IN_DB, 2);
+
+    prv_run(32);
+    prv_run(256);
+    prv_run(1024);
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2020-2021 Herald Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#ifndef __HOST_ZEPHYR_H__
+#define __HOST_ZEPHYR_H__
+
+/*
+ * The parts of the Zephyr kernel API used by the database, for single threaded
+ * host benchmarks only. Locks always succeed immediately.
+ */
+
+#define K_FOREVER 0
+
+struct k_mutex
+{
+    int locked;
+};
+
+static inline void k_mutex_init(struct k_mutex * mutex)
+{
+    mutex->locked = 0;
+}
+
+static inline int k_mutex_lock(struct k_mutex * mutex, int timeout)
+{
+    (void) timeout;
+    mutex->locked = 1;
+    return 0;
+}
+
+static inline int k_mutex_unlock(struct k_mutex * mutex)
+{
+    mutex->locked = 0;
+    return 0;
+}
+
+#endif /* __HOST_ZEPHYR_H__ */
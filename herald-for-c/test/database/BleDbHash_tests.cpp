@@ -0,0 +1,154 @@
+/*
+ * Copyright 2020-2021 Herald Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+    #include "database/BleDbDataStruct.h"
+}
+
+#define NUM_TEST_DATA 12
+
+static BleDbDataStruct_t db;
+
+static int prv_remove_even_cb(const BleAddress_t * addr, BleDevice_t * dev,
+    void * param1, void * param2)
+{
+    size_t * visited = (size_t*) param1;
+    (void) dev;
+    (void) param2;
+
+    (*visited)++;
+    /* Remove addresses with an even first byte */
+    return (addr->val[0] % 2) == 0;
+}
+
+TEST_GROUP(ble_db_hash)
+{
+    BleAddress_t addrs[NUM_TEST_DATA];
+
+    BleAddress_t base_addr = {
+        .val = {0xAA,1,2,0xFF,4,0xFF}
+    };
+
+    void setup()
+    {
+        BleDbDataStruct_init(&db);
+
+        /* Populate test data, with the first byte as the index */
+        for(size_t i=0; i<NUM_TEST_DATA; i++)
+        {
+            for(int j=0; j<6; j++)
+            {
+                addrs[i].val[j] = rand();
+            }
+            addrs[i].val[0] = i;
+        }
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(ble_db_hash, add_find)
+{
+    BleDevice_t * devs[NUM_TEST_DATA];
+
+    /* Add the items */
+    for(size_t i=0; i<NUM_TEST_DATA; i++)
+    {
+        devs[i] = BleDbDataStruct_add_entry(&db, &addrs[i]);
+        CHECK(devs[i] != NULL);
+        /* Check the size */
+        LONGS_EQUAL(i+1, BleDbDataStruct_get_size(&db));
+    }
+
+    for(size_t i=0; i<NUM_TEST_DATA; i++)
+    {
+        POINTERS_EQUAL(devs[i], BleDbDataStruct_find(&db, &addrs[i]));
+    }
+
+    /* Attempt to find an non existing item */
+    POINTERS_EQUAL(NULL, BleDbDataStruct_find(&db, &base_addr));
+}
+
+TEST(ble_db_hash, find_or_add)
+{
+    int created;
+    BleDevice_t * dev;
+
+    dev = BleDbDataStruct_find_or_add(&db, &addrs[0], &created);
+    CHECK(dev != NULL);
+    LONGS_EQUAL(1, created);
+
+    /* Not added twice */
+    POINTERS_EQUAL(dev, BleDbDataStruct_find_or_add(&db, &addrs[0], &created));
+    LONGS_EQUAL(0, created);
+    LONGS_EQUAL(1, BleDbDataStruct_get_size(&db));
+}
+
+TEST(ble_db_hash, full)
+{
+    int created;
+    BleAddress_t addr = base_addr;
+
+    /* Fill the whole pool */
+    for(size_t i=0; i<CONFIG_HERALD_MAX_DEVS_IN_DB; i++)
+    {
+        addr.val[1] = i;
+        addr.val[2] = i >> 8;
+        CHECK(BleDbDataStruct_find_or_add(&db, &addr, &created) != NULL);
+        LONGS_EQUAL(1, created);
+    }
+    LONGS_EQUAL(CONFIG_HERALD_MAX_DEVS_IN_DB, BleDbDataStruct_get_size(&db));
+
+    /* No more space */
+    POINTERS_EQUAL(NULL, BleDbDataStruct_find_or_add(&db, &addrs[0], &created));
+    LONGS_EQUAL(0, created);
+    POINTERS_EQUAL(NULL, BleDbDataStruct_add_entry(&db, &addrs[0]));
+
+    /* Existing devices are still found */
+    CHECK(BleDbDataStruct_find(&db, &addr) != NULL);
+}
+
+TEST(ble_db_hash, loop_remove)
+{
+    size_t visited = 0;
+
+    for(size_t i=0; i<NUM_TEST_DATA; i++)
+    {
+        CHECK(BleDbDataStruct_add_entry(&db, &addrs[i]) != NULL);
+    }
+
+    BleDbDataStruct_loop_devs(&db, prv_remove_even_cb, &visited, NULL);
+    LONGS_EQUAL(NUM_TEST_DATA, visited);
+    LONGS_EQUAL(NUM_TEST_DATA / 2, BleDbDataStruct_get_size(&db));
+
+    for(size_t i=0; i<NUM_TEST_DATA; i++)
+    {
+        if(i % 2 == 0)
+        {
+            POINTERS_EQUAL(NULL, BleDbDataStruct_find(&db, &addrs[i]));
+        }
+        else
+        {
+            CHECK(BleDbDataStruct_find(&db, &addrs[i]) != NULL);
+        }
+    }
+
+    /* Removed entries are reused */
+    for(size_t i=0; i<NUM_TEST_DATA; i+=2)
+    {
+        CHECK(BleDbDataStruct_add_entry(&db, &addrs[i]) != NULL);
+    }
+    LONGS_EQUAL(NUM_TEST_DATA, BleDbDataStruct_get_size(&db));
+    for(size_t i=0; i<NUM_TEST_DATA; i++)
+    {
+        CHECK(BleDbDataStruct_find(&db, &addrs[i]) != NULL);
+    }
+}
@@ -229,3 +229,137 @@ TEST_CASE("advert-parser-heraldpseudoaddress", "[advert][parser][heraldpseudoadd
     REQUIRE(std::byte(0x30) == heraldData.at(5));
   }
 }
+
+
+// MARK: ZERO COPY ADVERT VIEW
+
+TEST_CASE("advert-view-appletvfg", "[advert][view][appletvfg]") {
+  SECTION("advert-view-appletvfg") {
+    std::uint8_t data[] {
+      0x02, 0x01, 0x1a, 
+      0x02, 0x0a, 0x08,
+      0x0c, 0xff, 0x4c, 0x00,
+      0x10, 0x07, 0x33,
+      0x1f, 0x2c, 0x30, 0x2f, 0x92,
+      0x58
+    };
+    herald::datatype::Data original(data, 19);
+    herald::ble::filter::BLEAdvertView view(original);
+
+    std::vector<herald::ble::filter::BLEAdvertSegmentType> types;
+    for (const auto& segment : view) {
+      types.push_back(segment.type);
+    }
+    REQUIRE(3 == types.size());
+    REQUIRE(types[0] == herald::ble::filter::BLEAdvertSegmentType::flags);
+    REQUIRE(types[1] == herald::ble::filter::BLEAdvertSegmentType::txPowerLevel);
+    REQUIRE(types[2] == herald::ble::filter::BLEAdvertSegmentType::manufacturerData);
+
+    std::uint8_t txPower = 0;
+    REQUIRE(view.txPower(txPower));
+    REQUIRE(0x08 == txPower);
+
+    herald::ble::filter::BLEAdvertManufacturerDataView manu;
+    REQUIRE(view.manufacturerData(0x004c, manu));
+    REQUIRE(9 == manu.data.size());
+    REQUIRE(std::byte(0x10) == manu.data.at(0));
+    REQUIRE(std::byte(0x07) == manu.data.at(1));
+    // Refers to the original memory, not a copy
+    REQUIRE(manu.data.data() == original.rawMemoryStartAddress() + 10);
+    REQUIRE(!view.manufacturerData(0xfaff, manu));
+
+    std::size_t appleCount = 0;
+    REQUIRE(view.manufacturerData(0x004c, manu));
+    for (const auto& appleSegment : herald::ble::filter::BLEAdvertAppleSegments(manu.data)) {
+      ++appleCount;
+      REQUIRE(appleSegment.type == 0x10);
+      REQUIRE(appleSegment.data.size() == 7);
+      REQUIRE("331f2c302f9258" == appleSegment.data.hexEncodedString());
+    }
+    REQUIRE(1 == appleCount);
+
+    // Owning copy matches the vector based parser
+    auto viewSegments = view.toSegments();
+    auto parsedSegments = herald::ble::filter::BLEAdvertParser::extractSegments(original,0);
+    REQUIRE(parsedSegments.size() == viewSegments.size());
+    for (std::size_t i = 0;i < parsedSegments.size();++i) {
+      REQUIRE(parsedSegments[i].type == viewSegments[i].type);
+      REQUIRE(parsedSegments[i].data == viewSegments[i].data);
+    }
+  }
+}
+
+TEST_CASE("advert-view-heraldpseudoaddress", "[advert][view][heraldpseudoaddress]") {
+  SECTION("advert-view-heraldpseudoaddress") {
+    std::uint8_t data[] {
+      0x02, 0x01, 0x1a, 
+      0x02, 0x0a, 0x08,
+      0x09, 0xff, 0xff, 0xfa,
+      0x10, 0x07, 0x33, 0x1f, 0x2c, 0x30
+    };
+    herald::datatype::Data original(data, 16);
+    herald::ble::filter::BLEAdvertView view(original);
+
+    herald::ble::filter::BLEAdvertManufacturerDataView heraldData;
+    REQUIRE(view.manufacturerData(
+      herald::ble::filter::to_integral(herald::ble::filter::BLEAdvertManufacturers::heraldUnregistered),
+      heraldData));
+    REQUIRE(6 == heraldData.data.size());
+    REQUIRE(std::byte(0x10) == heraldData.data.at(0));
+    REQUIRE(std::byte(0x30) == heraldData.data.at(5));
+    herald::datatype::Data expected(data + 10, 6);
+    REQUIRE(heraldData.data == expected);
+    REQUIRE(heraldData.data.toData() == expected);
+  }
+}
+
+TEST_CASE("advert-view-malformed", "[advert][view][malformed]") {
+  SECTION("advert-view-empty") {
+    herald::datatype::Data empty;
+    herald::ble::filter::BLEAdvertView view(empty);
+    REQUIRE(view.begin() == view.end());
+    REQUIRE(view.toSegments().empty());
+  }
+
+  SECTION("advert-view-zerolength-terminates") {
+    // Significant part followed by zero padding, as per the Bluetooth Core Specification
+    std::uint8_t data[] {
+      0x02, 0x01, 0x1a,
+      0x00, 0x00, 0x00, 0x00
+    };
+    herald::ble::filter::BLEAdvertView view(data, 7);
+    std::size_t count = 0;
+    for (const auto& segment : view) {
+      REQUIRE(segment.type == herald::ble::filter::BLEAdvertSegmentType::flags);
+      ++count;
+    }
+    REQUIRE(1 == count);
+  }
+
+  SECTION("advert-view-overlong-segment") {
+    std::uint8_t data[] {
+      0x02, 0x01, 0x1a,
+      0x09, 0xff, 0xff, 0xfa // claims 8 data bytes, only 3 present
+    };
+    herald::ble::filter::BLEAdvertView view(data, 7);
+    std::size_t count = 0;
+    for (auto it = view.begin();it != view.end();++it) {
+      ++count;
+    }
+    REQUIRE(1 == count);
+    herald::ble::filter::BLEAdvertManufacturerDataView manu;
+    REQUIRE(!view.manufacturerData(0xfaff, manu));
+  }
+
+  SECTION("advert-view-apple-missing-length") {
+    // Apple type 0x10 with no length byte must end iteration
+    std::uint8_t data[] { 0x07, 0x00, 0x10 };
+    herald::ble::filter::BLEAdvertDataView manuData(data, 3);
+    std::size_t count = 0;
+    for (const auto& appleSegment : herald::ble::filter::BLEAdvertAppleSegments(manuData.subview(2, 1))) {
+      (void)appleSegment;
+      ++count;
+    }
+    REQUIRE(0 == count);
+  }
+}
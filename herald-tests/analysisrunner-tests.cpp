@@ -93,6 +93,27 @@ private:
   SampleList<Sample<RunningMean<Luminosity>>,25> brightness;
 };
 
+/// Counts analyse() calls, optionally generating a Distance each time
+struct CountingDistanceAnalyser {
+  using input_value_type = RSSI;
+  using output_value_type = Distance;
+
+  CountingDistanceAnalyser() : calls(0), generate(true) {}
+  ~CountingDistanceAnalyser() = default;
+
+  template <std::size_t SrcSz, std::size_t DstSz, typename CallableForNewSample>
+  bool analyse(Date timeNow, SampledID sampled, SampleList<Sample<RSSI>,SrcSz>& src, SampleList<Sample<Distance>,DstSz>& dst, CallableForNewSample& callable) {
+    ++calls;
+    if (generate) {
+      callable.template newSample<Distance>(sampled,Sample<Distance>(timeNow,Distance(1.0)));
+    }
+    return generate;
+  }
+
+  std::size_t calls;
+  bool generate;
+};
+
 TEST_CASE("variantset-basic", "[variantset][basic]") {
   SECTION("variantset-basic") {
     herald::analysis::VariantSet<int,double> vs;
@@ -157,6 +178,175 @@ TEST_CASE("variantset-listmanager", "[variantset][listmanager]") {
   }
 }
 
+TEST_CASE("flatlistmanager-basic", "[flatlistmanager][basic]") {
+  SECTION("flatlistmanager-basic") {
+    herald::analysis::FlatListManager<int,15,8> lm;
+    REQUIRE(lm.size() == 0);
+    REQUIRE(lm.begin() == lm.end());
+
+    // Sequential IDs share probe runs, so this also exercises collisions
+    for (SampledID id = 1;id <= 6;++id) {
+      lm.list(id).push(Sample(int(id * 10),int(id)));
+    }
+    REQUIRE(lm.size() == 6);
+    for (SampledID id = 1;id <= 6;++id) {
+      auto& list = lm.list(id);
+      REQUIRE(list.size() == 1);
+      REQUIRE(list[0].value == int(id));
+    }
+    REQUIRE(lm.size() == 6);
+
+    lm.remove(3);
+    lm.remove(99); // not present
+    REQUIRE(lm.size() == 5);
+    REQUIRE(lm.list(3).size() == 0); // recreated empty
+    lm.remove(3);
+    for (SampledID id : {1,2,4,5,6}) {
+      REQUIRE(lm.list(id).size() == 1);
+      REQUIRE(lm.list(id)[0].value == int(id));
+    }
+
+    std::size_t visited = 0;
+    SampledID idTotal = 0;
+    for (auto&& entry : lm) {
+      ++visited;
+      idTotal += entry.first;
+      REQUIRE(entry.second.size() == 1);
+    }
+    REQUIRE(visited == 5);
+    REQUIRE(idTotal == 18);
+  }
+}
+
+TEST_CASE("flatlistmanager-evict", "[flatlistmanager][evict]") {
+  SECTION("flatlistmanager-evict-full") {
+    herald::analysis::FlatListManager<int,15,4> lm;
+    lm.list(10).push(Sample(400,1));
+    lm.list(20).push(Sample(100,2)); // oldest
+    lm.list(30).push(Sample(300,3));
+    lm.list(40).push(Sample(200,4));
+    REQUIRE(lm.size() == 4);
+
+    // A new source when full replaces the one sampled least recently
+    lm.list(50).push(Sample(500,5));
+    REQUIRE(lm.size() == 4);
+    std::size_t visited = 0;
+    for (auto&& entry : lm) {
+      ++visited;
+      REQUIRE(entry.first != 20);
+    }
+    REQUIRE(visited == 4);
+    REQUIRE(lm.list(10)[0].value == 1);
+    REQUIRE(lm.list(30)[0].value == 3);
+    REQUIRE(lm.list(40)[0].value == 4);
+    REQUIRE(lm.list(50)[0].value == 5);
+  }
+
+  SECTION("flatlistmanager-evict-stale") {
+    herald::analysis::FlatListManager<int,15,8> lm;
+    REQUIRE(lm.staleAfter() == TimeInterval::minutes(15));
+    lm.staleAfter(TimeInterval::seconds(100));
+    lm.list(1).push(Sample(100,1));
+    lm.list(2).push(Sample(250,2));
+    lm.list(3); // never sampled
+    lm.list(4).push(Sample(190,4));
+    REQUIRE(lm.size() == 4);
+
+    lm.evictStale(Date(300));
+    REQUIRE(lm.size() == 1);
+    REQUIRE(lm.list(2)[0].value == 2);
+  }
+}
+
+TEST_CASE("analysisrunner-flat", "[analysisrunner][flat]") {
+  SECTION("analysisrunner-flat") {
+    SampleList<Sample<RSSI>,25> srcData;
+    for (int t = 10;t <= 100;t += 10) {
+      srcData.push(t,-55);
+    }
+    DummySampleSource src(1234,std::move(srcData));
+
+    herald::analysis::algorithms::distance::FowlerBasicAnalyser distanceAnalyser(30, -50, -24);
+
+    DummyDistanceDelegate myDelegate;
+    herald::analysis::AnalysisDelegateManager adm(std::move(myDelegate)); // NOTE: myDelegate MOVED FROM and no longer accessible
+    herald::analysis::AnalysisProviderManager apm(std::move(distanceAnalyser)); // NOTE: distanceAnalyser MOVED FROM and no longer accessible
+
+    // Same as analysisrunner-basic, but with sources held in flat tables
+    herald::analysis::BasicAnalysisRunner<
+      herald::analysis::FlatListStorage<16>,
+      herald::analysis::AnalysisDelegateManager<DummyDistanceDelegate>,
+      herald::analysis::AnalysisProviderManager<herald::analysis::algorithms::distance::FowlerBasicAnalyser>,
+      RSSI,Distance
+    > runner(adm, apm);
+
+    src.run(20,runner);
+    src.run(40,runner);
+    src.run(60,runner);
+    src.run(80,runner);
+    src.run(95,runner);
+
+    auto& delegateRef = adm.get<DummyDistanceDelegate>();
+    REQUIRE(delegateRef.lastSampled() == 1234);
+
+    auto& samples = delegateRef.samples();
+    REQUIRE(samples.size() == 2);
+    REQUIRE(samples[0].taken.secondsSinceUnixEpoch() == 40);
+    REQUIRE(samples[0].value != 0.0);
+    REQUIRE(samples[1].taken.secondsSinceUnixEpoch() == 80);
+    REQUIRE(samples[1].value != 0.0);
+  }
+}
+
+TEST_CASE("analysisrunner-changed-only", "[analysisrunner][changed]") {
+  SECTION("analysisrunner-changed-only") {
+    DummyDistanceDelegate myDelegate;
+    herald::analysis::AnalysisDelegateManager adm(std::move(myDelegate));
+    herald::analysis::AnalysisProviderManager apm(CountingDistanceAnalyser{});
+
+    herald::analysis::AnalysisRunner<
+      herald::analysis::AnalysisDelegateManager<DummyDistanceDelegate>,
+      herald::analysis::AnalysisProviderManager<CountingDistanceAnalyser>,
+      RSSI,Distance
+    > runner(adm, apm);
+    REQUIRE(!runner.analyseUnchanged());
+    auto& analyser = apm.get<CountingDistanceAnalyser>();
+
+    runner.newSample(1,Sample<RSSI>(10,-55));
+    runner.newSample(2,Sample<RSSI>(10,-65));
+    runner.run(Date(10));
+    REQUIRE(analyser.calls == 2);
+
+    // Only the source with new data is analysed
+    runner.newSample(1,Sample<RSSI>(20,-55));
+    runner.run(Date(20));
+    REQUIRE(analyser.calls == 3);
+    runner.run(Date(30));
+    REQUIRE(analyser.calls == 3);
+
+    // A source stays pending until an analysis generates output
+    analyser.generate = false;
+    runner.newSample(2,Sample<RSSI>(40,-65));
+    runner.run(Date(40));
+    REQUIRE(analyser.calls == 4);
+    runner.run(Date(50));
+    REQUIRE(analyser.calls == 5);
+    analyser.generate = true;
+    runner.run(Date(60));
+    REQUIRE(analyser.calls == 6);
+    runner.run(Date(70));
+    REQUIRE(analyser.calls == 6);
+
+    // Every source when requested
+    runner.analyseUnchanged(true);
+    runner.run(Date(80));
+    REQUIRE(analyser.calls == 8);
+
+    auto& delegateRef = adm.get<DummyDistanceDelegate>();
+    REQUIRE(delegateRef.samples().size() == 6);
+  }
+}
+
 /// Null test case with zero data, no failures, correct summary output
 TEST_CASE("analysisrunner-nodata", "[analysisrunner][nodata]") {
   SECTION("analysisrunner-nodata") {
@@ -80,7 +80,7 @@ TEST_CASE("analysissensor-rssi-basic", "[analysissensor][rssi][basic]") {
       RSSI,Distance
     > runner(adm, apm); // just for Sample<RSSI> types, and their produced output (Sample<Distance>)
 
-    herald::analysis::SensorDelegateRSSISource<decltype(runner)> src(runner);
+    herald::analysis::SensorDelegateRSSISource<decltype(runner),herald::SystemClock> src(runner);
     PayloadData payload(std::byte(5),4);
     TargetIdentifier id(Data(std::byte(3),16));
     src.sensor(SensorType::BLE, p1, id, payload);
@@ -135,7 +135,7 @@ TEST_CASE("analysissensor-output", "[sensorlogger][analysissensor][output]") {
       RSSI,Distance
     > runner(adm, apm); // just for Sample<RSSI> types, and their produced output (Sample<Distance>)
 
-    herald::analysis::SensorDelegateRSSISource<decltype(runner)> src(runner);
+    herald::analysis::SensorDelegateRSSISource<decltype(runner)> src(runner, ctx.getClock()); // cached context time
     PayloadData payload(std::byte(5),4);
     TargetIdentifier id(Data(std::byte(3),16));
     src.sensor(SensorType::BLE, p1, id, payload);
@@ -0,0 +1,225 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+namespace {
+
+std::array<std::uint8_t,6> macFor(std::uint8_t last) {
+  return std::array<std::uint8_t,6>{0x11,0x22,0x33,0x44,0x55,last};
+}
+
+}
+
+TEST_CASE("ble-advertqueue-empty", "[ble][advertqueue][empty]") {
+  SECTION("ble-advertqueue-empty") {
+    herald::ble::BLEAdvertQueue<8> queue;
+    REQUIRE(queue.empty());
+    REQUIRE(queue.size() == 0);
+    std::size_t calls = 0;
+    REQUIRE(queue.drain([&calls] (const auto&) { ++calls; }) == 0);
+    REQUIRE(calls == 0);
+    REQUIRE(queue.pushed() == 0);
+    REQUIRE(queue.dropped() == 0);
+  }
+}
+
+TEST_CASE("ble-advertqueue-fifo", "[ble][advertqueue][fifo]") {
+  SECTION("ble-advertqueue-fifo") {
+    herald::ble::BLEAdvertQueue<8> queue;
+    std::uint8_t bytes[] = {0x02,0x01,0x06};
+    for (std::uint8_t i = 0;i < 5;++i) {
+      auto mac = macFor(i);
+      bytes[2] = i;
+      REQUIRE(queue.push(mac.data(), -50 - i, 0, bytes, sizeof(bytes)));
+    }
+    REQUIRE(queue.size() == 5);
+
+    std::vector<std::uint8_t> order;
+    REQUIRE(queue.drain([&order] (const auto& advert) {
+      REQUIRE(advert.length == 3);
+      REQUIRE(advert.bytes[2] == advert.mac[5]);
+      REQUIRE(advert.rssi == -50 - advert.mac[5]);
+      order.push_back(advert.mac[5]);
+    }) == 5);
+    REQUIRE(order == std::vector<std::uint8_t>{0,1,2,3,4});
+    REQUIRE(queue.empty());
+    REQUIRE(queue.pushed() == 5);
+    REQUIRE(queue.deduplicated() == 0);
+  }
+}
+
+TEST_CASE("ble-advertqueue-full", "[ble][advertqueue][full]") {
+  SECTION("ble-advertqueue-full") {
+    herald::ble::BLEAdvertQueue<4> queue;
+    std::uint8_t bytes[] = {0x01};
+    for (std::uint8_t i = 0;i < 4;++i) {
+      auto mac = macFor(i);
+      REQUIRE(queue.push(mac.data(), -60, 0, bytes, sizeof(bytes)));
+    }
+    auto mac = macFor(9);
+    REQUIRE(!queue.push(mac.data(), -60, 0, bytes, sizeof(bytes)));
+    REQUIRE(!queue.push(mac.data(), -60, 0, bytes, sizeof(bytes)));
+    REQUIRE(queue.dropped() == 2);
+    REQUIRE(queue.pushed() == 4);
+
+    // Space again once drained, and wraps around the ring
+    std::size_t seen = 0;
+    REQUIRE(queue.drain([&seen] (const auto&) { ++seen; }, 3) == 3);
+    REQUIRE(seen == 3);
+    REQUIRE(queue.push(mac.data(), -60, 0, bytes, sizeof(bytes)));
+    std::vector<std::uint8_t> last;
+    REQUIRE(queue.drain([&last] (const auto& advert) { last.push_back(advert.mac[5]); }) == 2);
+    REQUIRE(last == std::vector<std::uint8_t>{3,9});
+  }
+}
+
+TEST_CASE("ble-advertqueue-truncate", "[ble][advertqueue][truncate]") {
+  SECTION("ble-advertqueue-truncate") {
+    herald::ble::BLEAdvertQueue<4,8> queue;
+    std::uint8_t bytes[12] = {1,2,3,4,5,6,7,8,9,10,11,12};
+    auto mac = macFor(1);
+    REQUIRE(queue.push(mac.data(), -70, 0, bytes, sizeof(bytes)));
+    REQUIRE(queue.truncated() == 1);
+    queue.drain([] (const auto& advert) {
+      REQUIRE(advert.length == 8);
+      REQUIRE(advert.bytes[7] == 8);
+    });
+  }
+}
+
+TEST_CASE("ble-advertqueue-deduplicate", "[ble][advertqueue][deduplicate]") {
+  SECTION("ble-advertqueue-deduplicate") {
+    herald::ble::BLEAdvertQueue<16> queue;
+    std::uint8_t bytes[] = {0x01};
+    auto a = macFor(0xaa);
+    auto b = macFor(0xbb);
+    queue.push(a.data(), -80, 0, bytes, 1);
+    queue.push(b.data(), -81, 0, bytes, 1);
+    queue.push(a.data(), -82, 0, bytes, 1);
+    queue.push(a.data(), -83, 4, bytes, 1); // different advert type (E.g. scan response) is kept
+    queue.push(a.data(), -84, 0, bytes, 1);
+
+    std::vector<std::int8_t> rssis;
+    REQUIRE(queue.drain([&rssis] (const auto& advert) { rssis.push_back(advert.rssi); }) == 5);
+    // Latest from each source, in the order they arrived
+    REQUIRE(rssis == std::vector<std::int8_t>{-81,-83,-84});
+    REQUIRE(queue.deduplicated() == 2);
+
+    // Not de-duplicated across batches
+    queue.push(a.data(), -85, 0, bytes, 1);
+    rssis.clear();
+    queue.drain([&rssis] (const auto& advert) { rssis.push_back(advert.rssi); });
+    REQUIRE(rssis == std::vector<std::int8_t>{-85});
+    REQUIRE(queue.deduplicated() == 2);
+  }
+
+  SECTION("ble-advertqueue-deduplicate-rssi") {
+    herald::ble::BLEAdvertQueue<16> queue;
+    std::uint8_t bytes[] = {0x01};
+    auto a = macFor(0xaa);
+    auto b = macFor(0xbb);
+    queue.push(a.data(), -80, 0, bytes, 1);
+    queue.push(b.data(), -81, 0, bytes, 1);
+    queue.push(a.data(), -82, 0, bytes, 1);
+    queue.push(a.data(), -83, 4, bytes, 1);
+    queue.push(a.data(), -84, 0, bytes, 1);
+
+    // Every RSSI reaches the handler, superseded ones first
+    std::vector<std::int8_t> rssis;
+    REQUIRE(queue.drain([&rssis] (const auto& advert, const std::int8_t* earlierRssi, std::size_t earlierCount) {
+      rssis.insert(rssis.end(), earlierRssi, earlierRssi + earlierCount);
+      rssis.push_back(advert.rssi);
+    }) == 5);
+    REQUIRE(rssis == std::vector<std::int8_t>{-81,-83,-80,-82,-84});
+
+    auto counters = queue.counters();
+    REQUIRE(counters.pushed == 5);
+    REQUIRE(counters.dropped == 0);
+    REQUIRE(counters.truncated == 0);
+    REQUIRE(counters.deduplicated == 2);
+  }
+
+  SECTION("ble-advertqueue-deduplicate-fullbatch") {
+    // Sources sharing most MAC bytes, repeated across full batches, so buckets collide and are reused
+    herald::ble::BLEAdvertQueue<64> queue;
+    std::uint8_t bytes[] = {0x01};
+    for (int round = 0;round < 3;++round) {
+      for (int i = 0;i < 64;++i) {
+        auto mac = macFor(std::uint8_t(i % 20));
+        queue.push(mac.data(), std::int8_t(-(i + round)), 0, bytes, 1);
+      }
+      std::vector<std::uint8_t> sources;
+      std::size_t total = 0;
+      bool ordered = true;
+      REQUIRE(queue.drain([&] (const auto& advert, const std::int8_t* earlierRssi, std::size_t earlierCount) {
+        sources.push_back(advert.mac[5]);
+        total += earlierCount + 1;
+        // Each source's RSSI arrives oldest first, 20 pushes apart
+        for (std::size_t e = 0;e < earlierCount;++e) {
+          const int expected = -(int(advert.mac[5]) + 20 * int(e) + round);
+          ordered = ordered && expected == earlierRssi[e];
+        }
+      }) == 64);
+      REQUIRE(ordered);
+      REQUIRE(total == 64);
+      // The latest of sources 0..3 came last, at positions 60..63
+      REQUIRE(sources.size() == 20);
+      REQUIRE(sources.front() == 4);
+      REQUIRE(sources.back() == 3);
+    }
+    REQUIRE(queue.deduplicated() == 3 * 44);
+  }
+}
+
+TEST_CASE("ble-advertqueue-stress", "[ble][advertqueue][stress]") {
+  SECTION("ble-advertqueue-stress") {
+    // One producer thread pushing as fast as it can, one consumer draining in batches
+    herald::ble::BLEAdvertQueue<64> queue;
+    constexpr std::uint32_t total = 200'000;
+    constexpr std::uint8_t sources = 8;
+
+    std::thread producer([&queue] {
+      std::uint8_t bytes[4];
+      for (std::uint32_t seq = 0;seq < total;++seq) {
+        std::memcpy(bytes, &seq, 4);
+        auto mac = macFor((std::uint8_t)(seq % sources));
+        queue.push(mac.data(), -60, 0, bytes, 4);
+      }
+    });
+
+    std::array<std::int64_t,sources> lastSeen;
+    lastSeen.fill(-1);
+    std::size_t removed = 0;
+    std::size_t delivered = 0;
+    bool ordered = true;
+    auto handler = [&] (const auto& advert) {
+      std::uint32_t seq;
+      std::memcpy(&seq, advert.bytes.data(), 4);
+      const std::uint8_t source = advert.mac[5];
+      ordered = ordered && advert.length == 4 && source == seq % sources && (std::int64_t)seq > lastSeen[source];
+      lastSeen[source] = seq;
+      ++delivered;
+    };
+    while (queue.pushed() + queue.dropped() < total) {
+      removed += queue.drain(handler, 16);
+    }
+    producer.join();
+    removed += queue.drain(handler);
+
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+    REQUIRE(queue.pushed() + queue.dropped() == total);
+    REQUIRE(removed == queue.pushed());
+    REQUIRE(delivered + queue.deduplicated() == queue.pushed());
+  }
+}
@@ -0,0 +1,126 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+#include <vector>
+
+using namespace herald::datatype;
+using namespace herald::ble;
+
+namespace {
+
+using Scheduler = BLEConnectionScheduler<128>;
+
+TargetIdentifier schedulerTarget(std::uint8_t value) {
+  return TargetIdentifier(Data(std::byte(value),6));
+}
+
+BLEConnectionCandidate newContact(std::uint8_t value, int rssi) {
+  return BLEConnectionCandidate{schedulerTarget(value), herald::engine::Priorities::High,
+    false, TimeInterval::never(), RSSI(rssi), value};
+}
+
+BLEConnectionCandidate knownContact(std::uint8_t value, long payloadAgeSeconds, int rssi) {
+  return BLEConnectionCandidate{schedulerTarget(value), herald::engine::Priorities::High,
+    true, TimeInterval::seconds(payloadAgeSeconds), RSSI(rssi), value};
+}
+
+}
+
+TEST_CASE("bleconnectionscheduler-score", "[ble][scheduler][score]") {
+  SECTION("bleconnectionscheduler-score") {
+    // Priority outweighs everything else
+    auto important = knownContact(1, 0, -99);
+    important.priority = herald::engine::Priorities::Critical;
+    REQUIRE(Scheduler::score(important) > Scheduler::score(newContact(2, -30)));
+    // A new contact outweighs a payload refresh, however stale or close
+    REQUIRE(Scheduler::score(newContact(1, -99)) > Scheduler::score(knownContact(2, 86400, -30)));
+    // Staler payloads come first
+    REQUIRE(Scheduler::score(knownContact(1, 1200, -70)) > Scheduler::score(knownContact(2, 600, -70)));
+    // Then stronger signals
+    REQUIRE(Scheduler::score(newContact(1, -50)) > Scheduler::score(newContact(2, -80)));
+    // An unknown RSSI adds nothing
+    REQUIRE(Scheduler::score(newContact(1, 0)) < Scheduler::score(newContact(2, -99)));
+  }
+}
+
+TEST_CASE("bleconnectionscheduler-budget", "[ble][scheduler][budget]") {
+  SECTION("bleconnectionscheduler-budget") {
+    Scheduler scheduler(2);
+    REQUIRE(scheduler.budget() == 2);
+    std::vector<BLEConnectionCandidate> candidates;
+    candidates.push_back(knownContact(1, 3600, -40));
+    candidates.push_back(newContact(2, -90));
+    candidates.push_back(knownContact(3, 60, -40));
+    candidates.push_back(newContact(4, -60));
+    scheduler.schedule(candidates);
+    REQUIRE(candidates.size() == 2);
+    REQUIRE(candidates[0].target == schedulerTarget(4));
+    REQUIRE(candidates[1].target == schedulerTarget(2));
+    REQUIRE(scheduler.passedOver(1) == 1);
+    REQUIRE(scheduler.passedOver(2) == 0);
+    REQUIRE(scheduler.passedOver(3) == 1);
+
+    // Fewer candidates than the budget are all kept
+    std::vector<BLEConnectionCandidate> few(1, newContact(5, -70));
+    scheduler.schedule(few);
+    REQUIRE(few.size() == 1);
+    // Devices that stopped asking for a connection are forgotten
+    REQUIRE(scheduler.passedOver(1) == 0);
+    REQUIRE(scheduler.passedOver(3) == 0);
+  }
+}
+
+TEST_CASE("bleconnectionscheduler-aging", "[ble][scheduler][aging]") {
+  SECTION("bleconnectionscheduler-aging") {
+    // One slot, a steady stream of closer new contacts, and one stale payload
+    Scheduler scheduler(1);
+    std::size_t iterations = 0;
+    bool staleChosen = false;
+    while (!staleChosen && iterations < 20) {
+      std::vector<BLEConnectionCandidate> candidates;
+      candidates.push_back(knownContact(1, 3600, -90));
+      candidates.push_back(newContact(std::uint8_t(100 + iterations), -40));
+      scheduler.schedule(candidates);
+      REQUIRE(candidates.size() == 1);
+      staleChosen = candidates.front().target == schedulerTarget(1);
+      ++iterations;
+    }
+    REQUIRE(staleChosen);
+    REQUIRE(iterations < 20);
+    REQUIRE(scheduler.passedOver(1) == 0);
+  }
+}
+
+TEST_CASE("bleconnectionscheduler-slotreuse", "[ble][scheduler][slot]") {
+  SECTION("bleconnectionscheduler-slotreuse") {
+    Scheduler scheduler(1);
+    std::vector<BLEConnectionCandidate> candidates;
+    candidates.push_back(newContact(1, -40));
+    candidates.push_back(newContact(2, -90));
+    scheduler.schedule(candidates);
+    REQUIRE(scheduler.passedOver(2) == 1);
+
+    // A different device now occupies slot 2, so it does not inherit the aging
+    auto replacement = newContact(3, -90);
+    replacement.slot = 2;
+    candidates.clear();
+    candidates.push_back(newContact(1, -40));
+    candidates.push_back(replacement);
+    scheduler.schedule(candidates);
+    REQUIRE(candidates.front().target == schedulerTarget(1));
+    REQUIRE(scheduler.passedOver(2) == 1);
+
+    // Candidates with a slot outside the database are never scheduled
+    auto stray = newContact(4, -30);
+    stray.slot = 128;
+    candidates.clear();
+    candidates.push_back(stray);
+    scheduler.schedule(candidates);
+    REQUIRE(candidates.empty());
+  }
+}
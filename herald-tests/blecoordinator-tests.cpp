@@ -227,6 +227,41 @@ TEST_CASE("blecoordinator-two-mixed-no-id", "[coordinator][two-mixed-no-id][basi
   }
 }
 
+TEST_CASE("blecoordinator-connection-budget", "[coordinator][connection-budget][basic]") {
+  SECTION("blecoordinator-connection-budget") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    herald::Context ctx(dpt,dls,dbsm); // default context include
+    using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+    herald::ble::ConcreteBLEDatabase<CT,64> db(ctx);
+    NoOpHeraldV1ProtocolProvider pp(ctx,db);
+    herald::ble::HeraldProtocolBLECoordinationProvider coord(ctx,db,pp);
+
+    // More new devices nearby than there are connections available
+    const std::size_t budget = std::size_t(ctx.getSensorConfiguration().maxBluetoothConnections);
+    const std::size_t deviceCount = budget + 10;
+    for (std::size_t i = 0;i < deviceCount;++i) {
+      herald::datatype::Data devMac(std::byte(i + 1),6);
+      herald::ble::BLEDevice& dev = db.device(herald::datatype::TargetIdentifier(devMac));
+      dev.rssi(herald::datatype::RSSI(-40 - int(i)));
+    }
+
+    // Closest devices first
+    auto conns = coord.requiredConnections();
+    REQUIRE(conns.size() == budget);
+    REQUIRE(std::get<2>(conns.front()).value() == herald::datatype::TargetIdentifier(herald::datatype::Data(std::byte(1),6)));
+
+    // Those passed over are aged ahead of those just connected to
+    conns = coord.requiredConnections();
+    REQUIRE(conns.size() == budget);
+    for (std::size_t i = 0;i < deviceCount - budget;++i) {
+      herald::datatype::Data expected(std::byte(budget + i + 1),6);
+      REQUIRE(std::get<2>(conns[i]).value() == herald::datatype::TargetIdentifier(expected));
+    }
+  }
+}
+
 TEST_CASE("blecoordinator-got-os-and-id", "[coordinator][got-os-and-id][basic]") {
   SECTION("blecoordinator-got-os-and-id") {
     DummyLoggingSink dls;
@@ -405,4 +405,147 @@ TEST_CASE("ble-database-device-bymac", "[ble][database][device][bymac]") {
     REQUIRE(sameDev.identifier() == ti2);
     REQUIRE(devPtrti2.payloadData() == pl);
   }
-}
\ No newline at end of file
+}
+TEST_CASE("ble-database-eviction-lru", "[ble][database][eviction][lru]") {
+  SECTION("ble-database-eviction-lru") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    herald::Context ctx(dpt,dls,dbsm); // default context include
+    using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+    herald::ble::ConcreteBLEDatabase<CT,3> db(ctx);
+    DummyBLEDBDelegate delegate;
+    db.add(delegate);
+
+    herald::datatype::TargetIdentifier ti1(herald::datatype::Data(std::byte(0x01),6));
+    herald::datatype::TargetIdentifier ti2(herald::datatype::Data(std::byte(0x02),6));
+    herald::datatype::TargetIdentifier ti3(herald::datatype::Data(std::byte(0x03),6));
+    herald::datatype::TargetIdentifier ti4(herald::datatype::Data(std::byte(0x04),6));
+
+    db.device(ti1);
+    db.device(ti2);
+    db.device(ti3);
+    REQUIRE(db.size() == 3);
+    REQUIRE(delegate.deleteCallbackCalled == false);
+
+    // Use the first device again, so the second is now the least recently used
+    herald::ble::BLEDevice& dev1 = db.device(ti1);
+    REQUIRE(dev1.identifier() == ti1);
+
+    herald::ble::BLEDevice& dev4 = db.device(ti4);
+    REQUIRE(db.size() == 3);
+    REQUIRE(delegate.deleteCallbackCalled == true);
+    REQUIRE(dev4.identifier() == ti4);
+
+    auto remaining = db.matches([&ti2](const herald::ble::BLEDevice& d) {
+      return d.identifier() == ti2;
+    });
+    REQUIRE(remaining.size() == 0);
+    remaining = db.matches([&ti1](const herald::ble::BLEDevice& d) {
+      return d.identifier() == ti1;
+    });
+    REQUIRE(remaining.size() == 1);
+
+    // Removal frees the slot without an eviction
+    delegate.deleteCallbackCalled = false;
+    db.remove(ti3);
+    REQUIRE(db.size() == 2);
+    REQUIRE(delegate.deleteCallbackCalled == true);
+    delegate.deleteCallbackCalled = false;
+    db.device(ti2);
+    REQUIRE(db.size() == 3);
+    REQUIRE(delegate.deleteCallbackCalled == false);
+  }
+}
+
+TEST_CASE("ble-database-device-bypseudo", "[ble][database][device][bypseudo]") {
+  SECTION("ble-database-device-bypseudo") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    herald::Context ctx(dpt,dls,dbsm); // default context include
+    using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+    herald::ble::ConcreteBLEDatabase<CT> db(ctx);
+
+    herald::ble::BLEMacAddress mac1(herald::datatype::Data(std::byte(0x01),6));
+    herald::ble::BLEMacAddress mac2(herald::datatype::Data(std::byte(0x02),6));
+    herald::ble::BLEMacAddress pseudo(herald::datatype::Data(std::byte(0x0a),6));
+
+    herald::ble::BLEDevice& first = db.device(mac1,pseudo);
+    REQUIRE(db.size() == 1);
+    REQUIRE(first.pseudoDeviceAddress().has_value());
+    REQUIRE(first.pseudoDeviceAddress().value() == pseudo);
+
+    // Same pseudo address seen from a rotated mac returns the same device
+    herald::ble::BLEDevice& second = db.device(mac2,pseudo);
+    REQUIRE(db.size() == 1);
+    REQUIRE(&first == &second);
+
+    // Removing the device removes it from the pseudo index too
+    db.remove(first.identifier());
+    REQUIRE(db.size() == 0);
+    herald::ble::BLEDevice& third = db.device(mac2,pseudo);
+    REQUIRE(db.size() == 1);
+    REQUIRE(third.pseudoDeviceAddress().value() == pseudo);
+  }
+}
+
+TEST_CASE("ble-database-device-bypayload", "[ble][database][device][bypayload]") {
+  SECTION("ble-database-device-bypayload") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    herald::Context ctx(dpt,dls,dbsm); // default context include
+    using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+    herald::ble::ConcreteBLEDatabase<CT> db(ctx);
+
+    // A payload read from a device found by mac is then found by payload
+    herald::ble::BLEDevice& byMac = db.device(herald::datatype::TargetIdentifier(herald::datatype::Data(std::byte(0x01),6)));
+    herald::datatype::PayloadData payload(std::byte(0x19),20);
+    byMac.payloadData(payload);
+    REQUIRE(&db.device(payload) == &byMac);
+    REQUIRE(db.size() == 1);
+
+    // A changed payload moves its index entry
+    herald::datatype::PayloadData changed(std::byte(0x20),20);
+    byMac.payloadData(changed);
+    REQUIRE(&db.device(changed) == &byMac);
+    herald::ble::BLEDevice& fresh = db.device(payload);
+    REQUIRE(&fresh != &byMac);
+    REQUIRE(db.size() == 2);
+
+    // Removing the device removes it from the payload index too
+    db.remove(byMac.identifier());
+    REQUIRE(db.size() == 1);
+    herald::ble::BLEDevice& recreated = db.device(changed);
+    REQUIRE(recreated.payloadData() == changed);
+    REQUIRE(db.size() == 2);
+  }
+}
+
+TEST_CASE("ble-database-clock", "[ble][database][clock]") {
+  SECTION("ble-database-clock") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    herald::FakeClock fake(herald::datatype::Date{1000});
+    using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager,herald::FakeClock>;
+    CT ctx(dpt,dls,dbsm,fake);
+    herald::ble::ConcreteBLEDatabase<CT> db(ctx);
+
+    herald::datatype::Data devMac(std::byte(0x02),6);
+    herald::datatype::TargetIdentifier dev(devMac);
+    herald::ble::BLEDevice& device = db.device(dev);
+    REQUIRE(device.lastUpdatedAt().secondsSinceUnixEpoch() == 1000);
+
+    // Device times follow the context's cached now, not the system clock
+    fake.advance(herald::datatype::TimeInterval::seconds(20));
+    REQUIRE(device.timeIntervalSinceLastUpdate().millis() == 0);
+    ctx.getClock().refresh();
+    REQUIRE(device.timeIntervalSinceLastUpdate().millis() == 20'000);
+
+    device.txPower(herald::ble::BLETxPower(12));
+    REQUIRE(device.lastUpdatedAt().secondsSinceUnixEpoch() == 1020);
+    REQUIRE(device.timeIntervalSinceLastUpdate().millis() == 0);
+  }
+}
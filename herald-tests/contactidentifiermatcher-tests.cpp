@@ -0,0 +1,110 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+#include <vector>
+
+using namespace herald::datatype;
+using namespace herald::payload::simple;
+
+TEST_CASE("payload-simple-matcher-k", "[payload][simple][matcher][k]") {
+  SECTION("payload-simple-matcher-k") {
+    // 70 keys spans two work items of lockstep hashing
+    const std::size_t keyCount = 70;
+    const std::size_t keyLength = 64;
+    std::vector<std::uint8_t> keys(keyCount * keyLength);
+    for (std::size_t i = 0;i < keys.size();++i) {
+      keys[i] = std::uint8_t(i * 13 + i / keyLength);
+    }
+    const int daysFor = 10;
+    const int periods = 6;
+    ContactIdentifierMatcher matcher(daysFor, periods, 4);
+    REQUIRE(matcher.threads() == 4);
+    // Includes days beyond daysFor, which repeat the top seed's identifiers
+    matcher.build(keys.data(), keyLength, keyCount, 8, 11);
+    REQUIRE(matcher.size() == keyCount * 4 * periods);
+
+    K k(int(keyLength), daysFor, periods);
+    const std::size_t checkedKeys[] {0, 1, 63, 64, 69};
+    std::vector<ContactIdentifier> observed;
+    std::vector<std::size_t> expectedKeys;
+    for (auto key : checkedKeys) {
+      SecretKey secretKey(keys.data() + key * keyLength, keyLength);
+      for (int day = 8;day <= 10;++day) {
+        for (int period = 0;period < periods;++period) {
+          observed.push_back(k.contactIdentifier(secretKey, day, period));
+          expectedKeys.push_back(key);
+        }
+      }
+    }
+    // Unknown identifier, and a real identifier for a day outside the table
+    observed.push_back(ContactIdentifier(std::byte(7), 16));
+    observed.push_back(k.contactIdentifier(SecretKey(keys.data(), keyLength), 5, 0));
+
+    auto matches = matcher.match(observed);
+    // Day 10 (daysFor) identifiers also appear as day 11
+    REQUIRE(matches.size() == std::size(checkedKeys) * 4 * periods);
+    std::size_t m = 0;
+    for (std::size_t o = 0;o < expectedKeys.size();++o) {
+      const int day = 8 + int(o / periods) % 3;
+      const int period = int(o % periods);
+      INFO("observation " << o);
+      REQUIRE(m < matches.size());
+      REQUIRE(matches[m].observation == o);
+      REQUIRE(matches[m].key == expectedKeys[o]);
+      REQUIRE(matches[m].period == period);
+      if (day < daysFor) {
+        REQUIRE(matches[m].day == day);
+        ++m;
+      } else {
+        REQUIRE(matches[m + 1].observation == o);
+        REQUIRE(matches[m].day + matches[m + 1].day == 21); // days 10 and 11
+        m += 2;
+      }
+    }
+    REQUIRE(m == matches.size());
+  }
+}
+
+TEST_CASE("payload-simple-matcher-data", "[payload][simple][matcher][data]") {
+  SECTION("payload-simple-matcher-data") {
+    std::vector<SecretKey> keys;
+    keys.emplace_back(std::byte(1), 32);
+    keys.emplace_back(std::byte(2), 32);
+    keys.emplace_back(std::byte(3), 16); // wrong length, skipped
+
+    ContactIdentifierMatcher single(20, 24, 1);
+    ContactIdentifierMatcher multi(20, 24, 8);
+    single.build(keys, 0, 2);
+    multi.build(keys, 0, 2);
+    REQUIRE(single.size() == 2 * 3 * 24);
+    REQUIRE(multi.size() == single.size());
+
+    K k(32, 20, 24);
+    std::vector<ContactIdentifier> observed;
+    observed.push_back(k.contactIdentifier(keys[1], 0, 23));
+    observed.push_back(k.contactIdentifier(keys[2], 0, 23));
+    observed.push_back(k.contactIdentifier(keys[0], 2, 0));
+    for (auto* matcher : {&single, &multi}) {
+      auto matches = matcher->match(observed);
+      REQUIRE(matches.size() == 2);
+      REQUIRE(matches[0].observation == 0);
+      REQUIRE(matches[0].key == 1);
+      REQUIRE(matches[0].day == 0);
+      REQUIRE(matches[0].period == 23);
+      REQUIRE(matches[1].observation == 2);
+      REQUIRE(matches[1].key == 0);
+      REQUIRE(matches[1].day == 2);
+      REQUIRE(matches[1].period == 0);
+    }
+
+    // Rebuilding with no keys empties the table
+    single.build(std::vector<SecretKey>(), 0, 2);
+    REQUIRE(single.size() == 0);
+    REQUIRE(single.match(observed).empty());
+  }
+}
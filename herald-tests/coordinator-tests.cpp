@@ -6,6 +6,11 @@
 #include <vector>
 #include <optional>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "test-templates.h"
 
@@ -328,3 +333,297 @@ TEST_CASE("coordinator-complex-iterations", "[coordinator][iterations][complex]"
 
   c.stop();
 }
+
+/// Provides (or required) a single feature, recording what it is asked to do
+class RecordingCoordinationProvider : public herald::engine::CoordinationProvider {
+public:
+  RecordingCoordinationProvider(std::vector<herald::engine::FeatureTag> provides,
+    std::vector<herald::engine::PrioritisedPrerequisite> required,
+    std::vector<herald::engine::Activity> acts)
+    : provides(provides), required(required), acts(acts), requested()
+  {}
+  ~RecordingCoordinationProvider() = default;
+
+  std::vector<herald::engine::FeatureTag> connectionsProvided() override {
+    return provides;
+  }
+  std::vector<herald::engine::PrioritisedPrerequisite> provision(
+    const std::vector<herald::engine::PrioritisedPrerequisite>& requestedNow) override {
+    requested.push_back(requestedNow);
+    return requestedNow; // everything requested is provisioned
+  }
+  std::vector<herald::engine::PrioritisedPrerequisite> requiredConnections() override {
+    return required;
+  }
+  std::vector<herald::engine::Activity> requiredActivities() override {
+    return acts;
+  }
+
+  std::vector<herald::engine::FeatureTag> provides;
+  std::vector<herald::engine::PrioritisedPrerequisite> required;
+  std::vector<herald::engine::Activity> acts;
+  std::vector<std::vector<herald::engine::PrioritisedPrerequisite>> requested;
+};
+
+TEST_CASE("coordinator-planning", "[coordinator][iterations][planning]") {
+  DummyLoggingSink dls;
+  DummyBluetoothStateManager dbsm;
+  herald::DefaultPlatformType dpt;
+  herald::Context ctx(dpt,dls,dbsm);
+  using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+
+  herald::engine::FeatureTag feature = herald::engine::Features::HeraldBluetoothProtocolConnection;
+  herald::datatype::TargetIdentifier device1(herald::datatype::Data(std::byte(0x1d),6));
+  herald::datatype::TargetIdentifier device2(herald::datatype::Data(std::byte(0x1f),6));
+  herald::datatype::TargetIdentifier device3(herald::datatype::Data(std::byte(0x09),6));
+
+  std::vector<std::string> executed;
+  auto activity = [&executed] (std::string name, herald::engine::Priority priority,
+    herald::datatype::TargetIdentifier target) -> herald::engine::Activity {
+    return herald::engine::Activity{priority, name,
+      {herald::engine::Prerequisite(herald::engine::Features::HeraldBluetoothProtocolConnection, target)},
+      [&executed] (const herald::engine::Activity act) -> std::optional<herald::engine::Activity> {
+        executed.push_back(act.name);
+        return {};
+      }};
+  };
+
+  RecordingCoordinationProvider connections({feature}, {}, {});
+  // Requests device1 twice (at two priorities) and device2 once. device3 is never connected.
+  RecordingCoordinationProvider low({}, {
+      {feature, herald::engine::Priorities::Low, device1},
+      {feature, herald::engine::Priorities::Default, device2}
+    }, {
+      activity("low-device1", herald::engine::Priorities::Low, device1),
+      activity("critical-device3", herald::engine::Priorities::Critical, device3)
+    });
+  RecordingCoordinationProvider high({}, {
+      {feature, herald::engine::Priorities::High, device1}
+    }, {
+      activity("high-device2", herald::engine::Priorities::High, device2)
+    });
+
+  MockSensor<RecordingCoordinationProvider> s1(connections);
+  MockSensor<RecordingCoordinationProvider> s2(low);
+  MockSensor<RecordingCoordinationProvider> s3(high);
+  herald::engine::Coordinator<CT> c(ctx);
+  c.add(s1);
+  c.add(s2);
+  c.add(s3);
+  c.start();
+
+  for (int iteration = 1;iteration <= 3;++iteration) {
+    executed.clear();
+    c.iteration();
+
+    // One de-duplicated, priority ordered request per iteration, to the feature's provider only
+    REQUIRE(connections.requested.size() == std::size_t(iteration));
+    REQUIRE(low.requested.size() == std::size_t(iteration));
+    REQUIRE(low.requested.back().empty());
+    auto& requested = connections.requested.back();
+    REQUIRE(requested.size() == 2);
+    REQUIRE(std::get<1>(requested[0]) == herald::engine::Priorities::High);
+    REQUIRE(std::get<2>(requested[0]) == device1);
+    REQUIRE(std::get<1>(requested[1]) == herald::engine::Priorities::Default);
+    REQUIRE(std::get<2>(requested[1]) == device2);
+
+    // Activities run in descending priority order, only once their prerequisites are provisioned
+    REQUIRE(executed.size() == 2);
+    REQUIRE(executed[0] == "high-device2");
+    REQUIRE(executed[1] == "low-device1");
+  }
+  c.stop();
+}
+
+TEST_CASE("coordinator-follow-on", "[coordinator][iterations][followon]") {
+  DummyLoggingSink dls;
+  DummyBluetoothStateManager dbsm;
+  herald::DefaultPlatformType dpt;
+  herald::Context ctx(dpt,dls,dbsm);
+  using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+
+  // Returns itself as a follow-on forever, which must be cut off at MaxFollowOns
+  std::size_t calls = 0;
+  herald::engine::Activity repeating{herald::engine::Priorities::Default, "repeating", {},
+    [&calls] (const herald::engine::Activity act) -> std::optional<herald::engine::Activity> {
+      ++calls;
+      return act;
+    }};
+  RecordingCoordinationProvider provider({}, {}, {repeating});
+  MockSensor<RecordingCoordinationProvider> sensor(provider);
+  herald::engine::Coordinator<CT> c(ctx);
+  REQUIRE(c.execution() == herald::engine::CoordinatorExecution::synchronous);
+  c.add(sensor);
+  c.start();
+  c.iteration();
+  REQUIRE(calls == 1 + herald::engine::Coordinator<CT>::MaxFollowOns);
+  c.stop();
+}
+
+#ifdef HERALD_COORDINATOR_ASYNC
+/// Does not finish provisioning until released by the test, as a provider held up by a slow connection would
+class BlockingCoordinationProvider : public RecordingCoordinationProvider {
+public:
+  using RecordingCoordinationProvider::RecordingCoordinationProvider;
+
+  std::vector<herald::engine::PrioritisedPrerequisite> provision(
+    const std::vector<herald::engine::PrioritisedPrerequisite>& requestedNow) override {
+    ++calls;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      entered = true;
+      changed.notify_all();
+      changed.wait(lock, [this] { return released; });
+    }
+    auto result = RecordingCoordinationProvider::provision(requestedNow);
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    changed.notify_all();
+    return result;
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    released = true;
+    changed.notify_all();
+  }
+
+  /// The timeouts only stop a broken coordinator hanging the tests. They are never expected to pass.
+  bool waitUntilEntered() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::seconds(10), [this] { return entered; });
+  }
+
+  bool waitUntilFinished() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::seconds(10), [this] { return finished; });
+  }
+
+  std::atomic<int> calls = 0;
+
+private:
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool entered = false;
+  bool released = false;
+  bool finished = false;
+};
+
+TEST_CASE("coordinator-async", "[coordinator][iterations][async]") {
+  DummyLoggingSink dls;
+  DummyBluetoothStateManager dbsm;
+  herald::DefaultPlatformType dpt;
+  herald::Context ctx(dpt,dls,dbsm);
+  using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+
+  herald::engine::FeatureTag fastFeature = herald::engine::Features::HeraldBluetoothProtocolConnection;
+  herald::engine::FeatureTag slowFeature(std::byte(0x02),1);
+  herald::datatype::TargetIdentifier device1(herald::datatype::Data(std::byte(0x1d),6));
+  herald::datatype::TargetIdentifier device2(herald::datatype::Data(std::byte(0x1f),6));
+
+  std::atomic<int> fastSteps(0);
+  std::atomic<int> slowSteps(0);
+  // Runs a chain of three follow-ons after the first step
+  herald::engine::Activity fast{herald::engine::Priorities::High, "fast",
+    {herald::engine::Prerequisite(fastFeature, device1)},
+    [&fastSteps] (const herald::engine::Activity act) -> std::optional<herald::engine::Activity> {
+      if (0 != (++fastSteps % 4)) {
+        return act;
+      }
+      return {};
+    }};
+  herald::engine::Activity slow{herald::engine::Priorities::Default, "slow",
+    {herald::engine::Prerequisite(slowFeature, device2)},
+    [&slowSteps] (const herald::engine::Activity) -> std::optional<herald::engine::Activity> {
+      ++slowSteps;
+      return {};
+    }};
+
+  RecordingCoordinationProvider fastProvider({fastFeature}, {}, {});
+  BlockingCoordinationProvider slowProvider({slowFeature}, {}, {});
+  RecordingCoordinationProvider requirer({}, {
+      {fastFeature, herald::engine::Priorities::High, device1},
+      {slowFeature, herald::engine::Priorities::Default, device2}
+    }, {fast, slow});
+  MockSensor<RecordingCoordinationProvider> s1(fastProvider);
+  MockSensor<BlockingCoordinationProvider> s2(slowProvider);
+  MockSensor<RecordingCoordinationProvider> s3(requirer);
+  herald::engine::Coordinator<CT> c(ctx);
+  c.add(s1);
+  c.add(s2);
+  c.add(s3);
+  // Generous, so the fast provider is never late. The blocked provider is given up on after it.
+  c.execution(herald::engine::CoordinatorExecution::asynchronous, std::chrono::milliseconds(500));
+  REQUIRE(c.execution() == herald::engine::CoordinatorExecution::asynchronous);
+  c.start();
+
+  // The blocked provider does not hold up the fast provider's activity (or its follow-ons)
+  c.iteration();
+  REQUIRE(slowProvider.waitUntilEntered());
+  REQUIRE(fastSteps == 4);
+  REQUIRE(slowSteps == 0);
+
+  // A provider still provisioning is not called again, or waited for
+  c.iteration();
+  REQUIRE(fastSteps == 8);
+  REQUIRE(fastProvider.requested.size() == 2);
+  REQUIRE(slowProvider.calls == 1);
+  REQUIRE(slowSteps == 0);
+
+  // Stopping waits for outstanding work
+  slowProvider.release();
+  c.stop();
+  REQUIRE(slowProvider.requested.size() == 1);
+}
+
+/// On its second call, releases a blocked provider and waits for it to finish before listing its prerequisites
+class ReleasingCoordinationProvider : public RecordingCoordinationProvider {
+public:
+  ReleasingCoordinationProvider(BlockingCoordinationProvider& blocked,
+    std::vector<herald::engine::PrioritisedPrerequisite> required)
+    : RecordingCoordinationProvider({}, required, {}), blocked(blocked), calls(0)
+  {}
+
+  std::vector<herald::engine::PrioritisedPrerequisite> requiredConnections() override {
+    if (2 == ++calls) {
+      blocked.release();
+      blocked.waitUntilFinished();
+    }
+    return RecordingCoordinationProvider::requiredConnections();
+  }
+
+  BlockingCoordinationProvider& blocked;
+  int calls; // only called from the iteration's thread
+};
+
+TEST_CASE("coordinator-async-finishes-mid-iteration", "[coordinator][iterations][async]") {
+  DummyLoggingSink dls;
+  DummyBluetoothStateManager dbsm;
+  herald::DefaultPlatformType dpt;
+  herald::Context ctx(dpt,dls,dbsm);
+  using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+
+  herald::engine::FeatureTag slowFeature(std::byte(0x02),1);
+  herald::datatype::TargetIdentifier device2(herald::datatype::Data(std::byte(0x1f),6));
+
+  BlockingCoordinationProvider slowProvider({slowFeature}, {}, {});
+  ReleasingCoordinationProvider requirer(slowProvider, {{slowFeature, herald::engine::Priorities::Default, device2}});
+  MockSensor<BlockingCoordinationProvider> s1(slowProvider);
+  MockSensor<ReleasingCoordinationProvider> s2(requirer);
+  herald::engine::Coordinator<CT> c(ctx);
+  c.add(s1);
+  c.add(s2);
+  c.execution(herald::engine::CoordinatorExecution::asynchronous, std::chrono::milliseconds(50));
+  c.start();
+
+  c.iteration(); // provisioning blocks beyond the timeout
+  REQUIRE(slowProvider.waitUntilEntered());
+  // Busy when this iteration starts, and finishes whilst prerequisites are gathered. Must not
+  // then be provisioned with nothing, which would tear down the connections it just made.
+  c.iteration();
+  c.stop();
+  REQUIRE(slowProvider.calls == 1);
+  REQUIRE(slowProvider.requested.size() == 1);
+  REQUIRE(slowProvider.requested[0].size() == 1);
+}
+#endif
@@ -683,3 +683,113 @@ TEST_CASE("datatypes-data-equals", "[datatypes][data][equals]") {
     REQUIRE(((d4 > d3) & (d3 < d4)) | ((d3 > d4) & (d4 < d3)));
   }
 }
+
+TEST_CASE("datatypes-data-compare", "[datatypes][data][compare]") {
+  SECTION("datatypes-data-compare") {
+    uint8_t a[] = {1,2,3,4};
+    uint8_t b[] = {1,2,4};
+    uint8_t c[] = {1,2,3,4,0};
+    herald::datatype::Data da(a, 4);
+    herald::datatype::Data db(b, 3);
+    herald::datatype::Data dc(c, 5);
+    herald::datatype::Data empty;
+
+    // Byte order first, then size
+    REQUIRE(da.compare(da) == 0);
+    REQUIRE(da.compare(db) < 0);
+    REQUIRE(db.compare(da) > 0);
+    REQUIRE(da.compare(dc) < 0);
+    REQUIRE(dc.compare(da) > 0);
+    REQUIRE(empty.compare(da) < 0);
+    REQUIRE(empty.compare(herald::datatype::Data()) == 0);
+    REQUIRE(da < db);
+    REQUIRE(db > da);
+    REQUIRE(da < dc);
+    REQUIRE(!(da < da));
+    REQUIRE(!(da > da));
+    REQUIRE(empty == herald::datatype::Data());
+    REQUIRE(empty != da);
+  }
+}
+
+TEST_CASE("datatypes-data-hash", "[datatypes][data][hash]") {
+  SECTION("datatypes-data-hash-lengths") {
+    // Covers each tail length either side of the 32 byte stripes
+    std::vector<std::uint8_t> raw(100);
+    for (std::size_t i = 0;i < raw.size();++i) {
+      raw[i] = std::uint8_t(i * 7);
+    }
+    for (std::size_t length = 1;length <= raw.size();++length) {
+      herald::datatype::Data d1(raw.data(), length);
+      herald::datatype::Data d2(raw.data(), length);
+      REQUIRE(d1.hashCode() == d2.hashCode());
+      REQUIRE(d1.hashCode() == std::hash<herald::datatype::Data>{}(d2));
+
+      // Every byte contributes
+      herald::datatype::Data changed(raw.data(), length);
+      changed.rawMemoryStartAddress()[length - 1] ^= 1;
+      REQUIRE(d1.hashCode() != changed.hashCode());
+      REQUIRE(d1 != changed);
+
+      herald::datatype::Data shorter(raw.data(), length - 1);
+      REQUIRE(d1.hashCode() != shorter.hashCode());
+    }
+  }
+
+  SECTION("datatypes-data-hash-seed") {
+    uint8_t raw[] = {0,1,2,3,4,5,6,7,8,9};
+    REQUIRE(herald::datatype::hashBytes(raw, 10, 1) == herald::datatype::hashBytes(raw, 10, 1));
+    REQUIRE(herald::datatype::hashBytes(raw, 10, 1) != herald::datatype::hashBytes(raw, 10, 2));
+    REQUIRE(herald::datatype::hashBytes(nullptr, 0, 1) != herald::datatype::hashBytes(nullptr, 0, 2));
+  }
+}
+
+TEST_CASE("datatypes-payloaddata-hash", "[datatypes][payloaddata][hash]") {
+  SECTION("datatypes-payloaddata-hash-cached") {
+    herald::datatype::PayloadData payload(std::byte(5), 20);
+    herald::datatype::Data data(std::byte(5), 20);
+    REQUIRE(payload.hashCode() == data.hashCode());
+
+    // Copies keep the calculated value
+    herald::datatype::PayloadData copy(payload);
+    REQUIRE(copy.hashCode() == data.hashCode());
+    herald::datatype::PayloadData assigned;
+    assigned = payload;
+    REQUIRE(assigned.hashCode() == data.hashCode());
+  }
+
+  SECTION("datatypes-payloaddata-hash-mutated") {
+    herald::datatype::PayloadData payload(std::byte(5), 20);
+    const std::size_t before = payload.hashCode();
+
+    payload.append(std::uint8_t(6));
+    herald::datatype::Data data(std::byte(5), 20);
+    data.append(std::uint8_t(6));
+    REQUIRE(payload.hashCode() != before);
+    REQUIRE(payload.hashCode() == data.hashCode());
+
+    herald::datatype::Data other(std::byte(7), 21);
+    payload.assign(other);
+    REQUIRE(payload.hashCode() == other.hashCode());
+
+    payload.assign(data);
+    REQUIRE(payload.hashCode() == data.hashCode());
+
+    payload.clear();
+    REQUIRE(payload.hashCode() == herald::datatype::Data().hashCode());
+  }
+
+  SECTION("datatypes-payloaddata-hash-rawwrite") {
+    herald::datatype::PayloadData payload(std::byte(5), 20);
+    const std::size_t before = payload.hashCode();
+    // Raw access is available on a non const payload, and only costs a rehash
+    const unsigned char* bytes = payload.rawMemoryStartAddress();
+    REQUIRE(bytes[0] == 5);
+    REQUIRE(payload.hashCode() == before);
+
+    payload.rawMemoryStartAddress()[19] = 6;
+    herald::datatype::Data data(std::byte(5), 19);
+    data.append(std::uint8_t(6));
+    REQUIRE(payload.hashCode() == data.hashCode());
+  }
+}
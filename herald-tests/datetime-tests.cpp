@@ -2,10 +2,14 @@
 //  SPDX-License-Identifier: Apache-2.0
 //
 
+#include "test-templates.h"
+
 #include "catch.hpp"
 
 #include "herald/herald.h"
 
+#include <type_traits>
+
 
 TEST_CASE("datatypes-date-basics", "[datatypes][date][basics]") {
   SECTION("datatypes-date-basics") {
@@ -98,4 +102,71 @@ TEST_CASE("datatypes-timeinterval-daterelative", "[datatypes][timeinterval][ctor
     herald::datatype::Date advanced = earlier + difference;
     REQUIRE(advanced == now);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("clock-fake-basics", "[clock][fake][basics]") {
+  SECTION("clock-fake-basics") {
+    herald::FakeClock clock(herald::datatype::Date{1608483600});
+    REQUIRE(clock.now().secondsSinceUnixEpoch() == 1608483600);
+    REQUIRE(clock.ticks() == 0);
+
+    clock.advance(herald::datatype::TimeInterval::seconds(30));
+    REQUIRE(clock.now().secondsSinceUnixEpoch() == 1608483630);
+    REQUIRE(clock.ticks() == 30'000);
+
+    // Setting the wall clock (E.g. replaying a log) doesn't move ticks
+    clock.set(herald::datatype::Date{1000});
+    REQUIRE(clock.now().secondsSinceUnixEpoch() == 1000);
+    REQUIRE(clock.ticks() == 30'000);
+
+    // Never goes backwards
+    clock.advance(herald::datatype::TimeInterval::seconds(-5));
+    REQUIRE(clock.ticks() == 30'000);
+  }
+}
+
+TEST_CASE("clock-system-ticks-monotonic", "[clock][system][ticks]") {
+  SECTION("clock-system-ticks-monotonic") {
+    herald::SystemClock clock;
+    auto first = clock.ticks();
+    auto second = clock.ticks();
+    REQUIRE(second >= first);
+  }
+}
+
+TEST_CASE("clock-cached-refresh", "[clock][cached][refresh]") {
+  SECTION("clock-cached-refresh") {
+    static_assert(!std::is_convertible_v<herald::datatype::Date,herald::FakeClock>);
+    herald::FakeClock source(herald::datatype::Date{1000});
+    herald::CachedClock<herald::FakeClock> clock(source);
+    REQUIRE(clock.now().secondsSinceUnixEpoch() == 1000);
+
+    source.advance(herald::datatype::TimeInterval::seconds(10));
+    REQUIRE(clock.now().secondsSinceUnixEpoch() == 1000); // still cached
+    REQUIRE(clock.ticks() == 10'000); // not cached
+
+    REQUIRE(clock.refresh().secondsSinceUnixEpoch() == 1010);
+    REQUIRE(clock.now().secondsSinceUnixEpoch() == 1010);
+
+    herald::CachedClock<herald::FakeClock> copy(clock);
+    REQUIRE(copy.now().secondsSinceUnixEpoch() == 1010);
+    REQUIRE(&copy.source() == &source);
+  }
+}
+
+TEST_CASE("clock-context-injected", "[clock][context][injected]") {
+  SECTION("clock-context-injected") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    herald::FakeClock fake(herald::datatype::Date{5000});
+    herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager,herald::FakeClock> ctx(dpt,dls,dbsm,fake);
+    REQUIRE(ctx.getNow().secondsSinceUnixEpoch() == 5000);
+
+    fake.advance(herald::datatype::TimeInterval::minutes(1));
+    REQUIRE(ctx.getNow().secondsSinceUnixEpoch() == 5000);
+    ctx.getClock().refresh();
+    REQUIRE(ctx.getNow().secondsSinceUnixEpoch() == 5060);
+    REQUIRE(ctx.getClock().ticks() == 60'000);
+  }
+}
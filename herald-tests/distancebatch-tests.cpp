@@ -0,0 +1,120 @@
+//  Copyright 2021 Herald project contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+#include <random>
+#include <vector>
+
+using namespace herald::analysis::algorithms::distance;
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+namespace {
+
+using RSSIList = SampleList<Sample<RSSI>,50>;
+
+/// Runs FowlerBasicAnalyser over src as the AnalysisRunner would, returning its output if any
+std::vector<Sample<Distance>> analyseOne(FowlerBasicAnalyser& analyser, Date timeNow, SampledID sampled, RSSIList& src) {
+  SampleList<Sample<Distance>,5> dst;
+  std::vector<Sample<Distance>> produced;
+  auto callable = [&produced](SampledID, const Sample<Distance>& sample) {
+    produced.push_back(sample);
+  };
+  analyser.analyse(timeNow, sampled, src, dst, callable);
+  return produced;
+}
+
+}
+
+TEST_CASE("distancebatch-empty", "[distancebatch][empty]") {
+  FowlerBatch batch;
+  std::vector<FowlerEstimate> estimates;
+  batch.estimate(estimates);
+  REQUIRE(estimates.size() == 0);
+
+  std::int8_t invalid[] = {0, -5, -100, 20};
+  batch.add(invalid, 4, 0);
+  batch.add(invalid, 0, 0);
+  REQUIRE(batch.size() == 2);
+  batch.estimate(estimates);
+  REQUIRE(estimates.size() == 2);
+  REQUIRE(!estimates[0].hasDistance);
+  REQUIRE(!estimates[1].hasDistance);
+
+  batch.clear();
+  REQUIRE(batch.size() == 0);
+  REQUIRE(FowlerBatch::toValue(-300) == 0);
+  REQUIRE(FowlerBatch::toValue(-60) == -60);
+}
+
+TEST_CASE("distancebatch-matches-analyser", "[distancebatch][fowler]") {
+  std::mt19937 random(12345);
+  std::uniform_int_distribution<int> lengths(0, 50);
+  std::uniform_int_distribution<int> centres(-90, -20);
+  std::uniform_int_distribution<int> spread(-6, 6);
+  std::uniform_int_distribution<int> noise(0, 9);
+
+  // Enough sources for several groups of lanes plus a remainder
+  const std::size_t sourceCount = 37;
+  std::vector<RSSIList> sources(sourceCount);
+  for (auto& src : sources) {
+    const int length = lengths(random);
+    const int centre = centres(random);
+    for (int t = 0;t < length;++t) {
+      int value = centre + spread(random);
+      if (0 == noise(random)) {
+        value = 0; // invalid, as from a device not reporting RSSI
+      }
+      src.push(Date(1000 + 2 * std::uint64_t(t)), RSSI(value));
+    }
+  }
+  sources[1].clear();
+  sources[2].clear();
+  sources[2].push(Date(1000), RSSI(-60)); // single value, so an undefined variance
+
+  SECTION("distancebatch-matches-analyser-first-run") {
+    FowlerBatch batch(-50, -24);
+    for (auto& src : sources) {
+      batch.add(src, Date(0));
+    }
+    std::vector<FowlerEstimate> estimates;
+    batch.estimate(estimates);
+    REQUIRE(estimates.size() == sourceCount);
+
+    for (std::size_t idx = 0;idx < sourceCount;++idx) {
+      FowlerBasicAnalyser analyser(30, -50, -24);
+      auto produced = analyseOne(analyser, Date(2000), 1, sources[idx]);
+      REQUIRE(estimates[idx].hasDistance == !produced.empty());
+      if (!produced.empty()) {
+        REQUIRE(estimates[idx].distance == produced.front().value.value);
+      }
+    }
+  }
+
+  SECTION("distancebatch-matches-analyser-since-last-run") {
+    FowlerBatch batch(-50, -24);
+    const Date lastRan(1040);
+    for (auto& src : sources) {
+      batch.add(src, lastRan);
+    }
+    std::vector<FowlerEstimate> estimates;
+    batch.estimate(estimates);
+
+    for (std::size_t idx = 0;idx < sourceCount;++idx) {
+      // Prime the analyser's last run time with data up to lastRan only
+      FowlerBasicAnalyser analyser(30, -50, -24);
+      RSSIList earlier;
+      earlier.push(lastRan, RSSI(-50));
+      analyseOne(analyser, Date(2000), 2, earlier);
+      auto produced = analyseOne(analyser, Date(3000), 1, sources[idx]);
+      REQUIRE(estimates[idx].hasDistance == !produced.empty());
+      if (!produced.empty()) {
+        REQUIRE(estimates[idx].distance == produced.front().value.value);
+      }
+    }
+  }
+}
@@ -8,6 +8,10 @@
 
 #include "test-templates.h"
 
+#include <array>
+#include <atomic>
+#include <vector>
+
 using namespace herald::analysis::sampling;
 using namespace herald::datatype;
 
@@ -29,6 +33,26 @@ TEST_CASE("exposure-empty", "[exposure][empty]") {
   }
 }
 
+TEST_CASE("exposure-risk-clock-anchor", "[exposure][risk][clock]") {
+  SECTION("exposure-risk-clock-anchor") {
+    // Periods are anchored on the given clock's time, rather than the system clock's
+    herald::FakeClock fc(Date{1000});
+    herald::CachedClock<herald::FakeClock> clock(fc);
+    fc.advance(TimeInterval::seconds(60)); // not refreshed, so still 1000
+
+    NoOptPassthrough nopt;
+    DummyExposureCallbackHandlerNoOpt dh{nopt};
+    herald::exposure::FixedMemoryExposureStore<8> des;
+    herald::exposure::ExposureManager<DummyExposureCallbackHandlerNoOpt, herald::exposure::FixedMemoryExposureStore<8>> em(dh,des,clock);
+    REQUIRE(em.getGlobalPeriodAnchor() == Date{1000});
+
+    herald::exposure::model::SampleDiseaseScreeningRiskModel sampleRM;
+    herald::exposure::FixedMemoryRiskStore<8> rs;
+    herald::exposure::RiskManager rm{herald::exposure::RiskModels{sampleRM}, herald::exposure::RiskParameters<8>{}, rs, clock};
+    REQUIRE(rm.getGlobalPeriodAnchor() == Date{1000});
+  }
+}
+
 
 TEST_CASE("exposure-callback-handler", "[exposure][callback][handler]") {
   SECTION("exposure-callback-handler") {
@@ -211,6 +235,347 @@ TEST_CASE("exposure-time-periods", "[exposure][periods][window]") {
   }
 }
 
+TEST_CASE("exposure-changed-slices", "[exposure][periods][window][changes]") {
+  NoOptPassthrough nopt;
+  DummyExposureCallbackHandlerNoOpt dh{nopt};
+  herald::exposure::FixedMemoryExposureStore<8> des;
+  herald::exposure::ExposureManager<DummyExposureCallbackHandlerNoOpt, herald::exposure::FixedMemoryExposureStore<8>> em(dh,des);
+  REQUIRE(em.setGlobalPeriodInterval(0,120)); // 120 second windows starting at DateTime==0
+
+  herald::datatype::UUID proxInstanceId = 
+    herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111");
+  REQUIRE(em.addSource<RSSIMinute>(
+    herald::datatype::agent::humanProximity, 
+    sensorClass::bluetoothProximityHerald, proxInstanceId));
+  em.enableRunning();
+
+  auto expose = [&em] (std::uint64_t taken, double value) {
+    em.applyAdditionalExposure(1234, Sample<RSSIMinute>{Date(taken), RSSIMinute(value)});
+  };
+  auto notified = [&dh, &em] () {
+    dh.currentExposureValue = 0;
+    dh.timesCalled = 0;
+    return em.notifyOfChanges();
+  };
+
+  // Several changes to one source are coalesced into one notification
+  expose(0,1);
+  expose(60,2);
+  expose(120,4); // closes the first period
+  REQUIRE(notified());
+  REQUIRE(1 == dh.timesCalled);
+  REQUIRE(dh.currentExposureValue == 7);
+  REQUIRE(2 == em.getCountByInstanceId(proxInstanceId));
+
+  // Only the changed exposure is passed, not the unchanged earlier period
+  expose(180,8);
+  REQUIRE(notified());
+  REQUIRE(1 == dh.timesCalled);
+  REQUIRE(dh.currentExposureValue == 12);
+
+  // Closing a period passes both the closed and the new exposure
+  expose(240,16);
+  REQUIRE(notified());
+  REQUIRE(dh.currentExposureValue == 28);
+
+  // Nothing changed, so nothing notified
+  REQUIRE(!notified());
+  REQUIRE(0 == dh.timesCalled);
+}
+
+/// \brief Receives every changed source in a single exposureLevelsChanged() call
+struct BatchExposureCallbackHandler {
+  template <typename BatchT>
+  void exposureLevelsChanged(const BatchT& batch) noexcept {
+    ++timesCalled;
+    batch.forEach([this] (const herald::datatype::ExposureMetadata& meta, auto& iter, auto& end) {
+      ++sources;
+      for (;iter != end;++iter) {
+        currentExposureValue += iter->value;
+      }
+    });
+  }
+
+  std::size_t timesCalled = 0;
+  std::size_t sources = 0;
+  double currentExposureValue = 0;
+};
+
+TEST_CASE("exposure-changed-batch", "[exposure][periods][window][changes]") {
+  BatchExposureCallbackHandler dh;
+  herald::exposure::FixedMemoryExposureStore<8> des;
+  herald::exposure::ExposureManager<BatchExposureCallbackHandler, herald::exposure::FixedMemoryExposureStore<8>> em(dh,des);
+  REQUIRE(em.setGlobalPeriodInterval(0,120));
+
+  REQUIRE(em.addSource<RSSIMinute>(
+    herald::datatype::agent::humanProximity, 
+    sensorClass::bluetoothProximityHerald,
+    herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111")));
+  REQUIRE(em.addSource<Luminosity>(
+    herald::datatype::agent::lightBrightness, 
+    sensorClass::luninositySingleChannelLums,
+    herald::datatype::UUID::fromString("88888888-1111-4011-8011-111111111111")));
+  em.enableRunning();
+
+  // Changes to both sources are delivered together
+  em.applyAdditionalExposure(1234, Sample<RSSIMinute>{Date(0), RSSIMinute(1)});
+  em.applyAdditionalExposure(1234, Sample<RSSIMinute>{Date(60), RSSIMinute(2)});
+  em.applyAdditionalExposure(1234, Sample<Luminosity>{Date(30), Luminosity(4)});
+  REQUIRE(em.notifyOfChanges());
+  REQUIRE(1 == dh.timesCalled);
+  REQUIRE(2 == dh.sources);
+  REQUIRE(dh.currentExposureValue == 7);
+
+  // Only changed sources are in the batch (here with the closed and the new period)
+  em.applyAdditionalExposure(1234, Sample<Luminosity>{Date(150), Luminosity(8)});
+  REQUIRE(em.notifyOfChanges());
+  REQUIRE(2 == dh.timesCalled);
+  REQUIRE(3 == dh.sources);
+  REQUIRE(dh.currentExposureValue == 19);
+
+  // Nothing changed, so no call
+  REQUIRE(!em.notifyOfChanges());
+  REQUIRE(2 == dh.timesCalled);
+}
+
+/// \brief A risk model whose dependency depends upon the exposure value, so is not dependsOnAgentOnly
+struct ThresholdRiskModel {
+  static constexpr AlgorithmId algorithmId{2};
+
+  bool potentiallyDirty(const Agent& agent, const Exposure& exposure) const noexcept {
+    return agent == herald::datatype::agent::humanProximity && exposure.value >= 10.0;
+  }
+
+  template <typename RiskParametersT, typename ExposureSourceT, typename RiskSinkT>
+  bool produce(const RiskParametersT& riskParameters, const ExposureSourceT& exposures, const Date startTime, const Date endTime, const TimeInterval periodicity, RiskSinkT& sink) noexcept {
+    sink.score(RiskScore{
+      .periodStart = startTime,
+      .periodEnd = endTime,
+      .value = 1.0,
+      .confidence = 1.0
+    });
+    return true;
+  }
+};
+
+TEST_CASE("risk-dependent-models", "[exposure][risk][changes]") {
+  using RiskManagerT = herald::exposure::RiskManager<
+    herald::exposure::RiskModels<herald::exposure::model::SampleDiseaseScreeningRiskModel>,
+    herald::exposure::RiskParameters<8>,
+    8,
+    herald::exposure::FixedMemoryRiskStore<8>
+  >;
+  herald::exposure::model::SampleDiseaseScreeningRiskModel sampleRM;
+  herald::exposure::RiskModels models{sampleRM};
+  herald::exposure::RiskParameters<8> myStats;
+  herald::exposure::FixedMemoryRiskStore<8> riskStore;
+  herald::exposure::FixedMemoryExposureStore<8> des;
+  RiskManagerT rm{std::move(models), std::move(myStats), riskStore};
+  rm.setGlobalPeriodInterval(Date{0}, TimeInterval::seconds(120));
+
+  herald::datatype::ExposureMetadata proxMeta{
+    .agentId = herald::datatype::agent::humanProximity,
+    .sensorClassId = sensorClass::bluetoothProximityHerald,
+    .sensorInstanceId = herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111"),
+    .modelClassId = herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111")
+  };
+  herald::datatype::ExposureMetadata otherMeta = proxMeta;
+  otherMeta.agentId = herald::datatype::Agent{77}; // not used by the sample model
+  std::vector<Exposure> changed{
+    Exposure{.periodStart = Date(0), .periodEnd = Date(120), .value = 45},
+    Exposure{.periodStart = Date(120), .periodEnd = Date(240), .value = 45}
+  };
+  auto inject = [&rm, &des, &changed] (const herald::datatype::ExposureMetadata& meta) {
+    auto iter = changed.begin();
+    auto end = changed.end();
+    rm.injectExposureChanges(des, meta, iter, end);
+  };
+
+  // Dependencies calculated before any model is added must not hide later models
+  inject(proxMeta);
+  herald::datatype::UUID sampleRMID = 
+    herald::datatype::UUID::fromString("77777777-1111-4011-8011-134341111111");
+  REQUIRE(rm.addRiskModel(sampleRMID, herald::datatype::Agent{55}, sampleRM));
+
+  // Exposure to an agent the model does not use does not make it dirty
+  inject(otherMeta);
+  rm.refreshDirtyScores(des);
+  REQUIRE(0 == rm.getRiskScoreCount(sampleRMID));
+
+  // Risk scores are produced over the whole changed period
+  inject(proxMeta);
+  rm.refreshDirtyScores(des);
+  REQUIRE(2 == rm.getRiskScoreCount(sampleRMID));
+
+  // The adapter receives all of an ExposureManager's changes in one batch
+  using RMECA = herald::exposure::RiskManagerExposureCallbackAdapter<RiskManagerT, herald::exposure::FixedMemoryExposureStore<8>>;
+  RMECA adapter{rm, des};
+  herald::exposure::ExposureManager<RMECA, herald::exposure::FixedMemoryExposureStore<8>> em(adapter,des);
+  REQUIRE(em.setGlobalPeriodInterval(0,120));
+  REQUIRE(em.addSource<RSSIMinute>(proxMeta.agentId, sensorClass::bluetoothProximityHerald, proxMeta.sensorInstanceId));
+  em.enableRunning();
+  em.applyAdditionalExposure(1234, Sample<RSSIMinute>{Date(300), RSSIMinute(10)});
+  REQUIRE(em.notifyOfChanges());
+  rm.refreshDirtyScores(des);
+  REQUIRE(2 < rm.getRiskScoreCount(sampleRMID));
+}
+
+TEST_CASE("risk-exposure-dependent-models", "[exposure][risk][changes]") {
+  REQUIRE(herald::exposure::dependsOnAgentOnly<herald::exposure::model::SampleDiseaseScreeningRiskModel>());
+  REQUIRE(!herald::exposure::dependsOnAgentOnly<ThresholdRiskModel>());
+
+  using RiskManagerT = herald::exposure::RiskManager<
+    herald::exposure::RiskModels<ThresholdRiskModel>,
+    herald::exposure::RiskParameters<8>,
+    8,
+    herald::exposure::FixedMemoryRiskStore<8>
+  >;
+  ThresholdRiskModel thresholdRM;
+  herald::exposure::RiskModels models{thresholdRM};
+  herald::exposure::RiskParameters<8> myStats;
+  herald::exposure::FixedMemoryRiskStore<8> riskStore;
+  herald::exposure::FixedMemoryExposureStore<8> des;
+  RiskManagerT rm{std::move(models), std::move(myStats), riskStore};
+  herald::datatype::UUID thresholdRMID = 
+    herald::datatype::UUID::fromString("77777777-1111-4011-8011-134341111112");
+  REQUIRE(rm.addRiskModel(thresholdRMID, herald::datatype::Agent{55}, thresholdRM));
+
+  herald::datatype::ExposureMetadata proxMeta{
+    .agentId = herald::datatype::agent::humanProximity,
+    .sensorClassId = sensorClass::bluetoothProximityHerald,
+    .sensorInstanceId = herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111"),
+    .modelClassId = herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111")
+  };
+  auto inject = [&rm, &des, &proxMeta] (std::vector<Exposure> changed) {
+    auto iter = changed.begin();
+    auto end = changed.end();
+    rm.injectExposureChanges(des, proxMeta, iter, end);
+  };
+  std::vector<RiskScore> scores;
+  auto refresh = [&rm, &des, &scores, &thresholdRMID] () {
+    rm.refreshDirtyScores(des);
+    scores.clear();
+    rm.forEachRiskScore(thresholdRMID, [&scores] (const herald::datatype::RiskScoreMetadata& meta, const RiskScore& score) {
+      scores.push_back(score);
+    });
+  };
+
+  // The first exposure alone must not decide for the whole agent
+  inject({
+    Exposure{.periodStart = Date(0), .periodEnd = Date(120), .value = 1},
+    Exposure{.periodStart = Date(120), .periodEnd = Date(240), .value = 20}
+  });
+  refresh();
+  REQUIRE(1 == scores.size());
+  // Only over the period of the exposure the model depends upon
+  REQUIRE(120 == scores[0].periodStart.secondsSinceUnixEpoch());
+  REQUIRE(240 == scores[0].periodEnd.secondsSinceUnixEpoch());
+
+  // Nor is an earlier answer reused for later exposures
+  inject({
+    Exposure{.periodStart = Date(240), .periodEnd = Date(360), .value = 2}
+  });
+  refresh();
+  REQUIRE(1 == scores.size());
+}
+
+#ifdef HERALD_RISK_MANAGER_PARALLEL
+TEST_CASE("risk-refresh-pool", "[exposure][risk][parallel]") {
+  herald::exposure::RefreshPool pool(4);
+  REQUIRE(4 == pool.threads());
+  std::vector<std::atomic<int>> calls(1000);
+  auto work = [&calls] (std::size_t item) { ++calls[item]; };
+  for (int run = 0;run < 10;++run) {
+    pool.run(calls.size(), work);
+  }
+  pool.run(0, work);
+  for (auto& count : calls) {
+    REQUIRE(10 == count);
+  }
+}
+
+TEST_CASE("risk-parallel-refresh", "[exposure][risk][parallel]") {
+  auto numberedInstance = [] (std::size_t number) {
+    std::array<std::uint8_t,16> data{};
+    data[15] = std::uint8_t(number);
+    return UUID(data);
+  };
+  using RiskManagerT = herald::exposure::RiskManager<
+    herald::exposure::RiskModels<herald::exposure::model::SampleDiseaseScreeningRiskModel>,
+    herald::exposure::RiskParameters<8>,
+    8,
+    herald::exposure::FixedMemoryRiskStore<8>
+  >;
+  herald::exposure::model::SampleDiseaseScreeningRiskModel sampleRM;
+
+  // Six periods of proximity and light exposures
+  herald::exposure::IndexedExposureStore<4,16> des;
+  std::vector<Exposure> changed;
+  for (const auto& agent : {herald::datatype::agent::humanProximity, herald::datatype::agent::lightBrightness}) {
+    herald::datatype::ExposureMetadata meta{
+      .agentId = agent,
+      .sensorClassId = sensorClass::bluetoothProximityHerald,
+      .sensorInstanceId = agent,
+      .modelClassId = agent
+    };
+    REQUIRE(des.add(meta));
+    auto& contents = des.getContents(des.findMeta(meta));
+    for (std::uint64_t idx = 0;idx < 6;++idx) {
+      contents.add(Exposure{.periodStart = Date(120 * idx), .periodEnd = Date(120 * (idx + 1)), .value = 10.0 * (idx + 1)});
+    }
+  }
+  herald::datatype::ExposureMetadata proxMeta = des.getTag(des.findMetaByAgentId(herald::datatype::agent::humanProximity));
+  auto& proxContents = des.getContents(des.findMeta(proxMeta));
+
+  auto scoresOf = [&numberedInstance] (RiskManagerT& rm, std::size_t instances) {
+    std::vector<RiskScore> all;
+    for (std::size_t instance = 0;instance < instances;++instance) {
+      rm.forEachRiskScore(numberedInstance(instance + 1), [&all] (const RiskScoreMetadata& meta, const RiskScore& score) {
+        all.push_back(score);
+      });
+    }
+    return all;
+  };
+  auto refreshed = [&] (RiskManagerT& rm) {
+    for (std::size_t instance = 1;instance <= 6;++instance) {
+      REQUIRE(rm.addRiskModel(numberedInstance(instance), herald::datatype::Agent{55}, sampleRM));
+    }
+    auto iter = proxContents.begin();
+    auto end = proxContents.end();
+    rm.injectExposureChanges(des, proxMeta, iter, end);
+    rm.refreshDirtyScores(des);
+    return scoresOf(rm, 6);
+  };
+
+  herald::exposure::RiskParameters<8> serialStats;
+  serialStats.set(herald::exposure::parameter::age, 21.0);
+  herald::exposure::FixedMemoryRiskStore<8> serialStore;
+  RiskManagerT serial{herald::exposure::RiskModels{sampleRM}, std::move(serialStats), serialStore};
+  serial.setGlobalPeriodInterval(Date{0}, TimeInterval::seconds(120));
+  REQUIRE(herald::exposure::RiskRefreshExecution::serial == serial.execution());
+
+  herald::exposure::RefreshPool pool(3);
+  herald::exposure::RiskParameters<8> parallelStats;
+  parallelStats.set(herald::exposure::parameter::age, 21.0);
+  herald::exposure::FixedMemoryRiskStore<8> parallelStore;
+  RiskManagerT parallel{herald::exposure::RiskModels{sampleRM}, std::move(parallelStats), parallelStore};
+  parallel.setGlobalPeriodInterval(Date{0}, TimeInterval::seconds(120));
+  parallel.execution(herald::exposure::RiskRefreshExecution::parallel); // no pool
+  REQUIRE(herald::exposure::RiskRefreshExecution::serial == parallel.execution());
+  parallel.execution(herald::exposure::RiskRefreshExecution::parallel, &pool);
+  REQUIRE(herald::exposure::RiskRefreshExecution::parallel == parallel.execution());
+
+  const auto expected = refreshed(serial);
+  const auto actual = refreshed(parallel);
+  REQUIRE(expected.size() == 6 * 6);
+  REQUIRE(actual.size() == expected.size());
+  for (std::size_t idx = 0;idx < expected.size();++idx) {
+    REQUIRE(actual[idx] == expected[idx]);
+  }
+  REQUIRE(expected[1].value == 2 * 21.0 * 20.0); // indoors (light < 30) in the second period
+}
+#endif
+
 // [Who]   As an epidemiologist
 // [What]  I need to run a risk analysis for all source variables over a given time period (E.g. hourly)
 // [Value] To calculate risk values for each target period during that time (E.g. a day), to accurately estimate a variety of risks (E.g. for a screening application)
@@ -0,0 +1,201 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+#include "test-templates.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+namespace {
+
+UUID numberedId(int prefix, int number) {
+  char id[37];
+  std::snprintf(id, sizeof(id), "%08d-1111-4011-8011-%012d", prefix, number);
+  return UUID::fromString(std::string(id));
+}
+
+ExposureMetadata numberedMeta(int agent, int instance, int model) {
+  return ExposureMetadata{
+    .agentId = numberedId(11111111, agent),
+    .sensorClassId = sensorClass::bluetoothProximityHerald,
+    .sensorInstanceId = numberedId(22222222, instance),
+    .modelClassId = numberedId(33333333, model)
+  };
+}
+
+}
+
+TEST_CASE("exposurestore-sortedarray", "[exposure][store][indexed]") {
+  herald::exposure::SortedExposureArray<4> arr;
+  REQUIRE(arr.size() == 0);
+  REQUIRE(arr.begin() == arr.end());
+  REQUIRE(arr.add(Exposure{.periodStart = 20, .periodEnd = 30, .value = 2.0}));
+  REQUIRE(arr.add(Exposure{.periodStart = 0, .periodEnd = 10, .value = 0.0}));
+  REQUIRE(arr.add(Exposure{.periodStart = 10, .periodEnd = 20, .value = 1.0}));
+  REQUIRE(arr.add(Exposure{.periodStart = 30, .periodEnd = 40, .value = 3.0}));
+  REQUIRE(!arr.add(Exposure{.periodStart = 40, .periodEnd = 50, .value = 4.0}));
+  REQUIRE(arr.size() == 4);
+  double expected = 0.0;
+  for (const auto& exposure : arr) {
+    REQUIRE(exposure.value == expected);
+    expected += 1.0;
+  }
+
+  // Moving forward stops at the end, as for AllocatableArray
+  auto iter = arr.begin();
+  iter += 10;
+  REQUIRE(iter == arr.end());
+  ++iter;
+  REQUIRE(iter == arr.end());
+
+  arr.clear();
+  REQUIRE(arr.size() == 0);
+}
+
+TEST_CASE("exposurestore-indexed-search", "[exposure][store][indexed]") {
+  herald::exposure::IndexedExposureStore<8> store;
+  REQUIRE(herald::exposure::IndexedExposureStore<8>::max_size == 8);
+  REQUIRE(store.size() == 0);
+  REQUIRE(store.findMetaByAgentId(numberedId(11111111, 1)) == 8);
+
+  // Added out of key order, with two sources sharing an agent
+  REQUIRE(store.add(numberedMeta(3, 5, 1)));
+  REQUIRE(store.add(numberedMeta(1, 2, 3)));
+  REQUIRE(store.add(numberedMeta(3, 1, 2)));
+  REQUIRE(store.add(numberedMeta(1, 2, 3))); // already present
+  REQUIRE(store.size() == 3);
+  REQUIRE(store.add(numberedMeta(1, 4, 3))); // another instance of the same source
+  REQUIRE(store.size() == 4);
+  REQUIRE(store.remove(numberedId(22222222, 4)));
+
+  REQUIRE(store.findMeta(numberedMeta(1, 2, 3)) == 1);
+  REQUIRE(store.findMeta(numberedMeta(1, 2, 4)) == 8);
+  REQUIRE(store.findMeta(numberedMeta(1, 7, 3)) == 1); // sensor instance is not compared
+  REQUIRE(store.findMetaByAgentId(numberedId(11111111, 3)) == 0); // earliest added
+  REQUIRE(store.findMetaByAgentId(numberedId(11111111, 1)) == 1);
+  REQUIRE(store.findMetaByAgentId(numberedId(11111111, 2)) == 8);
+  REQUIRE(store.findMetaBySensorInstanceId(numberedId(22222222, 1)) == 2);
+  REQUIRE(store.findMetaBySensorInstanceId(numberedId(22222222, 5)) == 0);
+  REQUIRE(store.findMetaByModelClassId(numberedId(33333333, 2)) == 2);
+  REQUIRE(store.getTag(2) == numberedMeta(3, 1, 2));
+
+  REQUIRE(store.remove(numberedId(22222222, 5)));
+  REQUIRE(!store.remove(numberedId(22222222, 5)));
+  REQUIRE(store.size() == 2);
+  REQUIRE(store.findMetaByAgentId(numberedId(11111111, 3)) == 1);
+  REQUIRE(store.findMetaBySensorInstanceId(numberedId(22222222, 2)) == 0);
+  REQUIRE(store.findMetaByModelClassId(numberedId(33333333, 1)) == 8);
+  REQUIRE(store.getTag(1) == numberedMeta(3, 1, 2));
+
+  for (int i = 0;i < 6;++i) {
+    REQUIRE(store.add(numberedMeta(10 + i, 10 + i, 10 + i)));
+  }
+  REQUIRE(!store.add(numberedMeta(20, 20, 20)));
+  for (int i = 0;i < 6;++i) {
+    REQUIRE(store.findMetaBySensorInstanceId(numberedId(22222222, 10 + i)) == std::size_t(2 + i));
+  }
+}
+
+TEST_CASE("exposurestore-indexed-matches-fixed", "[exposure][store][indexed]") {
+  herald::exposure::FixedMemoryExposureStore<8> fixed;
+  herald::exposure::IndexedExposureStore<8> indexed;
+  std::mt19937 random(4321);
+  std::uniform_int_distribution<int> gaps(0, 3);
+  std::uniform_int_distribution<int> lengths(0, 60);
+  std::uniform_int_distribution<int> values(0, 100);
+
+  // Chronological, non overlapping exposures, sometimes touching, as written by the ExposureManager
+  for (int source = 0;source < 4;++source) {
+    const auto meta = numberedMeta(source, source, source);
+    REQUIRE(fixed.add(meta));
+    REQUIRE(indexed.add(meta));
+    auto& fixedContents = fixed.getContents(fixed.findMeta(meta));
+    auto& indexedContents = indexed.getContents(indexed.findMeta(meta));
+    std::uint64_t time = 1000;
+    for (int idx = 0;idx < 2 * source;++idx) {
+      time += 30 * gaps(random);
+      const std::uint64_t end = time + lengths(random);
+      const Exposure exposure{.periodStart = time, .periodEnd = end, .value = double(values(random))};
+      fixedContents.add(exposure);
+      indexedContents.add(exposure);
+      time = end;
+    }
+  }
+
+  for (std::uint64_t start = 950;start < 1400;start += 17) {
+    for (std::uint64_t length : {0, 10, 60, 200}) {
+      for (int source = 0;source < 5;++source) {
+        std::vector<Exposure> fromFixed;
+        std::vector<Exposure> fromIndexed;
+        fixed.aggregate(numberedId(11111111, source), Date(start), Date(start + length),
+          herald::analysis::aggregates::Sum{}, [&fromFixed] (const Exposure& e) { fromFixed.push_back(e); });
+        indexed.aggregate(numberedId(11111111, source), Date(start), Date(start + length),
+          herald::analysis::aggregates::Sum{}, [&fromIndexed] (const Exposure& e) { fromIndexed.push_back(e); });
+        REQUIRE(fromFixed.size() == fromIndexed.size());
+        for (std::size_t idx = 0;idx < fromFixed.size();++idx) {
+          REQUIRE(fromFixed[idx].periodStart == fromIndexed[idx].periodStart);
+          REQUIRE(fromFixed[idx].periodEnd == fromIndexed[idx].periodEnd);
+          REQUIRE(fromFixed[idx].value == fromIndexed[idx].value);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("exposurestore-indexed-exposure-manager", "[exposure][store][indexed][periods]") {
+  using StoreT = herald::exposure::IndexedExposureStore<8>;
+  using ManagerT = herald::exposure::ExposureManager<DummyExposureCallbackHandlerNoOpt, StoreT>;
+  NoOptPassthrough nopt;
+  DummyExposureCallbackHandlerNoOpt dh{nopt};
+  StoreT des;
+  ManagerT em(dh,des);
+  REQUIRE(em.setGlobalPeriodInterval(0,120)); // 120 second windows starting at DateTime==0
+
+  SampleList<Sample<RSSI>,25> srcData;
+  for (std::uint64_t t = 60;t <= 300;t += 30) {
+    srcData.push(t,-55);
+  }
+  DummySampleSource src(1234,std::move(srcData));
+
+  herald::analysis::algorithms::RSSIMinutesAnalyser riskAnalyser{60};
+  auto analysisDelegate = em.template analysisDelegate<herald::datatype::RSSIMinute>();
+  herald::analysis::AnalysisDelegateManager adm(std::move(analysisDelegate));
+  herald::analysis::AnalysisProviderManager apm(std::move(riskAnalyser));
+  herald::analysis::AnalysisRunner<
+    herald::analysis::AnalysisDelegateManager<
+      herald::exposure::ExposureManagerDelegate<herald::datatype::RSSIMinute, ManagerT>
+    >,
+    herald::analysis::AnalysisProviderManager<herald::analysis::algorithms::RSSIMinutesAnalyser>,
+    RSSI,RSSIMinute
+  > runner(adm, apm);
+
+  herald::datatype::UUID proxInstanceId =
+    herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111");
+  REQUIRE(em.addSource<RSSIMinute>(
+    herald::datatype::agent::humanProximity,
+    sensorClass::bluetoothProximityHerald, proxInstanceId));
+
+  em.enableRunning();
+  src.run(301, runner);
+  REQUIRE(em.notifyOfChanges());
+
+  // As for exposure-time-periods with a FixedMemoryExposureStore
+  REQUIRE(dh.agent == herald::datatype::agent::humanProximity);
+  REQUIRE(dh.currentExposureValue == (45 * 4));
+  REQUIRE(2 == em.getCountByInstanceId(proxInstanceId));
+
+  double total = 0;
+  des.aggregate(herald::datatype::agent::humanProximity, Date(0), Date(360),
+    herald::analysis::aggregates::Sum{}, [&total] (const Exposure& e) { total = e.value; });
+  REQUIRE(total == (45 * 4));
+}
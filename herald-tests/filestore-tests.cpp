@@ -0,0 +1,280 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+#include "test-templates.h"
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+namespace {
+
+/// A file name in the temporary directory, removed before and after use
+struct TemporaryFile {
+  TemporaryFile(const std::string& name)
+    : path((std::filesystem::temp_directory_path() / ("herald-" + name)).string())
+  {
+    std::remove(path.c_str());
+  }
+
+  ~TemporaryFile() {
+    std::remove(path.c_str());
+  }
+
+  std::string path;
+};
+
+ExposureMetadata exposureMeta(int number) {
+  char id[37];
+  std::snprintf(id, sizeof(id), "22222222-1111-4011-8011-%012d", number);
+  return ExposureMetadata{
+    .agentId = herald::datatype::agent::humanProximity,
+    .sensorClassId = sensorClass::bluetoothProximityHerald,
+    .sensorInstanceId = UUID::fromString(std::string(id)),
+    .modelClassId = UUID::fromString(std::string(id))
+  };
+}
+
+/// Writes exposures as the ExposureManager does: extending the latest, then adding the next
+template <typename StoreT>
+void addExposures(StoreT& store, std::size_t pos, std::uint64_t from, std::size_t count) {
+  for (std::size_t idx = 0;idx < count;++idx) {
+    auto& contents = store.getContents(pos);
+    const std::uint64_t start = from + 60 * idx;
+    if (0 != contents.size()) {
+      contents[contents.size() - 1].periodEnd = Date(start);
+    }
+    contents.add(Exposure{.periodStart = start, .periodEnd = start, .value = double(idx % 7)});
+    contents[contents.size() - 1].value += 1.0;
+  }
+}
+
+std::vector<Exposure> allOf(const herald::exposure::FileExposureStore<4,4>& store, std::size_t pos) {
+  std::vector<Exposure> all;
+  store.over(pos, [&all] (const Exposure& e) { all.push_back(e); });
+  return all;
+}
+
+}
+
+TEST_CASE("filestore-appendlog", "[filestore][appendlog]") {
+  TemporaryFile file("appendlog.bin");
+  std::array<std::uint8_t,4> record;
+  {
+    herald::data::AppendLog log(file.path, 4);
+    REQUIRE(!log.append(record.data())); // not open
+    REQUIRE(log.open());
+    REQUIRE(log.size() == 0);
+    REQUIRE(log.record(0) == nullptr);
+    for (std::uint8_t idx = 0;idx < 10;++idx) {
+      record.fill(idx);
+      REQUIRE(log.append(record.data()));
+    }
+    REQUIRE(log.size() == 10);
+    REQUIRE(log.record(3)[0] == 3); // buffered
+    REQUIRE(log.flush());
+    REQUIRE(log.record(3)[3] == 3); // mapped
+    record.fill(10);
+    REQUIRE(log.append(record.data()));
+    REQUIRE(log.record(10)[0] == 10);
+  } // closing writes the rest
+
+  // A partial record, as from a crash while writing, is dropped
+  {
+    std::ofstream out(file.path, std::ios::binary | std::ios::app);
+    out.write("ab", 2);
+  }
+  {
+    herald::data::AppendLog log(file.path, 4);
+    REQUIRE(log.open());
+    REQUIRE(log.size() == 11);
+    REQUIRE(log.record(10)[2] == 10);
+    REQUIRE(log.record(11) == nullptr);
+
+    std::vector<std::uint8_t> replacement{1,2,3,4, 5,6,7,8};
+    REQUIRE(!log.replace(std::vector<std::uint8_t>{1,2,3}));
+    REQUIRE(log.replace(replacement));
+    REQUIRE(log.size() == 2);
+    REQUIRE(log.record(1)[0] == 5);
+  }
+  REQUIRE(std::filesystem::file_size(file.path) == 8);
+}
+
+TEST_CASE("filestore-exposure-history", "[filestore][exposure]") {
+  TemporaryFile file("exposures.bin");
+  herald::exposure::IndexedExposureStore<4,128> expected;
+  REQUIRE(expected.add(exposureMeta(1)));
+  REQUIRE(expected.add(exposureMeta(2)));
+  addExposures(expected, 0, 1000, 100);
+  addExposures(expected, 1, 5000, 20);
+
+  auto check = [&expected] (const herald::exposure::FileExposureStore<4,4>& store) {
+    for (std::size_t pos = 0;pos < 2;++pos) {
+      REQUIRE(store.count(pos) == expected.getContents(pos).size());
+      const auto all = allOf(store, pos);
+      for (std::size_t idx = 0;idx < all.size();++idx) {
+        REQUIRE(all[idx] == expected.getContents(pos)[idx]);
+      }
+    }
+    for (std::uint64_t start = 900;start < 7000;start += 250) {
+      double fromFile = -1;
+      double fromMemory = -1;
+      store.aggregate(herald::datatype::agent::humanProximity, Date(start), Date(start + 300),
+        herald::analysis::aggregates::Sum{}, [&fromFile] (const Exposure& e) { fromFile = e.value; });
+      expected.aggregate(herald::datatype::agent::humanProximity, Date(start), Date(start + 300),
+        herald::analysis::aggregates::Sum{}, [&fromMemory] (const Exposure& e) { fromMemory = e.value; });
+      REQUIRE(fromFile == fromMemory);
+    }
+  };
+
+  {
+    herald::exposure::FileExposureStore<4,4> store(file.path);
+    REQUIRE(!store.add(exposureMeta(1))); // not open
+    REQUIRE(store.open());
+    REQUIRE(store.add(exposureMeta(1)));
+    REQUIRE(store.add(exposureMeta(1))); // already present
+    REQUIRE(store.add(exposureMeta(2)));
+    REQUIRE(store.size() == 2);
+    addExposures(store, 0, 1000, 100);
+    addExposures(store, 1, 5000, 20);
+    REQUIRE(store.getContents(0).size() <= 4);
+    check(store);
+
+    // Changes to the latest exposure after it is written replace it
+    REQUIRE(store.flush());
+    store.getContents(0)[store.getContents(0).size() - 1].value += 10.0;
+    expected.getContents(0)[99].value += 10.0;
+    check(store);
+  }
+
+  {
+    herald::exposure::FileExposureStore<4,4> store(file.path);
+    REQUIRE(store.open());
+    REQUIRE(store.size() == 2);
+    REQUIRE(store.getTag(1) == exposureMeta(2));
+    REQUIRE(store.getTag(1).sensorInstanceId == exposureMeta(2).sensorInstanceId);
+    check(store);
+
+    // Carry on where the file left off
+    addExposures(store, 1, 6200, 5);
+    addExposures(expected, 1, 6200, 5);
+    check(store);
+
+    REQUIRE(store.add(exposureMeta(3)));
+    addExposures(store, 2, 1000, 10);
+    REQUIRE(store.remove(exposureMeta(3).sensorInstanceId));
+    REQUIRE(!store.remove(exposureMeta(3).sensorInstanceId));
+    REQUIRE(store.size() == 2);
+    REQUIRE(store.compact());
+    check(store);
+  }
+
+  {
+    herald::exposure::FileExposureStore<4,4> store(file.path);
+    REQUIRE(store.open());
+    REQUIRE(store.size() == 2);
+    check(store);
+  }
+}
+
+TEST_CASE("filestore-exposure-manager", "[filestore][exposure][periods]") {
+  TemporaryFile file("exposure-manager.bin");
+  using StoreT = herald::exposure::FileExposureStore<8>;
+  using ManagerT = herald::exposure::ExposureManager<DummyExposureCallbackHandlerNoOpt, StoreT>;
+  NoOptPassthrough nopt;
+  DummyExposureCallbackHandlerNoOpt dh{nopt};
+  StoreT des(file.path);
+  REQUIRE(des.open());
+  ManagerT em(dh,des);
+  REQUIRE(em.setGlobalPeriodInterval(0,120)); // 120 second windows starting at DateTime==0
+
+  SampleList<Sample<RSSI>,25> srcData;
+  for (std::uint64_t t = 60;t <= 300;t += 30) {
+    srcData.push(t,-55);
+  }
+  DummySampleSource src(1234,std::move(srcData));
+
+  herald::analysis::algorithms::RSSIMinutesAnalyser riskAnalyser{60};
+  auto analysisDelegate = em.template analysisDelegate<herald::datatype::RSSIMinute>();
+  herald::analysis::AnalysisDelegateManager adm(std::move(analysisDelegate));
+  herald::analysis::AnalysisProviderManager apm(std::move(riskAnalyser));
+  herald::analysis::AnalysisRunner<
+    herald::analysis::AnalysisDelegateManager<
+      herald::exposure::ExposureManagerDelegate<herald::datatype::RSSIMinute, ManagerT>
+    >,
+    herald::analysis::AnalysisProviderManager<herald::analysis::algorithms::RSSIMinutesAnalyser>,
+    RSSI,RSSIMinute
+  > runner(adm, apm);
+
+  herald::datatype::UUID proxInstanceId =
+    herald::datatype::UUID::fromString("99999999-1111-4011-8011-111111111111");
+  REQUIRE(em.addSource<RSSIMinute>(
+    herald::datatype::agent::humanProximity,
+    sensorClass::bluetoothProximityHerald, proxInstanceId));
+
+  em.enableRunning();
+  src.run(301, runner);
+  REQUIRE(em.notifyOfChanges());
+  REQUIRE(des.flush());
+
+  // As for exposure-time-periods with a FixedMemoryExposureStore
+  REQUIRE(dh.currentExposureValue == (45 * 4));
+  REQUIRE(2 == em.getCountByInstanceId(proxInstanceId));
+
+  StoreT reopened(file.path + ".copy");
+  std::filesystem::copy_file(file.path, file.path + ".copy", std::filesystem::copy_options::overwrite_existing);
+  REQUIRE(reopened.open());
+  double total = 0;
+  reopened.aggregate(herald::datatype::agent::humanProximity, Date(0), Date(360),
+    herald::analysis::aggregates::Sum{}, [&total] (const Exposure& e) { total = e.value; });
+  REQUIRE(total == (45 * 4));
+  reopened.close();
+  std::remove((file.path + ".copy").c_str());
+}
+
+TEST_CASE("filestore-risk", "[filestore][risk]") {
+  TemporaryFile file("risks.bin");
+  const RiskScoreMetadata meta{
+    .agentId = herald::datatype::agent::humanProximity,
+    .algorithmId = AlgorithmId{UUID::fromString("33333333-1111-4011-8011-111111111111")},
+    .instanceId = UUID::fromString("44444444-1111-4011-8011-111111111111")
+  };
+  {
+    herald::exposure::FileRiskStore<4,4> store(file.path);
+    REQUIRE(store.open());
+    REQUIRE(store.add(meta));
+    REQUIRE(store.findMetaByModelInstanceId(meta.instanceId) == 0);
+    REQUIRE(store.findMetaByAlgorithmId(meta.algorithmId) == 0);
+    for (std::uint64_t idx = 0;idx < 30;++idx) {
+      store.score(meta, RiskScore{.periodStart = 60 * idx, .periodEnd = 60 * (idx + 1), .value = double(idx)});
+    }
+    REQUIRE(store.getContents(0).size() <= 4);
+    REQUIRE(store.count(0) == 30);
+  }
+  {
+    herald::exposure::FileRiskStore<4,4> store(file.path);
+    REQUIRE(store.open());
+    REQUIRE(store.size() == 1);
+    REQUIRE(store.getTag(0) == meta);
+    double expected = 0;
+    store.over(0, [&expected] (const RiskScore& score) {
+      REQUIRE(score.value == expected);
+      REQUIRE(score.periodStart == Date(60 * std::uint64_t(expected)));
+      expected += 1.0;
+    });
+    REQUIRE(expected == 30.0);
+    REQUIRE(store.remove(meta.instanceId));
+    REQUIRE(store.size() == 0);
+  }
+}
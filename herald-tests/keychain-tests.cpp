@@ -0,0 +1,61 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+using namespace herald::datatype;
+
+/// Uncached derivation, as K did before checkpointing, for comparison
+herald::payload::simple::ContactKey uncachedContactKey(const herald::datatype::Data& secretKey,
+  int daysFor, int periodsInDay, int dayFor, int periodFor) {
+  using namespace herald::payload::simple;
+  Data seed(F::h(secretKey));
+  for (int i = daysFor - 1;i >= dayFor;--i) {
+    seed = F::h(F::t(seed));
+  }
+  Data mk(F::h(F::xorData(seed, F::h(F::t(seed)))));
+  Data periodSeed(F::h(mk));
+  for (int j = periodsInDay - 1;j >= periodFor;--j) {
+    periodSeed = F::h(F::t(periodSeed));
+  }
+  return ContactKey(F::h(F::xorData(periodSeed, F::h(F::t(periodSeed)))));
+}
+
+TEST_CASE("payload-simple-k-cache", "[payload][simple][k][cache]") {
+  SECTION("payload-simple-k-cache") {
+    herald::payload::simple::SecretKey ks1;
+    herald::payload::simple::SecretKey ks2;
+    for (int i = 0;i < 64;i++) {
+      ks1.append(std::byte(i));
+      ks2.append(std::byte(255 - i));
+    }
+    const int daysFor = 100;
+    const int periods = 24;
+    herald::payload::simple::K k(64,daysFor,periods,herald::payload::simple::K::getEpoch(),16,5);
+
+    // Out of order, repeated, checkpoint boundaries, beyond the ends of the chain
+    const int requests[][2] {
+      {0,0}, {0,1}, {0,23}, {1,0}, {99,12}, {100,24}, {84,5}, {85,5}, {83,5}, {3,20},
+      {3,19}, {3,19}, {50,0}, {120,30}, {16,4}, {-1,-1}
+    };
+    for (const auto& request : requests) {
+      auto cached = k.contactKey(ks1,request[0],request[1]);
+      auto expected = uncachedContactKey(ks1,daysFor,periods,request[0],request[1]);
+      INFO("day " << request[0] << " period " << request[1]);
+      REQUIRE(cached.hexEncodedString() == expected.hexEncodedString());
+    }
+
+    // Changing secret key must invalidate the cache
+    auto other = k.contactKey(ks2,3,19);
+    REQUIRE(other.hexEncodedString() == uncachedContactKey(ks2,daysFor,periods,3,19).hexEncodedString());
+    auto back = k.contactKey(ks1,3,19);
+    REQUIRE(back.hexEncodedString() == uncachedContactKey(ks1,daysFor,periods,3,19).hexEncodedString());
+
+    // A copy retains identical results
+    herald::payload::simple::K copy(k);
+    REQUIRE(copy.matchingKey(ks1,7).hexEncodedString() == k.matchingKey(ks1,7).hexEncodedString());
+  }
+}
@@ -28,7 +28,7 @@ TEST_CASE("memoryarena-pagesrequired","[memoryarena][pagesrequired]") {
 TEST_CASE("memoryarena-size","[memoryarena][size]") {
   SECTION("memoryarena-size") {
     herald::datatype::MemoryArena<2048,10> arena;
-    REQUIRE(sizeof(arena) == 2048 + ((205 + 9) / 8) + 2 + 2 + 2); // size of array, Size, PageSize
+    REQUIRE(sizeof(arena) == 2048 + (7 * 4) + 2 + 2 + 2 + 2); // array, 205 page bits in 32 bit words, counters (+2 padding)
   }
 }
 
@@ -174,4 +174,134 @@ TEST_CASE("memoryarena-entry-rawlocation","[memoryarena][entry][rawlocation]") {
     arena.rawCopy(largeBuffer,0);
     REQUIRE(largeBuffer[71] == ((unsigned char)0));
   }
-}
\ No newline at end of file
+}
+TEST_CASE("memoryarena-wordscan-useall","[memoryarena][wordscan][useall]") {
+  SECTION("memoryarena-wordscan-useall") {
+    herald::datatype::MemoryArena<2048,10,herald::datatype::WordScanAllocation> arena;
+    REQUIRE(arena.pagesFree() == 205);
+    auto entry1 = arena.allocate(512);
+    REQUIRE(entry1.startPageIndex == 0);
+    auto entry2 = arena.allocate(1024);
+    REQUIRE(entry2.startPageIndex == 52);
+    auto entry3 = arena.allocate(491);
+    REQUIRE(entry3.startPageIndex == 155);
+    REQUIRE(arena.pagesFree() == 0);
+    REQUIRE_THROWS([&arena](){
+      auto entry4 = arena.allocate(1); // should fail to allocate
+    }());
+    arena.deallocate(entry1);
+    REQUIRE(arena.pagesFree() == 52);
+    arena.deallocate(entry3);
+    REQUIRE(arena.pagesFree() == 102); // 52 + 50
+    arena.deallocate(entry2);
+    REQUIRE(arena.pagesFree() == 205);
+  }
+}
+
+TEST_CASE("memoryarena-wordscan-matches-firstfit","[memoryarena][wordscan][firstfit]") {
+  SECTION("memoryarena-wordscan-matches-firstfit") {
+    // Same sequence of allocations and frees must give identical placement
+    herald::datatype::MemoryArena<1024,8,herald::datatype::FirstFitAllocation> firstFit;
+    herald::datatype::MemoryArena<1024,8,herald::datatype::WordScanAllocation> wordScan;
+    std::array<herald::datatype::MemoryArenaEntry,24> ffEntries;
+    std::array<herald::datatype::MemoryArenaEntry,24> wsEntries;
+    for (std::size_t i = 0;i < ffEntries.size();++i) {
+      const std::size_t size = 1 + ((i * 37) % 40);
+      ffEntries[i] = firstFit.allocate(size);
+      wsEntries[i] = wordScan.allocate(size);
+      REQUIRE(ffEntries[i].startPageIndex == wsEntries[i].startPageIndex);
+    }
+    for (std::size_t i = 0;i < ffEntries.size();i += 3) {
+      firstFit.deallocate(ffEntries[i]);
+      wordScan.deallocate(wsEntries[i]);
+    }
+    REQUIRE(firstFit.pagesFree() == wordScan.pagesFree());
+    REQUIRE(firstFit.largestFreeRun() == wordScan.largestFreeRun());
+    for (std::size_t i = 0;i < ffEntries.size();i += 3) {
+      const std::size_t size = 1 + ((i * 11) % 40);
+      ffEntries[i] = firstFit.allocate(size);
+      wsEntries[i] = wordScan.allocate(size);
+      REQUIRE(ffEntries[i].startPageIndex == wsEntries[i].startPageIndex);
+    }
+  }
+}
+
+TEST_CASE("memoryarena-fragmentation-stats","[memoryarena][stats]") {
+  SECTION("memoryarena-fragmentation-stats") {
+    herald::datatype::MemoryArena<800,10,herald::datatype::WordScanAllocation> arena; // 80 pages
+    REQUIRE(arena.largestFreeRun() == 80);
+    REQUIRE(arena.allocationFailures() == 0);
+    REQUIRE(arena.highWaterMark() == 0);
+
+    std::array<herald::datatype::MemoryArenaEntry,8> entries;
+    for (auto& entry : entries) {
+      entry = arena.allocate(100); // 10 pages each
+    }
+    REQUIRE(arena.pagesFree() == 0);
+    REQUIRE(arena.largestFreeRun() == 0);
+    REQUIRE(arena.highWaterMark() == 80);
+
+    // Free every other entry - half the arena free, but only in 10 page runs
+    for (std::size_t i = 0;i < entries.size();i += 2) {
+      arena.deallocate(entries[i]);
+    }
+    REQUIRE(arena.pagesFree() == 40);
+    REQUIRE(arena.largestFreeRun() == 10);
+    REQUIRE(arena.highWaterMark() == 80); // retained
+
+    herald::datatype::MemoryArenaEntry big;
+    REQUIRE(!arena.tryAllocate(200, big));
+    REQUIRE(!big.isInitialised());
+    REQUIRE(arena.allocationFailures() == 1);
+    REQUIRE_THROWS([&arena](){
+      auto failed = arena.allocate(200);
+    }());
+    REQUIRE(arena.allocationFailures() == 2);
+
+    // Coalesces once a neighbour is freed
+    arena.deallocate(entries[1]);
+    REQUIRE(arena.largestFreeRun() == 30);
+    REQUIRE(arena.tryAllocate(200, big));
+    REQUIRE(big.startPageIndex == 0);
+    REQUIRE(arena.largestFreeRun() == 10);
+  }
+}
+
+TEST_CASE("memoryarena-inuse-count","[memoryarena][stats]") {
+  SECTION("memoryarena-inuse-count") {
+    herald::datatype::MemoryArena<800,10> arena; // 80 pages
+    auto entry = arena.allocate(20); // 2 pages
+    arena.reserve(entry, 50); // grows in place to 5 pages
+    REQUIRE(arena.pagesFree() == 75);
+    REQUIRE(arena.highWaterMark() == 5);
+    auto other = arena.allocate(30); // 3 pages, right after entry
+    arena.reserve(entry, 100); // moves to 10 pages at the end
+    REQUIRE(arena.pagesFree() == 67);
+    REQUIRE(arena.highWaterMark() == 18); // counted before the old 5 were freed
+    arena.deallocate(other);
+    REQUIRE(arena.pagesFree() == 70);
+    arena.reset();
+    REQUIRE(arena.pagesFree() == 80);
+    REQUIRE(arena.highWaterMark() == 18);
+  }
+}
+
+TEST_CASE("memoryarena-pagetable-wordboundaries","[memoryarena][pagetable]") {
+  SECTION("memoryarena-pagetable-wordboundaries") {
+    herald::datatype::MemoryArenaPageTable<70> table;
+    REQUIRE(0 == table.count());
+    table.setRange(30, 36, true); // spans three words
+    REQUIRE(36 == table.count());
+    REQUIRE(!table.test(29));
+    REQUIRE(table.test(30));
+    REQUIRE(table.test(65));
+    REQUIRE(!table.test(66));
+    REQUIRE(30 == table.findNext(0, true));
+    REQUIRE(66 == table.findNext(30, false));
+    REQUIRE(70 == table.findNext(66, true));
+    REQUIRE(30 == table.largestFreeRun());
+    table.setRange(32, 32, false); // exactly one whole word
+    REQUIRE(4 == table.count());
+    REQUIRE(32 == table.largestFreeRun());
+  }
+}
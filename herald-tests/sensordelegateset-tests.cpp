@@ -0,0 +1,157 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include <vector>
+
+#include "test-templates.h"
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+namespace {
+
+/// Implements single measurement callbacks only
+struct MeasuringDelegate {
+  void sensor(herald::datatype::SensorType, const herald::datatype::Proximity& didMeasure,
+    const herald::datatype::TargetIdentifier&) {
+    measured.push_back(didMeasure.value);
+  }
+
+  void sensor(herald::datatype::SensorType, const herald::datatype::Proximity& didMeasure,
+    const herald::datatype::TargetIdentifier&, const herald::datatype::PayloadData&) {
+    measuredWithPayload.push_back(didMeasure.value);
+  }
+
+  void sensor(herald::datatype::SensorType, const herald::datatype::SensorState& didUpdateState) {
+    states.push_back(didUpdateState);
+  }
+
+  std::vector<double> measured;
+  std::vector<double> measuredWithPayload;
+  std::vector<herald::datatype::SensorState> states;
+};
+
+/// Opts in to batched measurements
+struct BatchingDelegate {
+  void sensor(herald::datatype::SensorType, const herald::ProximityUpdates& didMeasure) {
+    batches.push_back(didMeasure.size());
+    for (const auto& update : didMeasure) {
+      measured.push_back(update.didMeasure.value);
+      payloadSizes.push_back(update.withPayload->size());
+    }
+  }
+
+  std::vector<std::size_t> batches;
+  std::vector<double> measured;
+  std::vector<std::size_t> payloadSizes;
+};
+
+/// Implements no callbacks at all
+struct SilentDelegate {
+};
+
+struct NoPayloadSupplier {
+};
+
+}
+
+TEST_CASE("sensordelegateset-dispatch", "[sensordelegateset][dispatch]") {
+  SECTION("sensordelegateset-dispatch") {
+    MeasuringDelegate measuring;
+    SilentDelegate silent;
+    herald::SensorDelegateSet delegates(measuring, silent);
+    static_assert(!decltype(delegates)::batchesProximity);
+    REQUIRE(decltype(delegates)::Size == 2);
+
+    herald::datatype::TargetIdentifier target(herald::datatype::Data(std::byte(0x01),6));
+    herald::datatype::PayloadData payload(std::byte(0x02),4);
+    auto prox = herald::datatype::Proximity{.unit=herald::datatype::ProximityMeasurementUnit::RSSI, .value=-55};
+
+    delegates.sensor(herald::datatype::SensorType::BLE, prox, target);
+    delegates.sensor(herald::datatype::SensorType::BLE, prox, target, payload);
+    delegates.sensor(herald::datatype::SensorType::BLE, herald::datatype::SensorState::on);
+    delegates.sensor(herald::datatype::SensorType::BLE, target); // implemented by neither
+
+    REQUIRE(measuring.measured == std::vector<double>{-55});
+    REQUIRE(measuring.measuredWithPayload == std::vector<double>{-55});
+    REQUIRE(measuring.states.size() == 1);
+    REQUIRE(measuring.states[0] == herald::datatype::SensorState::on);
+  }
+}
+
+TEST_CASE("sensordelegateset-batched", "[sensordelegateset][batched]") {
+  SECTION("sensordelegateset-batched") {
+    MeasuringDelegate measuring;
+    BatchingDelegate batching;
+    herald::SensorDelegateSet delegates(measuring, batching);
+    static_assert(decltype(delegates)::batchesProximity);
+
+    herald::datatype::TargetIdentifier t1(herald::datatype::Data(std::byte(0x01),6));
+    herald::datatype::TargetIdentifier t2(herald::datatype::Data(std::byte(0x02),6));
+    herald::datatype::PayloadData withPayload(std::byte(0x03),4);
+    herald::datatype::PayloadData noPayload;
+    auto rssi = [] (double value) {
+      return herald::datatype::Proximity{.unit=herald::datatype::ProximityMeasurementUnit::RSSI, .value=value};
+    };
+    std::vector<herald::ProximityUpdate> updates{
+      {&t1, rssi(-50), &withPayload},
+      {&t2, rssi(-60), &noPayload},
+      {&t1, rssi(-70), &withPayload}
+    };
+
+    delegates.sensor(herald::datatype::SensorType::BLE, herald::ProximityUpdates(updates.data(), updates.size()));
+
+    // One call for the delegate that batches
+    REQUIRE(batching.batches == std::vector<std::size_t>{3});
+    REQUIRE(batching.measured == std::vector<double>{-50,-60,-70});
+    // Single calls for the one that doesn't, with payload only where known
+    REQUIRE(measuring.measured == std::vector<double>{-50,-60,-70});
+    REQUIRE(measuring.measuredWithPayload == std::vector<double>{-50,-70});
+  }
+}
+
+TEST_CASE("sensordelegateset-blesensor-batched", "[sensordelegateset][batched][ble]") {
+  SECTION("sensordelegateset-blesensor-batched") {
+    DummyLoggingSink dls;
+    DummyBluetoothStateManager dbsm;
+    herald::DefaultPlatformType dpt;
+    using CT = typename herald::Context<herald::DefaultPlatformType,DummyLoggingSink,DummyBluetoothStateManager>;
+    CT ctx(dpt,dls,dbsm);
+    NoPayloadSupplier pds;
+    BatchingDelegate batching;
+    herald::SensorDelegateSet delegates(batching);
+    herald::ble::ConcreteBLESensor<CT,NoPayloadSupplier,decltype(delegates)> sensor(ctx,dbsm,pds,delegates);
+
+    herald::ble::ConcreteBLEDatabase<CT> db(ctx);
+    herald::ble::BLEDevice& d1 = db.device(herald::datatype::TargetIdentifier(herald::datatype::Data(std::byte(0x01),6)));
+    herald::ble::BLEDevice& d2 = db.device(herald::datatype::TargetIdentifier(herald::datatype::Data(std::byte(0x02),6)));
+    d1.rssi(herald::datatype::RSSI(-40));
+    d2.rssi(herald::datatype::RSSI(-45));
+
+    // RSSI updates are held until flushed
+    sensor.bleDatabaseDidUpdate(d1, herald::ble::BLEDeviceAttribute::rssi);
+    sensor.bleDatabaseDidUpdate(d2, herald::ble::BLEDeviceAttribute::rssi);
+    REQUIRE(batching.batches.empty());
+    sensor.flush();
+    REQUIRE(batching.batches == std::vector<std::size_t>{2});
+    REQUIRE(batching.measured == std::vector<double>{-40,-45});
+    sensor.flush();
+    REQUIRE(batching.batches.size() == 1);
+
+    // Any other change to a device delivers what is pending first
+    sensor.bleDatabaseDidUpdate(d1, herald::ble::BLEDeviceAttribute::rssi);
+    sensor.bleDatabaseDidUpdate(d2, herald::ble::BLEDeviceAttribute::state);
+    REQUIRE(batching.batches == std::vector<std::size_t>{2,1});
+
+    // Updates batched before a payload change are delivered with the payload they were measured against
+    db.add(sensor);
+    d1.rssi(herald::datatype::RSSI(-41));
+    REQUIRE(batching.batches.size() == 2);
+    d1.payloadData(herald::datatype::PayloadData(std::byte(0x05),4));
+    REQUIRE(batching.batches == std::vector<std::size_t>{2,1,1});
+    REQUIRE(batching.measured.back() == -41);
+    REQUIRE(batching.payloadSizes.back() == 0);
+  }
+}
@@ -6,7 +6,12 @@
 
 #include "catch.hpp"
 
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "herald/herald.h"
 
@@ -261,4 +266,197 @@ TEST_CASE("sensorlogger-output-targetidentifier", "[sensorlogger][output]") {
     HTLOG("Complex {} type",t);
     REQUIRE(strcmp(r.c_str(),dls.value.c_str()) == 0);
   }
-}
\ No newline at end of file
+}
+
+namespace {
+
+/// Keeps every line written, with its level
+struct RecordingLoggingSink {
+  void log(const std::string& sub,const std::string& cat,herald::data::SensorLoggerLevel level, std::string message) {
+    lines.push_back(sub + "," + cat + "," + message);
+    levels.push_back(level);
+  }
+
+  std::vector<std::string> lines;
+  std::vector<herald::data::SensorLoggerLevel> levels;
+};
+
+}
+
+TEST_CASE("sensorlogger-output-levels", "[sensorlogger][output]") {
+  SECTION("sensorlogger-output-levels") {
+    RecordingLoggingSink rls;
+    herald::data::SensorLogger logger(rls,"testout","mytest");
+
+    HTDBG("Simple string");
+    HTLOG("Simple string");
+    HTERR("Simple string");
+    REQUIRE(rls.levels == std::vector<herald::data::SensorLoggerLevel>{
+      herald::data::SensorLoggerLevel::debug,herald::data::SensorLoggerLevel::info,herald::data::SensorLoggerLevel::fault});
+  }
+}
+
+TEST_CASE("sensorlogger-binary-output", "[sensorlogger][binary][output]") {
+  SECTION("sensorlogger-binary-output") {
+    herald::data::BinaryLoggingSink<16> bls;
+    static_assert(herald::data::IsBinaryLoggingSinkV<decltype(bls)>);
+    static_assert(!herald::data::IsBinaryLoggingSinkV<RecordingLoggingSink>);
+    herald::data::SensorLogger logger(bls,"testout","mytest");
+    herald::data::SensorLogger other(bls,"testout","other");
+
+    const char* cc = "some const char";
+    std::string str("a string");
+    herald::datatype::TargetIdentifier t(herald::datatype::Data(std::byte(0x09),3));
+    HTDBG("Simple string");
+    HTLOG("There are {} strings","two");
+    HTERR("There are two params 1: {} and 2: {} and some more text {} <- but this is blank", 15, -45);
+    HTDBG("Too few {} parameters",15,45);
+    HTDBG("Intrinsic {} {} {} {} types",std::uint8_t(255),std::int8_t(-39),std::uint64_t(3737373737),true);
+    HTDBG("There are {} const chars and {}",cc,str);
+    HTDBG("Complex {} type",t);
+    HTDBG("Real {}",-12.7);
+    HTDBG(str); // not a literal, so copied
+    std::string last("Last {}");
+    HTDBG(last,99); // formatted as usual
+    {
+      auto logger = other;
+      HTLOG("From {}","other");
+    }
+
+    RecordingLoggingSink rls;
+    REQUIRE(bls.drain([&rls] (const std::string& sub, const std::string& cat, herald::data::SensorLoggerLevel level, const std::string& msg) {
+      rls.log(sub,cat,level,msg);
+    }) == 11);
+    REQUIRE(bls.dropped() == 0);
+    REQUIRE(rls.lines.size() == 11);
+    REQUIRE(rls.lines[0] == "testout,mytest,Simple string");
+    REQUIRE(rls.lines[1] == "testout,mytest,There are two strings");
+    REQUIRE(rls.lines[2] == "testout,mytest,There are two params 1: 15 and 2: -45 and some more text  <- but this is blank");
+    REQUIRE(rls.lines[3] == "testout,mytest,Too few 15 parameters");
+    REQUIRE(rls.lines[4] == "testout,mytest,Intrinsic 255 -39 3737373737 1 types");
+    REQUIRE(rls.lines[5] == "testout,mytest,There are some const char const chars and a string");
+    REQUIRE(rls.lines[6] == "testout,mytest,Complex 090909 type");
+    REQUIRE(rls.lines[7] == "testout,mytest,Real ~-12d");
+    REQUIRE(rls.lines[8] == "testout,mytest,a string");
+    REQUIRE(strcmp(rls.lines[9].c_str(),"testout,mytest,Last 99") == 0);
+    REQUIRE(rls.lines[10] == "testout,other,From other");
+    REQUIRE(rls.levels[0] == herald::data::SensorLoggerLevel::debug);
+    REQUIRE(rls.levels[1] == herald::data::SensorLoggerLevel::info);
+    REQUIRE(rls.levels[2] == herald::data::SensorLoggerLevel::fault);
+
+    REQUIRE(bls.drain([] (const auto&, const auto&, auto, const auto&) {}) == 0);
+  }
+}
+
+TEST_CASE("sensorlogger-binary-buffer", "[sensorlogger][binary][buffer]") {
+  SECTION("sensorlogger-binary-buffer") {
+    herald::data::BinaryLoggingSink<16> bls;
+    herald::data::SensorLogger logger(bls,"testout","mytest");
+    // Binary loggers hold the source id only, not copies of the names
+    static_assert(std::is_same_v<decltype(logger)::source_type,std::uint8_t>);
+
+    // A char array that is not a literal is copied, so may be reused before the drain
+    char buffer[16];
+    std::strcpy(buffer, "First {}");
+    HTDBG(buffer,1);
+    std::strcpy(buffer, "Second {}");
+    logger.info(buffer,2);
+    std::strcpy(buffer, "Overwritten");
+
+    std::vector<std::string> lines;
+    REQUIRE(bls.drain([&lines] (const std::string&, const std::string&, herald::data::SensorLoggerLevel, const std::string& msg) {
+      lines.push_back(msg);
+    }) == 2);
+    REQUIRE(strcmp(lines[0].c_str(),"First 1") == 0);
+    REQUIRE(strcmp(lines[1].c_str(),"Second 2") == 0);
+  }
+}
+
+TEST_CASE("sensorlogger-binary-full", "[sensorlogger][binary][full]") {
+  SECTION("sensorlogger-binary-full") {
+    herald::data::BinaryLoggingSink<4,16> bls;
+    herald::data::SensorLogger logger(bls,"testout","mytest");
+    for (int i = 0;i < 6;++i) {
+      HTDBG("Line {}",i);
+    }
+    REQUIRE(bls.dropped() == 2);
+
+    // Arguments beyond the record size are cut short
+    std::vector<std::string> lines;
+    auto collect = [&lines] (const std::string&, const std::string&, herald::data::SensorLoggerLevel, const std::string& msg) {
+      lines.push_back(msg);
+    };
+    REQUIRE(bls.drain(collect, 3) == 3);
+    HTDBG("Long {} {}","0123456789abcdefghij",1);
+    REQUIRE(bls.drain(collect) == 2);
+    REQUIRE(lines == std::vector<std::string>{"Line 0","Line 1","Line 2","Line 3","Long 0123456789abcd ..."});
+  }
+}
+
+TEST_CASE("sensorlogger-binary-fallback", "[sensorlogger][binary][fallback]") {
+  SECTION("sensorlogger-binary-fallback") {
+    std::string longMessage(40, 'x');
+    std::vector<std::string> lines;
+    auto collect = [&lines] (const std::string&, const std::string&, herald::data::SensorLoggerLevel, const std::string& msg) {
+      lines.push_back(msg);
+    };
+
+    // Without a fallback, over long messages are cut short and marked
+    herald::data::BinaryLoggingSink<4,16> marked;
+    {
+      herald::data::SensorLogger logger(marked,"testout","mytest");
+      HTDBG(longMessage);
+    }
+    REQUIRE(marked.drain(collect) == 1);
+    REQUIRE(lines[0] == std::string(14, 'x') + "...");
+
+    // With one, they are passed to it whole. Short ones are recorded as usual.
+    RecordingLoggingSink rls;
+    herald::data::BinaryLoggingSink<4,16,4,RecordingLoggingSink> bls(rls);
+    herald::data::SensorLogger logger(bls,"testout","mytest");
+    HTDBG(longMessage);
+    HTDBG(std::string("short"));
+    REQUIRE(rls.lines.size() == 1);
+    REQUIRE(strcmp(rls.lines[0].c_str(), ("testout,mytest," + longMessage).c_str()) == 0);
+    lines.clear();
+    REQUIRE(bls.drain(collect) == 1);
+    REQUIRE(strcmp(lines[0].c_str(), "short") == 0);
+  }
+}
+
+TEST_CASE("sensorlogger-binary-threads", "[sensorlogger][binary][threads]") {
+  SECTION("sensorlogger-binary-threads") {
+    // Several writers at once, with the drain thread writing out to a text sink
+    herald::data::BinaryLoggingSink<64> bls;
+    RecordingLoggingSink rls;
+    constexpr int writers = 4;
+    constexpr int perWriter = 5000;
+    {
+      herald::data::BinaryLogDrainThread drainer(bls, rls, std::chrono::milliseconds(1));
+      std::vector<std::thread> threads;
+      for (int w = 0;w < writers;++w) {
+        threads.emplace_back([&bls, w] {
+          herald::data::SensorLogger logger(bls,"writer",std::to_string(w));
+          for (int i = 0;i < perWriter;++i) {
+            HTDBG("Line {}",i);
+          }
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    } // stopping the drain thread writes out the remainder
+
+    REQUIRE(rls.lines.size() + bls.dropped() == writers * perWriter);
+    // Each writer's lines arrive in the order written
+    std::vector<int> last(writers, -1);
+    bool ordered = true;
+    for (const auto& line : rls.lines) {
+      const int w = line[7] - '0';
+      const int i = std::stoi(line.substr(line.find("Line ") + 5));
+      ordered = ordered && i > last[w];
+      last[w] = i;
+    }
+    REQUIRE(ordered);
+  }
+}
@@ -6,6 +6,8 @@
 
 #include "herald/herald.h"
 
+#include <vector>
+
 TEST_CASE("sha256-mutated", "[sha256][mutated]") {
   SECTION("sha256-mutated") {
     herald::datatype::SHA256 sha;
@@ -106,4 +108,45 @@ TEST_CASE("sha256-same", "[zephyronly][sha256][same]") {
     REQUIRE(hash1 == hash2);
   }
 }
-#endif
\ No newline at end of file
+#endif
+
+TEST_CASE("sha256-batch-known-value", "[sha256][batch][known-value]") {
+  SECTION("sha256-batch-known-value") {
+    const std::uint8_t abc[] {'a','b','c','a','b','c'};
+    std::uint8_t digests[2 * herald::datatype::SHA256::DigestLength];
+    herald::datatype::SHA256::digestBatch(abc, 3, 2, digests);
+
+    // FIPS 180-2 example: sha256("abc")
+    herald::datatype::Data expected = herald::datatype::Data::fromHexEncodedString(
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    REQUIRE(herald::datatype::Data(digests, 32) == expected);
+    REQUIRE(herald::datatype::Data(digests + 32, 32) == expected);
+  }
+}
+
+TEST_CASE("sha256-batch-matches-digest", "[sha256][batch][matches-digest]") {
+  SECTION("sha256-batch-matches-digest") {
+    // Lengths either side of the padding and block boundaries, counts either side of the lane width
+    const std::size_t lengths[] {0, 1, 16, 32, 55, 56, 63, 64, 65, 119, 120, 200};
+    const std::size_t counts[] {0, 1, 2, 3, 7, 8, 9, 17};
+    herald::datatype::SHA256 sha;
+    for (auto length : lengths) {
+      for (auto count : counts) {
+        std::vector<std::uint8_t> messages(length * count + 1);
+        for (std::size_t i = 0;i < messages.size();++i) {
+          messages[i] = std::uint8_t(i * 7 + length);
+        }
+        std::vector<std::uint8_t> digests(count * herald::datatype::SHA256::DigestLength + 1, 0xee);
+        herald::datatype::SHA256::digestBatch(messages.data(), length, count, digests.data());
+
+        for (std::size_t m = 0;m < count;++m) {
+          herald::datatype::Data message(messages.data() + m * length, length);
+          herald::datatype::Data batched(digests.data() + m * 32, 32);
+          INFO("length " << length << ", count " << count << ", message " << m);
+          REQUIRE(batched == sha.digest(message));
+        }
+        REQUIRE(digests.back() == 0xee); // nothing written past the last digest
+      }
+    }
+  }
+}
@@ -0,0 +1,106 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include "herald/herald.h"
+
+#include <array>
+
+TEST_CASE("slothashindex-empty", "[slothashindex][ctor][empty]") {
+  SECTION("slothashindex-empty") {
+    herald::datatype::SlotHashIndex<8> idx;
+    REQUIRE(0 == idx.size());
+    REQUIRE(idx.Capacity == 16);
+    REQUIRE(idx.npos == idx.find(1234,[](std::size_t) { return true; }));
+    REQUIRE(!idx.contains(0));
+    REQUIRE(!idx.remove(0));
+  }
+}
+
+TEST_CASE("slothashindex-insert-find-remove", "[slothashindex][insert][find][remove]") {
+  SECTION("slothashindex-insert-find-remove") {
+    herald::datatype::SlotHashIndex<8> idx;
+    std::array<int,8> keys{10,20,30,40,50,60,70,80};
+    for (std::size_t s = 0;s < keys.size();++s) {
+      REQUIRE(idx.insert(s,std::hash<int>{}(keys[s])));
+    }
+    REQUIRE(8 == idx.size());
+    REQUIRE(!idx.insert(8,1)); // out of range
+    for (std::size_t s = 0;s < keys.size();++s) {
+      const int key = keys[s];
+      REQUIRE(s == idx.find(std::hash<int>{}(key),[&keys,key](std::size_t slot) { return keys[slot] == key; }));
+    }
+
+    REQUIRE(idx.remove(3));
+    REQUIRE(7 == idx.size());
+    REQUIRE(idx.npos == idx.find(std::hash<int>{}(40),[&keys](std::size_t slot) { return keys[slot] == 40; }));
+    // All others still reachable after the backward shift
+    for (std::size_t s = 0;s < keys.size();++s) {
+      if (3 == s) {
+        continue;
+      }
+      const int key = keys[s];
+      REQUIRE(s == idx.find(std::hash<int>{}(key),[&keys,key](std::size_t slot) { return keys[slot] == key; }));
+    }
+  }
+}
+
+TEST_CASE("slothashindex-collisions", "[slothashindex][collisions]") {
+  SECTION("slothashindex-collisions") {
+    // Every slot under the same hash - the matcher must disambiguate
+    herald::datatype::SlotHashIndex<4> idx;
+    for (std::size_t s = 0;s < 4;++s) {
+      idx.insert(s,42);
+    }
+    for (std::size_t s = 0;s < 4;++s) {
+      REQUIRE(s == idx.find(42,[s](std::size_t slot) { return slot == s; }));
+    }
+    idx.remove(0);
+    idx.remove(2);
+    REQUIRE(2 == idx.size());
+    REQUIRE(1 == idx.find(42,[](std::size_t slot) { return slot == 1; }));
+    REQUIRE(3 == idx.find(42,[](std::size_t slot) { return slot == 3; }));
+    REQUIRE(idx.npos == idx.find(42,[](std::size_t slot) { return slot == 0; }));
+
+    // Re-inserting a slot replaces its previous entry
+    idx.insert(1,7);
+    REQUIRE(2 == idx.size());
+    REQUIRE(idx.npos == idx.find(42,[](std::size_t slot) { return slot == 1; }));
+    REQUIRE(1 == idx.find(7,[](std::size_t slot) { return slot == 1; }));
+  }
+}
+
+TEST_CASE("slotlrulist-acquire-touch-release", "[slotlrulist][acquire][touch][release]") {
+  SECTION("slotlrulist-acquire-touch-release") {
+    herald::datatype::SlotLRUList<3> lru;
+    REQUIRE(0 == lru.size());
+    REQUIRE(lru.npos == lru.leastRecent());
+
+    REQUIRE(0 == lru.acquire());
+    REQUIRE(1 == lru.acquire());
+    REQUIRE(2 == lru.acquire());
+    REQUIRE(lru.npos == lru.acquire()); // full
+    REQUIRE(3 == lru.size());
+    REQUIRE(0 == lru.leastRecent());
+    REQUIRE(2 == lru.mostRecent());
+
+    lru.touch(0);
+    REQUIRE(1 == lru.leastRecent());
+    REQUIRE(0 == lru.mostRecent());
+
+    lru.release(1);
+    REQUIRE(2 == lru.size());
+    REQUIRE(!lru.contains(1));
+    REQUIRE(2 == lru.leastRecent());
+
+    REQUIRE(1 == lru.acquire()); // most recently freed slot is reused
+    REQUIRE(1 == lru.mostRecent());
+    REQUIRE(2 == lru.leastRecent());
+
+    lru.clear();
+    REQUIRE(0 == lru.size());
+    REQUIRE(0 == lru.acquire());
+  }
+}
@@ -72,6 +72,23 @@ TEST_CASE("datatypes-targetidentifier-comparison", "[datatypes][targetidentifier
     // hash codes
     REQUIRE(t1.hashCode() == t2.hashCode());
     REQUIRE(t1.hashCode() != t3.hashCode());
+    REQUIRE(t1.hashCode() == t1out.hashCode());
+
+    // copies and assignment keep the hash code
+    herald::datatype::TargetIdentifier t4(t3);
+    REQUIRE(t4.hashCode() == t3.hashCode());
+    REQUIRE(t4 == t3);
+    t4 = t1;
+    REQUIRE(t4.hashCode() == t1.hashCode());
+    REQUIRE(t4 == t1);
+    REQUIRE(t4 != t3);
+
+    // same size, different bytes
+    herald::datatype::Data d5{std::byte('a'),5};
+    d5.append(std::byte('b'));
+    herald::datatype::TargetIdentifier t5(d5);
+    REQUIRE(t5 != t1);
+    REQUIRE(!(t5 == t1));
 
     // string representation comparison
     REQUIRE(((std::string)t1) == ((std::string)t2));
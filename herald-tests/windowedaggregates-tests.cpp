@@ -0,0 +1,241 @@
+//  Copyright 2021 Herald project contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "catch.hpp"
+
+#include <vector>
+
+#include "herald/herald.h"
+
+using namespace herald::analysis::aggregates;
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+TEST_CASE("windowedaggregates-mean-variance", "[windowedaggregates][mean][variance]") {
+  SECTION("windowedaggregates-mean-variance-addremove") {
+    WindowedMean mean;
+    WindowedVariance variance;
+    REQUIRE(mean.reduce() == 0.0);
+    REQUIRE(variance.reduce() == 0.0);
+    for (double v : {10.0, 12.0, 14.0, 20.0}) {
+      mean.add(v);
+      variance.add(v);
+    }
+    REQUIRE(mean.size() == 4);
+    REQUIRE(mean.reduce() == 14.0);
+    REQUIRE(variance.mean() == Approx(14.0));
+    REQUIRE(variance.reduce() == Approx(56.0 / 3.0));
+
+    mean.remove(20.0);
+    variance.remove(20.0);
+    REQUIRE(mean.reduce() == 12.0);
+    REQUIRE(variance.mean() == Approx(12.0));
+    REQUIRE(variance.reduce() == Approx(4.0));
+
+    variance.remove(10.0);
+    variance.remove(12.0);
+    REQUIRE(variance.size() == 1);
+    REQUIRE(variance.mean() == Approx(14.0));
+    REQUIRE(variance.reduce() == 0.0);
+  }
+
+  SECTION("windowedaggregates-mean-variance-aggregate") {
+    SampleList<Sample<int>,5> sl;
+    for (int i = 1;i <= 5;++i) {
+      sl.push(1000 + i, i);
+    }
+    herald::analysis::views::in_range all(0,10);
+    auto values = sl
+                | herald::analysis::views::filter(all)
+                | herald::analysis::views::to_view();
+    auto summary = values
+                 | summarise<WindowedMean,WindowedVariance>();
+    REQUIRE(summary.get<WindowedMean>() == 3.0);
+    REQUIRE(summary.get<WindowedVariance>() == Approx(2.5));
+  }
+}
+
+TEST_CASE("windowedaggregates-mode", "[windowedaggregates][mode]") {
+  WindowedMode mode;
+  REQUIRE(mode.reduce() == 0.0);
+  for (double v : {-60.0, -55.0, -60.0, -55.0, -70.0}) {
+    mode.add(v);
+  }
+  // Ties go to the smallest value, as for Mode
+  REQUIRE(mode.reduce() == -60.0);
+  REQUIRE(mode.modeWithin(-58.0, -50.0) == -55.0);
+  REQUIRE(mode.modeWithin(-40.0, -30.0) == 0.0);
+  REQUIRE(mode.modeWithin(-50.0, -58.0) == 0.0);
+
+  mode.remove(-60.0);
+  REQUIRE(mode.reduce() == -55.0);
+  mode.remove(-55.0);
+  mode.remove(-55.0);
+  REQUIRE(mode.reduce() == -70.0);
+  mode.remove(-12.0); // not present
+  REQUIRE(mode.reduce() == -70.0);
+}
+
+TEST_CASE("windowedaggregates-median", "[windowedaggregates][median]") {
+  WindowedMedian median;
+  REQUIRE(median.reduce() == 0.0);
+  median.add(5.0);
+  REQUIRE(median.reduce() == 5.0);
+  median.add(1.0);
+  REQUIRE(median.reduce() == 3.0);
+  median.add(9.0);
+  median.add(7.0);
+  median.add(3.0);
+  REQUIRE(median.size() == 5);
+  REQUIRE(median.reduce() == 5.0);
+  median.remove(5.0);
+  REQUIRE(median.reduce() == 5.0); // (3 + 7) / 2
+  median.remove(1.0);
+  median.remove(3.0);
+  REQUIRE(median.reduce() == 8.0);
+}
+
+TEST_CASE("windowedaggregates-slidingwindow-sync", "[windowedaggregates][slidingwindow]") {
+  SampleList<Sample<RSSI>,5> src;
+  SlidingWindow<WindowedMean,WindowedMode> window;
+  auto valid = [](const Sample<RSSI>& s) { return s.value.intValue() < 0; };
+
+  window.sync(src, valid);
+  REQUIRE(window.size() == 0);
+
+  src.push(Date(1000), RSSI(-50));
+  src.push(Date(1010), RSSI(-60));
+  src.push(Date(1010), RSSI(0)); // invalid
+  window.sync(src, valid);
+  REQUIRE(window.size() == 2);
+  REQUIRE(window.get<WindowedMean>().reduce() == -55.0);
+
+  // Nothing new
+  window.sync(src, valid);
+  REQUIRE(window.size() == 2);
+
+  // A further sample at the latest time, then wrap the list evicting the first two
+  src.push(Date(1010), RSSI(-70));
+  src.push(Date(1020), RSSI(-70));
+  src.push(Date(1030), RSSI(-40));
+  src.push(Date(1040), RSSI(-40));
+  window.sync(src, valid);
+  REQUIRE(src.size() == 5);
+  REQUIRE(window.size() == 4);
+  REQUIRE(window.earliest() == Date(1010));
+  REQUIRE(window.latest() == Date(1040));
+  REQUIRE(window.get<WindowedMean>().reduce() == -55.0);
+  REQUIRE(window.get<WindowedMode>().reduce() == -70.0);
+
+  src.clearBeforeDate(Date(1030));
+  window.sync(src, valid);
+  REQUIRE(window.size() == 2);
+  REQUIRE(window.get<WindowedMode>().reduce() == -40.0);
+
+  src.clear();
+  window.sync(src, valid);
+  REQUIRE(window.size() == 0);
+  REQUIRE(window.get<WindowedMean>().size() == 0);
+}
+
+TEST_CASE("windowedaggregates-slidingwindow-range", "[windowedaggregates][slidingwindow]") {
+  SampleList<Sample<RSSI>,10> src;
+  for (int i = 0;i < 10;++i) {
+    src.push(Date(1000 + 10 * i), RSSI(-50 - i));
+  }
+  SlidingWindow<WindowedMean> window;
+  window.sync(src, [](const Sample<RSSI>&) { return true; }, [](double rssi) { return -rssi; });
+  REQUIRE(window.size() == 10);
+
+  // Compare each range against a recalculation
+  auto check = [&](std::uint64_t from, std::uint64_t to) {
+    window.range(Date(from), Date(to));
+    double sum = 0;
+    std::size_t count = 0;
+    for (std::size_t i = 0;i < src.size();++i) {
+      if (src[i].taken >= Date(from) && src[i].taken <= Date(to)) {
+        sum += -(double)src[i].value;
+        ++count;
+      }
+    }
+    REQUIRE(window.size() == count);
+    REQUIRE(window.get<WindowedMean>().size() == count);
+    if (count > 0) {
+      REQUIRE(window.get<WindowedMean>().reduce() == Approx(sum / count));
+    }
+  };
+  check(1000, 1030);
+  check(1020, 1060); // forwards
+  check(1030, 1050); // end backwards
+  check(1010, 1050); // start backwards
+  check(1200, 1300); // past the end
+  check(1000, 1090); // everything again
+  check(1045, 1049); // between samples
+  check(1050, 1040); // inverted
+  check(1000, 1000);
+}
+
+TEST_CASE("windowedaggregates-sourcewindows", "[windowedaggregates][slidingwindow]") {
+  SourceWindows<SlidingWindow<WindowedMean>> windows;
+  windows.window(1, Date(1000)).get<WindowedMean>().add(1.0);
+  windows.window(2, Date(1000)).get<WindowedMean>().add(2.0);
+  REQUIRE(windows.size() == 2);
+  REQUIRE(windows.window(1, Date(1500)).get<WindowedMean>().reduce() == 1.0);
+
+  // Source 2 has not been used for over 15 minutes
+  windows.window(1, Date(2500));
+  REQUIRE(windows.size() == 1);
+}
+
+TEST_CASE("windowedaggregates-analysers-invalid-newest", "[windowedaggregates][analysers]") {
+  // Outputs match those from before the analysers kept sliding windows, including where the
+  // newest sample is not valid RSSI. Note views::view::latest() gives the time of the list's
+  // newest sample, whether or not that sample passed the view's filters.
+  SECTION("windowedaggregates-analysers-invalid-newest-fowler") {
+    herald::analysis::algorithms::distance::FowlerBasicAnalyser analyser(10, -50, -24);
+    SampleList<Sample<RSSI>,25> src;
+    SampleList<Sample<Distance>,25> dst;
+    std::vector<Sample<Distance>> outputs;
+    auto callable = [&outputs] (SampledID sampled, Sample<Distance> sample) {
+      outputs.push_back(sample);
+    };
+    src.push(Date(1000), RSSI(-55));
+    src.push(Date(1002), RSSI(-55));
+    src.push(Date(1004), RSSI(-60));
+    src.push(Date(1006), RSSI(-5)); // invalid
+    REQUIRE(analyser.analyse(Date(1020), 1, src, dst, callable));
+    src.push(Date(1030), RSSI(-57));
+    src.push(Date(1032), RSSI(-120)); // invalid
+    REQUIRE(analyser.analyse(Date(1040), 1, src, dst, callable));
+
+    REQUIRE(outputs.size() == 2);
+    REQUIRE(outputs[0].taken.secondsSinceUnixEpoch() == 1006);
+    REQUIRE((double)outputs[0].value == Approx(1.6156).epsilon(0.0001));
+    REQUIRE(outputs[1].taken.secondsSinceUnixEpoch() == 1032);
+    REQUIRE((double)outputs[1].value == Approx(0.00825404).epsilon(0.0001));
+  }
+
+  SECTION("windowedaggregates-analysers-invalid-newest-rssiminutes") {
+    herald::analysis::algorithms::RSSIMinutesAnalyser analyser(10);
+    SampleList<Sample<RSSI>,25> src;
+    SampleList<Sample<RSSIMinute>,25> dst;
+    std::vector<Sample<RSSIMinute>> outputs;
+    auto callable = [&outputs] (SampledID sampled, Sample<RSSIMinute> sample) {
+      outputs.push_back(sample);
+    };
+    for (int t = 1000;t <= 1030;t += 5) {
+      src.push(Date(t), RSSI(-50 - (t - 1000) / 5));
+    }
+    src.push(Date(1033), RSSI(-5)); // invalid
+    REQUIRE(analyser.analyse(Date(1040), 1, src, dst, callable));
+    REQUIRE(outputs.empty());
+    src.push(Date(1045), RSSI(-60));
+    src.push(Date(1052), RSSI(-3)); // invalid
+    REQUIRE(analyser.analyse(Date(1060), 1, src, dst, callable));
+
+    REQUIRE(outputs.size() == 1);
+    REQUIRE(outputs[0].taken.secondsSinceUnixEpoch() == 1050);
+    REQUIRE((double)outputs[0].value == Approx(6.66667).epsilon(0.0001));
+  }
+}
@@ -5,6 +5,7 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/datatype/stdlib.h
   ${HERALD_BASE}/include/herald/util/is_valid.h
 
+  ${HERALD_BASE}/include/herald/clock.h
   ${HERALD_BASE}/include/herald/context.h
   ${HERALD_BASE}/include/herald/device.h
   ${HERALD_BASE}/include/herald/default_sensor_delegate.h
@@ -12,6 +13,7 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/sensor_delegate.h
   ${HERALD_BASE}/include/herald/sensor.h
   ${HERALD_BASE}/include/herald/analysis/aggregates.h
+  ${HERALD_BASE}/include/herald/analysis/distance_batch.h
   ${HERALD_BASE}/include/herald/analysis/distance_conversion.h
   ${HERALD_BASE}/include/herald/analysis/logging_analysis_delegate.h
   ${HERALD_BASE}/include/herald/analysis/ranges.h
@@ -19,8 +21,11 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/analysis/sampling.h
   ${HERALD_BASE}/include/herald/analysis/sample_algorithms.h
   ${HERALD_BASE}/include/herald/analysis/sensor_source.h
+  ${HERALD_BASE}/include/herald/analysis/sliding_window.h
   ${HERALD_BASE}/include/herald/ble/ble.h
+  ${HERALD_BASE}/include/herald/ble/ble_advert_queue.h
   ${HERALD_BASE}/include/herald/ble/ble_concrete.h
+  ${HERALD_BASE}/include/herald/ble/ble_connection_scheduler.h
   ${HERALD_BASE}/include/herald/ble/ble_coordinator.h
   ${HERALD_BASE}/include/herald/ble/ble_database_delegate.h
   ${HERALD_BASE}/include/herald/ble/ble_database.h
@@ -36,8 +41,11 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/ble/bluetooth_state_manager.h
   ${HERALD_BASE}/include/herald/ble/bluetooth_state_manager_delegate.h
   ${HERALD_BASE}/include/herald/ble/filter/ble_advert_parser.h
+  ${HERALD_BASE}/include/herald/ble/filter/ble_advert_view.h
   ${HERALD_BASE}/include/herald/ble/filter/ble_advert_types.h
   ${HERALD_BASE}/include/herald/ble/zephyr/nordic_uart/nordic_uart_sensor_delegate.h
+  ${HERALD_BASE}/include/herald/data/append_log.h
+  ${HERALD_BASE}/include/herald/data/binary_logging_sink.h
   ${HERALD_BASE}/include/herald/data/contact_log.h
   ${HERALD_BASE}/include/herald/data/payload_data_formatter.h
   ${HERALD_BASE}/include/herald/data/sensor_logger.h
@@ -52,6 +60,7 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/datatype/encounter.h
   ${HERALD_BASE}/include/herald/datatype/exposure_risk.h
   ${HERALD_BASE}/include/herald/datatype/error_code.h
+  ${HERALD_BASE}/include/herald/datatype/hash.h
   ${HERALD_BASE}/include/herald/datatype/immediate_send_data.h
   ${HERALD_BASE}/include/herald/datatype/location_reference.h
   ${HERALD_BASE}/include/herald/datatype/location.h
@@ -70,6 +79,7 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/datatype/sensor_type.h
   ${HERALD_BASE}/include/herald/datatype/sha256.h
   ${HERALD_BASE}/include/herald/datatype/signal_characteristic_data.h
+  ${HERALD_BASE}/include/herald/datatype/slot_index.h
   ${HERALD_BASE}/include/herald/datatype/subject_parameters.h
   ${HERALD_BASE}/include/herald/datatype/target_identifier.h
   ${HERALD_BASE}/include/herald/datatype/time_interval.h
@@ -77,13 +87,18 @@ set(HERALD_HEADERS
   ${HERALD_BASE}/include/herald/engine/activities.h
   ${HERALD_BASE}/include/herald/engine/coordinator.h
   ${HERALD_BASE}/include/herald/exposure/exposure_manager.h
+  ${HERALD_BASE}/include/herald/exposure/file_exposure_store.h
+  ${HERALD_BASE}/include/herald/exposure/file_risk_store.h
+  ${HERALD_BASE}/include/herald/exposure/file_score_log.h
   ${HERALD_BASE}/include/herald/exposure/model.h
   ${HERALD_BASE}/include/herald/exposure/parameters.h
+  ${HERALD_BASE}/include/herald/exposure/refresh_pool.h
   ${HERALD_BASE}/include/herald/exposure/risk_manager.h
   ${HERALD_BASE}/include/herald/payload/payload_data_supplier.h
   ${HERALD_BASE}/include/herald/payload/beacon/beacon_payload_data_supplier.h
   ${HERALD_BASE}/include/herald/payload/fixed/fixed_payload_data_supplier.h
   ${HERALD_BASE}/include/herald/payload/simple/contact_identifier.h
+  ${HERALD_BASE}/include/herald/payload/simple/contact_identifier_matcher.h
   ${HERALD_BASE}/include/herald/payload/simple/contact_key.h
   ${HERALD_BASE}/include/herald/payload/simple/contact_key_seed.h
   ${HERALD_BASE}/include/herald/payload/simple/f.h
@@ -115,6 +130,7 @@ set(HERALD_HEADERS_WINDOWS
 
 )
 set(HERALD_SOURCES
+  ${HERALD_BASE}/src/analysis/distance_batch.cpp
   ${HERALD_BASE}/src/ble/ble.cpp
   ${HERALD_BASE}/src/ble/ble_mac_address.cpp
   ${HERALD_BASE}/src/ble/ble_coordinator.cpp
@@ -125,6 +141,7 @@ set(HERALD_SOURCES
   ${HERALD_BASE}/src/ble/concrete_ble_sensor.cpp
   ${HERALD_BASE}/src/ble/concrete_ble_database.cpp
   ${HERALD_BASE}/src/ble/filter/ble_advert_parser.cpp
+  ${HERALD_BASE}/src/ble/filter/ble_advert_view.cpp
   ${HERALD_BASE}/src/ble/filter/ble_advert_types.cpp
   ${HERALD_BASE}/src/data/concrete_payload_data_formatter.cpp
   ${HERALD_BASE}/src/data/sensor_logger.cpp
@@ -136,6 +153,7 @@ set(HERALD_SOURCES
   ${HERALD_BASE}/src/datatype/distribution.cpp
   ${HERALD_BASE}/src/datatype/encounter.cpp
   ${HERALD_BASE}/src/datatype/exposure_risk.cpp
+  ${HERALD_BASE}/src/datatype/hash.cpp
   ${HERALD_BASE}/src/datatype/immediate_send_data.cpp
   ${HERALD_BASE}/src/datatype/location.cpp
   ${HERALD_BASE}/src/datatype/luminosity.cpp
@@ -143,6 +161,7 @@ set(HERALD_SOURCES
   ${HERALD_BASE}/src/datatype/rssi.cpp
   ${HERALD_BASE}/src/datatype/rssi_minute.cpp
   ${HERALD_BASE}/src/datatype/sensor_type.cpp
+  ${HERALD_BASE}/src/datatype/sha256_batch.cpp
   ${HERALD_BASE}/src/datatype/signal_characteristic_data.cpp
   ${HERALD_BASE}/src/datatype/target_identifier.cpp
   ${HERALD_BASE}/src/datatype/time_interval.cpp
@@ -164,6 +183,12 @@ set(HERALD_SOURCES_ZEPHYR
   ${HERALD_BASE}/src/data/zephyr/zephyr_logging_sink.cpp
   ${HERALD_BASE}/src/zephyr_context.cpp
 )
+# Host (server side) components, E.g. multi threaded or file backed. Not built for embedded targets
+set(HERALD_SOURCES_SERVER
+  ${HERALD_BASE}/src/data/append_log.cpp
+  ${HERALD_BASE}/src/exposure/refresh_pool.cpp
+  ${HERALD_BASE}/src/payload/simple/contact_identifier_matcher.cpp
+)
 set(HERALD_SOURCES_MBEDTLS
   ${HERALD_BASE}/src/datatype/mbedtls/sha256.cpp
 )
@@ -16,6 +16,7 @@
 // Convenience include file
 
 // Root namespace
+#include "herald/clock.h"
 #include "herald/context.h"
 #include "herald/default_sensor_delegate.h"
 #include "herald/device.h"
@@ -46,6 +47,7 @@
 #include "herald/datatype/distribution.h"
 #include "herald/datatype/encounter.h"
 #include "herald/datatype/error_code.h"
+#include "herald/datatype/hash.h"
 #include "herald/datatype/exposure_risk.h"
 #include "herald/datatype/immediate_send_data.h"
 #include "herald/datatype/location_reference.h"
@@ -66,6 +68,7 @@
 #include "herald/datatype/sensor_state.h"
 #include "herald/datatype/sensor_type.h"
 #include "herald/datatype/signal_characteristic_data.h"
+#include "herald/datatype/slot_index.h"
 #include "herald/datatype/subject_parameters.h"
 #include "herald/datatype/target_identifier.h"
 #include "herald/datatype/time_interval.h"
@@ -73,6 +76,8 @@
 #include "herald/datatype/wgs84.h"
 
 // data namespace
+#include "herald/data/append_log.h"
+#include "herald/data/binary_logging_sink.h"
 #include "herald/data/contact_log.h"
 #include "herald/data/payload_data_formatter.h"
 #include "herald/data/sensor_logger.h"
@@ -84,6 +89,8 @@
 
 // ble namespace
 #include "herald/ble/ble.h"
+#include "herald/ble/ble_advert_queue.h"
+#include "herald/ble/ble_connection_scheduler.h"
 #include "herald/ble/ble_coordinator.h"
 #include "herald/ble/ble_database_delegate.h"
 #include "herald/ble/ble_database.h"
@@ -101,6 +108,7 @@
 
 #include "herald/ble/filter/ble_advert_types.h"
 #include "herald/ble/filter/ble_advert_parser.h"
+#include "herald/ble/filter/ble_advert_view.h"
 
 #include "herald/ble/ble_concrete.h"
 #include "herald/ble/ble_concrete_database.h"
@@ -110,6 +118,7 @@
 
 // analysis namespace
 #include "herald/analysis/aggregates.h"
+#include "herald/analysis/distance_batch.h"
 #include "herald/analysis/distance_conversion.h"
 #include "herald/analysis/logging_analysis_delegate.h"
 #include "herald/analysis/ranges.h"
@@ -117,12 +126,17 @@
 #include "herald/analysis/sampling.h"
 #include "herald/analysis/sample_algorithms.h"
 #include "herald/analysis/sensor_source.h"
+#include "herald/analysis/sliding_window.h"
 
 // exposure namespace
 //#include "herald/exposure/agent.h"
 #include "herald/exposure/exposure_manager.h"
+#include "herald/exposure/file_exposure_store.h"
+#include "herald/exposure/file_risk_store.h"
+#include "herald/exposure/file_score_log.h"
 #include "herald/exposure/model.h"
 #include "herald/exposure/parameters.h"
+#include "herald/exposure/refresh_pool.h"
 #include "herald/exposure/risk_manager.h"
 
 // risk namespace
@@ -134,6 +148,7 @@
 #include "herald/payload/beacon/beacon_payload_data_supplier.h"
 #include "herald/payload/fixed/fixed_payload_data_supplier.h"
 #include "herald/payload/simple/contact_identifier.h"
+#include "herald/payload/simple/contact_identifier_matcher.h"
 #include "herald/payload/simple/contact_key.h"
 #include "herald/payload/simple/contact_key_seed.h"
 #include "herald/payload/simple/f.h"
@@ -5,12 +5,17 @@
 #ifndef HERALD_AGGREGATES_H
 #define HERALD_AGGREGATES_H
 
+#include <cmath> // Used in WindowedGaussian
+#include <cstddef>
+#include <iterator> // Used in WindowedMedian
 #include <map> // Used in Mode
+#include <set> // Used in WindowedMode and WindowedMedian
 #include <variant> // Used in aggregate::operator|()
 #include <vector> // Used in aggregate::operator|()
 // #include <iostream>
 
 #include "ranges.h"
+#include "../datatype/distribution.h"
 
 namespace herald {
 namespace analysis {
@@ -401,13 +406,359 @@ struct Gaussian {
     distribution.reset();
   }
 
-  const Distribution& model() const {
+  const herald::datatype::Distribution& model() const {
     return distribution;
   }
 
 private:
   int run;
-  Distribution distribution;
+  herald::datatype::Distribution distribution;
+};
+
+
+
+/// Windowed aggregates accept remove() as well as add(), so that a SlidingWindow can keep them
+/// current as samples enter and leave it rather than rescanning every sample each time.
+/// map() adds a value, so they may also be used with aggregate and summarise.
+
+/// \brief Mean supporting removal, in O(1)
+struct WindowedMean {
+  static constexpr int runs = 1;
+
+  WindowedMean() : run(1), count(0), sum(0.0) {}
+  ~WindowedMean() = default;
+
+  void beginRun(int thisRun) { // 1 indexed
+    run = thisRun;
+  }
+
+  template <typename ValT>
+  void map(ValT value) {
+    if (run > 1) return; // performance enhancement
+
+    add((double)value);
+  }
+
+  void add(double value) noexcept {
+    sum += value;
+    ++count;
+  }
+
+  void remove(double value) noexcept {
+    sum -= value;
+    --count;
+  }
+
+  std::size_t size() const noexcept {
+    return count;
+  }
+
+  double reduce() const noexcept {
+    if (0 == count) {
+      return 0.0;
+    }
+    return sum / count;
+  }
+
+  void reset() noexcept {
+    run = 1;
+    count = 0;
+    sum = 0.0;
+  }
+
+private:
+  int run;
+  std::size_t count;
+  double sum;
+};
+
+/// \brief Sample variance supporting removal, using Welford's algorithm, in O(1)
+struct WindowedVariance {
+  static constexpr int runs = 1;
+
+  WindowedVariance() : run(1), count(0), runningMean(0.0), m2(0.0) {}
+  ~WindowedVariance() = default;
+
+  void beginRun(int thisRun) { // 1 indexed
+    run = thisRun;
+  }
+
+  template <typename ValT>
+  void map(ValT value) {
+    if (run > 1) return; // performance enhancement
+
+    add((double)value);
+  }
+
+  void add(double value) noexcept {
+    ++count;
+    const double delta = value - runningMean;
+    runningMean += delta / count;
+    m2 += delta * (value - runningMean);
+  }
+
+  void remove(double value) noexcept {
+    if (count <= 1) {
+      reset();
+      return;
+    }
+    const double previousMean = (runningMean * count - value) / (count - 1);
+    m2 -= (value - runningMean) * (value - previousMean);
+    if (m2 < 0.0) {
+      m2 = 0.0; // rounding
+    }
+    runningMean = previousMean;
+    --count;
+  }
+
+  std::size_t size() const noexcept {
+    return count;
+  }
+
+  double mean() const noexcept {
+    return runningMean;
+  }
+
+  /// \brief Sample variance, or 0 for fewer than two values
+  double reduce() const noexcept {
+    if (count < 2) {
+      return 0.0;
+    }
+    return m2 / (count - 1);
+  }
+
+  void reset() noexcept {
+    run = 1;
+    count = 0;
+    runningMean = 0.0;
+    m2 = 0.0;
+  }
+
+private:
+  int run;
+  std::size_t count;
+  double runningMean;
+  double m2;
+};
+
+/// \brief Mode supporting removal, from a frequency map, in O(log n)
+///
+/// Ties are broken in favour of the smallest value, as for Mode.
+struct WindowedMode {
+  static constexpr int runs = 1;
+
+  WindowedMode() : run(1), counts(), ranked() {}
+  ~WindowedMode() = default;
+
+  void beginRun(int thisRun) { // 1 indexed
+    run = thisRun;
+  }
+
+  template <typename ValT>
+  void map(ValT value) {
+    if (run > 1) return; // performance enhancement
+
+    add((double)value);
+  }
+
+  void add(double value) {
+    auto& count = counts[value];
+    if (count > 0) {
+      ranked.erase(Ranked{count,value});
+    }
+    ++count;
+    ranked.insert(Ranked{count,value});
+  }
+
+  void remove(double value) {
+    auto found = counts.find(value);
+    if (counts.end() == found) {
+      return;
+    }
+    ranked.erase(Ranked{found->second,value});
+    if (0 == --(found->second)) {
+      counts.erase(found);
+    } else {
+      ranked.insert(Ranked{found->second,value});
+    }
+  }
+
+  double reduce() const noexcept {
+    if (ranked.empty()) {
+      return 0.0;
+    }
+    return ranked.begin()->value;
+  }
+
+  /// \brief The mode of only those values within [min,max], or 0 if there are none.
+  /// Linear in the number of distinct values in the range.
+  double modeWithin(double min, double max) const {
+    if (!(min <= max)) {
+      return 0.0; // also guards against NaN bounds
+    }
+    double largest = 0.0;
+    std::size_t largestCount = 0;
+    for (auto iter = counts.lower_bound(min);iter != counts.end() && iter->first <= max;++iter) {
+      if (iter->second > largestCount) {
+        largestCount = iter->second;
+        largest = iter->first;
+      }
+    }
+    return largest;
+  }
+
+  void reset() {
+    run = 1;
+    counts.clear();
+    ranked.clear();
+  }
+
+private:
+  struct Ranked {
+    std::size_t count;
+    double value;
+
+    bool operator<(const Ranked& other) const noexcept {
+      // Most frequent first, then smallest value first
+      return count > other.count || (count == other.count && value < other.value);
+    }
+  };
+
+  int run;
+  std::map<double,std::size_t> counts;
+  std::set<Ranked> ranked;
+};
+
+/// \brief Median supporting removal, using two balanced halves, in O(log n)
+struct WindowedMedian {
+  static constexpr int runs = 1;
+
+  WindowedMedian() : run(1), lower(), upper() {}
+  ~WindowedMedian() = default;
+
+  void beginRun(int thisRun) { // 1 indexed
+    run = thisRun;
+  }
+
+  template <typename ValT>
+  void map(ValT value) {
+    if (run > 1) return; // performance enhancement
+
+    add((double)value);
+  }
+
+  void add(double value) {
+    if (lower.empty() || value <= *lower.rbegin()) {
+      lower.insert(value);
+    } else {
+      upper.insert(value);
+    }
+    rebalance();
+  }
+
+  void remove(double value) {
+    if (!lower.empty() && value <= *lower.rbegin()) {
+      auto found = lower.find(value);
+      if (lower.end() == found) {
+        return;
+      }
+      lower.erase(found);
+    } else {
+      auto found = upper.find(value);
+      if (upper.end() == found) {
+        return;
+      }
+      upper.erase(found);
+    }
+    rebalance();
+  }
+
+  std::size_t size() const noexcept {
+    return lower.size() + upper.size();
+  }
+
+  double reduce() const noexcept {
+    if (lower.empty()) {
+      return 0.0; // empty data check
+    }
+    if (lower.size() > upper.size()) {
+      return *lower.rbegin();
+    }
+    return (*lower.rbegin() + *upper.begin()) / 2.0;
+  }
+
+  void reset() {
+    run = 1;
+    lower.clear();
+    upper.clear();
+  }
+
+private:
+  int run;
+  std::multiset<double> lower; // the smaller half, holding the extra value when the count is odd
+  std::multiset<double> upper;
+
+  void rebalance() {
+    if (lower.size() > upper.size() + 1) {
+      auto largest = std::prev(lower.end());
+      upper.insert(*largest);
+      lower.erase(largest);
+    } else if (upper.size() > lower.size()) {
+      auto smallest = upper.begin();
+      lower.insert(*smallest);
+      upper.erase(smallest);
+    }
+  }
+};
+
+/// \brief Gaussian model (mean and standard deviation) supporting removal, in O(1)
+struct WindowedGaussian {
+  static constexpr int runs = 1;
+
+  WindowedGaussian() : run(1), variance() {}
+  ~WindowedGaussian() = default;
+
+  void beginRun(int thisRun) {
+    run = thisRun;
+  }
+
+  template <typename ValT>
+  void map(ValT value) {
+    if (run > 1) {
+      return;
+    }
+    add((double)value);
+  }
+
+  void add(double value) noexcept {
+    variance.add(value);
+  }
+
+  void remove(double value) noexcept {
+    variance.remove(value);
+  }
+
+  std::size_t size() const noexcept {
+    return variance.size();
+  }
+
+  /// \brief The mean, as for Gaussian
+  double reduce() const noexcept {
+    return variance.mean();
+  }
+
+  double standardDeviation() const noexcept {
+    return std::sqrt(variance.reduce());
+  }
+
+  void reset() noexcept {
+    run = 1;
+    variance.reset();
+  }
+
+private:
+  int run;
+  WindowedVariance variance;
 };
 
 
@@ -0,0 +1,108 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_DISTANCE_BATCH_H
+#define HERALD_DISTANCE_BATCH_H
+
+#include "sampling.h"
+#include "../datatype/date.h"
+#include "../datatype/rssi.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace herald {
+namespace analysis {
+namespace algorithms {
+namespace distance {
+
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+/// \brief The result of FowlerBatch for one source
+struct FowlerEstimate {
+  /// \brief False if the source had no valid RSSI since it was last analysed, as when
+  /// FowlerBasicAnalyser produces no sample
+  bool hasDistance;
+  double distance;
+};
+
+/// \brief Fowler basic distance estimation for many sources in one call, for gateways
+/// tracking large numbers of devices.
+///
+/// Each source's RSSI window is appended with add() to one contiguous buffer. estimate()
+/// then takes the count, mode and sample variance of the new valid (-99 to -10) RSSI of each
+/// source, the mode of all valid RSSI within two standard deviations of that mode, and from
+/// it the distance. Results are identical to those of FowlerBasicAnalyser for the same data.
+///
+/// Modes are taken from per source histograms rather than maps, as RSSI values are small
+/// integers. This, not vectorisation, is where most of the gain over FowlerBasicAnalyser
+/// comes from. On x86-64 the count and variance sums of several sources are added in one
+/// vector (AVX2 where the CPU supports it), each lane summing in the same order as the
+/// scalar path, but each lane's values are still gathered one at a time.
+///
+/// \note Experimental. No analyser or AnalysisRunner uses this yet, as they analyse one
+/// source per call. Callers holding many sources' samples may use it directly.
+class FowlerBatch {
+public:
+  FowlerBatch(double intercept = -11, double coefficient = -0.4) noexcept;
+  ~FowlerBatch() noexcept = default;
+
+  /// \brief Appends a source's RSSI values, oldest first. Values before newFrom were
+  /// analysed in a previous run, and only contribute to the final mode.
+  void add(const std::int8_t* rssi, std::size_t length, std::size_t newFrom);
+
+  /// \brief Appends the RSSI held in a SampleList, treating samples taken after since as new.
+  /// Samples must be in time order, as pushed by the AnalysisRunner.
+  template <typename SampleListT>
+  void add(const SampleListT& src, Date since) {
+    const std::size_t length = src.size();
+    const std::size_t offset = values.size();
+    std::size_t newFrom = length;
+    values.reserve(offset + length);
+    for (std::size_t idx = 0;idx < length;++idx) {
+      values.push_back(toValue(src[idx].value.intValue()));
+      if (newFrom == length && src[idx].taken > since) {
+        newFrom = idx;
+      }
+    }
+    windows.push_back(Window{offset, length, newFrom});
+  }
+
+  /// \brief Removes every source added
+  void clear() noexcept;
+
+  /// \brief Number of sources added
+  std::size_t size() const noexcept;
+
+  /// \brief Estimates the distance of each source added, in the order they were added.
+  /// into is resized to size().
+  void estimate(std::vector<FowlerEstimate>& into) const;
+
+  /// \brief Converts an RSSI value to the stored form. Values that cannot be held are
+  /// stored as 0, which like them is never valid.
+  static std::int8_t toValue(int rssi) noexcept {
+    return (rssi < INT8_MIN || rssi > INT8_MAX) ? 0 : std::int8_t(rssi);
+  }
+
+private:
+  struct Window {
+    std::size_t offset;
+    std::size_t length;
+    std::size_t newFrom;
+  };
+
+  double intercept;
+  double coefficient;
+  std::vector<std::int8_t> values; // every source's RSSI back to back
+  std::vector<Window> windows;
+};
+
+}
+}
+}
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "ranges.h"
 #include "runner.h"
 #include "sampling.h"
+#include "sliding_window.h"
 #include "../datatype/distance.h"
 
 // Debug only
@@ -42,7 +43,12 @@ struct FowlerBasic {
   }
 
   double reduce() {
-    double exponent = (mode.reduce() - intercept) / coefficient;
+    return fromMode(mode.reduce());
+  }
+
+  /// \brief Distance for a given mode RSSI
+  double fromMode(double modeRSSI) const {
+    double exponent = (modeRSSI - intercept) / coefficient;
     return std::pow(10, exponent); // distance
   }
 
@@ -63,8 +69,8 @@ struct FowlerBasicAnalyser {
   using output_value_type = Distance;
 
   /// default constructor required for array instantiation in manager AnalysisProviderManager
-  FowlerBasicAnalyser() : interval(10), basic(-11,-0.4), lastRan(0) {}
-  FowlerBasicAnalyser(long interval, double intercept, double coefficient) : interval(interval), basic(intercept, coefficient), lastRan(0) {}
+  FowlerBasicAnalyser() : interval(10), basic(-11,-0.4), lastRan(0), windows() {}
+  FowlerBasicAnalyser(long interval, double intercept, double coefficient) : interval(interval), basic(intercept, coefficient), lastRan(0), windows() {}
   ~FowlerBasicAnalyser() = default;
 
   // Generic
@@ -93,13 +99,6 @@ struct FowlerBasicAnalyser {
     //   return false;
     // }
 
-    basic.reset();
-
-    auto values = src 
-                | herald::analysis::views::filter(valid) 
-                | herald::analysis::views::filter(sinceLastRun)
-                | herald::analysis::views::to_view();
-
     auto summary = newData
                  | summarise<Count,Mode,Variance>();
 
@@ -113,21 +112,16 @@ struct FowlerBasicAnalyser {
     auto var = summary.template get<Variance>();
     auto sd = std::sqrt(var);
 
-    auto distance = src 
-                  | herald::analysis::views::filter(valid) 
-                  | herald::analysis::views::filter(
-                      herald::analysis::views::in_range(
-                        mode - 2*sd, // NOTE: WE USE THE MODE FOR FILTER, BUT SD FOR BOUNDS - See website for the reasoning
-                        mode + 2*sd
-                      )
-                    )
-                  | aggregate(basic); // type actually <herald::analysis::algorithms::distance::FowlerBasic>
-    
-    auto agg = distance.template get<FowlerBasic>();
-    auto d = agg.reduce();
-
-
-    Date latestTime = values.latest();
+    // The mode of all valid data is kept up to date as samples arrive and leave, rather than
+    // recounted over the whole list on each run
+    auto& window = windows.window(sampled, timeNow);
+    window.sync(src, [&valid](const Sample<RSSI>& sample) { return valid(sample); });
+    auto d = basic.fromMode(window.template get<WindowedMode>().modeWithin(
+      mode - 2*sd, // NOTE: WE USE THE MODE FOR FILTER, BUT SD FOR BOUNDS - See website for the reasoning
+      mode + 2*sd
+    ));
+
+    Date latestTime = newData.latest();
     lastRan = latestTime; // TODO move this logic to the caller not the analysis provider
     // std::cout << "Latest value at time: " << latestTime.secondsSinceUnixEpoch() << std::endl;
 
@@ -141,6 +135,7 @@ private:
   TimeInterval interval;
   FowlerBasic basic;
   Date lastRan;
+  SourceWindows<SlidingWindow<WindowedMode>> windows;
 };
 
 }
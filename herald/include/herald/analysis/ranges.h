@@ -274,11 +274,11 @@ struct view {
   //   //return source.latest();
   //   return *(source.end() - 1);
   // }
-  Date latest() {
+  herald::datatype::Date latest() {
     return (*(source.end() - 1)).taken;
   }
 
-  Date earliest() {
+  herald::datatype::Date earliest() {
     IterProxyT srcCopy{source};
     return (*(srcCopy)).taken;
   }
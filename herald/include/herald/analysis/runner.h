@@ -6,9 +6,17 @@
 #define HERALD_ANALYSIS_RUNNER_H
 
 #include "sampling.h"
+#include "../datatype/time_interval.h"
 
 #include <variant>
+#include <algorithm>
 #include <array>
+#include <bitset>
+#include <map>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 // debug only
 // #include <iostream>
@@ -34,6 +42,32 @@ struct ListManager {
 
   void remove(const SampledID listFor) {
     lists.erase(listFor);
+    changedIds.erase(listFor);
+  }
+
+  /// \brief Records that new samples have been added to the list for sampled
+  void changed(const SampledID sampled) {
+    changedIds.insert(sampled);
+  }
+
+  /// \brief Calls f(sampled, list) for each changed list, in SampledID order. A list stays
+  /// changed if f returns false. f may add samples to (or add sources to) this ListManager, but
+  /// must not remove the source it was given, as that destroys the list passed to it.
+  template <typename CallableT>
+  void forEachChanged(CallableT&& f) {
+    pending.assign(changedIds.begin(), changedIds.end());
+    changedIds.clear();
+    std::sort(pending.begin(), pending.end());
+    for (auto sampled : pending) {
+      auto iter = lists.find(sampled);
+      if (lists.end() != iter && !f(iter->first, iter->second)) {
+        changedIds.insert(sampled);
+      }
+    }
+  }
+
+  void clearChanged() {
+    changedIds.clear();
   }
 
   const std::size_t size() const {
@@ -50,6 +84,247 @@ struct ListManager {
 
 private:
   std::map<SampledID,SampleList<Sample<ValT>,Size>> lists;
+  std::unordered_set<SampledID> changedIds;
+  std::vector<SampledID> pending; // reused by forEachChanged
+};
+
+/// \brief A ListManager held in a fixed capacity, open addressed (linear probing) table.
+///
+/// The SampledIDs are held contiguously apart from the lists, so finding the list for a
+/// sample only touches a few adjacent IDs rather than walking std::map nodes across the heap.
+/// Nothing is allocated after construction. When a new source arrives and the table is full
+/// the source with the oldest latest sample is evicted, and evictStale() removes every source
+/// not sampled within staleAfter().
+///
+/// Note each source's samples remain a SampleList of Sample structs, not separate timestamp and
+/// value arrays, as the existing analysers and views read Sample references from them.
+template <typename ValT, std::size_t Size, std::size_t Capacity = 64>
+struct FlatListManager {
+  using value_type = ValT;
+  using list_type = SampleList<Sample<ValT>,Size>;
+  static constexpr std::size_t max_size = Size;
+  static constexpr std::size_t capacity = Capacity;
+  static_assert(Capacity > 0, "FlatListManager requires a non zero Capacity");
+
+  /// \brief Iterates occupied slots, providing first (SampledID) and second (list) as std::map does
+  template <typename ManagerT, typename ListT>
+  struct Iterator {
+    Iterator(ManagerT& manager, std::size_t from) noexcept : manager(manager), pos(from) {
+      skipEmpty();
+    }
+
+    std::pair<const SampledID&,ListT&> operator*() const noexcept {
+      return std::pair<const SampledID&,ListT&>(manager.ids[pos],manager.lists[pos]);
+    }
+
+    Iterator& operator++() noexcept {
+      ++pos;
+      skipEmpty();
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const noexcept {
+      return pos == other.pos;
+    }
+
+    bool operator!=(const Iterator& other) const noexcept {
+      return pos != other.pos;
+    }
+
+  private:
+    ManagerT& manager;
+    std::size_t pos;
+
+    void skipEmpty() noexcept {
+      while (pos < Capacity && !manager.occupied[pos]) {
+        ++pos;
+      }
+    }
+  };
+
+  using iterator = Iterator<FlatListManager,list_type>;
+
+  FlatListManager() : ids(), occupied(), dirty(), lists(), pending(), count(0), staleInterval(TimeInterval::minutes(15)) {}
+  ~FlatListManager() = default;
+
+  list_type& list(const SampledID sampled) {
+    std::size_t pos = find(sampled);
+    if (Capacity != pos) {
+      return lists[pos];
+    }
+    if (Capacity == count) {
+      eraseSlot(oldestSlot());
+    }
+    pos = home(sampled);
+    while (occupied[pos]) {
+      pos = next(pos);
+    }
+    ids[pos] = sampled;
+    occupied.set(pos);
+    dirty.reset(pos);
+    lists[pos].clear();
+    ++count;
+    return lists[pos];
+  }
+
+  void remove(const SampledID listFor) {
+    std::size_t pos = find(listFor);
+    if (Capacity != pos) {
+      eraseSlot(pos);
+    }
+  }
+
+  /// \brief Records that new samples have been added to the list for sampled
+  void changed(const SampledID sampled) noexcept {
+    std::size_t pos = find(sampled);
+    if (Capacity != pos) {
+      dirty.set(pos);
+    }
+  }
+
+  /// \brief Calls f(sampled, list) for each changed list. A list stays changed if f returns false.
+  ///
+  /// f may add samples to lists of sources already in this FlatListManager, including the one
+  /// passed. f must not add a new source (call list() for a SampledID not present) or remove
+  /// one, as either may move lists between slots and leave the list reference given to f (and
+  /// any it holds from earlier calls) referring to another source's samples.
+  template <typename CallableT>
+  void forEachChanged(CallableT&& f) {
+    // Collect IDs first, as f may move entries around the table
+    std::size_t changedCount = 0;
+    for (std::size_t pos = 0;pos < Capacity;++pos) {
+      if (dirty[pos]) {
+        pending[changedCount++] = ids[pos];
+      }
+    }
+    dirty.reset();
+    for (std::size_t idx = 0;idx < changedCount;++idx) {
+      std::size_t pos = find(pending[idx]);
+      if (Capacity != pos && !f(ids[pos], lists[pos])) {
+        changed(pending[idx]);
+      }
+    }
+  }
+
+  void clearChanged() noexcept {
+    dirty.reset();
+  }
+
+  /// \brief Removes every source with no sample taken since timeNow - staleAfter()
+  void evictStale(Date timeNow) {
+    // Date is unsigned, so don't wrap below zero for times soon after epoch or restart
+    const std::uint64_t stale = std::uint64_t(std::max(0L, staleInterval.seconds()));
+    const std::uint64_t now = timeNow.secondsSinceUnixEpoch();
+    const Date cutoff(now > stale ? now - stale : 0);
+    for (std::size_t pos = 0;pos < Capacity;) {
+      if (occupied[pos] && (0 == lists[pos].size() || lists[pos].latest() < cutoff)) {
+        eraseSlot(pos); // may move a later entry into pos, so check pos again
+      } else {
+        ++pos;
+      }
+    }
+  }
+
+  TimeInterval staleAfter() const noexcept {
+    return staleInterval;
+  }
+
+  void staleAfter(TimeInterval interval) noexcept {
+    staleInterval = interval;
+  }
+
+  const std::size_t size() const {
+    return count;
+  }
+
+  iterator begin() noexcept {
+    return iterator(*this,0);
+  }
+
+  iterator end() noexcept {
+    return iterator(*this,Capacity);
+  }
+
+private:
+  std::array<SampledID,Capacity> ids;
+  std::bitset<Capacity> occupied;
+  std::bitset<Capacity> dirty; // has new samples to analyse
+  std::array<list_type,Capacity> lists;
+  std::array<SampledID,Capacity> pending; // reused by forEachChanged
+  std::size_t count;
+  TimeInterval staleInterval;
+
+  static std::size_t home(SampledID sampled) noexcept {
+    // SampledIDs are usually hashes already, but spread small sequential values too
+    return (std::size_t)((std::uint64_t(sampled) * 0x9E3779B97F4A7C15ull) >> 32) % Capacity;
+  }
+
+  static std::size_t next(std::size_t pos) noexcept {
+    return (pos + 1 == Capacity) ? 0 : pos + 1;
+  }
+
+  std::size_t find(SampledID sampled) const noexcept {
+    std::size_t pos = home(sampled);
+    for (std::size_t probes = 0;probes < Capacity && occupied[pos];++probes) {
+      if (ids[pos] == sampled) {
+        return pos;
+      }
+      pos = next(pos);
+    }
+    return Capacity;
+  }
+
+  std::size_t oldestSlot() const noexcept {
+    std::size_t oldest = Capacity;
+    for (std::size_t pos = 0;pos < Capacity;++pos) {
+      if (!occupied[pos]) {
+        continue;
+      }
+      if (0 == lists[pos].size()) {
+        return pos; // never sampled
+      }
+      if (Capacity == oldest || lists[pos].latest() < lists[oldest].latest()) {
+        oldest = pos;
+      }
+    }
+    return oldest;
+  }
+
+  /// Backward shift deletion, so no tombstones are needed
+  void eraseSlot(std::size_t hole) noexcept {
+    occupied.reset(hole);
+    dirty.reset(hole);
+    --count;
+    for (std::size_t pos = next(hole);occupied[pos];pos = next(pos)) {
+      const std::size_t want = home(ids[pos]);
+      // Move pos back into the hole unless its home lies cyclically within (hole, pos]
+      const bool homeInRange = (hole <= pos) ? (hole < want && want <= pos) : (hole < want || want <= pos);
+      if (!homeInRange) {
+        ids[hole] = ids[pos];
+        lists[hole] = std::move(lists[pos]);
+        occupied.set(hole);
+        occupied.reset(pos);
+        dirty[hole] = dirty[pos];
+        dirty.reset(pos);
+        hole = pos;
+      }
+    }
+  }
+};
+
+/// \brief Selects std::map backed ListManager instances for BasicAnalysisRunner
+struct MapListStorage {
+  template <typename ValT, std::size_t Size>
+  using manager = ListManager<ValT,Size>;
+  static constexpr bool evictsStale = false;
+};
+
+/// \brief Selects FlatListManager instances, each with room for Capacity sources, for BasicAnalysisRunner
+template <std::size_t Capacity>
+struct FlatListStorage {
+  template <typename ValT, std::size_t Size>
+  using manager = FlatListManager<ValT,Size,Capacity>;
+  static constexpr bool evictsStale = true;
 };
 
 /// \brief A fixed size set that holds exactly one instance of the std::variant for each
@@ -165,14 +440,16 @@ struct AnalysisProviderManager {
   }
   ~AnalysisProviderManager() = default;
 
-  template <typename InputValT, std::size_t SrcSz, typename SourceType, std::size_t ListSize, typename CallableForNewSample>
-  bool analyse(Date timeNow, SampledID sampled, SampleList<Sample<InputValT>,SrcSz>& src, ListManager<SourceType,ListSize>& lists, CallableForNewSample& callable) {
+  template <typename InputValT, std::size_t SrcSz, typename ListManagerT, typename CallableForNewSample>
+  bool analyse(Date timeNow, SampledID sampled, SampleList<Sample<InputValT>,SrcSz>& src, ListManagerT& lists, CallableForNewSample& callable) {
+    using OutputValT = typename ListManagerT::value_type;
     bool generated = false;
     for (auto& providerV : providers) {
       std::visit([&timeNow,&sampled,&src,&lists,&generated,&callable](auto&& arg) {
         using noref = typename std::remove_reference<decltype(arg)>::type;
         // Ensure our calee supports the types we have
-        if constexpr (std::is_same_v<InputValT, typename noref::input_value_type>) {
+        if constexpr (std::is_same_v<InputValT, typename noref::input_value_type> &&
+                      std::is_same_v<OutputValT, typename noref::output_value_type>) {
           auto& listRef = lists.list(sampled);
           generated = generated | ((decltype(arg))arg).analyse(timeNow,sampled,src,listRef,callable);
         }
@@ -196,28 +473,18 @@ struct AnalysisProviderManager {
 #endif
   }
 
+  /// \brief Whether any provider converts Sample<InputT::value_type> to OutputT. Resolved at compile time.
   template <typename InputT,typename OutputT>
-  constexpr bool hasMatchingAnalyser() noexcept {
-    bool match = false;
-    for (auto& providerV : providers) {
-      std::visit([&match] (auto&& provider) {
-        using InputValT = typename InputT::value_type;
-        using InT = typename std::remove_reference_t<decltype(provider)>::input_value_type;
-        using OutT = typename std::remove_reference_t<decltype(provider)>::output_value_type;
-        // std::cout << "  Provider being checked " << typeid(provider).name() << std::endl;
-        // InT inInstance;
-        // OutT outInstance;
-        // std::cout << "    In type " << typeid(inInstance).name() << ", out type " << typeid(outInstance).name() << std::endl;
-        // InputValT inputInstance;
-        // OutputT outputInstance;
-        // std::cout << "    Input type " << typeid(inputInstance).name() << ", output type " << typeid(outputInstance).name() << std::endl;
-        if constexpr (std::is_same_v<InputValT,InT> && std::is_same_v<OutputT,OutT>) {
-          match = true;
-          // std::cout << "  MATCHED!" << std::endl;
-        }
-      }, providerV);
-    }
-    return match;
+  static constexpr bool hasMatchingAnalyser() noexcept {
+    using InputValT = typename InputT::value_type;
+    return (false || ... || (std::is_same_v<InputValT,typename ProviderTypes::input_value_type> &&
+                             std::is_same_v<OutputT,typename ProviderTypes::output_value_type>));
+  }
+
+  /// \brief Whether any provider takes InputValT samples as its input
+  template <typename InputValT>
+  static constexpr bool hasAnalyserFor() noexcept {
+    return (false || ... || std::is_same_v<InputValT,typename ProviderTypes::input_value_type>);
   }
 
 private:
@@ -241,19 +508,26 @@ private:
 /// This class can be used 'live' against real sensors, or statically with reference data. 
 /// This is achieved by ensuring the run(Date) method takes in the Date for the time of evaluation rather
 /// than using the current Date.
-template <typename AnalysisDelegateManagerT, typename AnalysisProviderManagerT, typename... SourceTypes> // TODO derive SourceTypes from providers and delegates // TODO parameterise type lengths somehow (traits template?)
-struct AnalysisRunner {
+///
+/// ListStorageT chooses the ListManager used for each value type. See MapListStorage and FlatListStorage.
+template <typename ListStorageT, typename AnalysisDelegateManagerT, typename AnalysisProviderManagerT, typename... SourceTypes> // TODO derive SourceTypes from providers and delegates // TODO parameterise type lengths somehow (traits template?)
+struct BasicAnalysisRunner {
   static constexpr std::size_t ListSize = 25; // TODO make this external somehow for each type (trait?)
   // using valueTypes = (typename SourceTypes::value_type)...;
 
-  AnalysisRunner(AnalysisDelegateManagerT& adm, AnalysisProviderManagerT& provds) : lists(), delegates(adm), runners(provds) /*, hasNewData(false)*/ {}
-  ~AnalysisRunner() = default;
+  template <typename ValT>
+  using list_manager = typename ListStorageT::template manager<ValT,ListSize>;
+
+  BasicAnalysisRunner(AnalysisDelegateManagerT& adm, AnalysisProviderManagerT& provds) : lists(), delegates(adm), runners(provds), analyseAll(false) {}
+  ~BasicAnalysisRunner() = default;
 
   /// We are an analysis delegate ourselves - this is used by Source types, and by producers (analysis runners)
   template <typename ValT>
   void newSample(SampledID sampled, sampling::Sample<ValT> sample) {
     // incoming sample. Pass to correct list
-    lists.template get<ListManager<ValT,ListSize>>().list(sampled).push(sample); // TODO get ListSize dynamically
+    auto& manager = std::get<list_manager<ValT>>(lists);
+    manager.list(sampled).push(sample); // TODO get ListSize dynamically
+    manager.changed(sampled);
     // inform delegates
     delegates.notify(sampled,sample);
   }
@@ -263,49 +537,72 @@ struct AnalysisRunner {
     newSample(sampled,sample);
   }
 
+  /// \brief Whether run() also analyses sources with no new samples since they last produced output.
+  /// Defaults to false. Enable this for analysers that can produce a new value without new data.
+  bool analyseUnchanged() const noexcept {
+    return analyseAll;
+  }
+
+  void analyseUnchanged(bool analyseEverySource) noexcept {
+    analyseAll = analyseEverySource;
+  }
+
   /// Run the relevant analyses given the current time point
+  ///
+  /// Only sources with new samples are analysed (unless analyseUnchanged() is set). A source
+  /// stays pending until one of its analyses produces output, so interval guarded analysers
+  /// still see samples that arrived before their interval elapsed.
   void run(Date timeNow) {
-    // call analyse(dateNow,srcList,dstDelegate) for all delegates with the correct list each, for each sampled
-    
-    // DO NOT USE Performance enhancement - 'dirty' sample lists only (ones with new data)
-    // The reason this is commented out is because for some analysers producing a new value based on no new data may be valid.
-    // if (!hasNewData) {
-    //   // This also prevents 'new' conversions even if no new data has arrived, skewing analysis results
-    //   return;
-    // }
-    for (auto& listManager : lists) { // For each input list
-      std::visit([timeNow,this] (auto&& arg) { // Visit each of our list managers (that may be used as an output list)
-        for (auto& mgrPair : arg) { // For each output list instance // arg = ListManager<SampleList<InputValueT>,SrcSz>
-          // Derived Input type and size from 'list' input list
-          
-          auto& sampled = mgrPair.first;
-          auto& list = mgrPair.second;
-
-          for (auto& outputListManagerV : lists) {
-            std::visit([timeNow, &list, &sampled, this] (auto&& outputListManager) { // Visit each of our list managers (that may be used as an output list)
-              using InputValT = typename std::remove_reference_t<decltype(list)>::value_type;
-              using LMValT = typename std::remove_reference_t<decltype(outputListManager)>::value_type;
-              // std::cout << "Trying to call analysers for source type " << typeid(list).name() << " to output type " << typeid(outputListManager).name() << std::endl;
-
-              // Check for presence of an analyser that converts from InputValT to LMValT
-              if (runners.template hasMatchingAnalyser<InputValT,LMValT>()) {
-                // std::cout << "Found matching analyser!" << std::endl;
-                /*bool newDataGenerated =*/ runners.template analyse(timeNow,sampled,list,outputListManager, *this); // <InputValT,InputSz,LMValT,LMSz>
-              }
-            }, outputListManagerV);
-          }
-        }
-      }, listManager);
+    if constexpr (ListStorageT::evictsStale) {
+      std::apply([timeNow] (auto&... managers) {
+        (managers.evictStale(timeNow), ...);
+      }, lists);
     }
-    // hasNewData = false;
+    // Input and output list pairs with a matching analyser are chosen at compile time
+    (analyseSources<SourceTypes>(timeNow), ...);
   }
 
 private:
   // TODO make sizes a parameterised list derived from template parameters
-  VariantSet<ListManager<SourceTypes,ListSize>...> lists; // exactly one list manager per value type
+  std::tuple<list_manager<SourceTypes>...> lists; // exactly one list manager per value type
   AnalysisDelegateManagerT& delegates;
   AnalysisProviderManagerT& runners;
-  // bool hasNewData;
+  bool analyseAll;
+
+  template <typename InputValT>
+  void analyseSources(Date timeNow) {
+    auto& inputs = std::get<list_manager<InputValT>>(lists);
+    if constexpr (!AnalysisProviderManagerT::template hasAnalyserFor<InputValT>()) {
+      inputs.clearChanged(); // nothing ever reads this type
+    } else {
+      auto analyseSource = [timeNow,this] (SampledID sampled, auto& list) -> bool {
+        bool generated = false;
+        (analyseInto<SourceTypes>(timeNow,sampled,list,generated), ...);
+        return generated;
+      };
+      if (analyseAll) {
+        inputs.clearChanged();
+        for (auto&& entry : inputs) {
+          analyseSource(entry.first,entry.second);
+        }
+      } else {
+        inputs.forEachChanged(analyseSource);
+      }
+    }
+  }
+
+  template <typename OutputValT, typename InputListT>
+  void analyseInto(Date timeNow, SampledID sampled, InputListT& list, bool& generated) {
+    if constexpr (AnalysisProviderManagerT::template hasMatchingAnalyser<typename InputListT::value_type,OutputValT>()) {
+      generated = runners.analyse(timeNow,sampled,list,std::get<list_manager<OutputValT>>(lists),*this) || generated;
+    }
+  }
+};
+
+/// \brief The default AnalysisRunner, holding each source's samples in a std::map based ListManager
+template <typename AnalysisDelegateManagerT, typename AnalysisProviderManagerT, typename... SourceTypes>
+struct AnalysisRunner : BasicAnalysisRunner<MapListStorage,AnalysisDelegateManagerT,AnalysisProviderManagerT,SourceTypes...> {
+  using BasicAnalysisRunner<MapListStorage,AnalysisDelegateManagerT,AnalysisProviderManagerT,SourceTypes...>::BasicAnalysisRunner;
 };
 
 }
@@ -11,6 +11,7 @@
 #include "ranges.h"
 #include "runner.h"
 #include "sampling.h"
+#include "sliding_window.h"
 #include "../datatype/rssi_minute.h"
 #include "../datatype/rssi.h"
 #include "../datatype/time_interval.h"
@@ -79,8 +80,8 @@ struct RSSIMinutesAnalyser {
   // static constexpr std::size_t classId = RSSIMinute::classId;
 
   /// default constructor required for array instantiation in manager AnalysisProviderManager
-  RSSIMinutesAnalyser() : interval(5), calculator(), lastRan(0), hasRan(false) {}
-  RSSIMinutesAnalyser(long interval) : interval(interval), calculator(), lastRan(0), hasRan(false) {}
+  RSSIMinutesAnalyser() : interval(5), lastRan(0), hasRan(false), windows() {}
+  RSSIMinutesAnalyser(long interval) : interval(interval), lastRan(0), hasRan(false), windows() {}
   ~RSSIMinutesAnalyser() = default;
 
   // Generic
@@ -98,42 +99,39 @@ struct RSSIMinutesAnalyser {
     }
     // std::cout << "RUNNING FOWLER BASIC ANALYSIS at " << timeNow.secondsSinceUnixEpoch() << std::endl;
 
+    herald::analysis::views::in_range valid(-99,-10);
+
+    // Valid data is mirrored once per run, then each interval below only adds and removes the
+    // samples entering and leaving it
+    auto& window = windows.window(sampled, timeNow);
+    window.sync(src, [&valid](const Sample<RSSI>& sample) { return valid(sample); },
+      [](double rssi) { return 100.0 + rssi; }); // rssi is a negative
+    auto& agg = window.template get<WindowedMean>();
+
     // split into windows of data based on interval time
     Date startInterval = lastRan;
     while (startInterval <= timeNow) {
       // limit also to before startInterval + interval
       herald::analysis::views::beforeOrEqual beforeEndOfThisInterval(startInterval + interval);
 
-      herald::analysis::views::in_range valid(-99,-10);
-
       // Check that there has been any new data since the last run
       herald::analysis::views::sinceOrEqual sinceLastRun(lastRan);
-      // auto inRangeData =  src
-      //             | herald::analysis::views::filter(valid) 
-      //             | herald::analysis::views::filter(beforeEndOfThisInterval)
-      //             | herald::analysis::views::filter(sinceLastRun);
       auto newData = src
                   | herald::analysis::views::filter(valid) 
                   | herald::analysis::views::filter(beforeEndOfThisInterval)
                   | herald::analysis::views::filter(sinceLastRun)
                   | herald::analysis::views::to_view();
 
-      calculator.reset();
+      // The window aggregates the same range, adding and removing only the samples that moved
+      window.range(lastRan, startInterval + interval);
 
-      auto values = src
-                  | herald::analysis::views::filter(valid) 
-                  | herald::analysis::views::filter(beforeEndOfThisInterval)
-                  | herald::analysis::views::filter(sinceLastRun)
-                  | aggregate(calculator); // type is MeanValidRSSI
-      
-      auto agg = values.template get<MeanValidRSSI>();
       if (!hasRan) {
         // use first time in sequence as lastRan for this purpose
         Date firstTime = newData.earliest();
         startInterval = firstTime;
         hasRan = true;
       }
-      if (agg.getCount() > 0) { // only output a sample if we have data in this check window
+      if (agg.size() > 0) { // only output a sample if we have data in this check window
         auto d = agg.reduce();
 
         Date latestTime = startInterval + interval;
@@ -163,9 +161,9 @@ struct RSSIMinutesAnalyser {
 
 private:
   TimeInterval interval;
-  MeanValidRSSI calculator;
   Date lastRan;
   bool hasRan;
+  SourceWindows<SlidingWindow<WindowedMean>> windows;
 };
 
 /**
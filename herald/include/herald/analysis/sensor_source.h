@@ -6,29 +6,40 @@
 #define HERALD_ANALYSIS_SENSOR_SOURCE_H
 
 #include "sampling.h"
+#include "../clock.h"
 #include "../datatype/rssi.h"
 
+#include <type_traits>
+
 namespace herald {
 namespace analysis {
 
 using namespace sampling;
 
 /// \brief Connects the RSSI readings from a SensorDelegate to a source for AnalysisRunner data
-template <typename RunnerT>
+///
+/// Samples are timestamped from ClockT. By default this is a Context's cached clock, so pass
+/// Context::getClock() and samples use the per iteration time without reading the platform clock.
+/// Contexts with a custom clock source need ClockT to be their clock_type. Use a FakeClock for replay.
+template <typename RunnerT, typename ClockT = CachedClock<SystemClock>>
 struct SensorDelegateRSSISource {
 
   // Must delete for GCC 8/9. See https://stackoverflow.com/questions/63812165/stdvariant-requires-default-constructor-in-gcc-8-and-9-and-not-require-in-gcc
   SensorDelegateRSSISource() = delete;
-  SensorDelegateRSSISource(RunnerT& runner) : runner(runner) {};
+  /// \brief Only for clocks with a process wide instance (E.g. SystemClock). A cached clock must be the Context's, which is refreshed.
+  template <typename C = ClockT, std::enable_if_t<std::is_default_constructible_v<C>,int> = 0>
+  SensorDelegateRSSISource(RunnerT& runner) : runner(runner), clock(defaultClockSource<ClockT>()) {};
+  SensorDelegateRSSISource(RunnerT& runner, ClockT& clock) : runner(runner), clock(clock) {};
   ~SensorDelegateRSSISource() = default;
 
   void sensor(SensorType sensor, const Proximity& didMeasure, const TargetIdentifier& fromTarget, const PayloadData& withPayload) {
     if (sensor != SensorType::BLE) return; // guard for BLE RSSI proximity only data
-    runner.template newSample<RSSI>(withPayload.hashCode(),Sample<RSSI>(Date(),RSSI(didMeasure.value)));
+    runner.template newSample<RSSI>(withPayload.hashCode(),Sample<RSSI>(clock.now(),RSSI(didMeasure.value)));
   }
 
 private:
   RunnerT& runner; // reference to app wide Analysis Runner instance
+  ClockT& clock;
 };
 
 }
@@ -0,0 +1,249 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_ANALYSIS_SLIDING_WINDOW_H
+#define HERALD_ANALYSIS_SLIDING_WINDOW_H
+
+#include "aggregates.h"
+#include "sampling.h"
+#include "../datatype/date.h"
+#include "../datatype/time_interval.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <tuple>
+
+namespace herald {
+namespace analysis {
+namespace aggregates {
+
+using namespace herald::analysis::sampling;
+using namespace herald::datatype;
+
+/// \brief Keeps windowed aggregates (WindowedMean, WindowedMode, etc.) up to date over a time
+/// range of the samples held in a SampleList.
+///
+/// sync() mirrors the valid samples of a SampleList, processing only those pushed to or evicted
+/// from it since the last sync. range() then limits the aggregates to samples taken within
+/// [from,to]. Moving the range only adds or removes the samples that enter or leave it, so each
+/// sample is aggregated once rather than on every analysis run.
+///
+/// Samples must be pushed to the SampleList in time order.
+template <typename... Aggs>
+struct SlidingWindow {
+  SlidingWindow() : items(), rangeBegin(0), rangeEnd(0), from(std::uint64_t(0)), to(UINT64_MAX), aggregates() {}
+  ~SlidingWindow() = default;
+
+  /// \brief Mirrors those samples in src for which valid(sample) is true
+  template <typename SampleListT, typename Pred>
+  void sync(const SampleListT& src, Pred valid) {
+    sync(src, valid, [](double value) { return value; });
+  }
+
+  /// \brief As above, aggregating transform((double)sample) rather than the sample value
+  template <typename SampleListT, typename Pred, typename Transform>
+  void sync(const SampleListT& src, Pred valid, Transform transform) {
+    const std::size_t srcSize = src.size();
+    if (0 == srcSize) {
+      clear();
+      return;
+    }
+
+    // Drop samples src has evicted
+    const Date earliest = src.earliest();
+    while (!items.empty() && items.front().taken < earliest) {
+      popFront();
+    }
+
+    // Samples sharing our latest time may have been joined by others, so mirror those again
+    std::size_t next = 0;
+    if (!items.empty()) {
+      const Date latest = items.back().taken;
+      while (!items.empty() && items.back().taken == latest) {
+        popBack();
+      }
+      next = srcSize;
+      while (next > 0 && src[next - 1].taken >= latest) {
+        --next;
+      }
+    }
+
+    // Some of those sharing src's earliest time may also have been evicted
+    std::size_t remainingAtEarliest = 0;
+    for (std::size_t idx = 0;idx < srcSize && src[idx].taken == earliest;++idx) {
+      if (valid(src[idx])) {
+        ++remainingAtEarliest;
+      }
+    }
+    std::size_t heldAtEarliest = 0;
+    while (heldAtEarliest < items.size() && items[heldAtEarliest].taken == earliest) {
+      ++heldAtEarliest;
+    }
+    for (;heldAtEarliest > remainingAtEarliest;--heldAtEarliest) {
+      popFront();
+    }
+
+    for (;next < srcSize;++next) {
+      if (valid(src[next])) {
+        items.push_back(Item{src[next].taken, transform((double)src[next])});
+      }
+    }
+    advance();
+  }
+
+  /// \brief Limits the aggregates to samples taken within [rangeFrom,rangeTo].
+  /// Only samples entering or leaving the range are added or removed.
+  void range(Date rangeFrom, Date rangeTo) {
+    from = rangeFrom;
+    to = rangeTo;
+    for (;rangeEnd > rangeBegin && items[rangeEnd - 1].taken > to;--rangeEnd) {
+      exclude(items[rangeEnd - 1].value);
+    }
+    if (rangeEnd == rangeBegin) {
+      // Empty, so start again from wherever the range now begins
+      rangeBegin = std::size_t(std::partition_point(items.begin(), items.end(),
+        [this](const Item& item) { return item.taken < from; }) - items.begin());
+      rangeEnd = rangeBegin;
+    }
+    for (;rangeBegin > 0 && items[rangeBegin - 1].taken >= from;--rangeBegin) {
+      include(items[rangeBegin - 1].value);
+    }
+    advance();
+  }
+
+  /// \brief Number of samples within the range
+  std::size_t size() const noexcept {
+    return rangeEnd - rangeBegin;
+  }
+
+  /// \brief Time of the earliest sample within the range. Only valid if size() > 0.
+  Date earliest() const noexcept {
+    return items[rangeBegin].taken;
+  }
+
+  /// \brief Time of the latest sample within the range. Only valid if size() > 0.
+  Date latest() const noexcept {
+    return items[rangeEnd - 1].taken;
+  }
+
+  template <typename Agg>
+  Agg& get() noexcept {
+    return std::get<Agg>(aggregates);
+  }
+
+  void clear() {
+    items.clear();
+    rangeBegin = 0;
+    rangeEnd = 0;
+    std::apply([] (auto&... aggregate) { (aggregate.reset(), ...); }, aggregates);
+  }
+
+private:
+  struct Item {
+    Date taken;
+    double value;
+  };
+
+  std::deque<Item> items; // mirrored samples, oldest first
+  std::size_t rangeBegin; // items[rangeBegin,rangeEnd) are aggregated
+  std::size_t rangeEnd;
+  Date from;
+  Date to;
+  std::tuple<Aggs...> aggregates;
+
+  void include(double value) {
+    std::apply([value] (auto&... aggregate) { (aggregate.add(value), ...); }, aggregates);
+  }
+
+  void exclude(double value) {
+    std::apply([value] (auto&... aggregate) { (aggregate.remove(value), ...); }, aggregates);
+  }
+
+  void popFront() {
+    if (rangeBegin > 0) {
+      --rangeBegin;
+      --rangeEnd;
+    } else if (rangeEnd > 0) {
+      exclude(items.front().value);
+      --rangeEnd;
+    }
+    items.pop_front();
+  }
+
+  void popBack() {
+    if (rangeEnd == items.size()) {
+      if (rangeBegin < rangeEnd) {
+        exclude(items.back().value);
+      } else {
+        --rangeBegin;
+      }
+      --rangeEnd;
+    }
+    items.pop_back();
+  }
+
+  void advance() {
+    for (;rangeBegin < items.size() && items[rangeBegin].taken < from;++rangeBegin) {
+      if (rangeBegin < rangeEnd) {
+        exclude(items[rangeBegin].value);
+      }
+    }
+    rangeEnd = std::max(rangeEnd, rangeBegin);
+    for (;rangeEnd < items.size() && items[rangeEnd].taken <= to && items[rangeEnd].taken >= from;++rangeEnd) {
+      include(items[rangeEnd].value);
+    }
+  }
+};
+
+/// \brief One window per SampledID, for analysers that are shared by every source.
+/// Windows not used within staleAfter are discarded.
+template <typename WindowT>
+struct SourceWindows {
+  SourceWindows() : windows(), lastPruned(std::uint64_t(0)), staleAfter(TimeInterval::minutes(15)) {}
+  ~SourceWindows() = default;
+
+  WindowT& window(SampledID sampled, Date timeNow) {
+    if (lastPruned + staleAfter < timeNow) {
+      prune(timeNow);
+    }
+    auto& entry = windows[sampled];
+    entry.lastUsed = timeNow;
+    return entry.window;
+  }
+
+  std::size_t size() const noexcept {
+    return windows.size();
+  }
+
+private:
+  struct Entry {
+    Entry() : window(), lastUsed(std::uint64_t(0)) {}
+
+    WindowT window;
+    Date lastUsed;
+  };
+
+  std::map<SampledID,Entry> windows;
+  Date lastPruned;
+  TimeInterval staleAfter;
+
+  void prune(Date timeNow) {
+    for (auto iter = windows.begin();iter != windows.end();) {
+      if (iter->second.lastUsed + staleAfter < timeNow) {
+        iter = windows.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    lastPruned = timeNow;
+  }
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,239 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_BLE_ADVERT_QUEUE_H
+#define HERALD_BLE_ADVERT_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace herald {
+namespace ble {
+
+/// \brief An advert as received by a platform scan callback, before any parsing
+template <std::size_t MaxAdvertLength>
+struct RawAdvert {
+  std::array<std::uint8_t,6> mac; // big endian, as for BLEMacAddress
+  std::int8_t rssi;
+  std::uint8_t type; // platform advert type. Scan responses are not merged with adverts
+  std::uint8_t length;
+  std::array<std::uint8_t,MaxAdvertLength> bytes;
+
+  bool sameSource(const RawAdvert& other) const noexcept {
+    return type == other.type && mac == other.mac;
+  }
+
+  /// \brief A hash of the source (MAC and advert type), consistent with sameSource()
+  std::uint32_t sourceHash() const noexcept {
+    std::uint64_t key = type;
+    for (auto byte : mac) {
+      key = (key << 8) | byte;
+    }
+    return (std::uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32); // Fibonacci hashing
+  }
+};
+
+/// \brief Counts of the adverts handled by a BLEAdvertQueue, for monitoring ingestion under load
+struct BLEAdvertQueueCounters {
+  std::size_t pushed = 0;
+  std::size_t dropped = 0;
+  std::size_t truncated = 0;
+  std::size_t deduplicated = 0;
+};
+
+/// \brief Bounded single producer, single consumer queue of raw adverts.
+///
+/// Lets a BLE scan callback hand adverts to the SensorArray thread without
+/// taking locks or allocating. push() is constant time and never blocks: when
+/// the queue is full the advert is dropped and counted. Adverts longer than
+/// MaxAdvertLength are truncated and counted.
+///
+/// The consumer calls drain() once per iteration. Within each batch only the
+/// latest advert from each MAC (and advert type) is passed on, as earlier ones
+/// would be immediately superseded in the BLEDatabase. The RSSI of the earlier
+/// ones can be passed along with it, so that no RSSI samples are lost. Sources
+/// are matched through a small open addressed table, so a batch is handled in
+/// time linear in its size.
+///
+/// Exactly one thread (or interrupt context) may push, and exactly one may drain.
+template <std::size_t Capacity, std::size_t MaxAdvertLength = 31>
+class BLEAdvertQueue {
+public:
+  static_assert(Capacity > 1 && 0 == (Capacity & (Capacity - 1)), "Capacity must be a power of two");
+  static_assert(MaxAdvertLength <= 255, "Advert length is held in one byte");
+
+  using advert_type = RawAdvert<MaxAdvertLength>;
+  static constexpr std::size_t max_size = Capacity;
+
+  BLEAdvertQueue() noexcept
+    : head(0), duplicateCount(0), tail(0), dropCount(0), truncateCount(0), pushCount(0), slots(),
+      latestBySource(), previousFromSource()
+  {
+    latestBySource.fill(noAdvert);
+  }
+  BLEAdvertQueue(const BLEAdvertQueue&) = delete;
+  BLEAdvertQueue(BLEAdvertQueue&&) = delete;
+  ~BLEAdvertQueue() noexcept = default;
+
+  /// \brief PRODUCER ONLY. Copies an advert in to the queue. Returns false if it was dropped as the queue is full.
+  bool push(const std::uint8_t mac[6], std::int8_t rssi, std::uint8_t type,
+    const std::uint8_t* bytes, std::size_t length) noexcept {
+    const std::uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= Capacity) {
+      dropCount.store(dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    if (length > MaxAdvertLength) {
+      truncateCount.store(truncateCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      length = MaxAdvertLength;
+    }
+    advert_type& slot = slots[t & (Capacity - 1)];
+    std::memcpy(slot.mac.data(), mac, 6);
+    slot.rssi = rssi;
+    slot.type = type;
+    slot.length = (std::uint8_t)length;
+    std::memcpy(slot.bytes.data(), bytes, length);
+    tail.store(t + 1, std::memory_order_release);
+    pushCount.store(pushCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// \brief CONSUMER ONLY. Passes up to maxBatch queued adverts to handler, skipping
+  /// any superseded by a later advert from the same source in the same batch.
+  ///
+  /// handler is called as handler(const advert_type&), in arrival order of the
+  /// adverts kept. If handler also accepts (const std::int8_t* earlierRssi,
+  /// std::size_t earlierCount) it is passed the RSSI of the adverts that the kept
+  /// one superseded, oldest first. Returns the number of adverts removed from
+  /// the queue, including duplicates.
+  template <typename HandlerT>
+  std::size_t drain(HandlerT&& handler, std::size_t maxBatch = Capacity) noexcept {
+    const std::uint32_t h = head.load(std::memory_order_relaxed);
+    std::uint32_t count = tail.load(std::memory_order_acquire) - h;
+    if (count > maxBatch) {
+      count = (std::uint32_t)maxBatch;
+    }
+    // Slots between head and head + count are ours until head is advanced.
+    // First pass: chain each advert to the previous one from its source.
+    std::bitset<Capacity> superseded;
+    for (std::uint32_t i = 0;i < count;++i) {
+      const advert_type& advert = slots[(h + i) & (Capacity - 1)];
+      std::size_t bucket = advert.sourceHash() & (TableSize - 1);
+      while (noAdvert != latestBySource[bucket] &&
+             !advert.sameSource(slots[(h + latestBySource[bucket]) & (Capacity - 1)])) {
+        bucket = (bucket + 1) & (TableSize - 1);
+      }
+      previousFromSource[i] = latestBySource[bucket];
+      if (noAdvert != latestBySource[bucket]) {
+        superseded.set(latestBySource[bucket]);
+      }
+      latestBySource[bucket] = (index_type)i;
+    }
+    // Second pass: pass on the latest from each source, then empty the table
+    for (std::uint32_t i = 0;i < count;++i) {
+      const advert_type& advert = slots[(h + i) & (Capacity - 1)];
+      if (superseded.test(i)) {
+        ++duplicateCount;
+        continue;
+      }
+      if constexpr (std::is_invocable_v<HandlerT&,const advert_type&,const std::int8_t*,std::size_t>) {
+        std::array<std::int8_t,Capacity> earlierRssi;
+        std::size_t earlierCount = 0;
+        for (index_type earlier = previousFromSource[i];noAdvert != earlier;earlier = previousFromSource[earlier]) {
+          earlierRssi[earlierCount++] = slots[(h + earlier) & (Capacity - 1)].rssi;
+        }
+        std::reverse(earlierRssi.begin(), earlierRssi.begin() + earlierCount); // oldest first
+        handler(advert, earlierRssi.data(), earlierCount);
+      } else {
+        handler(advert);
+      }
+    }
+    for (std::uint32_t i = 0;i < count;++i) {
+      if (!superseded.test(i)) {
+        // Clear this source's bucket. Its entry is present, so probing may step over buckets already cleared
+        std::size_t bucket = slots[(h + i) & (Capacity - 1)].sourceHash() & (TableSize - 1);
+        while (i != latestBySource[bucket]) {
+          bucket = (bucket + 1) & (TableSize - 1);
+        }
+        latestBySource[bucket] = noAdvert;
+      }
+    }
+    head.store(h + count, std::memory_order_release);
+    return count;
+  }
+
+  /// \brief Number of adverts waiting. Approximate whilst the producer is active.
+  std::size_t size() const noexcept {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const noexcept {
+    return 0 == size();
+  }
+
+  /// \brief Adverts accepted by push()
+  std::size_t pushed() const noexcept {
+    return pushCount.load(std::memory_order_relaxed);
+  }
+
+  /// \brief Adverts lost because the queue was full
+  std::size_t dropped() const noexcept {
+    return dropCount.load(std::memory_order_relaxed);
+  }
+
+  /// \brief Adverts whose bytes were cut to MaxAdvertLength
+  std::size_t truncated() const noexcept {
+    return truncateCount.load(std::memory_order_relaxed);
+  }
+
+  /// \brief CONSUMER ONLY. Adverts not passed on by drain() as a later one from the same source followed
+  std::size_t deduplicated() const noexcept {
+    return duplicateCount;
+  }
+
+  /// \brief CONSUMER ONLY. All of the counts above
+  BLEAdvertQueueCounters counters() const noexcept {
+    return BLEAdvertQueueCounters{
+      .pushed = pushed(),
+      .dropped = dropped(),
+      .truncated = truncated(),
+      .deduplicated = deduplicated()
+    };
+  }
+
+private:
+#ifdef __ZEPHYR__
+  static constexpr std::size_t lineSize = alignof(std::uint32_t); // no cache to share
+#else
+  static constexpr std::size_t lineSize = 64; // keeps each side's writes off the other's cache line
+#endif
+
+  // Free running positions. Only their difference is used, so wrapping is harmless.
+  alignas(lineSize) std::atomic<std::uint32_t> head; // written by the consumer only
+  std::uint32_t duplicateCount;
+  alignas(lineSize) std::atomic<std::uint32_t> tail; // written by the producer only, as are the counters below
+  std::atomic<std::uint32_t> dropCount;
+  std::atomic<std::uint32_t> truncateCount;
+  std::atomic<std::uint32_t> pushCount;
+  alignas(lineSize) std::array<advert_type,Capacity> slots;
+
+  // Consumer only working space for drain(), held here to keep it off small stacks
+  using index_type = std::conditional_t<(Capacity < 0xFFFF), std::uint16_t, std::uint32_t>;
+  static constexpr index_type noAdvert = std::numeric_limits<index_type>::max();
+  static constexpr std::size_t TableSize = 2 * Capacity; // at most 50% full
+  std::array<index_type,TableSize> latestBySource; // batch position of each source's latest advert, by hash
+  std::array<index_type,Capacity> previousFromSource; // batch position of the previous advert from the same source
+};
+
+} // end namespace
+} // end namespace
+
+#endif
@@ -36,6 +36,7 @@
 #include "default/concrete_ble_transmitter.h"
 #endif
 
+#include <array>
 #include <memory>
 #include <algorithm>
 #include <optional>
@@ -68,7 +69,9 @@ public:
     receiver(ctx, bluetoothStateManager, payloadDataSupplier, database, dels),
     delegates(dels),
     coordinator(ctx, database, receiver),
-    addedSelfAsDelegate(false)
+    addedSelfAsDelegate(false),
+    pending(),
+    pendingCount(0)
     HLOGGERINIT(ctx,"sensor","ConcreteBLESensor")
   {
   }
@@ -114,6 +117,7 @@ public:
   }
 
   void stop() {
+    flush();
     transmitter.stop();
     receiver.stop();
     // for (auto& delegate : delegates) {
@@ -121,6 +125,29 @@ public:
     // }
   }
 
+  /// \brief Ingests adverts queued by the platform scan callback. Called at the start of each SensorArray iteration.
+  std::size_t processAdverts() {
+    return receiver.processAdverts();
+  }
+
+  /// \brief Counts of adverts queued, dropped and truncated by the receiver. See BLEAdvertQueue.
+  BLEAdvertQueueCounters advertCounters() const {
+    return receiver.advertCounters();
+  }
+
+  /// \brief Delivers proximity measurements batched since the last call, if any delegate
+  /// batches them (See SensorDelegateSet::batchesProximity). Called after each SensorArray iteration.
+  ///
+  /// The batch is not synchronised, so database updates must come from the thread that calls this,
+  /// as they do when the BLE providers run synchronously (See CoordinatorExecution).
+  void flush() {
+    if (0 == pendingCount) {
+      return;
+    }
+    delegates.sensor(SensorType::BLE, ProximityUpdates(pending.data(), pendingCount)); // didMeasure, in bulk
+    pendingCount = 0;
+  }
+
   // Database overrides
   void bleDatabaseDidCreate(const BLEDevice& device) override {
     // for (auto& delegate : delegates) {
@@ -128,13 +155,27 @@ public:
     // }
   }
 
+  void bleDatabaseWillUpdate(const BLEDevice&, const BLEDeviceAttribute) override {
+    flush(); // batched updates refer to the device's current payload, so deliver them before it changes
+  }
+
   void bleDatabaseDidUpdate(const BLEDevice& device, const BLEDeviceAttribute attribute) override {
+    if (BLEDeviceAttribute::rssi != attribute) {
+      flush(); // deliver batched updates before the events for this change
+    }
     switch (attribute) {
       case BLEDeviceAttribute::rssi: {
         auto rssi = device.rssi();
         if (rssi.intValue() != 0) {
           double rssiValue = (double)rssi.intValue();
           auto prox = Proximity{.unit=ProximityMeasurementUnit::RSSI, .value=rssiValue};
+          if constexpr (SensorDelegateSetT::batchesProximity) {
+            if (pendingCount == pending.size()) {
+              flush();
+            }
+            pending[pendingCount++] = ProximityUpdate{&device.identifier(), prox, &device.payloadData()};
+            break;
+          }
           // for (auto& delegate: delegates) {
             delegates.sensor(SensorType::BLE,
               prox,
@@ -142,7 +183,7 @@ public:
             ); // didMeasure
           // }
           // also payload with rssi
-          auto payload = device.payloadData();
+          const auto& payload = device.payloadData();
           if (payload.size() > 0) {
             // for (auto& delegate: delegates) {
               delegates.sensor(SensorType::BLE,
@@ -156,7 +197,7 @@ public:
         break;
       }
       case BLEDeviceAttribute::payloadData: {
-        auto payload = device.payloadData();
+        const auto& payload = device.payloadData();
         if (payload.size() > 0) {
           // for (auto& delegate: delegates) {
             delegates.sensor(SensorType::BLE,
@@ -191,6 +232,7 @@ public:
   }
 
   void bleDatabaseDidDelete(const BLEDevice& device) override {
+    flush();
     ; // TODO just log this // TODO determine if to pass this on too
     // TODO fire this for analysis runner and others' benefit
   }
@@ -227,6 +269,9 @@ private:
 
   bool addedSelfAsDelegate;
 
+  std::array<ProximityUpdate,DBSize> pending; // RSSI updates not yet passed to delegates, when batching. SensorArray thread only.
+  std::size_t pendingCount;
+
   HLOGGER(ContextT);
 };
 
@@ -14,15 +14,18 @@
 #include "bluetooth_state_manager.h"
 #include "ble_device_delegate.h"
 #include "filter/ble_advert_parser.h"
+#include "filter/ble_advert_view.h"
 #include "../payload/payload_data_supplier.h"
 #include "../context.h"
 #include "../data/sensor_logger.h"
 #include "ble_sensor_configuration.h"
 #include "ble_coordinator.h"
 #include "../datatype/bluetooth_state.h"
+#include "../datatype/slot_index.h"
 
 #include <array>
 #include <algorithm>
+#include <functional>
 
 namespace herald {
 namespace ble {
@@ -35,7 +38,7 @@ using namespace herald::payload;
 /// \brief Provides a callable that assists in ordering for most recently updated BLEDevice
 struct last_updated_descending {
   bool operator()(const BLEDevice& a, const BLEDevice& b) noexcept {
-    return a.timeIntervalSinceLastUpdate() > b.timeIntervalSinceLastUpdate(); // opposite order
+    return a.lastUpdatedAt() < b.lastUpdatedAt(); // least recently updated first
   }
   bool operator()(const std::optional<std::reference_wrapper<BLEDevice>>& lhs, const std::optional<std::reference_wrapper<BLEDevice>>& rhs) noexcept {
     if (lhs.has_value() && !rhs.has_value()) {
@@ -44,10 +47,16 @@ struct last_updated_descending {
     if (rhs.has_value()&& !lhs.has_value()) {
       return 0;
     }
-    return lhs.value().get().timeIntervalSinceLastUpdate() > rhs.value().get().timeIntervalSinceLastUpdate();
+    return lhs.value().get().lastUpdatedAt() < rhs.value().get().lastUpdatedAt();
   }
 };
 
+/// \brief Fixed size BLEDevice database.
+///
+/// Devices are held in a std::array and located via hash indexes by TargetIdentifier,
+/// by pseudo device address and by payload, so advert ingestion and payload lookups are
+/// O(1) rather than O(MaxDevices).
+/// When full, the least recently used device (by lookup or attribute update) is evicted.
 template <typename ContextT, std::size_t MaxDevicesCached = 10>
 class ConcreteBLEDatabase : public BLEDatabase, public BLEDeviceDelegate /*, public std::enable_shared_from_this<ConcreteBLEDatabase<ContextT>>*/  {
 public:
@@ -56,7 +65,11 @@ public:
   ConcreteBLEDatabase(ContextT& context) noexcept
   : ctx(context),
     delegates(),
-    devices()
+    devices(),
+    identifierIndex(),
+    pseudoIndex(),
+    payloadIndex(),
+    recency()
     HLOGGERINIT(context,"herald","ConcreteBLEDatabase")
   {
     ;
@@ -77,25 +90,16 @@ public:
   BLEDevice& device(const BLEMacAddress& mac, const Data& advert/*, const RSSI& rssi*/) noexcept override {
     // Check by MAC first
     TargetIdentifier targetIdentifier(mac.underlyingData());
-    auto results = matches([&targetIdentifier](const BLEDevice& d) {
-      return d.identifier() == targetIdentifier;
-    });
-    if (results.size() != 0 && results[0].has_value()) {
+    const std::size_t knownIdx = findByIdentifier(targetIdentifier);
+    if (npos != knownIdx) {
       // HTDBG("DEVICE ALREADY KNOWN BY MAC");
       // Assume advert details are known already
-      return results[0].value().get(); // TODO ensure we send back the latest, not just the first match
-      // res->rssi(rssi);
-      // return res;
+      recency.touch(knownIdx);
+      return devices[knownIdx];
     }
 
-    // Now check by pseudo mac
-    auto segments = BLEAdvertParser::extractSegments(advert,0);
-    // HTDBG("segments:-");
-    // HTDBG(std::to_string(segments.size()));
-    auto manuData = BLEAdvertParser::extractManufacturerData(segments);
-    auto heraldDataSegments = BLEAdvertParser::extractHeraldManufacturerData(manuData);
-    // HTDBG("herald data segments:-");
-    // HTDBG(std::to_string(heraldDataSegments.size()));
+    // Now check by pseudo mac, walking the advert in place (no copies until a new device is created)
+    BLEAdvertView view(advert);
     // auto device = db->device(bleMacAddress); // For most devices this will suffice
 
     // TODO Check for public herald service in ADV_IND packet - shown if an Android device, wearable or beacon in zephyr
@@ -108,23 +112,22 @@ public:
     //     device->operatingSystem(BLEDeviceOperatingSystem::android);
     //   }
     // }
-    
 
-    if (0 != heraldDataSegments.size()) {
+    BLEAdvertManufacturerDataView heraldData;
+    if (view.manufacturerData(to_integral(BLEAdvertManufacturers::heraldUnregistered), heraldData)) {
       // HTDBG("Found Herald Android pseudo device address in advert");
       // Try to FIND by pseudo first
-      BLEMacAddress pseudo(heraldDataSegments.front());
-      auto samePseudo = matches([&pseudo](const BLEDevice& d) {
-        return d.pseudoDeviceAddress() == pseudo;
-      });
-      if (0 != samePseudo.size() && samePseudo[0].has_value()) {
+      BLEMacAddress pseudo(heraldData.data.toData());
+      const std::size_t pseudoIdx = findByPseudo(pseudo);
+      if (npos != pseudoIdx) {
         // HTDBG("FOUND EXISTING DEVICE BY PSEUDO");
-        return samePseudo[0].value().get();
+        recency.touch(pseudoIdx);
+        return devices[pseudoIdx];
       }
       // HTDBG("CREATING NEW DEVICE BY MAC AND PSEUDO ONLY");
       // Now create new device with mac and pseudo
       auto& newDevice = device(mac,pseudo);
-      assignAdvertData(newDevice,std::move(segments), manuData);
+      assignAdvertData(newDevice,view);
       // newDevice->rssi(rssi);
       return newDevice;
     }
@@ -134,25 +137,23 @@ public:
     // Now create a device just from a mac
     auto& newDevice = device(targetIdentifier);
     // HTDBG("Got new device");
-    assignAdvertData(newDevice,std::move(segments), manuData);
+    assignAdvertData(newDevice,view);
     // newDevice->rssi(rssi);
     // HTDBG("Assigned advert data");
     return newDevice;
   }
 
   BLEDevice& device(const BLEMacAddress& mac, const BLEMacAddress& pseudo) noexcept override {
-    auto samePseudo = matches([&pseudo](const BLEDevice& d) {
-      return d.pseudoDeviceAddress() == pseudo;
-    });
-    if (0 == samePseudo.size()) {
+    const std::size_t pseudoIdx = findByPseudo(pseudo);
+    if (npos == pseudoIdx) {
       auto& ptr = device(TargetIdentifier(pseudo.underlyingData()));
       ptr.pseudoDeviceAddress(pseudo);
+      pseudoIndex.insert(slotOf(ptr),pseudo.hashCode());
       return ptr;
     }
-    // get most recent and clone, then attach
-    auto comp = last_updated_descending();
-    std::sort(samePseudo.begin(),samePseudo.end(), comp); // functional style
-    BLEDevice& updatedDevice = samePseudo[0].value().get();
+    // The pseudo index only ever holds the latest device for a given pseudo address
+    recency.touch(pseudoIdx);
+    BLEDevice& updatedDevice = devices[pseudoIdx];
     // TODO support calling card
     // auto toShare = shareDataAcrossDevices(pseudo);
     // if (toShare.has_value()) {
@@ -163,7 +164,7 @@ public:
     updatedDevice.operatingSystem(BLEDeviceOperatingSystem::android);
 
     // register new device discovery date
-    updatedDevice.registerDiscovery(Date());
+    updatedDevice.registerDiscovery(ctx.getNow());
 
     // devices.push_back(updatedDevice);
     for (auto& delegate : delegates) {
@@ -184,21 +185,21 @@ public:
     // HTDBG("device(PayloadData)");
     // HTDBG(payloadData.toString());
     auto pti = TargetIdentifier(payloadData);
-    auto results = matches([&pti,&payloadData](const BLEDevice& d) {
-      if (d.identifier() == pti) {
-        return true;
-      }
-      auto payload = d.payloadData();
-      if (payload.size() == 0) {
-        return false;
-      }
-      return payload==payloadData;
-    });
-    if (results.size() != 0 && results[0].has_value()) {
-      return results[0].value().get(); // TODO ensure we send back the latest, not just the first match
+    const std::size_t knownIdx = findByIdentifier(pti);
+    if (npos != knownIdx) {
+      recency.touch(knownIdx);
+      return devices[knownIdx];
     }
-    BLEDevice& newDevice = devices[indexAvailable()];
+    // At most one device holds a given payload - see device(const BLEDevice&,BLEDeviceAttribute)
+    const std::size_t payloadIdx = findByPayload(payloadData, npos);
+    if (npos != payloadIdx) {
+      recency.touch(payloadIdx);
+      return devices[payloadIdx];
+    }
+    const std::size_t newIdx = indexAvailable();
+    BLEDevice& newDevice = devices[newIdx];
     newDevice.reset(pti,*this);
+    identifierIndex.insert(newIdx,pti.hashCode());
 
     for (auto& delegate : delegates) {
       if (delegate.has_value()) {
@@ -213,20 +214,17 @@ public:
   BLEDevice& device(const TargetIdentifier& targetIdentifier) noexcept override {
     // HTDBG("device(TargetIdentifier)");
     // HTDBG((std::string)targetIdentifier);
-    auto results = matches([/*this,*/&targetIdentifier](const BLEDevice& d) {
-      // HTDBG("device(TargetIdentifier) matches callback");
-      // HTDBG(" Testing existing target identifier {} against new target identifier {}",(std::string)d.identifier(),(std::string)targetIdentifier);
-      return d.identifier() == targetIdentifier;
-    });
-    // HTDBG("Got matches");
-    // HTDBG(std::to_string(results.size()));
-    if (results.size() != 0 && results[0].has_value()) {
+    const std::size_t knownIdx = findByIdentifier(targetIdentifier);
+    if (npos != knownIdx) {
       // HTDBG("Device for target identifier {} already exists",(std::string)targetIdentifier);
-      return results[0].value().get(); // TODO ensure we send back the latest, not just the first match
+      recency.touch(knownIdx);
+      return devices[knownIdx];
     }
     HTDBG("New target identified: {}",(std::string)targetIdentifier);
-    BLEDevice& newDevice = devices[indexAvailable()];
+    const std::size_t newIdx = indexAvailable();
+    BLEDevice& newDevice = devices[newIdx];
     newDevice.reset(targetIdentifier,*this);
+    identifierIndex.insert(newIdx,targetIdentifier.hashCode());
 
     for (auto& delegate : delegates) {
       if (delegate.has_value()) {
@@ -238,13 +236,7 @@ public:
   
   // Introspection overrides
   std::size_t size() const noexcept override {
-    std::size_t count = 0;
-    for (auto& d : devices) {
-      if (d.state() != BLEDeviceState::uninitialised) {
-        ++count;
-      }
-    }
-    return count;
+    return recency.size();
   }
 
   BLEDeviceList matches(const std::function<bool(const BLEDevice&)>& matcher) noexcept override {
@@ -268,29 +260,38 @@ public:
 
   /// Cannot name a function delete in C++. remove is common.
   void remove(const TargetIdentifier& targetIdentifier) noexcept override {
-    auto found = std::find_if(devices.begin(),devices.end(),
-      [&targetIdentifier](BLEDevice& d) -> bool {
-        return d.identifier() == targetIdentifier;
-      }
-    );
-    if (found != devices.end()) {
-      BLEDevice& toRemove = *found;
-      remove(toRemove);
+    const std::size_t idx = findByIdentifier(targetIdentifier);
+    if (npos != idx) {
+      remove(devices[idx]);
     }
   }
 
   // BLE Device Delegate overrides
+  Date now() noexcept override {
+    return ctx.getNow();
+  }
+
+  void deviceWillUpdate(const BLEDevice& device, BLEDeviceAttribute willUpdate) noexcept override {
+    for (auto& delegate : delegates) {
+      if (delegate.has_value()) {
+        delegate.value().get().bleDatabaseWillUpdate(device, willUpdate);
+      }
+    }
+  }
+
   void device(const BLEDevice& device, BLEDeviceAttribute didUpdate) noexcept override {
+    const std::size_t idx = slotOf(device);
+    recency.touch(idx);
     // Update any internal DB state as necessary (E.g. payload received and its a duplicate as mac has rotated)
     if (BLEDeviceAttribute::payloadData == didUpdate) {
-      // check for all devices with this payload that are NOT THIS device
-      auto oldMacsForSamePayload = matches([device](auto& devRef) {
-        return devRef.identifier() != device.identifier() && 
-               devRef.payloadData().size() > 0 && devRef.payloadData() == device.payloadData();
-      });
-      for (auto& oldMacDevice : oldMacsForSamePayload) {
-        if (oldMacDevice.has_value()) {
-          remove(oldMacDevice.value().get().identifier());
+      const PayloadData& payload = device.payloadData();
+      if (0 == payload.size()) {
+        payloadIndex.remove(idx);
+      } else {
+        payloadIndex.insert(idx, payload.hashCode());
+        // remove all other devices with this payload (each removal also leaves the index)
+        for (std::size_t oldIdx = findByPayload(payload, idx);npos != oldIdx;oldIdx = findByPayload(payload, idx)) {
+          remove(devices[oldIdx]);
         }
       }
     }
@@ -303,29 +304,42 @@ public:
     }
   }
 
+  /// \brief Returns the slot position of a device within this database, or MaxDevices if not ours.
+  /// Stable for as long as the device remains in the database.
+  std::size_t slotOf(const BLEDevice& device) const noexcept {
+    const BLEDevice* ptr = &device;
+    if (std::less<const BLEDevice*>{}(ptr,devices.data()) ||
+        !std::less<const BLEDevice*>{}(ptr,devices.data() + MaxDevices)) {
+      return npos;
+    }
+    return std::size_t(ptr - devices.data());
+  }
+
 private:
-  void assignAdvertData(BLEDevice& newDevice, std::vector<BLEAdvertSegment>&& toMove, 
-    const std::vector<BLEAdvertManufacturerData>& manuData) noexcept
+  static constexpr std::size_t npos = MaxDevices;
+
+  void assignAdvertData(BLEDevice& newDevice, const BLEAdvertView& view) noexcept
   {
-    newDevice.advertData(std::move(toMove));
+    newDevice.advertData(view.toSegments());
 
     // If it's an apple device, check to see if its on our ignore list
-    auto appleDataSegments = BLEAdvertParser::extractAppleManufacturerSegments(manuData);
-    if (0 != appleDataSegments.size()) {
-      HTDBG("Found apple device");
-      // HTDBG((std::string)mac);
-      newDevice.operatingSystem(BLEDeviceOperatingSystem::ios);
-      // TODO see if we should ignore this Apple device
-      // TODO abstract these out eventually in to BLEDevice class
-      bool ignore = false;
-      /*
-          "^10....04",
-          "^10....14",
-          "^0100000000000000000000000000000000",
-          "^05","^07","^09",
-          "^00","^1002","^06","^08","^03","^0C","^0D","^0F","^0E","^0B"
-      */
-      for (auto& segment : appleDataSegments) {
+    bool isApple = false;
+    bool ignore = false;
+    BLEAdvertManufacturerDataView manu;
+    for (const auto& advertSegment : view) {
+      if (!BLEAdvertManufacturerDataView::from(advertSegment, manu) ||
+          manu.manufacturer != to_integral(BLEAdvertManufacturers::apple)) {
+        continue;
+      }
+      for (const auto& segment : BLEAdvertAppleSegments(manu.data)) {
+        isApple = true;
+        /*
+            "^10....04",
+            "^10....14",
+            "^0100000000000000000000000000000000",
+            "^05","^07","^09",
+            "^00","^1002","^06","^08","^03","^0C","^0D","^0F","^0E","^0B"
+        */
         HTDBG(segment.data.hexEncodedString());
         switch (segment.type) {
           case 0x00:
@@ -357,6 +371,12 @@ private:
             break;
         }
       }
+    }
+    if (isApple) {
+      HTDBG("Found apple device");
+      // HTDBG((std::string)mac);
+      newDevice.operatingSystem(BLEDeviceOperatingSystem::ios);
+      // TODO abstract these out eventually in to BLEDevice class
       if (ignore) {
         HTDBG(" - Ignoring Apple device due to Apple data filter");
         newDevice.ignore(true);
@@ -377,6 +397,11 @@ private:
     if (toRemove.state() == BLEDeviceState::uninitialised) {
       return;
     }
+    const std::size_t idx = slotOf(toRemove);
+    identifierIndex.remove(idx);
+    pseudoIndex.remove(idx);
+    payloadIndex.remove(idx);
+    recency.release(idx);
     toRemove.state(BLEDeviceState::uninitialised);
     // TODO validate all other device data is reset
     for (auto& delegate : delegates) {
@@ -387,32 +412,55 @@ private:
   }
 
   std::size_t indexAvailable() noexcept {
-    for (std::size_t idx = 0;idx < devices.size();++idx) {
-      auto& device = devices[idx];
-      if (BLEDeviceState::uninitialised == device.state()) {
-        return idx;
-      }
+    const std::size_t freeIdx = recency.acquire();
+    if (npos != freeIdx) {
+      return freeIdx;
     }
     // If we've got here then there is no space available
-    // Remove the oldest by lastUpdated
-    auto comp = last_updated_descending();
-    std::size_t oldestIndex = 0;
-    for (std::size_t idx = 0;idx < devices.size();++idx) {
-      if (!comp(devices[oldestIndex],devices[idx])) {
-        // new oldest
-        oldestIndex = idx;
+    // Remove the least recently used, and notify we're deleting this device
+    remove(devices[recency.leastRecent()]);
+    // Now re-use this slot (the free list hands back the slot just released)
+    return recency.acquire();
+  }
+
+  /// \brief Returns the slot of the in-use device with this identifier, or npos
+  std::size_t findByIdentifier(const TargetIdentifier& targetIdentifier) const noexcept {
+    return identifierIndex.find(targetIdentifier.hashCode(),
+      [this,&targetIdentifier](std::size_t idx) {
+        return BLEDeviceState::uninitialised != devices[idx].state() &&
+               devices[idx].identifier() == targetIdentifier;
       }
-    }
-    // Now notify we're deleting this device
-    auto& oldest = devices[oldestIndex];
-    remove(oldest);
-    // Now re-use this reference
-    return oldestIndex;
+    );
+  }
+
+  /// \brief Returns the slot of the in-use device with this pseudo device address, or npos
+  std::size_t findByPseudo(const BLEMacAddress& pseudo) const noexcept {
+    return pseudoIndex.find(pseudo.hashCode(),
+      [this,&pseudo](std::size_t idx) {
+        return BLEDeviceState::uninitialised != devices[idx].state() &&
+               devices[idx].pseudoDeviceAddress() == pseudo;
+      }
+    );
+  }
+
+  /// \brief Returns the slot of an in-use device other than except with this (non empty) payload, or npos
+  std::size_t findByPayload(const PayloadData& payload, std::size_t except) const noexcept {
+    return payloadIndex.find(payload.hashCode(),
+      [this,&payload,except](std::size_t idx) {
+        return except != idx &&
+               BLEDeviceState::uninitialised != devices[idx].state() &&
+               devices[idx].payloadData() == payload;
+      }
+    );
   }
 
   ContextT& ctx;
   BLEDatabaseDelegateList delegates;
   std::array<BLEDevice,MaxDevices> devices; // bool = in-use (not 'removed' from DB)
+  SlotHashIndex<MaxDevices> identifierIndex;
+  SlotHashIndex<MaxDevices> pseudoIndex;
+  SlotHashIndex<MaxDevices> payloadIndex;
+  SlotLRUList<MaxDevices> recency;
 
   HLOGGER(ContextT);
 };
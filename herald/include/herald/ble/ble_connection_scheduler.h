@@ -0,0 +1,166 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_BLE_CONNECTION_SCHEDULER_H
+#define HERALD_BLE_CONNECTION_SCHEDULER_H
+
+#include "../engine/activities.h"
+#include "../datatype/rssi.h"
+#include "../datatype/target_identifier.h"
+#include "../datatype/time_interval.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace herald {
+namespace ble {
+
+using namespace herald::datatype;
+using namespace herald::engine;
+
+/// \brief A device that would like a Bluetooth connection this iteration
+struct BLEConnectionCandidate {
+  TargetIdentifier target;
+  Priority priority;
+  /// \brief Whether a payload has already been read from this device
+  bool hasPayload;
+  /// \brief Time since the payload was last read. Ignored if hasPayload is false.
+  TimeInterval payloadAge;
+  /// \brief Last RSSI seen. 0 means not yet known.
+  RSSI rssi;
+  /// \brief The device's slot in the BLE database. Must be below the scheduler's Slots.
+  std::size_t slot;
+};
+
+/// \brief Chooses which devices to connect to when there are more candidates than the
+/// per-iteration connection budget allows.
+///
+/// Candidates are scored on their priority, then on whether we still need their payload
+/// (new contacts first, then the most stale payloads), then on signal strength. Every
+/// iteration a candidate is passed over it gains an aging bonus, so a busy environment
+/// cannot starve a device of connections forever. The bonus resets once it is chosen.
+///
+/// Aging state is held per BLE database slot in a fixed array, so scheduling never
+/// allocates once the working vectors have grown to the number of candidates.
+template <std::size_t Slots>
+class BLEConnectionScheduler {
+public:
+  /// \brief Score added per iteration a candidate has been passed over
+  static constexpr long AgingBonus = 1000;
+
+  BLEConnectionScheduler(std::size_t budget) noexcept
+    : maxPerIteration(budget),
+      round(0),
+      waiting(),
+      ranked(),
+      ordered()
+  {
+    ;
+  }
+
+  ~BLEConnectionScheduler() noexcept = default;
+
+  /// \brief Maximum number of candidates chosen by each call to schedule()
+  std::size_t budget() const noexcept {
+    return maxPerIteration;
+  }
+
+  void budget(std::size_t newBudget) noexcept {
+    maxPerIteration = newBudget;
+  }
+
+  /// \brief Reorders candidates best first and truncates them to the budget.
+  /// Candidates not chosen are aged, and devices no longer present are forgotten.
+  void schedule(std::vector<BLEConnectionCandidate>& candidates) {
+    ++round;
+    ranked.clear();
+    ranked.reserve(candidates.size());
+    for (std::size_t idx = 0;idx < candidates.size();++idx) {
+      const auto& candidate = candidates[idx];
+      if (candidate.slot >= Slots) {
+        continue; // not from our database - never schedule it
+      }
+      auto& wait = waiting[candidate.slot];
+      const std::size_t targetHash = candidate.target.hashCode();
+      if (wait.lastSeen + 1 != round || wait.targetHash != targetHash) {
+        // Absent last round, or the slot now holds a different device
+        wait.iterations = 0;
+        wait.targetHash = targetHash;
+      }
+      wait.lastSeen = round;
+      ranked.emplace_back(score(candidate) + long(wait.iterations) * AgingBonus, idx);
+    }
+
+    // Highest score first, ties in the order given
+    const std::size_t chosen = std::min(maxPerIteration, ranked.size());
+    std::stable_sort(ranked.begin(), ranked.end(),
+      [](const std::pair<long,std::size_t>& left, const std::pair<long,std::size_t>& right) {
+        return left.first > right.first;
+      });
+
+    ordered.clear();
+    for (std::size_t pos = 0;pos < ranked.size();++pos) {
+      auto& candidate = candidates[ranked[pos].second];
+      if (pos < chosen) {
+        waiting[candidate.slot].iterations = 0;
+        ordered.push_back(std::move(candidate));
+      } else {
+        ++waiting[candidate.slot].iterations;
+      }
+    }
+    candidates.swap(ordered);
+  }
+
+  /// \brief Number of consecutive calls to schedule() that passed over the device in this slot
+  std::size_t passedOver(std::size_t slot) const noexcept {
+    if (slot >= Slots || waiting[slot].lastSeen != round) {
+      return 0; // devices that stopped asking for a connection are forgotten
+    }
+    return waiting[slot].iterations;
+  }
+
+  /// \brief The score of a candidate excluding any aging bonus. Higher is scheduled first.
+  static long score(const BLEConnectionCandidate& candidate) noexcept {
+    long result = long(candidate.priority) * PriorityWeight;
+    if (!candidate.hasPayload) {
+      result += NoPayloadBonus;
+    } else if (TimeInterval::never() != candidate.payloadAge) {
+      const long minutes = std::clamp(candidate.payloadAge.seconds() / 60, 0L, MaxStalenessMinutes);
+      result += minutes * StalenessPerMinute;
+    }
+    const long rssi = candidate.rssi.intValue();
+    if (0 != rssi) {
+      result += std::clamp(rssi - RSSIFloor, 0L, -RSSIFloor) * RSSIWeight;
+    }
+    return result;
+  }
+
+private:
+  static constexpr long PriorityWeight = 10000; // one priority step outweighs every other factor
+  static constexpr long NoPayloadBonus = 6000; // new contacts beat any payload refresh
+  static constexpr long StalenessPerMinute = 50;
+  static constexpr long MaxStalenessMinutes = 60;
+  static constexpr long RSSIFloor = -100;
+  static constexpr long RSSIWeight = 10; // up to 1000 for the strongest signal
+
+  struct Waiting {
+    std::size_t iterations = 0;
+    std::size_t lastSeen = 0; // round this slot last held a candidate
+    std::size_t targetHash = 0; // of the device last seen in this slot
+  };
+
+  std::size_t maxPerIteration;
+  std::size_t round;
+  std::array<Waiting,Slots> waiting;
+  std::vector<std::pair<long,std::size_t>> ranked; // reused working space
+  std::vector<BLEConnectionCandidate> ordered; // reused working space
+};
+
+}
+}
+
+#endif
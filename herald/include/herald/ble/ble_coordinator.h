@@ -10,12 +10,14 @@
 #include "ble_database.h"
 #include "ble_protocols.h"
 #include "ble_coordinator.h"
+#include "ble_connection_scheduler.h"
 #include "../engine/activities.h"
 #include "ble_protocols.h"
 #include "../data/sensor_logger.h"
 #include "ble_sensor_configuration.h"
 #include "../util/byte_array_printer.h"
 
+#include <algorithm>
 #include <memory>
 #include <functional>
 #include <optional>
@@ -33,6 +35,8 @@ public:
     db(bledb),
     pp(provider),
     previouslyProvisioned(),
+    scheduler(std::size_t(std::max(0, ctx.getSensorConfiguration().maxBluetoothConnections))),
+    candidates(),
     iterationsSinceBreak(0),
     breakEvery(10),
     breakFor(10)
@@ -82,14 +86,19 @@ public:
       }
     }
 
-    // Now provision new connections
+    // Now provision new connections, most important first
+    std::vector<PrioritisedPrerequisite> ordered(requested);
+    std::stable_sort(ordered.begin(), ordered.end(),
+      [](const PrioritisedPrerequisite& left, const PrioritisedPrerequisite& right) {
+        return std::get<1>(left) > std::get<1>(right);
+      });
     std::vector<PrioritisedPrerequisite> provisioned;
     // For this provider, a prerequisite is a connection to a remote target identifier over Bluetooth
-    auto requestIter = requested.cbegin();
+    auto requestIter = ordered.cbegin();
     bool lastConnectionSuccessful = true;
-    while (/*currentConnections < maxConnections && */
-          lastConnectionSuccessful && 
-          requestIter != requested.cend()) {
+    std::size_t connectionsAttempted = 0;
+    while (lastConnectionSuccessful && 
+          requestIter != ordered.cend()) {
       HTDBG(" - Satisfying prereq");
       // HTDBG(" - currentConnections currently:-");
       // HTDBG(std::to_string(currentConnections));
@@ -98,8 +107,11 @@ public:
       // If so, add to provisioned list
       // If not, try to connect
       auto& optTarget = std::get<2>(req);
-      if (optTarget.has_value()) {
+      if (optTarget.has_value() && connectionsAttempted >= scheduler.budget()) {
+        HTDBG(" - Connection budget used, leaving remaining targets for a later iteration");
+      } else if (optTarget.has_value()) {
         HTDBG(" - Have defined target for this prerequisite. Requesting connection be made available.");
+        ++connectionsAttempted;
         // std::future<void> fut = std::async(std::launch::async,
         //     &HeraldProtocolV1Provider::openConnection,pp,
         //     optTarget.value(),[&lastConnectionSuccessful] (
@@ -148,6 +160,9 @@ public:
     printAllDevices();
     std::vector<std::tuple<FeatureTag,Priority,std::optional<TargetIdentifier>>> results;
 
+    // Adverts received since the last iteration are ingested by SensorArray::iteration() before this call,
+    // including iterations where the coordinator skips this provider. See ConcreteBLESensor::processAdverts()
+
     // This ensures we break from making connections to allow advertising and scanning
     iterationsSinceBreak++;
     if (iterationsSinceBreak >= breakEvery &&
@@ -210,14 +225,31 @@ public:
         )
         ;
     });
+    // More devices may want a connection than we can make, so let the scheduler choose
+    candidates.clear();
     for (auto& device : newConns) {
       if (device.has_value()) {
-        results.emplace_back(herald::engine::Features::HeraldBluetoothProtocolConnection,
+        auto& dev = device.value().get();
+        bool hasPayload = dev.payloadData().size() > 0;
+        candidates.push_back(BLEConnectionCandidate{
+          dev.identifier(),
           herald::engine::Priorities::High,
-          device.value().get().identifier()
-        );
+          hasPayload,
+          hasPayload ? dev.timeIntervalSinceLastPayloadDataUpdate() : TimeInterval::never(),
+          dev.rssi(),
+          db.slotOf(dev)
+        });
       }
     }
+    scheduler.budget(std::size_t(std::max(0, context.getSensorConfiguration().maxBluetoothConnections)));
+    scheduler.schedule(candidates);
+    for (auto& candidate : candidates) {
+      HTDBG("Scheduling connection to {}", (std::string)candidate.target);
+      results.emplace_back(herald::engine::Features::HeraldBluetoothProtocolConnection,
+        candidate.priority,
+        candidate.target
+      );
+    }
 
     // TODO any other devices we may have outstanding work for that requires connections
 
@@ -469,6 +501,8 @@ private:
   ProviderT& pp;
 
   std::vector<PrioritisedPrerequisite> previouslyProvisioned;
+  BLEConnectionScheduler<BLEDBT::MaxDevices> scheduler;
+  std::vector<BLEConnectionCandidate> candidates;
 
   int iterationsSinceBreak;
   int breakEvery;
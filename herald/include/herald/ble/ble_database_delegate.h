@@ -24,6 +24,11 @@ public:
   virtual void bleDatabaseDidCreate(const BLEDevice& device) = 0;
   
   virtual void bleDatabaseDidUpdate(const BLEDevice& device, const BLEDeviceAttribute attribute) = 0;
+
+  /// \brief Called before an attribute of device changes, while it still holds its old value. Currently payloadData only.
+  virtual void bleDatabaseWillUpdate(const BLEDevice&, const BLEDeviceAttribute) {
+    ;
+  }
   
   virtual void bleDatabaseDidDelete(const BLEDevice& device) = 0;
 };
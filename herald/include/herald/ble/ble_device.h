@@ -212,6 +212,7 @@ public:
 
   // GENERAL BLUETOOTH STATE
   TimeInterval timeIntervalSinceLastUpdate() const override;
+  const Date& lastUpdatedAt() const noexcept; // for ordering devices without reading the clock
   // TimeInterval timeIntervalSinceConnected() const; // TODO unused, consider removing
 
   // TODO add in generic Advert and GATT handle number information caching here
@@ -267,7 +268,7 @@ public:
   std::optional<BLEMacAddress> pseudoDeviceAddress() const;
   void pseudoDeviceAddress(BLEMacAddress newAddress);
 
-  PayloadData payloadData() const;
+  const PayloadData& payloadData() const;
   void payloadData(PayloadData newPayloadData);
 
   // std::optional<ImmediateSendData> immediateSendData() const;
@@ -284,6 +285,8 @@ public:
   // void registerWriteRssi(Date at); // ALWAYS externalise time (now())
   
 private:
+  Date now() const noexcept; // from the delegate's clock, if set
+
   static BLESensorConfiguration staticConfig; // Used by empty constructor for array construction ONLY
   BLESensorConfiguration& conf; // allows this class to minimise its memory storage space
 
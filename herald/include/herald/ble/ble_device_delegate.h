@@ -16,6 +16,16 @@ public:
   virtual ~BLEDeviceDelegate() noexcept = default;
 
   virtual void device(const BLEDevice& device, const BLEDeviceAttribute didUpdate) noexcept = 0;  
+
+  /// \brief Called just before the payload of device is replaced, while it still holds the old value
+  virtual void deviceWillUpdate(const BLEDevice&, const BLEDeviceAttribute) noexcept {
+    ;
+  }
+
+  /// \brief The time BLEDevice instances record against attribute changes. Defaults to reading the system clock.
+  virtual Date now() noexcept {
+    return Date();
+  }
 };
 
 } // end namespace
@@ -35,6 +35,9 @@ public:
 
   void bytesBigEndian(std::uint8_t bytesBigEndian[6]) const;
 
+  /// \brief Returns the hash code of this address. Equal to that of TargetIdentifier for the same bytes.
+  std::size_t hashCode() const;
+
   Data underlyingData() const;
 
 private:
@@ -45,4 +48,15 @@ private:
 }
 }
 
+namespace std {
+  template<>
+  struct hash<herald::ble::BLEMacAddress>
+  {
+    size_t operator()(const herald::ble::BLEMacAddress& v) const
+    {
+      return v.hashCode();
+    }
+  };
+} // end namespace
+
 #endif
@@ -7,6 +7,7 @@
 
 #include "../datatype/target_identifier.h"
 #include "../engine/activities.h"
+#include "ble_advert_queue.h"
 
 namespace herald {
 namespace ble {
@@ -46,6 +47,16 @@ public:
   /** Restart scanning and advertising (if they were previously doing so) **/
   virtual void restartScanningAndAdvertising() = 0;
 
+  /** Ingests adverts queued by the platform scan callback since the last call. Returns the number taken from the queue. Call from one thread only. **/
+  virtual std::size_t processAdverts() {
+    return 0;
+  }
+
+  /** Counts of the adverts queued, and of those dropped because the queue was full, since start. **/
+  virtual BLEAdvertQueueCounters advertCounters() const {
+    return {};
+  }
+
   virtual std::optional<Activity> serviceDiscovery(Activity) = 0;
   virtual std::optional<Activity> readPayload(Activity) = 0;
   // virtual std::optional<Activity> immediateSend(Activity) = 0;
@@ -0,0 +1,241 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_BLE_ADVERT_VIEW_H
+#define HERALD_BLE_ADVERT_VIEW_H
+
+#include "ble_advert_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace herald {
+namespace ble {
+namespace filter {
+
+using namespace herald::datatype;
+
+/// \brief A non-owning, read only view of a contiguous range of advert bytes
+/// \since v2.1.0
+///
+/// Refers directly to the memory of the Data (or raw buffer) it was created from,
+/// so never copies or allocates. The view is only valid whilst that source is alive
+/// and unmodified. Use toData() to take an owned copy.
+class BLEAdvertDataView {
+public:
+  /// \brief Creates an empty view
+  BLEAdvertDataView() noexcept;
+  /// \brief Creates a view over length bytes starting at start
+  BLEAdvertDataView(const std::uint8_t* start, std::size_t length) noexcept;
+  /// \brief Creates a view over the whole of a Data instance
+  explicit BLEAdvertDataView(const Data& from) noexcept;
+  BLEAdvertDataView(const BLEAdvertDataView& other) noexcept = default;
+  BLEAdvertDataView& operator=(const BLEAdvertDataView& other) noexcept = default;
+  ~BLEAdvertDataView() noexcept = default;
+
+  /// \brief Returns the number of bytes in view
+  std::size_t size() const noexcept {
+    return length;
+  }
+
+  /// \brief Returns the address of the first byte in view (nullptr if empty)
+  const std::uint8_t* data() const noexcept {
+    return start;
+  }
+
+  /// \brief Returns the byte at index, or a byte value of zero if index is out of bounds (as for Data)
+  std::byte at(std::size_t index) const noexcept {
+    if (index >= length) {
+      return std::byte(0);
+    }
+    return std::byte(start[index]);
+  }
+
+  /// \brief Returns whether reading a single uint8_t to `into` at `fromIndex` was successful
+  bool uint8(std::size_t fromIndex, std::uint8_t& into) const noexcept;
+  /// \brief Returns whether reading a little endian uint16_t to `into` at `fromIndex` was successful
+  bool uint16(std::size_t fromIndex, std::uint16_t& into) const noexcept;
+
+  /// \brief Returns a view of a subset of this view, clamped to the bytes available
+  BLEAdvertDataView subview(std::size_t offset, std::size_t count) const noexcept;
+
+  /// \brief Returns a NEWLY allocated Data instance holding a copy of the bytes in view
+  Data toData() const;
+
+  /// \brief Returns a hex encoded string of the bytes in view
+  std::string hexEncodedString() const;
+
+  /// \brief Byte for byte equality with an owned Data instance
+  bool operator==(const Data& other) const noexcept;
+  bool operator!=(const Data& other) const noexcept;
+
+private:
+  const std::uint8_t* start;
+  std::size_t length;
+};
+
+/// \brief A typed advert segment referring to the advert's bytes in place
+struct BLEAdvertSegmentView {
+  BLEAdvertSegmentType type;
+  BLEAdvertDataView data;
+};
+
+/// \brief A manufacturer data segment (code removed from the data) referring to the advert's bytes in place
+struct BLEAdvertManufacturerDataView {
+  std::uint16_t manufacturer = 0;
+  BLEAdvertDataView data;
+
+  /// \brief Reads a manufacturer data segment. Returns false if segment is not valid manufacturer data.
+  static bool from(const BLEAdvertSegmentView& segment, BLEAdvertManufacturerDataView& into) noexcept;
+};
+
+/// \brief An Apple manufacturer data sub segment referring to the advert's bytes in place
+struct BLEAdvertAppleManufacturerSegmentView {
+  std::uint8_t type;
+  BLEAdvertDataView data;
+};
+
+/// \brief Forward iterator over the length-type-value segments of an advert
+///
+/// A zero length segment marks the end of the significant part of an advert
+/// (as per the Bluetooth Core Specification) and ends iteration, as does a
+/// segment whose reported length runs past the end of the data.
+class BLEAdvertSegmentIterator {
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = BLEAdvertSegmentView;
+  using pointer = const BLEAdvertSegmentView*;
+  using reference = const BLEAdvertSegmentView&;
+  using iterator_category = std::forward_iterator_tag;
+
+  /// \brief Creates an end iterator
+  BLEAdvertSegmentIterator() noexcept;
+  /// \brief Creates an iterator positioned at the first segment at or after offset within raw
+  BLEAdvertSegmentIterator(const BLEAdvertDataView& raw, std::size_t offset) noexcept;
+
+  reference operator*() const noexcept {
+    return current;
+  }
+
+  pointer operator->() const noexcept {
+    return &current;
+  }
+
+  BLEAdvertSegmentIterator& operator++() noexcept;
+  BLEAdvertSegmentIterator operator++(int) noexcept;
+
+  /// \brief Equality operator. Compares position.
+  bool operator==(const BLEAdvertSegmentIterator& other) const noexcept;
+  bool operator!=(const BLEAdvertSegmentIterator& other) const noexcept;
+
+private:
+  void readSegment() noexcept;
+
+  BLEAdvertDataView raw;
+  std::size_t position; // of the next segment to read
+  bool atEnd;
+  BLEAdvertSegmentView current;
+};
+
+/// \brief A zero allocation, non-owning view over a raw BLE advert
+/// \since v2.1.0
+///
+/// Walks the raw advert bytes in place, yielding typed BLEAdvertSegmentView instances.
+/// Equivalent to BLEAdvertParser::extractSegments and related functions, but without
+/// creating any std::vector or Data instances. Only valid whilst the source is alive.
+class BLEAdvertView {
+public:
+  using iterator = BLEAdvertSegmentIterator;
+  using const_iterator = BLEAdvertSegmentIterator;
+
+  /// \brief Views the advert held in raw, starting at offset
+  explicit BLEAdvertView(const Data& raw, std::size_t offset = 0) noexcept;
+  /// \brief Views an advert held in a raw buffer. E.g. the buffer provided to a scan callback.
+  BLEAdvertView(const std::uint8_t* raw, std::size_t length) noexcept;
+  ~BLEAdvertView() noexcept = default;
+
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+
+  /// \brief Reads the first valid tx power segment value. Returns false if there is none.
+  bool txPower(std::uint8_t& into) const noexcept;
+
+  /// \brief Finds the first manufacturer data segment for the given (little endian) manufacturer code
+  bool manufacturerData(std::uint16_t manufacturer, BLEAdvertManufacturerDataView& into) const noexcept;
+
+  /// \brief Returns an owning copy of all segments. Same result as BLEAdvertParser::extractSegments.
+  std::vector<BLEAdvertSegment> toSegments() const;
+
+private:
+  BLEAdvertDataView raw;
+  std::size_t offset;
+};
+
+/// \brief Forward iterator over the type-length-data sub segments of Apple manufacturer data
+class BLEAdvertAppleSegmentIterator {
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = BLEAdvertAppleManufacturerSegmentView;
+  using pointer = const BLEAdvertAppleManufacturerSegmentView*;
+  using reference = const BLEAdvertAppleManufacturerSegmentView&;
+  using iterator_category = std::forward_iterator_tag;
+
+  /// \brief Creates an end iterator
+  BLEAdvertAppleSegmentIterator() noexcept;
+  /// \brief Creates an iterator positioned at the first sub segment of Apple manufacturer data
+  explicit BLEAdvertAppleSegmentIterator(const BLEAdvertDataView& manufacturerData) noexcept;
+
+  reference operator*() const noexcept {
+    return current;
+  }
+
+  pointer operator->() const noexcept {
+    return &current;
+  }
+
+  BLEAdvertAppleSegmentIterator& operator++() noexcept;
+  BLEAdvertAppleSegmentIterator operator++(int) noexcept;
+
+  /// \brief Equality operator. Compares position.
+  bool operator==(const BLEAdvertAppleSegmentIterator& other) const noexcept;
+  bool operator!=(const BLEAdvertAppleSegmentIterator& other) const noexcept;
+
+private:
+  void readSegment() noexcept;
+
+  BLEAdvertDataView raw;
+  std::size_t position; // of the next sub segment to read
+  bool atEnd;
+  BLEAdvertAppleManufacturerSegmentView current;
+};
+
+/// \brief Range over the sub segments of Apple manufacturer data, for use in range-for loops
+class BLEAdvertAppleSegments {
+public:
+  explicit BLEAdvertAppleSegments(const BLEAdvertDataView& manufacturerData) noexcept
+   : raw(manufacturerData)
+  {
+    ;
+  }
+
+  BLEAdvertAppleSegmentIterator begin() const noexcept {
+    return BLEAdvertAppleSegmentIterator(raw);
+  }
+
+  BLEAdvertAppleSegmentIterator end() const noexcept {
+    return BLEAdvertAppleSegmentIterator();
+  }
+
+private:
+  BLEAdvertDataView raw;
+};
+
+}
+}
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "../ble_coordinator.h"
 #include "../../datatype/bluetooth_state.h"
 #include "../ble_mac_address.h"
+#include "../ble_advert_queue.h"
 #include "../../zephyr_context.h"
 
 // nRF Connect SDK includes
@@ -42,6 +43,11 @@
 #include <map>
 #include <functional>
 
+#ifndef CONFIG_HERALD_ADVERT_QUEUE_SIZE
+  // About 200 adverts per second in a busy area, over a 250ms iteration, with room to spare. ~40 bytes each.
+  #define CONFIG_HERALD_ADVERT_QUEUE_SIZE 128
+#endif
+
 namespace herald {
 namespace ble {
 
@@ -236,7 +242,9 @@ public:
       db(bleDatabase),
       delegates(dels),
       connectionStates(),
-      isScanning(false)
+      isScanning(false),
+      adverts(),
+      reportedDrops(0)
       HLOGGERINIT(ctx,"Sensor","BLE.ConcreteBLEReceiver")
   {
     ;
@@ -608,6 +616,43 @@ public:
 
 
 
+  std::size_t processAdverts() override
+  {
+    std::size_t processed = adverts.drain([this] (const auto& advert, const std::int8_t* earlierRssi, std::size_t earlierCount) {
+      // identify device by both MAC and potential pseudoDeviceAddress
+      BLEMacAddress bleMacAddress(advert.mac.data());
+      Data advertData(advert.bytes.data(),advert.length);
+      auto& device = db.device(bleMacAddress,advertData);
+
+      if (device.ignore()) {
+        // device.rssi(RSSI(rssi)); // TODO should we do this so our update date works and shows this as a 'live' device?
+        return;
+      }
+
+      // Now pass to relevant BLEDatabase API call
+      if (device.rssi().intValue() == 0) { // No RSSI yet, so must be a new device instance
+        HTDBG("didDiscover (device={})",(std::string)bleMacAddress);
+      }
+
+      // Readings from adverts superseded within this batch are still passed on, for analysis
+      for (std::size_t i = 0;i < earlierCount;++i) {
+        device.rssi(RSSI(earlierRssi[i]));
+      }
+      // Add this RSSI reading - called at the end to ensure all other data variables set
+      device.rssi(RSSI(advert.rssi));
+    });
+    if (adverts.dropped() != reportedDrops) {
+      HTDBG("Advert queue full. Dropped {} adverts since last iteration", adverts.dropped() - reportedDrops);
+      reportedDrops = adverts.dropped();
+    }
+    return processed;
+  }
+
+  BLEAdvertQueueCounters advertCounters() const override
+  {
+    return adverts.counters();
+  }
+
   void restartScanningAndAdvertising() override
   {
     HTDBG("RESTART SCANNING AND ADVERTISING CALLED");
@@ -792,26 +837,8 @@ private:
   void scan_cb(const bt_addr_le_t *addr, int8_t rssi, uint8_t adv_type,
       struct net_buf_simple *buf) override
   {
-    // identify device by both MAC and potential pseudoDeviceAddress
-    BLEMacAddress bleMacAddress(addr->a.val);
-    Data advert(buf->data,buf->len);
-    auto& device = db.device(bleMacAddress,advert);
-
-    // auto& device = db.device(target);
-    if (device.ignore()) {
-      // device.rssi(RSSI(rssi)); // TODO should we do this so our update date works and shows this as a 'live' device?
-      return;
-    }
-
-    // Now pass to relevant BLEDatabase API call
-    if (device.rssi().intValue() == 0) { // No RSSI yet, so must be a new device instance
-      char addr_str[BT_ADDR_LE_STR_LEN];
-      bt_addr_le_to_str(addr, addr_str, sizeof(addr_str));
-      HTDBG("didDiscover (device={})",addr_str);
-    }
-
-    // Add this RSSI reading - called at the end to ensure all other data variables set
-    device.rssi(RSSI(rssi));
+    // Runs in the Bluetooth callback context, so only queue the advert. See processAdverts()
+    adverts.push(addr->a.val, rssi, adv_type, buf->data, buf->len);
   }
 
   void le_param_updated(struct bt_conn *conn, uint16_t interval,
@@ -1182,6 +1209,9 @@ private:
   std::map<TargetIdentifier,ConnectedDeviceState> connectionStates;
   bool isScanning;
 
+  BLEAdvertQueue<CONFIG_HERALD_ADVERT_QUEUE_SIZE> adverts; // filled by scan_cb, emptied by processAdverts()
+  std::size_t reportedDrops;
+
   HLOGGER(ContextT);
 };
 
@@ -0,0 +1,162 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_CLOCK_H
+#define HERALD_CLOCK_H
+
+#include "datatype/date.h"
+#include "datatype/time_interval.h"
+
+#include <cstdint>
+
+#ifdef __ZEPHYR__
+#include <kernel.h>
+#else
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace herald {
+
+/// \brief Default clock source. Reads the platform clock on every call.
+///
+/// now() has the same meaning as Date(): seconds since the Unix epoch, or
+/// since restart on Zephyr. ticks() is monotonic milliseconds on all
+/// platforms, from an unspecified start, and never goes backwards when the
+/// wall clock is adjusted.
+struct SystemClock {
+  datatype::Date now() noexcept {
+    return datatype::Date();
+  }
+
+  std::uint64_t ticks() noexcept {
+#ifdef __ZEPHYR__
+    return (std::uint64_t)k_uptime_get();
+#else
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+};
+
+/// \brief Returns a process wide instance of ClockSourceT, for use where no clock source is supplied
+template <typename ClockSourceT>
+ClockSourceT& defaultClockSource() noexcept {
+  static ClockSourceT source;
+  return source;
+}
+
+/// \brief Clock source that only moves when told to. For deterministic tests and replay.
+struct FakeClock {
+  FakeClock() noexcept : wallMillis(0), millis(0) {}
+  explicit FakeClock(const datatype::Date& start) noexcept : wallMillis(1000 * start.secondsSinceUnixEpoch()), millis(0) {}
+  ~FakeClock() = default;
+
+  datatype::Date now() noexcept {
+    return datatype::Date(wallMillis / 1000);
+  }
+
+  std::uint64_t ticks() noexcept {
+    return millis;
+  }
+
+  /// \brief Sets the wall clock time. Does not affect ticks(), which stay monotonic.
+  void set(const datatype::Date& to) noexcept {
+    wallMillis = 1000 * to.secondsSinceUnixEpoch();
+  }
+
+  /// \brief Moves both now() and ticks() forward
+  void advance(const datatype::TimeInterval& by) noexcept {
+    if (by.millis() <= 0) {
+      return;
+    }
+    wallMillis += (std::uint64_t)by.millis();
+    millis += (std::uint64_t)by.millis();
+  }
+
+private:
+  std::uint64_t wallMillis; // kept in millis so that sub second advances accumulate
+  std::uint64_t millis;
+};
+
+/// \brief Holds the current time as of the last refresh() of a ClockSourceT.
+///
+/// Context refreshes this once per SensorArray iteration, so all components
+/// acting within one iteration see the same now() without reading the
+/// platform clock each time. ticks() is passed straight through to the source.
+///
+/// Components that act outside of a SensorArray iteration see the time of
+/// the last refresh(), so must call refresh() themselves if they need a
+/// later time.
+///
+/// now() may be read from other threads (E.g. coordinator tasks, or Zephyr
+/// Bluetooth callbacks) whilst refresh() is called. The cached value is
+/// atomic where threads exist, and read and written with interrupts locked
+/// on Zephyr, as 64 bit values cannot be read in one instruction on 32 bit
+/// Cortex-M cores.
+template <typename ClockSourceT>
+class CachedClock {
+public:
+  CachedClock(ClockSourceT& source) noexcept
+    : clockSource(source), cached(source.now().secondsSinceUnixEpoch())
+  {
+    ;
+  }
+  CachedClock(const CachedClock& other) noexcept
+    : clockSource(other.clockSource), cached(other.secondsSinceEpoch())
+  {
+    ;
+  }
+  ~CachedClock() = default;
+
+  /// \brief Returns the time as of the last refresh()
+  datatype::Date now() const noexcept {
+    return datatype::Date(secondsSinceEpoch());
+  }
+
+  /// \brief Re-reads the clock source. Returns the new now().
+  datatype::Date refresh() noexcept {
+    datatype::Date latest = clockSource.now();
+#ifdef __ZEPHYR__
+    unsigned int key = irq_lock();
+    cached = latest.secondsSinceUnixEpoch();
+    irq_unlock(key);
+#else
+    cached.store(latest.secondsSinceUnixEpoch(), std::memory_order_relaxed);
+#endif
+    return latest;
+  }
+
+  /// \brief Returns monotonic milliseconds, read from the clock source on each call
+  std::uint64_t ticks() noexcept {
+    return clockSource.ticks();
+  }
+
+  ClockSourceT& source() noexcept {
+    return clockSource;
+  }
+
+private:
+  ClockSourceT& clockSource;
+#ifdef __ZEPHYR__
+  std::uint64_t cached;
+#else
+  std::atomic<std::uint64_t> cached;
+#endif
+
+  std::uint64_t secondsSinceEpoch() const noexcept {
+#ifdef __ZEPHYR__
+    unsigned int key = irq_lock();
+    std::uint64_t value = cached;
+    irq_unlock(key);
+    return value;
+#else
+    return cached.load(std::memory_order_relaxed);
+#endif
+  }
+};
+
+} // end namespace
+
+#endif
@@ -6,7 +6,9 @@
 #define HERALD_CONTEXT_H
 
 #include "ble/ble_sensor_configuration.h" // TODO abstract this away in to platform class
+#include "clock.h"
 #include "datatype/date.h"
+#include "datatype/hash.h"
 
 namespace herald {
 
@@ -15,17 +17,36 @@ namespace herald {
 /// Covers all cross-cutting concerns methods and helpers to prevent tight coupling between components
 /// Currently hard-coded to include Bluetooth relevant radio, but this should be abstracted in future to
 /// compile out if Bluetooth support is not needed
+///
+/// The current time is read from ClockSourceT once per SensorArray iteration and cached, so
+/// getNow() only moves when SensorArray::iteration() (or getClock().refresh()) is called. Code
+/// that uses a Context without a SensorArray must refresh the clock itself. Pass a FakeClock (and
+/// its type as ClockSourceT) to control time in tests. PlatformT::getNow() is not used. A platform
+/// with its own time source should provide it as ClockSourceT instead.
+///
+/// Construction also seeds the process wide hash seed (See datatype::hashCode()) from the
+/// platform's random number source, if no hash has been calculated yet.
 template <typename PlatformT,
           typename LoggingSinkT,
-          typename BluetoothStateManagerT
+          typename BluetoothStateManagerT,
+          typename ClockSourceT = SystemClock
          >
 struct Context {
   using logging_sink_type = LoggingSinkT;
+  using clock_type = CachedClock<ClockSourceT>;
 
   Context(PlatformT& platform,LoggingSinkT& sink,BluetoothStateManagerT& bsm) noexcept
-    : platform(platform), loggingSink(sink), bleStateManager(bsm), config() {}
+    : platform(platform), loggingSink(sink), bleStateManager(bsm), config(), clock(defaultClockSource<ClockSourceT>())
+  {
+    datatype::hashing::seed();
+  }
+  Context(PlatformT& platform,LoggingSinkT& sink,BluetoothStateManagerT& bsm,ClockSourceT& clockSource) noexcept
+    : platform(platform), loggingSink(sink), bleStateManager(bsm), config(), clock(clockSource)
+  {
+    datatype::hashing::seed();
+  }
   Context(const Context& other) noexcept
-    : platform(other.platform), loggingSink(other.loggingSink), bleStateManager(other.bleStateManager), config(other.config)
+    : platform(other.platform), loggingSink(other.loggingSink), bleStateManager(other.bleStateManager), config(other.config), clock(other.clock)
   {}
   // Context(Context&& other)
   //   : loggingSink(std::move(other.loggingSink)), bleStateManager(std::move(other.bleStateManager))
@@ -33,7 +54,7 @@ struct Context {
   ~Context() = default;
 
   
-  Context<PlatformT,LoggingSinkT,BluetoothStateManagerT>& operator=(Context& other) noexcept {
+  Context<PlatformT,LoggingSinkT,BluetoothStateManagerT,ClockSourceT>& operator=(Context& other) noexcept {
     platform = other.platform;
     loggingSink = other.loggingSink;
     bleStateManager = other.bleStateManager;
@@ -63,8 +84,14 @@ struct Context {
     config = newConfig;
   }
 
+  // \brief Returns the clock used by getNow(), for monotonic ticks() or to refresh() it
+  clock_type& getClock() noexcept {
+    return clock;
+  }
+
+  // \brief Returns the time as of the last clock refresh (the start of the current iteration), without reading the platform clock
   datatype::Date getNow() noexcept {
-    return platform.getNow();
+    return clock.now();
   }
 
 private:
@@ -72,6 +99,7 @@ private:
   LoggingSinkT& loggingSink;
   BluetoothStateManagerT& bleStateManager;
   ble::BLESensorConfiguration config;
+  clock_type clock;
 };
 
 // \brief Default empty platform type for platforms that have no custom functionality
@@ -0,0 +1,83 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_APPEND_LOG_H
+#define HERALD_APPEND_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace herald {
+namespace data {
+
+/// \brief An append only file of fixed size binary records, read through a memory mapping
+///
+/// Appended records are buffered in memory and written to the end of the file by flush(),
+/// or when the buffer fills. record() reads any record, whether written or still buffered.
+/// Written records are read through a read only memory mapping of the file, which is
+/// extended as the file grows, so historical reads do not copy or allocate.
+///
+/// Records are never changed once appended. replace() rewrites the whole file (E.g. to
+/// compact it) by writing a new file and renaming it over the old one, so a crash leaves
+/// either the old or the new file in place. A partial record left at the end of the file by
+/// a crash during a write is dropped by open().
+///
+/// Only available on POSIX hosts (Linux, macOS). Elsewhere open() returns false.
+/// Only built for host (non embedded) platforms - see HERALD_SOURCES_SERVER.
+class AppendLog {
+public:
+  AppendLog(std::string path, std::size_t recordSize) noexcept;
+  ~AppendLog() noexcept;
+
+  AppendLog(const AppendLog&) = delete;
+  AppendLog& operator=(const AppendLog&) = delete;
+
+  /// \brief Opens the file, creating it if it does not exist
+  bool open() noexcept;
+  /// \brief Flushes any buffered records and closes the file
+  void close() noexcept;
+  bool isOpen() const noexcept;
+
+  const std::string& path() const noexcept;
+  std::size_t recordSize() const noexcept;
+  /// \brief Number of records, including those not yet written
+  std::size_t size() const noexcept;
+
+  /// \brief Appends one record of recordSize() bytes. Its record number is size() - 1 afterwards.
+  bool append(const std::uint8_t* record) noexcept;
+
+  /// \brief Returns the record with the given number, or nullptr if there is no such record.
+  /// The pointer is valid until the next call to any method, including record() itself,
+  /// which may move the mapping to read a newer record. Not safe to call from several threads at once.
+  const std::uint8_t* record(std::size_t number) const noexcept;
+
+  /// \brief Writes buffered records to the file
+  bool flush() noexcept;
+  /// \brief Writes buffered records and waits for the file to reach the storage device
+  bool sync() noexcept;
+
+  /// \brief Replaces every record with those given (a multiple of recordSize() bytes).
+  /// Returns true once the new file is in use. Its directory entry is synced too, but if that
+  /// alone fails the new file is still used, as the old one has already been renamed over.
+  bool replace(const std::vector<std::uint8_t>& records) noexcept;
+
+private:
+  std::string filePath;
+  std::size_t recordBytes;
+  int fd;
+  std::size_t written; // records in the file
+  std::vector<std::uint8_t> pending; // records appended but not yet written
+  mutable const std::uint8_t* mapping;
+  mutable std::size_t mappedRecords; // capacity of the mapping, which may exceed the file
+
+  bool remap(std::size_t records) const noexcept;
+  void unmap() const noexcept;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,448 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_BINARY_LOGGING_SINK_H
+#define HERALD_BINARY_LOGGING_SINK_H
+
+#include "sensor_logger.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifndef __ZEPHYR__
+#include <chrono>
+#include <thread>
+#endif
+
+namespace herald {
+namespace data {
+
+/// \brief How each argument is held within a BinaryLogRecord
+enum class BinaryLogArgType : std::uint8_t {
+  signedInteger, unsignedInteger, floatingPoint, string
+};
+
+/// \brief Default fallback for BinaryLoggingSink: over long messages are truncated and marked instead
+struct NoFallbackLoggingSink {
+};
+
+/// \brief One log line, held as the address of its format string plus its encoded arguments.
+///
+/// Arguments are tagged by BinaryLogArgType. Numbers take 8 bytes, strings
+/// a one byte length then their bytes. Arguments that do not fit are
+/// truncated (strings) or omitted, and truncated is set.
+template <std::size_t ArgBytes>
+struct BinaryLogRecord {
+  const char* format; // string literal, or a string copied in to args (See formatInArgs)
+  std::uint8_t source; // index in to the sink's subsystem and category table
+  SensorLoggerLevel level;
+  std::uint8_t argCount;
+  std::uint8_t used; // bytes of args in use
+  bool formatInArgs; // format was not a literal, so was copied as the first string argument
+  bool truncated;
+  std::array<std::uint8_t,ArgBytes> args;
+};
+
+/// \brief Logging sink that records log lines in binary form and defers formatting until they are drained.
+///
+/// SensorLogger detects this sink at compile time. For it, log calls with a string
+/// literal format do not parse the format or build a string. Instead the literal's
+/// address and the raw arguments are copied in to a fixed size record in a lock
+/// free ring buffer, which any number of threads may write to. Subsystem and
+/// category are registered once per SensorLogger and held as a one byte id.
+///
+/// drain() formats records in the same way as the text loggers and passes them to
+/// a callable (E.g. another logging sink), and may be called from a background
+/// thread (See BinaryLogDrainThread) or periodically from the application.
+/// When the ring is full new records are dropped and counted.
+///
+/// Only formats marked as literals by the HTDBG/HTLOG/HTERR macros are kept by
+/// address (See HERALD_LOG_FORMAT). Other formats, including char arrays, are copied.
+///
+/// Arguments that do not fit in a record are cut short, and the drained line ends
+/// with truncationMarker. Pre formatted (non literal) messages too long for a record
+/// are instead passed straight to the fallback sink, if one was given. It is called
+/// from the logging thread, so may receive them ahead of earlier lines still in the ring.
+template <std::size_t Capacity = 256, std::size_t RecordArgBytes = 104, std::size_t MaxSources = 32,
+          typename FallbackSinkT = NoFallbackLoggingSink>
+class BinaryLoggingSink {
+public:
+  static_assert(Capacity > 1 && 0 == (Capacity & (Capacity - 1)), "Capacity must be a power of two");
+  static_assert(RecordArgBytes >= 10 && RecordArgBytes <= 255, "Records hold between one number and 255 bytes of arguments");
+  static_assert(MaxSources < 255, "Source ids are one byte, with 255 meaning unregistered");
+
+  using record_type = BinaryLogRecord<RecordArgBytes>;
+  static constexpr std::uint8_t unknownSource = 255;
+  /// \brief Ends drained lines that lost some of their arguments or message
+  static constexpr const char* truncationMarker = "...";
+
+  BinaryLoggingSink() noexcept
+    : writePos(0), readPos(0), dropCount(0), slots(), sourceLock(), sourceCount(0), sources(), fallback(nullptr)
+  {
+    initSlots();
+  }
+
+  /// \brief Passes pre formatted messages too long for a record to fallbackSink (E.g. the drain's text sink).
+  /// fallbackSink must accept log() calls from every thread that logs.
+  explicit BinaryLoggingSink(FallbackSinkT& fallbackSink) noexcept
+    : writePos(0), readPos(0), dropCount(0), slots(), sourceLock(), sourceCount(0), sources(), fallback(&fallbackSink)
+  {
+    initSlots();
+  }
+  BinaryLoggingSink(const BinaryLoggingSink&) = delete;
+  BinaryLoggingSink(BinaryLoggingSink&&) = delete;
+  ~BinaryLoggingSink() noexcept = default;
+
+  /// \brief Returns the id for a subsystem and category, registering it if new. Called once per SensorLogger.
+  std::uint8_t source(const std::string& subsystem, const std::string& category) noexcept {
+    while (sourceLock.test_and_set(std::memory_order_acquire)) {
+      ; // only contended whilst loggers are being created
+    }
+    std::uint8_t id = find(subsystem, category);
+    const std::size_t count = sourceCount.load(std::memory_order_relaxed);
+    if (unknownSource == id && count < MaxSources) {
+      sources[count].subsystem = subsystem;
+      sources[count].category = category;
+      sourceCount.store(count + 1, std::memory_order_release);
+      id = (std::uint8_t)count;
+    }
+    sourceLock.clear(std::memory_order_release);
+    return id;
+  }
+
+  /// \brief Records a log line whose format is a string literal. Returns false if dropped as the ring is full.
+  template <typename... Types>
+  bool record(std::uint8_t source, SensorLoggerLevel level, const char* format, const Types&... args) noexcept {
+    Slot* slot = claim();
+    if (nullptr == slot) {
+      return false;
+    }
+    record_type& r = slot->record;
+    r.format = format;
+    r.source = source;
+    r.level = level;
+    r.argCount = 0;
+    r.used = 0;
+    r.formatInArgs = false;
+    r.truncated = false;
+    (encode(r, args), ...);
+    publish(slot);
+    return true;
+  }
+
+  /// \brief Text sink compatible entry point. The message is copied, as a pre formatted string.
+  void log(const std::string& subsystem, const std::string& category, SensorLoggerLevel level, std::string message) noexcept {
+    log(findRegistered(subsystem, category), level, std::move(message));
+  }
+
+  /// \brief As above, for a source already registered. Used by SensorLogger for non literal formats.
+  void log(std::uint8_t source, SensorLoggerLevel level, std::string message) noexcept {
+    if constexpr (!std::is_same_v<FallbackSinkT,NoFallbackLoggingSink>) {
+      if (nullptr != fallback && (message.size() > 255 || message.size() + 2 > RecordArgBytes)) {
+        static const std::string unknown("?");
+        const bool known = source < sourceCount.load(std::memory_order_acquire);
+        fallback->log(known ? sources[source].subsystem : unknown, known ? sources[source].category : unknown, level, message);
+        return;
+      }
+    }
+    Slot* slot = claim();
+    if (nullptr == slot) {
+      return;
+    }
+    record_type& r = slot->record;
+    r.format = nullptr;
+    r.source = source;
+    r.level = level;
+    r.argCount = 0;
+    r.used = 0;
+    r.formatInArgs = true;
+    r.truncated = false;
+    encode(r, message);
+    publish(slot);
+  }
+
+  /// \brief Formats and removes up to maxRecords records, calling
+  /// to(const std::string& subsystem, const std::string& category, SensorLoggerLevel, const std::string& message)
+  /// for each. Only one thread may drain at a time. Returns the number drained.
+  template <typename HandlerT>
+  std::size_t drain(HandlerT&& to, std::size_t maxRecords = Capacity) {
+    static const std::string unknown("?");
+    std::size_t drained = 0;
+    std::stringstream os;
+    std::string message;
+    while (drained < maxRecords) {
+      const std::size_t pos = readPos.load(std::memory_order_relaxed);
+      Slot& slot = slots[pos & (Capacity - 1)];
+      if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+        break; // empty, or the next record is still being written
+      }
+      const record_type& r = slot.record;
+      os.str(std::string());
+      os.clear();
+      format(os, r);
+      if (r.truncated) {
+        os << truncationMarker;
+      }
+      message = os.str();
+      const bool known = r.source < sourceCount.load(std::memory_order_acquire);
+      to(known ? sources[r.source].subsystem : unknown, known ? sources[r.source].category : unknown, r.level, message);
+      slot.sequence.store(pos + Capacity, std::memory_order_release);
+      readPos.store(pos + 1, std::memory_order_relaxed);
+      ++drained;
+    }
+    return drained;
+  }
+
+  /// \brief Records lost because the ring was full
+  std::size_t dropped() const noexcept {
+    return dropCount.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Slot {
+    std::atomic<std::size_t> sequence; // == position when free to write, position + 1 when readable
+    record_type record;
+  };
+
+  struct Source {
+    std::string subsystem;
+    std::string category;
+  };
+
+  std::atomic<std::size_t> writePos;
+  std::atomic<std::size_t> readPos;
+  std::atomic<std::size_t> dropCount;
+  std::array<Slot,Capacity> slots;
+
+  std::atomic_flag sourceLock;
+  std::atomic<std::size_t> sourceCount;
+  std::array<Source,MaxSources> sources;
+  FallbackSinkT* fallback; // optional
+
+  void initSlots() noexcept {
+    for (std::size_t i = 0;i < Capacity;++i) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// \brief Bounded multi producer claim (after D. Vyukov). Returns nullptr if full.
+  Slot* claim() noexcept {
+    std::size_t pos = writePos.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots[pos & (Capacity - 1)];
+      const std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+      if (seq == pos) {
+        if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          return &slot;
+        }
+      } else if (seq < pos) {
+        dropCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      } else {
+        pos = writePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void publish(Slot* slot) noexcept {
+    slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  std::uint8_t find(const std::string& subsystem, const std::string& category) const noexcept {
+    const std::size_t count = sourceCount.load(std::memory_order_acquire);
+    for (std::size_t i = 0;i < count;++i) {
+      if (sources[i].subsystem == subsystem && sources[i].category == category) {
+        return (std::uint8_t)i;
+      }
+    }
+    return unknownSource;
+  }
+
+  std::uint8_t findRegistered(const std::string& subsystem, const std::string& category) noexcept {
+    std::uint8_t id = find(subsystem, category);
+    if (unknownSource == id) {
+      id = source(subsystem, category);
+    }
+    return id;
+  }
+
+  // MARK: Encoding
+
+  bool reserve(record_type& r, std::size_t bytes) noexcept {
+    if (r.used + bytes > RecordArgBytes) {
+      r.truncated = true;
+      return false;
+    }
+    return true;
+  }
+
+  void encodeNumber(record_type& r, BinaryLogArgType type, const void* value) noexcept {
+    if (!reserve(r, 9)) {
+      return;
+    }
+    r.args[r.used] = (std::uint8_t)type;
+    std::memcpy(&r.args[r.used + 1], value, 8);
+    r.used += 9;
+    ++r.argCount;
+  }
+
+  void encodeString(record_type& r, const char* value, std::size_t length) noexcept {
+    if (!reserve(r, 2)) {
+      return;
+    }
+    const std::size_t space = RecordArgBytes - r.used - 2;
+    if (length > space || length > 255) {
+      r.truncated = true;
+      length = std::min<std::size_t>(space, 255);
+    }
+    r.args[r.used] = (std::uint8_t)BinaryLogArgType::string;
+    r.args[r.used + 1] = (std::uint8_t)length;
+    std::memcpy(&r.args[r.used + 2], value, length);
+    r.used += (std::uint8_t)(2 + length);
+    ++r.argCount;
+  }
+
+  template <typename T>
+  void encode(record_type& r, const T& value) noexcept {
+    if constexpr (std::is_same_v<T,char>) {
+      encodeString(r, &value, 1);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+      const std::int64_t v = value;
+      encodeNumber(r, BinaryLogArgType::signedInteger, &v);
+    } else if constexpr (std::is_integral_v<T>) {
+      const std::uint64_t v = value; // includes bool (0 or 1) and std::uint8_t (a number), as tprintValue prints them
+      encodeNumber(r, BinaryLogArgType::unsignedInteger, &v);
+    } else if constexpr (std::is_same_v<T,double>) {
+      encodeNumber(r, BinaryLogArgType::floatingPoint, &value);
+    } else if constexpr (std::is_convertible_v<const T&,const char*>) {
+      const char* v = value;
+      encodeString(r, v, nullptr == v ? 0 : std::strlen(v));
+    } else if constexpr (std::is_convertible_v<const T&,std::string_view>) {
+      const std::string_view v = value;
+      encodeString(r, v.data(), v.size());
+    } else {
+      // E.g. TargetIdentifier. Formatted now, as it may have changed by the time it is drained
+      std::stringstream os;
+      tprintValue(os, value);
+      const std::string v = os.str();
+      encodeString(r, v.data(), v.size());
+    }
+  }
+
+  // MARK: Decoding
+
+  /// \brief Writes the next argument from pos, advancing pos
+  static void decodeArg(std::stringstream& os, const record_type& r, std::size_t& pos) {
+    const BinaryLogArgType type = (BinaryLogArgType)r.args[pos];
+    if (BinaryLogArgType::string == type) {
+      const std::size_t length = r.args[pos + 1];
+      os.write((const char*)&r.args[pos + 2], length);
+      pos += 2 + length;
+      return;
+    }
+    if (BinaryLogArgType::signedInteger == type) {
+      std::int64_t v;
+      std::memcpy(&v, &r.args[pos + 1], 8);
+      tprintValue(os, v);
+    } else if (BinaryLogArgType::unsignedInteger == type) {
+      std::uint64_t v;
+      std::memcpy(&v, &r.args[pos + 1], 8);
+      tprintValue(os, v);
+    } else {
+      double v;
+      std::memcpy(&v, &r.args[pos + 1], 8);
+      tprintValue(os, v);
+    }
+    pos += 9;
+  }
+
+  /// \brief Substitutes each {} in the format with the next argument, as tprintf does
+  static void format(std::stringstream& os, const record_type& r) {
+    std::size_t pos = 0;
+    std::size_t remaining = r.argCount;
+    std::string_view fmt;
+    if (r.formatInArgs) {
+      if (0 == remaining) {
+        return;
+      }
+      const std::size_t length = r.args[1];
+      fmt = std::string_view((const char*)&r.args[2], length);
+      pos = 2 + length;
+      --remaining;
+    } else {
+      fmt = std::string_view(r.format);
+    }
+    for (std::size_t i = 0;i < fmt.size();++i) {
+      if ('{' != fmt[i]) {
+        os << fmt[i];
+        continue;
+      }
+      if (remaining > 0) {
+        decodeArg(os, r, pos);
+        --remaining;
+      }
+      if (i + 1 < fmt.size() && '}' == fmt[i + 1]) {
+        ++i;
+      }
+    }
+  }
+};
+
+#ifndef __ZEPHYR__
+
+/// \brief Drains a BinaryLoggingSink in to a text logging sink from a background thread, on hosted platforms
+template <typename BinarySinkT, typename TextSinkT>
+class BinaryLogDrainThread {
+public:
+  BinaryLogDrainThread(BinarySinkT& from, TextSinkT& to, std::chrono::milliseconds period = std::chrono::milliseconds(50))
+    : from(from), to(to), period(period), running(true), worker([this] { run(); })
+  {
+    ;
+  }
+  BinaryLogDrainThread(const BinaryLogDrainThread&) = delete;
+  BinaryLogDrainThread(BinaryLogDrainThread&&) = delete;
+
+  /// \brief Stops the thread, after writing out any records remaining
+  ~BinaryLogDrainThread() {
+    running.store(false, std::memory_order_release);
+    worker.join();
+    drainAll();
+  }
+
+private:
+  BinarySinkT& from;
+  TextSinkT& to;
+  std::chrono::milliseconds period;
+  std::atomic<bool> running;
+  std::thread worker; // last, so that it starts after the other members are initialised
+
+  void run() {
+    while (running.load(std::memory_order_acquire)) {
+      if (0 == drainAll()) {
+        std::this_thread::sleep_for(period);
+      }
+    }
+  }
+
+  std::size_t drainAll() {
+    return from.drain([this] (const std::string& subsystem, const std::string& category, SensorLoggerLevel level, const std::string& message) {
+      to.log(subsystem, category, level, message);
+    });
+  }
+};
+
+#endif
+
+} // end namespace
+} // end namespace
+
+#endif
@@ -6,14 +6,26 @@
 #define HERALD_SENSOR_LOGGER_H
 
 #include "../datatype/bluetooth_state.h"
+#include "../util/is_valid.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <ostream>
 #include <sstream>
+#include <type_traits>
 
 // Zephyr compile workaround. Not ideal.
 // #ifndef HERALD_LOG_LEVEL
+
+// Marks string literal formats, which binary sinks keep by address rather than copy (See LogLiteral).
+// Only GCC compatible compilers can tell a literal apart from any other char array, so elsewhere all are copied.
+#if defined(__GNUC__)
+#define HERALD_LOG_FORMAT(_msg) herald::data::LogFormat<__builtin_constant_p(_msg)>::of(_msg)
+#else
+#define HERALD_LOG_FORMAT(_msg) (_msg)
+#endif
 // #define HERALD_LOG_LEVEL 4
 // #endif
 
@@ -31,31 +43,31 @@
 // HDBG Defines for within main class (more common)
 // HTDBG Defines for within Impl class
 #if HERALD_LOG_LEVEL == 4
-#define HDBG(_msg, ...) mImpl->logger.debug(_msg, ##__VA_ARGS__);
-#define HTDBG(_msg, ...) logger.debug(_msg, ##__VA_ARGS__);
-#define HLOG(_msg, ...) mImpl->logger.info(_msg, ##__VA_ARGS__);
-#define HTLOG(_msg, ...) logger.info(_msg, ##__VA_ARGS__);
-#define HERR(_msg, ...) mImpl->logger.fault(_msg, ##__VA_ARGS__);
-#define HTERR(_msg, ...) logger.fault(_msg, ##__VA_ARGS__);
+#define HDBG(_msg, ...) mImpl->logger.debug(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTDBG(_msg, ...) logger.debug(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HLOG(_msg, ...) mImpl->logger.info(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTLOG(_msg, ...) logger.info(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HERR(_msg, ...) mImpl->logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTERR(_msg, ...) logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
 #endif
 
 #if HERALD_LOG_LEVEL == 3
 #define HDBG(...) /* No debug log */
 #define HTDBG(...) /* No debug log */
-#define HLOG(_msg, ...) mImpl->logger.info(_msg, ##__VA_ARGS__);
-#define HTLOG(_msg, ...) logger.info(_msg, ##__VA_ARGS__);
-#define HERR(_msg, ...) mImpl->logger.fault(_msg, ##__VA_ARGS__);
-#define HTERR(_msg, ...) logger.fault(_msg, ##__VA_ARGS__);
+#define HLOG(_msg, ...) mImpl->logger.info(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTLOG(_msg, ...) logger.info(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HERR(_msg, ...) mImpl->logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTERR(_msg, ...) logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
 #endif
 
 // This 'WARN' exists for runtime valid logging. E.g. contacts.log to RTT on Zephyr
 #if HERALD_LOG_LEVEL == 2
 #define HDBG(...) /* No debug log */
 #define HTDBG(...) /* No debug log */
-#define HLOG(_msg, ...) mImpl->logger.info(_msg, ##__VA_ARGS__);
-#define HTLOG(_msg, ...) logger.info(_msg, ##__VA_ARGS__);
-#define HERR(_msg, ...) mImpl->logger.fault(_msg, ##__VA_ARGS__);
-#define HTERR(_msg, ...) logger.fault(_msg, ##__VA_ARGS__);
+#define HLOG(_msg, ...) mImpl->logger.info(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTLOG(_msg, ...) logger.info(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HERR(_msg, ...) mImpl->logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTERR(_msg, ...) logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
 #endif
 
 #if HERALD_LOG_LEVEL == 1
@@ -63,8 +75,8 @@
 #define HTDBG(...) /* No debug log */
 #define HLOG(...) /* No info log */
 #define HTLOG(...) /* No info log */
-#define HERR(_msg, ...) mImpl->logger.fault(_msg, ##__VA_ARGS__);
-#define HTERR(_msg, ...) logger.fault(_msg, ##__VA_ARGS__);
+#define HERR(_msg, ...) mImpl->logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
+#define HTERR(_msg, ...) logger.fault(HERALD_LOG_FORMAT(_msg), ##__VA_ARGS__);
 #endif
 
 #if HERALD_LOG_LEVEL == 0
@@ -103,6 +115,27 @@ enum class SensorLoggerLevel : int {
   debug, info, fault
 };
 
+/// \brief A log format that is a string literal, so outlives any record of it. Made by HERALD_LOG_FORMAT.
+struct LogLiteral {
+  const char* format;
+};
+
+/// \brief Passes log formats on as they are, unless known to be constant, when they are marked as a LogLiteral
+template <bool IsLiteral>
+struct LogFormat {
+  template <typename T>
+  static constexpr const T& of(const T& format) noexcept {
+    return format;
+  }
+};
+
+template <>
+struct LogFormat<true> {
+  static constexpr LogLiteral of(const char* format) noexcept {
+    return LogLiteral{format};
+  }
+};
+
 /*
 class LoggingSink {
 public:
@@ -339,23 +372,43 @@ namespace {
   
 }
 
+/// \brief Detects logging sinks that record binary log lines (See BinaryLoggingSink)
+constexpr auto isBinaryLoggingSink = herald::util::isValid(
+  [](auto&& s) -> decltype(((decltype(s))s).source(std::string(),std::string())) {}
+);
+
+template <typename T>
+using IsBinaryLoggingSinkT = decltype(isBinaryLoggingSink(std::declval<T&>()));
+
+template <typename T>
+constexpr auto IsBinaryLoggingSinkV = IsBinaryLoggingSinkT<T>::value;
+
+/// \brief The subsystem and category a SensorLogger writes as, for text sinks
+struct SensorLoggerNames {
+  std::string subsystem;
+  std::string category;
+};
+
 template <typename LoggingSinkT>
 class SensorLogger {
 public:
+  /// \brief Binary sinks identify a logger by a one byte id, so the names are not kept
+  using source_type = std::conditional_t<IsBinaryLoggingSinkV<LoggingSinkT>,std::uint8_t,SensorLoggerNames>;
+
   SensorLogger(LoggingSinkT& sink, std::string subsystem, std::string category) noexcept
-    : mSink(sink), mSubsystem(subsystem), mCategory(category)
+    : mSink(sink), mSource(source(sink, std::move(subsystem), std::move(category)))
   {
     ;
   }
 
   SensorLogger(const SensorLogger& other) noexcept
-    : mSink(other.mSink), mSubsystem(other.mSubsystem), mCategory(other.mCategory)
+    : mSink(other.mSink), mSource(other.mSource)
   {
     ;
   }
 
   SensorLogger(SensorLogger&& other) noexcept
-    : mSink(other.mSink), mSubsystem(other.mSubsystem), mCategory(other.mCategory)
+    : mSink(other.mSink), mSource(other.mSource)
   {
     ;
   }
@@ -363,16 +416,14 @@ public:
   SensorLogger& operator=(const SensorLogger& other) noexcept
   {
     mSink = other.mSink;
-    mSubsystem = other.mSubsystem;
-    mCategory = other.mCategory;
+    mSource = other.mSource;
     return *this;
   }
 
   SensorLogger& operator=(SensorLogger&& other) noexcept
   {
     mSink = other.mSink;
-    mSubsystem = other.mSubsystem;
-    mCategory = other.mCategory;
+    mSource = other.mSource;
     return *this;
   }
   
@@ -385,51 +436,77 @@ public:
   // Note: C++11 Variadic template parameter pack expansion
   template <typename ... Types>
   void debug(const std::string& message, const Types&... args) const noexcept {
-    constexpr int size = sizeof...(args);
-    if constexpr (0 == size) {
-      log(SensorLoggerLevel::debug,message);
-    } else {
-      std::stringstream os;
-      tprintf(os,message,args...);
-      os << std::ends;
-      log(SensorLoggerLevel::debug, os.str());
-    }
+    format(SensorLoggerLevel::debug, message, args...);
+  }
+
+  /// \brief Chosen for string literal messages, as marked by HTDBG et al. Not formatted here for binary sinks.
+  template <typename ... Types>
+  void debug(LogLiteral message, const Types&... args) const noexcept {
+    write(SensorLoggerLevel::debug, message, args...);
   }
 
   template <typename ... Types>
   void info(const std::string& message, const Types&... args) const noexcept {
+    format(SensorLoggerLevel::info, message, args...);
+  }
+
+  template <typename ... Types>
+  void info(LogLiteral message, const Types&... args) const noexcept {
+    write(SensorLoggerLevel::info, message, args...);
+  }
+
+  template <typename ... Types>
+  void fault(const std::string& message, const Types&... args) const noexcept {
+    format(SensorLoggerLevel::fault, message, args...);
+  }
+
+  template <typename ... Types>
+  void fault(LogLiteral message, const Types&... args) const noexcept {
+    write(SensorLoggerLevel::fault, message, args...);
+  }
+
+private:
+  template <typename ... Types>
+  void format(SensorLoggerLevel lvl, const std::string& message, const Types&... args) const noexcept {
     constexpr int size = sizeof...(args);
     if constexpr (0 == size) {
-      log(SensorLoggerLevel::debug,message);
+      log(lvl,message);
     } else {
       std::stringstream os;
       tprintf(os,message,args...);
       os << std::ends;
-      log(SensorLoggerLevel::info, os.str());
+      log(lvl, os.str());
     }
   }
 
+  /// \brief Binary sinks keep the literal's address and the raw arguments. Others format as usual.
   template <typename ... Types>
-  void fault(const std::string& message, const Types&... args) const noexcept {
-    constexpr int size = sizeof...(args);
-    if constexpr (0 == size) {
-      log(SensorLoggerLevel::debug,message);
+  void write(SensorLoggerLevel lvl, LogLiteral message, const Types&... args) const noexcept {
+    if constexpr (IsBinaryLoggingSinkV<LoggingSinkT>) {
+      mSink.record(mSource, lvl, message.format, args...);
     } else {
-      std::stringstream os;
-      tprintf(os,message,args...);
-      os << std::ends;
-      log(SensorLoggerLevel::fault, os.str());
+      format(lvl, message.format, args...);
     }
   }
 
-private:
   inline void log(SensorLoggerLevel lvl, const std::string msg) const noexcept {
-    mSink.log(mSubsystem, mCategory, lvl, msg);
+    if constexpr (IsBinaryLoggingSinkV<LoggingSinkT>) {
+      mSink.log(mSource, lvl, msg);
+    } else {
+      mSink.log(mSource.subsystem, mSource.category, lvl, msg);
+    }
+  }
+
+  static source_type source(LoggingSinkT& sink, std::string subsystem, std::string category) noexcept {
+    if constexpr (IsBinaryLoggingSinkV<LoggingSinkT>) {
+      return sink.source(subsystem, category);
+    } else {
+      return SensorLoggerNames{std::move(subsystem), std::move(category)};
+    }
   }
 
   LoggingSinkT& mSink;
-  std::string mSubsystem;
-  std::string mCategory;
+  source_type mSource;
 };
 
 } // end namespace
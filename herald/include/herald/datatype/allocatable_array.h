@@ -86,10 +86,10 @@ public:
         return true;
       }
     }
-    if (size() == max_size) {
-      return false;
-    }
     const std::size_t nextIdx = nextAvailable();
+    if (max_size == nextIdx) {
+      return false; // full
+    }
     m_members[nextIdx] = toAdd;
     m_allocated.set(nextIdx);
     return true;
@@ -7,7 +7,9 @@
 
 #include <string>
 #include <iostream>
+#include <cstring>
 
+#include "hash.h"
 #include "memory_arena.h"
 
 namespace herald {
@@ -46,36 +48,25 @@ public:
   /// \brief Initialises a DataRef from a std::uint8_t array of length `length`
   DataRef(const std::uint8_t* value, std::size_t length) : 
   entry(getArena().allocate(length)) {
-    for (std::size_t i = 0;i < length; ++i) {
-      // data[i] = std::byte(value[i]);
-      getArena().set(entry, i, (unsigned char)value[i]);
-    }
+    copyIn(0, value, length);
   }
   /// \brief Initialises a DataRef from a std::byte array of length `length`
   DataRef(const std::byte* value, std::size_t length) : entry(getArena().allocate(length)) {
-    for (std::size_t i = 0;i < length; ++i) {
-      // data[i] = value[i];
-      getArena().set(entry, i, (unsigned char)value[i]);
-    }
+    copyIn(0, value, length);
   }
   /// \brief Initialises a DataRef from a string of chars
   DataRef(const std::string& from) : entry(getArena().allocate(from.size())) {
-    for (std::size_t i = 0;i < from.size(); ++i) {
-      // data[i] = value[i];
-      getArena().set(entry, i, (unsigned char)from[i]);
-    }
+    copyIn(0, from.data(), from.size());
   }
   /// \brief Initialises a DataRef copying another data object (uses more data, to ensure only one object owns the entry)
   DataRef(const DataRef& from) : entry(getArena().allocate(from.entry.byteLength)) {
-    for (std::size_t i = 0;i < from.size(); ++i) {
-      getArena().set(entry, i, from.getArena().get(from.entry,i));
-    }
+    copyIn(0, from.rawMemoryStartAddress(), from.size());
   }
 
   /// \brief Initialises a DataRef with count number of repeating bytes
   DataRef(std::byte repeating, std::size_t count) : entry(getArena().allocate(count)) {
-    for (std::size_t i = 0;i < count; ++i) {
-      getArena().set(entry,i,(unsigned char)repeating);
+    if (0 != count) {
+      std::memset(rawMemoryStartAddress(), (unsigned char)repeating, count);
     }
   }
   /// \brief Initialises a DataRef with reserveLength bytes of undefined data
@@ -88,10 +79,12 @@ public:
   /// \brief Copy assign operator. Copies the data to be sure only one object owns the entry
   DataRef& operator=(const DataRef& other)
   {
-    entry = getArena().allocate(other.entry.byteLength);
-    for (std::size_t i = 0;i < other.size(); ++i) {
-      getArena().set(entry, i, other.getArena().get(other.entry,i));
+    if (this == &other) {
+      return *this;
     }
+    clear(); // release our previous allocation, else it leaks from the arena
+    entry = getArena().allocate(other.entry.byteLength);
+    copyIn(0, other.rawMemoryStartAddress(), other.size());
     return *this;
   }
 
@@ -116,12 +109,10 @@ public:
     hexInput += hex;
 
     DataRef d(hexInput.size() / 2);
+    unsigned char* bytes = d.rawMemoryStartAddress();
 
     for (std::size_t i = 0; i < hexInput.size(); i += 2) {
-      std::string byteString = hexInput.substr(i, 2);
-      std::byte byte = std::byte(strtol(byteString.c_str(), NULL, 16));
-      // d.data.push_back(byte);
-      getArena().set(d.entry,i / 2, (unsigned char)byte);
+      bytes[i / 2] = hexByte(hexInput[i], hexInput[i + 1]);
     }
 
     return d;
@@ -140,10 +131,7 @@ public:
       return DataRef(0);
     }
     DataRef copy(entry.byteLength - offset);
-    for (std::size_t i = 0;i < entry.byteLength - offset;++i) {
-      copy.getArena().set(copy.entry,i,getArena().get(entry,i + offset));
-    }
-    // std::copy(data.begin() + offset, data.end(), std::back_inserter(copy.data));
+    copy.copyIn(0, rawMemoryStartAddress() + offset, entry.byteLength - offset);
     return copy;
   }
 
@@ -159,18 +147,7 @@ public:
       correctedLength = entry.byteLength - offset;
     }
     DataRef copy(correctedLength);
-    // Note the below is necessary as calling with (4,-1), the second condition IS valid!
-    // if (length > entry.byteLength || offset + length > entry.byteLength) {
-    //   for (std::size_t i = 0;i < entry.byteLength - offset;++i) {
-    //     copy.getArena().set(copy.entry,i,getArena().get(entry,offset + i));
-    //   }
-    //   // std::copy(data.begin() + offset, data.end(), std::back_inserter(copy.data));
-    // } else {
-      for (std::size_t i = 0;i < correctedLength;++i) {
-        copy.getArena().set(copy.entry,i,getArena().get(entry,offset + i));
-      }
-      // std::copy(data.begin() + offset, data.begin() + offset + length, std::back_inserter(copy.data));
-    // }
+    copy.copyIn(0, rawMemoryStartAddress() + offset, correctedLength);
     return copy;
   }
 
@@ -189,12 +166,13 @@ public:
   /// Avoids repeated reallocation of memory on a copy.
   void assign(const DataRef& other)
   {
+    if (this == &other) {
+      return;
+    }
     if (other.size() > entry.byteLength) {
       getArena().reserve(entry,other.size());
     }
-    for (std::size_t pos = 0; pos < other.size();++pos) {
-      getArena().set(entry,pos,other.getArena().get(other.entry,pos));
-    }
+    copyIn(0, other.rawMemoryStartAddress(), other.size());
   }
 
   /// \brief Copies another DataRef into this instance, expanding if required
@@ -202,13 +180,11 @@ public:
   {
     auto curSize = entry.byteLength;
     getArena().reserve(entry,curSize + length);
-    for (std::size_t pos = 0; pos < length;++pos) {
-      getArena().set(entry,curSize + pos,rawData.getArena().get(rawData.entry,pos + offset));
+    // Note: rawData may be this instance, so only read its address after the reserve
+    if (offset < rawData.size()) {
+      const std::size_t available = rawData.size() - offset;
+      copyIn(curSize, rawData.rawMemoryStartAddress() + offset, length < available ? length : available);
     }
-    // std::copy(rawData.data.begin() + offset, 
-    //           rawData.data.begin() + offset + length, 
-    //           std::back_inserter(data)
-    // );
   }
 
   /// \brief Appends a set of characters to the end of this DataRef
@@ -216,9 +192,7 @@ public:
   {
     auto curSize = entry.byteLength;
     getArena().reserve(entry,curSize + rawData.size());
-    for (std::size_t pos = 0; pos < rawData.size();++pos) {
-      getArena().set(entry,curSize + pos,rawData[pos]);
-    }
+    copyIn(curSize, rawData.data(), rawData.size());
   }
 
   /// \brief Copies a uint8_t array onto the end of this instance, expanding if necessary
@@ -226,10 +200,7 @@ public:
   {
     auto curSize = entry.byteLength;
     getArena().reserve(entry,curSize + length);
-    for (std::size_t i = 0;i < length;++i) {
-      getArena().set(entry,curSize + i,(unsigned char)(rawData[offset + i]));
-      // getArena().set(entry,curSize,std::byte(rawData[offset + i]));
-    }
+    copyIn(curSize, rawData + offset, length);
   }
 
   /// \brief Appends the specified DataRef to this one, but in its reverse order
@@ -244,13 +215,11 @@ public:
     }
     auto curSize = entry.byteLength;
     getArena().reserve(entry,curSize + checkedLength);
+    // Note: rawData may be this instance, so only read its address after the reserve
+    const unsigned char* from = rawData.rawMemoryStartAddress() + offset;
+    unsigned char* to = rawMemoryStartAddress() + curSize;
     for (std::size_t i = 0;i < checkedLength;++i) {
-      getArena().set(entry,curSize + i,
-      rawData.getArena().get(rawData.entry,offset + (checkedLength - i - 1)));
-    // std::reverse_copy(rawData.data.begin() + offset, 
-    //                   rawData.data.begin() + offset + checkedLength, 
-    //                   std::back_inserter(data)
-    // );
+      to[i] = from[checkedLength - i - 1];
     }
   }
 
@@ -258,11 +227,9 @@ public:
   void append(const DataRef& rawData)
   {
     auto orig = entry.byteLength;
-    getArena().reserve(entry,rawData.size() + orig);
-    for (std::size_t pos = 0; pos < rawData.size();++pos) {
-      getArena().set(entry,orig + pos,rawData.getArena().get(rawData.entry,pos));
-    }
-    // std::copy(rawData.data.begin(), rawData.data.end(), std::back_inserter(data));
+    const std::size_t length = rawData.size(); // before reserve, as rawData may be this instance
+    getArena().reserve(entry,length + orig);
+    copyIn(orig, rawData.rawMemoryStartAddress(), length);
   }
 
   /// \brief Appends a single byte
@@ -290,8 +257,9 @@ public:
   {
     std::size_t curSize = entry.byteLength;
     getArena().reserve(entry,curSize + 2); // C++ ensures types are AT LEAST x bits
-    getArena().set(entry,curSize,(unsigned char)(rawData & 0xff));
-    getArena().set(entry,curSize + 1,(unsigned char)(rawData >> 8));
+    unsigned char* to = rawMemoryStartAddress() + curSize;
+    to[0] = (unsigned char)(rawData & 0xff);
+    to[1] = (unsigned char)(rawData >> 8);
   }
 
   /// \brief Appends a single uint32_t
@@ -299,10 +267,10 @@ public:
   {
     std::size_t curSize = entry.byteLength;
     getArena().reserve(entry,curSize + 4); // C++ ensures types are AT LEAST x bits
-    getArena().set(entry,curSize,(unsigned char)(rawData & 0xff));
-    getArena().set(entry,curSize + 1,(unsigned char)(rawData >> 8));
-    getArena().set(entry,curSize + 2,(unsigned char)(rawData >> 16));
-    getArena().set(entry,curSize + 3,(unsigned char)(rawData >> 24));
+    unsigned char* to = rawMemoryStartAddress() + curSize;
+    for (std::size_t i = 0;i < 4;++i) {
+      to[i] = (unsigned char)(rawData >> (8 * i));
+    }
   }
 
   /// \brief Appends a single uint64_t
@@ -310,14 +278,10 @@ public:
   {
     std::size_t curSize = entry.byteLength;
     getArena().reserve(entry,curSize + 8); // C++ ensures types are AT LEAST x bits
-    getArena().set(entry,curSize,(unsigned char)(rawData & 0xff));
-    getArena().set(entry,curSize + 1,(unsigned char)(rawData >> 8));
-    getArena().set(entry,curSize + 2,(unsigned char)(rawData >> 16));
-    getArena().set(entry,curSize + 3,(unsigned char)(rawData >> 24));
-    getArena().set(entry,curSize + 4,(unsigned char)(rawData >> 32));
-    getArena().set(entry,curSize + 5,(unsigned char)(rawData >> 40));
-    getArena().set(entry,curSize + 6,(unsigned char)(rawData >> 48));
-    getArena().set(entry,curSize + 7,(unsigned char)(rawData >> 56));
+    unsigned char* to = rawMemoryStartAddress() + curSize;
+    for (std::size_t i = 0;i < 8;++i) {
+      to[i] = (unsigned char)(rawData >> (8 * i));
+    }
   }
 
   /// \brief Returns whether reading a single uint8_t to `into` at `fromIndex` was successful
@@ -333,21 +297,23 @@ public:
   /// \brief Returns whether reading a single uint16_t to `into` at `fromIndex` was successful
   bool uint16(std::size_t fromIndex, uint16_t& into) const noexcept
   {
-    if (fromIndex > (unsigned short)(entry.byteLength - 2)) {
+    if (entry.byteLength < 2 || fromIndex > (unsigned short)(entry.byteLength - 2)) {
       return false;
     }
-    into = (std::uint16_t(std::uint8_t(getArena().get(entry,fromIndex + 1))) << 8) | std::uint16_t(std::uint8_t(getArena().get(entry,fromIndex)));
+    const unsigned char* from = rawMemoryStartAddress() + fromIndex;
+    into = (std::uint16_t(from[1]) << 8) | std::uint16_t(from[0]);
     return true;
   }
 
   /// \brief Returns whether reading a single uint32_t to `into` at `fromIndex` was successful
   bool uint32(std::size_t fromIndex, uint32_t& into) const noexcept
   {
-    if (fromIndex > (unsigned short)(entry.byteLength - 4)) {
+    if (entry.byteLength < 4 || fromIndex > (unsigned short)(entry.byteLength - 4)) {
       return false;
     }
-    into =  std::uint32_t(std::uint8_t(getArena().get(entry,fromIndex)))            | (std::uint32_t(std::uint8_t(getArena().get(entry,fromIndex + 1))) << 8) |
-          (std::uint32_t(std::uint8_t(getArena().get(entry,fromIndex + 2))) << 16) | (std::uint32_t(std::uint8_t(getArena().get(entry,fromIndex + 3))) << 24);
+    const unsigned char* from = rawMemoryStartAddress() + fromIndex;
+    into =  std::uint32_t(from[0])        | (std::uint32_t(from[1]) << 8) |
+          (std::uint32_t(from[2]) << 16) | (std::uint32_t(from[3]) << 24);
     return true;
   }
 
@@ -357,61 +323,72 @@ public:
     if (entry.byteLength < 8 || fromIndex > (unsigned short)(entry.byteLength - 8)) {
       return false;
     }
-    into = (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 7))) << 56) | (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 6))) << 48) |
-          (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 5))) << 40) | (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 4))) << 32) |
-          (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 3))) << 24) | (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 2))) << 16) |
-          (std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex + 1))) << 8)  |  std::uint64_t(std::uint8_t(getArena().get(entry,fromIndex)));
+    const unsigned char* from = rawMemoryStartAddress() + fromIndex;
+    into = 0;
+    for (std::size_t i = 8;i > 0;--i) {
+      into = (into << 8) | std::uint64_t(from[i - 1]);
+    }
     return true;
   }
 
   // TODO signed versions of the above functions too
-  /// \brief Equality operator for another DataRef instance (same memory arena)
+  /// \brief Equality operator for another DataRef instance (same memory arena). Compares bytes, not hash codes.
   bool operator==(const DataRef& other) const noexcept
   {
     if (size() != other.size()) {
       return false;
     }
-    //if (hashCode() != other.hashCode()) {
-    //  return false;
-    //}
-    // else compare each value
-
-    // alternatively, cheat...
-    return hashCode() == other.hashCode(); // Somewhat naughty
+    return 0 == size() || 0 == std::memcmp(rawMemoryStartAddress(), other.rawMemoryStartAddress(), size());
   }
 
   /// \brief Inequality operator for another DataRef instance (same memory arena)
   bool operator!=(const DataRef& other) const noexcept
   {
-    if (size() != other.size()) {
-      return true;
-    }
-    return hashCode() != other.hashCode();
+    return !(*this == other);
   }
 
   /// \brief Less than operator for another DataRef instance (same memory arena)
   bool operator<(const DataRef& other) const noexcept
   {
-    return hashCode() < other.hashCode();
+    return compare(other) < 0;
   }
 
   /// \brief Greater than operator for another DataRef instance (same memory arena)
   bool operator>(const DataRef& other) const noexcept
   {
-    return hashCode() > other.hashCode();
+    return compare(other) > 0;
+  }
+
+  /// \brief Returns a negative, zero or positive value as this instance sorts before, with or after other
+  ///
+  /// Orders by the bytes in common, then by size, as for std::string::compare
+  int compare(const DataRef& other) const noexcept
+  {
+    const std::size_t common = size() < other.size() ? size() : other.size();
+    if (0 != common) {
+      const int result = std::memcmp(rawMemoryStartAddress(), other.rawMemoryStartAddress(), common);
+      if (0 != result) {
+        return result;
+      }
+    }
+    if (size() == other.size()) {
+      return 0;
+    }
+    return size() < other.size() ? -1 : 1;
   }
 
   /// \brief Returns a new DataRef instance with the same data as this one, but in the reverse order
   DataRef reversed() const
   {
     DataRef result(entry.byteLength);
-    // result.reserve(entry.byteLength);
+    if (0 == entry.byteLength) {
+      return result;
+    }
+    const unsigned char* from = rawMemoryStartAddress();
+    unsigned char* to = result.rawMemoryStartAddress();
     for (std::size_t pos = 0;pos < entry.byteLength;++pos) {
-      result.getArena().set(result.entry,pos,getArena().get(entry,entry.byteLength - pos - 1));
+      to[pos] = from[entry.byteLength - pos - 1];
     }
-    // std::reverse_copy(data.begin(),data.end(),
-    //   std::back_inserter(result.data)
-    // );
     return result;
   }
 
@@ -423,17 +400,21 @@ public:
 
     // Keep byte order intact (caller could use reversed() to change that)
     // but reverse the order of the individual bits by each byte
+    if (0 == entry.byteLength) {
+      return result;
+    }
+    const unsigned char* from = rawMemoryStartAddress();
+    unsigned char* to = result.rawMemoryStartAddress();
     std::uint8_t value, original;
     for (std::size_t i = 0;i < entry.byteLength;++i) {
-      original = std::uint8_t(getArena().get(entry,i));
+      original = from[i];
       value = 0;
       for (int b = 0;b < 8;++b) {
         if ((original & (1 << b)) > 0) {
           value |= 1 << (7 - b);
         }
       }
-      // result.data[i] = std::byte(value);
-      result.getArena().set(result.entry,entry.byteLength - i - 1,value);
+      to[entry.byteLength - i - 1] = value;
     }
 
     return result;
@@ -452,21 +433,20 @@ public:
     std::string result;
     std::size_t size = entry.byteLength;
     result.reserve(size * 2);
+    const unsigned char* from = rawMemoryStartAddress();
     std::size_t v;
     for (std::size_t i = 0; i < size; ++i) {
-      // v = std::size_t(data.at(i));
-      v = std::size_t(getArena().get(entry,i));
+      v = std::size_t(from[i]);
       result += hexChars[0x0F & (v >> 4)]; // MSB
       result += hexChars[0x0F &  v      ]; // LSB
     }
     return result;
   }
 
-  /// \brief Returns the hash code of this instance
+  /// \brief Returns the hash code of this instance. Seeded per process, so do not persist it.
   std::size_t hashCode() const noexcept
   {
-    // TODO consider a faster (E.g. SIMD) algorithm or one with less hotspots (see hashdos attacks)
-    return std::hash<DataRef<MemoryArenaT>>{}(*this);
+    return herald::datatype::hashCode(rawMemoryStartAddress(), size());
   }
 
   /// \brief Returns the size in allocated bytes of this instance
@@ -481,7 +461,16 @@ public:
     getArena().deallocate(entry);
   }
 
-  const unsigned char* rawMemoryStartAddress() const {
+  /// \brief Returns the address of the first of size() contiguous bytes, or 0 if empty
+  const unsigned char* rawMemoryStartAddress() const noexcept {
+    return getArena().rawStartAddress(entry);
+  }
+
+  /// \brief Returns a writable address of the first of size() contiguous bytes, or 0 if empty
+  ///
+  /// Allows callers to fill a DataRef created with DataRef(reserveLength) in bulk.
+  /// Only valid until the next operation that changes the size of this instance.
+  unsigned char* rawMemoryStartAddress() noexcept {
     return getArena().rawStartAddress(entry);
   }
 
@@ -492,6 +481,42 @@ public:
   
 protected:
   MemoryArenaEntry entry;
+
+private:
+  /// \brief Bulk copies length bytes from source into this instance at offset. Caller ensures size.
+  void copyIn(std::size_t offset, const void* source, std::size_t length) noexcept {
+    if (0 == length || nullptr == source) {
+      return;
+    }
+    std::memcpy(rawMemoryStartAddress() + offset, source, length);
+  }
+
+  /// \brief Returns the value of a hex digit, or 16 if not a hex digit
+  static unsigned char hexValue(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+      return (unsigned char)(c - '0');
+    }
+    if (c >= 'a' && c <= 'f') {
+      return (unsigned char)(c - 'a' + 10);
+    }
+    if (c >= 'A' && c <= 'F') {
+      return (unsigned char)(c - 'A' + 10);
+    }
+    return 16;
+  }
+
+  /// \brief Parses a pair of hex characters. As per strtol, parsing stops at the first invalid character.
+  static unsigned char hexByte(char high, char low) noexcept {
+    const unsigned char h = hexValue(high);
+    if (h > 15) {
+      return 0;
+    }
+    const unsigned char l = hexValue(low);
+    if (l > 15) {
+      return h;
+    }
+    return (unsigned char)((h << 4) | l);
+  }
 };
 
 
@@ -575,16 +600,7 @@ namespace std {
   {
     size_t operator()(const herald::datatype::DataRef<MemoryArenaT>& v) const
     {
-      std::size_t hv = 0;
-      std::uint8_t ui = 0;
-      bool ok = true;
-      for (std::size_t pos = 0;ok && pos < v.size();++pos) {
-        ok = v.uint8(pos,ui);
-        if (ok) {
-          hash_combine_impl(hv, std::hash<std::uint8_t>()(ui));
-        }
-      }
-      return hv;
+      return v.hashCode();
     }
   };
 } // end namespace
@@ -144,6 +144,8 @@ struct Score {
   double value = 0.0;
   double confidence = 1.0;
 
+  Score() noexcept = default;
+  Score(const Score& other) noexcept = default;
   Score& operator=(const Score& other) noexcept;
   const bool operator==(const Score& other) const noexcept;
   const bool operator!=(const Score& other) const noexcept;
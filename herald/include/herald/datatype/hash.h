@@ -0,0 +1,147 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_HASH_H
+#define HERALD_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace herald {
+namespace datatype {
+
+namespace hashing {
+
+// Constants and rounds of the 64 bit xxHash algorithm
+constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t prime3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+inline std::uint64_t rotl(std::uint64_t value, int bits) noexcept
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+inline std::uint64_t read64(const unsigned char* from) noexcept
+{
+  std::uint64_t value;
+  std::memcpy(&value, from, 8);
+  return value;
+}
+
+inline std::uint32_t read32(const unsigned char* from) noexcept
+{
+  std::uint32_t value;
+  std::memcpy(&value, from, 4);
+  return value;
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t lane) noexcept
+{
+  acc += lane * prime2;
+  acc = rotl(acc, 31);
+  return acc * prime1;
+}
+
+inline std::uint64_t merge(std::uint64_t acc, std::uint64_t lane) noexcept
+{
+  acc ^= round(0, lane);
+  return (acc * prime1) + prime4;
+}
+
+/// \brief Returns a value from the platform's random number source (sys_rand32_get() on Zephyr, std::random_device elsewhere)
+std::uint64_t randomSeed() noexcept;
+
+/// \brief Returns the process wide seed. Read from randomSeed() on first use, so differs between runs.
+///
+/// Context construction reads it, so that the first use is not in a Bluetooth callback.
+inline std::uint64_t& seed() noexcept
+{
+  static std::uint64_t value = randomSeed();
+  return value;
+}
+
+} // end namespace
+
+/// \brief Returns the seeded 64 bit hash of length bytes
+///
+/// Reads 32 bytes per step as four independent 64 bit lanes, so that the
+/// compiler can interleave (or vectorise) them, then 8 bytes at a time.
+/// Callers supply the seed. See hashCode() for the process wide seed.
+inline std::uint64_t hashBytes(const unsigned char* bytes, std::size_t length, std::uint64_t seed) noexcept
+{
+  using namespace hashing;
+  const unsigned char* pos = bytes;
+  const unsigned char* const end = bytes + length;
+  std::uint64_t h;
+  if (length >= 32) {
+    std::uint64_t v1 = seed + prime1 + prime2;
+    std::uint64_t v2 = seed + prime2;
+    std::uint64_t v3 = seed;
+    std::uint64_t v4 = seed - prime1;
+    const unsigned char* const limit = end - 32;
+    do {
+      v1 = round(v1, read64(pos));
+      v2 = round(v2, read64(pos + 8));
+      v3 = round(v3, read64(pos + 16));
+      v4 = round(v4, read64(pos + 24));
+      pos += 32;
+    } while (pos <= limit);
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge(h, v1);
+    h = merge(h, v2);
+    h = merge(h, v3);
+    h = merge(h, v4);
+  } else {
+    h = seed + prime5;
+  }
+  h += (std::uint64_t)length;
+  for (;pos + 8 <= end;pos += 8) {
+    h ^= round(0, read64(pos));
+    h = (rotl(h, 27) * prime1) + prime4;
+  }
+  if (pos + 4 <= end) {
+    h ^= (std::uint64_t)read32(pos) * prime1;
+    h = (rotl(h, 23) * prime2) + prime3;
+    pos += 4;
+  }
+  for (;pos < end;++pos) {
+    h ^= (*pos) * prime5;
+    h = rotl(h, 11) * prime1;
+  }
+  h ^= h >> 33;
+  h *= prime2;
+  h ^= h >> 29;
+  h *= prime3;
+  h ^= h >> 32;
+  return h;
+}
+
+/// \brief Returns the hash code of length bytes, using the process wide seed
+inline std::size_t hashCode(const unsigned char* bytes, std::size_t length) noexcept
+{
+  const std::uint64_t h = hashBytes(bytes, length, hashing::seed());
+  if constexpr (sizeof(std::size_t) < sizeof(std::uint64_t)) {
+    return (std::size_t)(h ^ (h >> 32));
+  } else {
+    return (std::size_t)h;
+  }
+}
+
+/// \brief Replaces the process wide hash seed, E.g. with a value from a RandomnessSource.
+///
+/// Must be called before any hash codes are stored (E.g. at startup), as
+/// every hash code changes with the seed.
+inline void setHashSeed(std::uint64_t seed) noexcept
+{
+  hashing::seed() = seed;
+}
+
+} // end namespace
+} // end namespace
+
+#endif
@@ -6,9 +6,15 @@
 #define HERALD_MEMORY_ARENA_H
 
 #include <cstddef>
-#include <bitset>
+#include <cstdint>
+#include <cstring>
 #include <array>
 #include <limits>
+#include <stdexcept>
+
+#ifdef HERALD_MEMORYARENA_THREADSAFE
+#include <mutex>
+#endif
 
 /// \brief Acts as a non-global memory arena for arbitrary classes
 namespace herald {
@@ -32,12 +38,206 @@ constexpr unsigned long pagesRequired(std::size_t size,std::size_t pageSize)
   return (size + pageSize - 1) / pageSize;
 }
 
+/// \brief Bitmap of the pages in use within a MemoryArena, stored as 32-bit words
+///
+/// Provides word-at-a-time search and range update so that allocation policies can
+/// skip over fully used or fully free runs of 32 pages using a single instruction.
+template <std::size_t Pages>
+class MemoryArenaPageTable {
+public:
+  using word_type = std::uint32_t;
+  static constexpr std::size_t WordBits = 32;
+  static constexpr std::size_t Words = (Pages + WordBits - 1) / WordBits;
+
+  constexpr MemoryArenaPageTable() noexcept
+   : words()
+  {
+    ;
+  }
+
+  ~MemoryArenaPageTable() noexcept = default;
+
+  void reset() noexcept {
+    words.fill(0);
+  }
+
+  constexpr std::size_t size() const noexcept {
+    return Pages;
+  }
+
+  bool test(std::size_t page) const noexcept {
+    return 0 != (words[page / WordBits] & (word_type(1) << (page % WordBits)));
+  }
+
+  /// \brief Marks count pages starting at first as in use (or free), a word at a time
+  void setRange(std::size_t first, std::size_t count, bool inUse) noexcept {
+    while (count > 0) {
+      const std::size_t bit = first % WordBits;
+      const std::size_t run = (WordBits - bit) < count ? (WordBits - bit) : count;
+      const word_type mask = (run == WordBits) ? ~word_type(0) : (((word_type(1) << run) - 1) << bit);
+      if (inUse) {
+        words[first / WordBits] |= mask;
+      } else {
+        words[first / WordBits] &= ~mask;
+      }
+      first += run;
+      count -= run;
+    }
+  }
+
+  /// \brief Returns the number of pages in use
+  std::size_t count() const noexcept {
+    std::size_t total = 0;
+    for (auto word : words) {
+      total += popCount(word);
+    }
+    return total;
+  }
+
+  /// \brief Returns the index of the first page at or after from which is in use (or free), or Pages if none
+  std::size_t findNext(std::size_t from, bool inUse) const noexcept {
+    if (from >= Pages) {
+      return Pages;
+    }
+    std::size_t wordIndex = from / WordBits;
+    // mask off the bits before from in the first word
+    word_type candidates = (inUse ? words[wordIndex] : ~words[wordIndex]) & (~word_type(0) << (from % WordBits));
+    while (0 == candidates) {
+      if (++wordIndex == Words) {
+        return Pages;
+      }
+      candidates = inUse ? words[wordIndex] : ~words[wordIndex];
+    }
+    const std::size_t found = (wordIndex * WordBits) + countTrailingZeros(candidates);
+    return found < Pages ? found : Pages;
+  }
+
+  /// \brief Returns the length of the longest run of contiguous free pages
+  std::size_t largestFreeRun() const noexcept {
+    std::size_t largest = 0;
+    std::size_t start = findNext(0, false);
+    while (start < Pages) {
+      const std::size_t end = findNext(start, true);
+      if (end - start > largest) {
+        largest = end - start;
+      }
+      start = findNext(end, false);
+    }
+    return largest;
+  }
+
+private:
+  std::array<word_type,Words> words;
+
+  static std::size_t countTrailingZeros(word_type value) noexcept {
+    // Note: value is never zero when called
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    std::size_t count = 0;
+    while (0 == (value & 1)) {
+      value >>= 1;
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+  static std::size_t popCount(word_type value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(value);
+#else
+    std::size_t count = 0;
+    for (;0 != value;++count) {
+      value &= value - 1;
+    }
+    return count;
+#endif
+  }
+};
+
+/// \brief Allocation policy that checks each page in turn for the first free run that fits.
+///
+/// The original MemoryArena behaviour. O(pages) per allocation.
+struct FirstFitAllocation {
+  template <typename PageTableT>
+  static bool find(const PageTableT& pagesInUse, std::size_t pages, std::size_t& startPage) noexcept {
+    bool inEmpty = false;
+    std::size_t lastEmptyIndex = 0;
+    for (std::size_t i = 0;i < pagesInUse.size();++i) {
+      if (!pagesInUse.test(i)) {
+        // this one is empty
+        if (!inEmpty) {
+          inEmpty = true;
+          lastEmptyIndex = i;
+        }
+        if (i - lastEmptyIndex + 1 == pages) {
+          startPage = lastEmptyIndex;
+          return true;
+        }
+      } else {
+        inEmpty = false;
+      }
+    }
+    return false;
+  }
+};
+
+/// \brief Allocation policy that finds the same first free run as FirstFitAllocation, but
+/// scans the page table a 32-bit word at a time using count-trailing-zeros.
+///
+/// Skips whole words of used (or free) pages at once, so allocation cost is proportional
+/// to the number of free runs inspected rather than to the number of pages.
+struct WordScanAllocation {
+  template <typename PageTableT>
+  static bool find(const PageTableT& pagesInUse, std::size_t pages, std::size_t& startPage) noexcept {
+    std::size_t start = pagesInUse.findNext(0, false);
+    while (start + pages <= pagesInUse.size()) {
+      const std::size_t end = pagesInUse.findNext(start, true);
+      if (end - start >= pages) {
+        startPage = start;
+        return true;
+      }
+      start = pagesInUse.findNext(end, false);
+    }
+    return false;
+  }
+};
+
+#ifdef HERALD_MEMORYARENA_WORDSCAN
+using DefaultMemoryArenaAllocation = WordScanAllocation;
+#else
+using DefaultMemoryArenaAllocation = FirstFitAllocation;
+#endif
+
+#ifdef HERALD_MEMORYARENA_THREADSAFE
+/// \brief Serialises page table changes for all arenas, for hosts that share Data across threads
+///
+/// Recursive, as reserve() may allocate and deallocate. Define HERALD_MEMORYARENA_THREADSAFE for
+/// the whole build (as with HERALD_MEMORYARENA_MAX), never for individual translation units.
+inline std::recursive_mutex& memoryArenaMutex() noexcept {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+#define HERALD_MEMORYARENA_LOCK std::lock_guard<std::recursive_mutex> arenaGuard(memoryArenaMutex())
+#else
+#define HERALD_MEMORYARENA_LOCK
+#endif
+
 /// \brief Very basic paged memory arena class
 ///
 /// Can be used one arena per dynamic allocation class, or used by multiple classes.
 /// In this non-global implementation, pass it as a static reference variable to the class
 /// once during application startup after allocation in a main class or similar.
-template <std::size_t MaxSize, std::size_t AllocationSize>
+///
+/// The AllocationPolicy determines how free pages are found. FirstFitAllocation is the
+/// default unless HERALD_MEMORYARENA_WORDSCAN is defined, in which case WordScanAllocation
+/// is used. Both place allocations identically.
+///
+/// Not thread safe unless HERALD_MEMORYARENA_THREADSAFE is defined, in which case allocation,
+/// deallocation and page table queries are serialised. Reading and writing the bytes of an
+/// entry are never locked, so each entry must still only be used by one thread at a time.
+template <std::size_t MaxSize, std::size_t AllocationSize, typename AllocationPolicy = DefaultMemoryArenaAllocation>
 class MemoryArena {
 public:
   /// \brief The Maximum size to use for data (doesn't include page table)
@@ -45,9 +245,11 @@ public:
   /// \brief The allocation size for each page. Note total mem usage is Size + (Size / PageSize)
   /// Thus for MemoryArena<2048,10>() you use 2048 + (2048 / 10) = 2253 bytes
   static constexpr std::size_t PageSize = AllocationSize;
+  /// \brief The total number of pages in this arena
+  static constexpr std::size_t Pages = pagesRequired(Size,PageSize);
 
   constexpr MemoryArena() noexcept
-   : arena(), pagesInUse(false)
+   : arena(), pagesInUse(), pagesUsed(0), failures(0), highWaterPages(0)
   {
     ;
   }
@@ -55,47 +257,67 @@ public:
   ~MemoryArena() noexcept = default;
 
   /// \brief Forces all pages to be unset. Effectively clears memory in use.
+  /// \note Does not reset the allocation failure count or high water mark
   void reset() noexcept {
+    HERALD_MEMORYARENA_LOCK;
     pagesInUse.reset();
+    pagesUsed = 0;
   }
 
+  /// \brief Ensures entry refers to at least newSize bytes, preserving its content.
+  ///
+  /// Grows in place if the pages following the entry are free, else moves the entry.
   void reserve(MemoryArenaEntry& entry,std::size_t newSize) noexcept {
     if (newSize <= entry.byteLength) {
       return;
     }
+    HERALD_MEMORYARENA_LOCK;
+    if (entry.isInitialised()) {
+      const std::size_t curPages = pagesRequired(entry.byteLength,PageSize);
+      const std::size_t newPages = pagesRequired(newSize,PageSize);
+      const std::size_t end = entry.startPageIndex + curPages;
+      if (newPages == curPages ||
+          (entry.startPageIndex + newPages <= Pages && pagesInUse.findNext(end, true) >= entry.startPageIndex + newPages)) {
+        pagesInUse.setRange(end, newPages - curPages, true);
+        recordHighWater(newPages - curPages);
+        entry.byteLength = (unsigned short)newSize;
+        return;
+      }
+    }
     auto newEntry = allocate(newSize);
-    for (std::size_t i = 0;i < entry.byteLength;++i) {
-      set(newEntry,i,get(entry,i));
+    if (entry.isInitialised()) {
+      std::memcpy(rawStartAddress(newEntry), rawStartAddress(entry), entry.byteLength);
     }
     deallocate(entry);
     entry = newEntry;
   }
 
-  MemoryArenaEntry allocate(std::size_t size) {
+  /// \brief Attempts to allocate size bytes. Returns false (and leaves into untouched)
+  /// if there is no free run of pages large enough, rather than terminating.
+  bool tryAllocate(std::size_t size, MemoryArenaEntry& into) noexcept {
     if (0 == size) {
-      return MemoryArenaEntry{0,0};
+      into = MemoryArenaEntry{0,0};
+      return true;
     }
-    // find first page location with enough space
-    unsigned long pages = pagesRequired(size,PageSize);
-    bool inEmpty = false;
-    unsigned long lastEmptyIndex = 0;
-    for (std::size_t i = 0;i < pagesInUse.size();++i) {
-      if (!pagesInUse.test(i)) {
-        // this one is empty
-        if (!inEmpty) {
-          inEmpty = true;
-          lastEmptyIndex = i;
-        }
-        if (i - lastEmptyIndex + 1 == pages) {
-          // flip bits and return
-          for (unsigned long f = lastEmptyIndex;f <= i;++f) {
-            pagesInUse.set(f,true);
-          }
-          return MemoryArenaEntry{(unsigned short)lastEmptyIndex,(unsigned short)size};
-        }
-      } else {
-        inEmpty = false;
+    const std::size_t pages = pagesRequired(size,PageSize);
+    std::size_t startPage = 0;
+    HERALD_MEMORYARENA_LOCK;
+    if (!AllocationPolicy::find(pagesInUse, pages, startPage)) {
+      if (failures < std::numeric_limits<unsigned short>::max()) {
+        ++failures;
       }
+      return false;
+    }
+    pagesInUse.setRange(startPage, pages, true);
+    recordHighWater(pages);
+    into = MemoryArenaEntry{(unsigned short)startPage,(unsigned short)size};
+    return true;
+  }
+
+  MemoryArenaEntry allocate(std::size_t size) {
+    MemoryArenaEntry entry;
+    if (tryAllocate(size, entry)) {
+      return entry;
     }
     // ran out of memory! Throw! (Causes catastrophic crash)
 #ifdef __ZEPHYR__
@@ -109,11 +331,11 @@ public:
     if (!entry.isInitialised()) {
       return; // guard
     }
+    HERALD_MEMORYARENA_LOCK;
     // set relevant bits to empty
-    long pages = pagesRequired(entry.byteLength,PageSize);
-    for (int i = 0;i < pages;++i) {
-      pagesInUse.set(entry.startPageIndex + i,false);
-    }
+    const std::size_t pages = pagesRequired(entry.byteLength,PageSize);
+    pagesInUse.setRange(entry.startPageIndex, pages, false);
+    pagesUsed = (unsigned short)(pagesUsed - pages);
     entry.byteLength = 0;
     entry.startPageIndex = 0;
   }
@@ -140,8 +362,34 @@ public:
     return &arena[(entry.startPageIndex * PageSize)];
   }
 
+  /// \brief Returns a writable pointer to the entry's byteLength contiguous bytes, or 0 if not initialised
+  unsigned char* rawStartAddress(const MemoryArenaEntry& entry) noexcept {
+    if (!entry.isInitialised()) {
+      return 0;
+    }
+    return &arena[(entry.startPageIndex * PageSize)];
+  }
+
   std::size_t pagesFree() const noexcept {
-    return pagesRequired(Size,PageSize) - pagesInUse.count();
+    HERALD_MEMORYARENA_LOCK;
+    return Pages - pagesUsed;
+  }
+
+  /// \brief Returns the longest run of contiguous free pages. I.e. the largest allocation
+  /// (in pages) that will currently succeed. Much lower than pagesFree() indicates fragmentation.
+  std::size_t largestFreeRun() const noexcept {
+    HERALD_MEMORYARENA_LOCK;
+    return pagesInUse.largestFreeRun();
+  }
+
+  /// \brief Returns the number of allocation requests that could not be satisfied (saturates at 65535)
+  std::size_t allocationFailures() const noexcept {
+    return failures;
+  }
+
+  /// \brief Returns the highest number of pages ever in use at once
+  std::size_t highWaterMark() const noexcept {
+    return highWaterPages;
   }
 
   /// \brief Copies the segment of raw data from this arena
@@ -172,8 +420,19 @@ public:
   }
 
 private:
+  /// \brief Adds newly set pages to the running in use count. Caller holds the lock.
+  void recordHighWater(std::size_t pagesAdded) noexcept {
+    pagesUsed = (unsigned short)(pagesUsed + pagesAdded);
+    if (pagesUsed > highWaterPages) {
+      highWaterPages = pagesUsed;
+    }
+  }
+
   std::array<unsigned char,Size> arena;
-  std::bitset<pagesRequired(Size,PageSize)> pagesInUse;
+  MemoryArenaPageTable<Pages> pagesInUse;
+  unsigned short pagesUsed; // kept equal to pagesInUse.count() so stats are O(1)
+  unsigned short failures;
+  unsigned short highWaterPages;
 };
 
 }
@@ -7,6 +7,8 @@
 
 #include "data.h"
 
+#include <utility>
+
 namespace herald {
 namespace datatype {
 
@@ -14,6 +16,7 @@ class PayloadData : public Data {
 public:
   PayloadData();
   PayloadData(const Data& from);
+  PayloadData(const PayloadData& from);
   PayloadData(const std::byte* data, std::size_t length);
   PayloadData(std::byte repeating, std::size_t count);
   ~PayloadData() = default;
@@ -21,6 +24,34 @@ public:
 
   std::string shortName() const;
   std::string toString() const;
+
+  /// \brief Returns the hash code of this payload, calculated on first use after the payload is created or changed.
+  /// \note The first call after a change writes the cached value, so is not safe concurrently with other calls.
+  std::size_t hashCode() const noexcept;
+
+  // The mutators below mark the hash code for recalculation. Changes made via a Data
+  // reference to a PayloadData do not, so must not be made to a payload.
+
+  template <typename... ArgsT>
+  void append(ArgsT&&... args) {
+    Data::append(std::forward<ArgsT>(args)...);
+    hashed = false;
+  }
+
+  void appendReversed(const Data& rawData, std::size_t offset, std::size_t length);
+  void assign(const Data& other);
+  void clear() noexcept;
+
+  using Data::rawMemoryStartAddress;
+  /// \brief Writable bytes. Finish writing before the next hashCode() call, which recalculates.
+  unsigned char* rawMemoryStartAddress() noexcept {
+    hashed = false;
+    return Data::rawMemoryStartAddress();
+  }
+
+private:
+  mutable std::size_t hash;
+  mutable bool hashed;
 };
 
 } // end namespace
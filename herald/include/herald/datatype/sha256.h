@@ -7,6 +7,8 @@
 
 #include "data.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace herald {
@@ -21,6 +23,19 @@ public:
 
   void reset() noexcept; // Initialise to all zeros
 
+  /// \brief Length in bytes of every SHA-256 digest
+  static constexpr std::size_t DigestLength = 32;
+
+  /// \brief Digests count equal length messages in one call
+  ///
+  /// The messages are read back to back from messages (count * messageLength bytes) and
+  /// their digests are written back to back to digests (count * DigestLength bytes).
+  /// On x86-64 the messages are hashed several at a time across SIMD lanes (AVX2 where
+  /// the CPU supports it, SSE2 otherwise). Other platforms use a portable scalar
+  /// implementation. Results are identical to calling digest() on each message.
+  static void digestBatch(const std::uint8_t* messages, std::size_t messageLength,
+    std::size_t count, std::uint8_t* digests) noexcept;
+
 private:
   // No internal state required for Windows or TinyCrypt or mbedtls
 };
@@ -0,0 +1,319 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_SLOT_INDEX_H
+#define HERALD_SLOT_INDEX_H
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace herald {
+namespace datatype {
+
+/// \brief Returns the smallest power of two table size that holds slots at or below a 50% load factor
+constexpr std::size_t slotIndexCapacityFor(std::size_t slots) noexcept
+{
+  std::size_t capacity = 2;
+  while (capacity < slots * 2) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+/// \brief Returns log2 of a power of two value
+constexpr std::size_t slotIndexBitsFor(std::size_t powerOfTwo) noexcept
+{
+  std::size_t bits = 0;
+  while (powerOfTwo > 1) {
+    powerOfTwo >>= 1;
+    ++bits;
+  }
+  return bits;
+}
+
+/// \brief The smallest unsigned type able to hold the slot positions 0..MaxSlots inclusive
+template <std::size_t MaxSlots>
+using slot_position_t = std::conditional_t<(MaxSlots < 0xFFFF), std::uint16_t, std::uint32_t>;
+
+/// \brief A fixed capacity, allocation free, open addressing hash index of slot positions
+/// \since v2.1.0
+///
+/// Maps a caller-provided hash code onto a slot position within some other fixed size
+/// container (E.g. a std::array of BLEDevice). The index does not own or copy the keys.
+/// Instead, find() asks the caller to confirm a candidate slot via a matcher callable.
+/// This keeps the index small and allows several indexes (by different keys) over the
+/// same underlying container.
+///
+/// Each slot may be indexed under at most one hash code. Re-inserting a slot replaces
+/// its previous entry. Removal uses backward shift deletion rather than tombstones, so
+/// probe lengths do not degrade in long running applications.
+///
+/// Linear probing with a load factor of at most 50%, so find, insert and remove are O(1)
+/// on average. This class is noexcept compliant.
+template <std::size_t MaxSlots>
+class SlotHashIndex {
+public:
+  using slot_type = slot_position_t<MaxSlots>;
+
+  /// \brief The value returned by find() when no slot matches
+  static constexpr std::size_t npos = MaxSlots;
+  /// \brief The number of buckets in the hash table
+  static constexpr std::size_t Capacity = slotIndexCapacityFor(MaxSlots);
+
+  SlotHashIndex() noexcept
+   : buckets(), slotHashes(), indexed(), count(0)
+  {
+    clear();
+  }
+
+  ~SlotHashIndex() noexcept = default;
+
+  /// \brief Removes all entries from the index
+  void clear() noexcept {
+    buckets.fill(Bucket{0, emptySlot});
+    indexed.reset();
+    count = 0;
+  }
+
+  /// \brief Returns the number of slots currently indexed
+  std::size_t size() const noexcept {
+    return count;
+  }
+
+  /// \brief Returns whether the given slot is currently indexed
+  bool contains(std::size_t slot) const noexcept {
+    return slot < MaxSlots && indexed.test(slot);
+  }
+
+  /// \brief Returns the first slot stored against hash for which isMatch(slot) returns true, or npos
+  template <typename MatchT>
+  std::size_t find(std::size_t hash, MatchT&& isMatch) const noexcept {
+    const std::uint32_t h = fold(hash);
+    std::size_t pos = home(h);
+    for (std::size_t probes = 0;probes < Capacity;++probes) {
+      const Bucket& bucket = buckets[pos];
+      if (emptySlot == bucket.slot) {
+        return npos;
+      }
+      if (bucket.hash == h && isMatch(std::size_t(bucket.slot))) {
+        return bucket.slot;
+      }
+      pos = next(pos);
+    }
+    return npos;
+  }
+
+  /// \brief Indexes slot against hash, replacing any previous entry for this slot.
+  /// Returns false only if slot is out of range.
+  bool insert(std::size_t slot, std::size_t hash) noexcept {
+    if (slot >= MaxSlots) {
+      return false;
+    }
+    remove(slot);
+    const std::uint32_t h = fold(hash);
+    std::size_t pos = home(h);
+    // Always terminates, as at most MaxSlots of the Capacity buckets are in use
+    while (emptySlot != buckets[pos].slot) {
+      pos = next(pos);
+    }
+    buckets[pos] = Bucket{h, slot_type(slot)};
+    slotHashes[slot] = h;
+    indexed.set(slot);
+    ++count;
+    return true;
+  }
+
+  /// \brief Removes the entry for slot, if present. Returns whether an entry was removed.
+  bool remove(std::size_t slot) noexcept {
+    if (!contains(slot)) {
+      return false;
+    }
+    const std::uint32_t h = slotHashes[slot];
+    std::size_t hole = home(h);
+    while (buckets[hole].slot != slot) {
+      hole = next(hole);
+    }
+    // Backward shift deletion: move later entries of this probe run into the hole
+    // where doing so does not move them before their home bucket
+    std::size_t scan = next(hole);
+    while (emptySlot != buckets[scan].slot) {
+      const std::size_t ideal = home(buckets[scan].hash);
+      if (((scan - ideal) & mask) >= ((scan - hole) & mask)) {
+        buckets[hole] = buckets[scan];
+        hole = scan;
+      }
+      scan = next(scan);
+    }
+    buckets[hole] = Bucket{0, emptySlot};
+    indexed.reset(slot);
+    --count;
+    return true;
+  }
+
+private:
+  struct Bucket {
+    std::uint32_t hash;
+    slot_type slot;
+  };
+
+  static constexpr slot_type emptySlot = slot_type(MaxSlots);
+  static constexpr std::size_t mask = Capacity - 1;
+  static constexpr std::size_t bits = slotIndexBitsFor(Capacity);
+
+  /// \brief Folds a platform size_t hash in to 32 bits
+  static constexpr std::uint32_t fold(std::size_t hash) noexcept {
+    const std::uint64_t wide = std::uint64_t(hash);
+    return std::uint32_t(wide ^ (wide >> 32));
+  }
+
+  /// \brief Fibonacci hashing spreads weak (E.g. byte-sum) hashes across the table
+  static constexpr std::size_t home(std::uint32_t hash) noexcept {
+    return std::size_t((hash * std::uint32_t(2654435769u)) >> (32 - bits)) & mask;
+  }
+
+  static constexpr std::size_t next(std::size_t pos) noexcept {
+    return (pos + 1) & mask;
+  }
+
+  std::array<Bucket,Capacity> buckets;
+  std::array<std::uint32_t,MaxSlots> slotHashes;
+  std::bitset<MaxSlots> indexed;
+  std::size_t count;
+};
+
+/// \brief A fixed capacity least-recently-used ordering of slot positions, with an O(1) free list
+/// \since v2.1.0
+///
+/// Tracks which slots of some other fixed size container are in use, and in which order
+/// they were last used. acquire() hands out a free slot (lowest position first on a new
+/// list), touch() marks a slot as most recently used, and leastRecent() returns the best
+/// candidate for eviction when no slot is free. All operations are O(1).
+///
+/// This class is noexcept compliant.
+template <std::size_t MaxSlots>
+class SlotLRUList {
+public:
+  using slot_type = slot_position_t<MaxSlots>;
+
+  /// \brief The value returned when no slot is available
+  static constexpr std::size_t npos = MaxSlots;
+
+  SlotLRUList() noexcept
+   : previous(), following(), freeSlots(), inUse(), freeCount(0), head(nil), tail(nil)
+  {
+    clear();
+  }
+
+  ~SlotLRUList() noexcept = default;
+
+  /// \brief Releases all slots
+  void clear() noexcept {
+    // Stack ordered such that slot 0 is handed out first
+    for (std::size_t i = 0;i < MaxSlots;++i) {
+      freeSlots[i] = slot_type(MaxSlots - i - 1);
+    }
+    freeCount = MaxSlots;
+    inUse.reset();
+    head = nil;
+    tail = nil;
+  }
+
+  /// \brief Returns the number of slots in use
+  std::size_t size() const noexcept {
+    return MaxSlots - freeCount;
+  }
+
+  /// \brief Returns whether the given slot is in use
+  bool contains(std::size_t slot) const noexcept {
+    return slot < MaxSlots && inUse.test(slot);
+  }
+
+  /// \brief Takes a free slot and marks it as most recently used. Returns npos if none are free.
+  std::size_t acquire() noexcept {
+    if (0 == freeCount) {
+      return npos;
+    }
+    const slot_type slot = freeSlots[--freeCount];
+    inUse.set(slot);
+    linkFront(slot);
+    return slot;
+  }
+
+  /// \brief Marks an in use slot as the most recently used
+  void touch(std::size_t slot) noexcept {
+    if (!contains(slot) || head == slot) {
+      return;
+    }
+    unlink(slot_type(slot));
+    linkFront(slot_type(slot));
+  }
+
+  /// \brief Returns an in use slot to the free list
+  void release(std::size_t slot) noexcept {
+    if (!contains(slot)) {
+      return;
+    }
+    unlink(slot_type(slot));
+    inUse.reset(slot);
+    freeSlots[freeCount++] = slot_type(slot);
+  }
+
+  /// \brief Returns the least recently used slot, or npos if no slot is in use
+  std::size_t leastRecent() const noexcept {
+    return nil == tail ? npos : std::size_t(tail);
+  }
+
+  /// \brief Returns the most recently used slot, or npos if no slot is in use
+  std::size_t mostRecent() const noexcept {
+    return nil == head ? npos : std::size_t(head);
+  }
+
+private:
+  static constexpr slot_type nil = slot_type(MaxSlots);
+
+  void linkFront(slot_type slot) noexcept {
+    previous[slot] = nil;
+    following[slot] = head;
+    if (nil != head) {
+      previous[head] = slot;
+    }
+    head = slot;
+    if (nil == tail) {
+      tail = slot;
+    }
+  }
+
+  void unlink(slot_type slot) noexcept {
+    const slot_type before = previous[slot];
+    const slot_type after = following[slot];
+    if (nil == before) {
+      head = after;
+    } else {
+      following[before] = after;
+    }
+    if (nil == after) {
+      tail = before;
+    } else {
+      previous[after] = before;
+    }
+    previous[slot] = nil;
+    following[slot] = nil;
+  }
+
+  std::array<slot_type,MaxSlots> previous;
+  std::array<slot_type,MaxSlots> following;
+  std::array<slot_type,MaxSlots> freeSlots;
+  std::bitset<MaxSlots> inUse;
+  std::size_t freeCount;
+  slot_type head;
+  slot_type tail;
+};
+
+}
+}
+
+#endif
@@ -29,7 +29,7 @@ public:
   bool operator<(const TargetIdentifier& other) const noexcept; // required for std::less
   bool operator>(const TargetIdentifier& other) const noexcept; // required for std::less
 
-  std::size_t hashCode() const;
+  std::size_t hashCode() const; // computed once, on construction
 
   operator std::string() const;
 
@@ -39,7 +39,7 @@ public:
 
 private:
   Data value;
-
+  std::size_t hash;
 };
 
 } // end namespace
@@ -14,12 +14,39 @@
 #include <algorithm>
 #include <iterator>
 #include <optional>
+#include <unordered_map>
+
+// Asynchronous execution needs threads, and a memory arena that tolerates them.
+// The HERALD_COORDINATOR_ASYNC CMake option defines HERALD_MEMORYARENA_THREADSAFE for hosted builds.
+#if !defined(__ZEPHYR__) && (defined(__unix__) || defined(__APPLE__)) && defined(HERALD_MEMORYARENA_THREADSAFE)
+#define HERALD_COORDINATOR_ASYNC 1
+#include <chrono>
+#include <future>
+#endif
 
 namespace herald {
 
 /// \brief Engine classes provide for task scheduling, including complex inter-dependent tasks.
 namespace engine {
 
+/// \brief How Coordinator::iteration() runs provisioning and activities
+enum class CoordinatorExecution : int {
+  /// \brief provision() and activities run one after another on the caller's thread (all platforms)
+  synchronous,
+  /// \brief Each provider's provisioning, and each provider's activities, run on their own thread
+  /// and are awaited up to a timeout. Only available where HERALD_COORDINATOR_ASYNC is defined,
+  /// which is POSIX hosts built with the HERALD_COORDINATOR_ASYNC CMake option (never Zephyr).
+  ///
+  /// Everything a provider and its activity executors touch is then used from other threads,
+  /// including after the iteration has returned. Only select this when every provider synchronises
+  /// that state itself, E.g. application providers for other sensor types.
+  ///
+  /// The BLE providers in this library do not (ConcreteBLEDatabase, BLEDevice and the SensorDelegates
+  /// they call are unsynchronised), so must run synchronously. A slow BLE connection therefore still
+  /// holds up the iteration it is made in.
+  asynchronous
+};
+
 ///
 /// \brief Coordinates all connection and activities used across all sensors within Herald
 /// 
@@ -35,6 +62,10 @@ namespace engine {
 ///
 /// - SensorArray
 ///
+/// In asynchronous mode a provider whose provisioning or activities outlast the timeout is left
+/// to finish in the background, and is skipped by later iterations until it has. Other providers
+/// carry on meanwhile. No provider is ever called from two threads at once.
+///
 template <typename ContextT>
 class Coordinator {
 public:
@@ -42,11 +73,32 @@ public:
   Coordinator(ContextT& ctx)
   : context(ctx),
     providers(),
+    featureProviders(),
+    assignPrereqs(),
+    connsRequired(),
+    uniquePrereqs(),
+    providerProvisioned(),
+    provisioned(),
+    activities(),
+    skip(),
+    mode(CoordinatorExecution::synchronous),
+#ifdef HERALD_COORDINATOR_ASYNC
+    timeout(DefaultAsyncTimeout),
+    provisionTasks(),
+    activityTasks(),
+    providerActivities(),
+    launched(),
+#endif
     running(false)
     HLOGGERINIT(ctx,"engine","coordinator")
   {}
 
-  ~Coordinator() = default;
+  ~Coordinator() {
+    waitForTasks();
+  }
+
+  /// \brief Maximum number of follow-on activities run after each activity
+  static constexpr std::size_t MaxFollowOns = 8;
 
   /// Introspect and include in iteration planning
   template <typename SensorT>
@@ -65,18 +117,48 @@ public:
     // TODO support remove
   }
 
+  /// \brief Returns how iterations run provisioning and activities
+  CoordinatorExecution execution() const noexcept {
+    return mode;
+  }
+
+#ifdef HERALD_COORDINATOR_ASYNC
+  static constexpr std::chrono::milliseconds DefaultAsyncTimeout = std::chrono::milliseconds(250);
+
+  /// \brief Selects how iterations run provisioning and activities.
+  ///
+  /// In asynchronous mode each iteration waits up to taskTimeout for provisioning, then up
+  /// to taskTimeout again for activities. Waits for any outstanding tasks before switching.
+  /// See CoordinatorExecution::asynchronous for the thread safety providers then need.
+  void execution(CoordinatorExecution newMode, std::chrono::milliseconds taskTimeout = DefaultAsyncTimeout) {
+    waitForTasks();
+    mode = newMode;
+    timeout = taskTimeout;
+  }
+#endif
+
   /// Prepares for iterations to be called (may pre-emptively make calls)
+  ///
+  /// Also sizes the per provider planning containers, which are then reused by every iteration.
   void start() {
     HTDBG("Start called");
     // Clear feature providers
     featureProviders.clear();
     // Fetch feature providers
-    for (auto prov: providers) {
-      auto myFeatures = prov.get().connectionsProvided();
-      for (auto feature : myFeatures) {
-        featureProviders.emplace(feature,prov);
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      auto myFeatures = providers[idx].get().connectionsProvided();
+      for (auto& feature : myFeatures) {
+        featureProviders.emplace(feature,idx);
       }
     }
+    sizeProviderContainers();
+    for (auto& prereqs : assignPrereqs) {
+      prereqs.reserve(InitialPlanningCapacity);
+    }
+    connsRequired.reserve(InitialPlanningCapacity);
+    uniquePrereqs.reserve(InitialPlanningCapacity);
+    provisioned.reserve(InitialPlanningCapacity);
+    activities.reserve(InitialPlanningCapacity);
     running = true;
     HTDBG("Start returning");
   }
@@ -89,123 +171,296 @@ public:
     }
     HTDBG("################# ITERATION #################");
     HTDBG("Memory pages free in Data Arena: {}", herald::datatype::Data::getArena().pagesFree());
-    // HTDBG("Entered iteration");
-    // Create empty list of required prereqs per provider
-    std::map<std::reference_wrapper<CoordinationProvider>,std::vector<PrioritisedPrerequisite>> assignPrereqs;
-    for (auto& prov : providers) {
-      assignPrereqs.emplace(prov,std::vector<PrioritisedPrerequisite>());
+    // Reset the planning containers, keeping their capacity from previous iterations
+    sizeProviderContainers(); // in case a provider was added after start()
+    for (auto& prereqs : assignPrereqs) {
+      prereqs.clear();
+    }
+    for (auto& prereqs : providerProvisioned) {
+      prereqs.clear();
     }
-    HTDBG("Completed initialisation of provider prerequisities containers");
+    connsRequired.clear();
+    uniquePrereqs.clear();
+    provisioned.clear();
+    activities.clear();
     HTDBG(" - Provider count: {}", providers.size());
+    // Providers still working on an earlier iteration sit this one out. Decided once, so that a
+    // provider finishing part way through is not then provisioned with no prerequisites.
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      skip[idx] = busy(idx);
+    }
     
-    std::vector<PrioritisedPrerequisite> connsRequired;
     // Loop over providers and ask for feature pre-requisites
-    for (auto& prov : providers) {
-      auto myConns = prov.get().requiredConnections();
-      std::copy(myConns.begin(),myConns.end(),
-        std::back_insert_iterator<std::vector<PrioritisedPrerequisite>>(connsRequired));
-    }
-    HTDBG(std::to_string(connsRequired.size()));
-    HTDBG("Retrieved providers' current prerequisites");
-    // TODO de-duplicate pre-reqs
-    // Now link required prereqs to each provider
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      if (skip[idx]) {
+        continue;
+      }
+      auto myConns = providers[idx].get().requiredConnections();
+      connsRequired.insert(connsRequired.end(),myConns.begin(),myConns.end());
+    }
+    HTDBG("Retrieved providers' current prerequisites: {}", connsRequired.size());
+    // Sort by descending priority, then keep the first (highest priority) request for each
+    // feature and target. Each provider's list below is therefore already in priority order.
+    std::stable_sort(connsRequired.begin(),connsRequired.end(),
+      [] (const PrioritisedPrerequisite& a, const PrioritisedPrerequisite& b) -> bool {
+        return std::get<1>(a) > std::get<1>(b);
+      });
     for (auto& p : connsRequired) {
+      auto pos = std::lower_bound(uniquePrereqs.begin(),uniquePrereqs.end(),key(p),keyLess);
+      if (uniquePrereqs.end() != pos && !(key(p) < key(**pos))) {
+        continue; // duplicate of a higher priority request
+      }
+      uniquePrereqs.insert(pos,&p);
       auto el = featureProviders.find(std::get<0>(p)); // find provider for given prereq by feature tag
       if (featureProviders.end() != el) {
         assignPrereqs[el->second].push_back(p);
       }
     }
-    HTDBG("Linked pre-reqs to their providers");
-
-    // // Some debug checks here
-    // int cnt = 0;
-    // for (auto& ass : assignPrereqs) {
-    //   // HTDBG("assign prereqs number {} has this many prereqs to fill {}", cnt, ass.second.size());
-    //   cnt++;
-    // }
+    HTDBG("Linked {} unique pre-reqs to their providers", uniquePrereqs.size());
     
     // Communicate with relevant feature providers and request features for targets (in descending priority order)
     //  - Includes removal of previous features no longer needed
-    std::vector<PrioritisedPrerequisite> provisioned;
-    for (auto& prov : assignPrereqs) {
-      // TODO sort by descending priority before passing on
-
-      // FOR PLATFORMS WITH STD::FUTURE AND STD::ASYNC
-      // std::future<void> fut = std::async(std::launch::async,
-      //     &CoordinationProvider::provision, prov.first,
-      // //prov.first->provision(
-      //     prov.second,[&provisioned] (
-      //   const std::vector<PrioritisedPrerequisite> myProvisioned) -> void {
-      //   std::copy(myProvisioned.begin(),myProvisioned.end(),
-      //     std::back_insert_iterator<std::vector<PrioritisedPrerequisite>>(provisioned));
-      // });
-      // fut.get(); // waits for callback // TODO wait with timeout
-
-      // FOR OTHER PLATFORMS (E.g. ZEPHYR):-
-      std::vector<PrioritisedPrerequisite> myProvisioned = prov.first.get().provision(prov.second);
-      std::copy(myProvisioned.begin(),myProvisioned.end(),
-        std::back_insert_iterator<std::vector<PrioritisedPrerequisite>>(provisioned));
+#ifdef HERALD_COORDINATOR_ASYNC
+    if (CoordinatorExecution::asynchronous == mode) {
+      provisionAsync();
+    } else
+#endif
+    {
+      for (std::size_t idx = 0;idx < providers.size();++idx) {
+        providerProvisioned[idx] = providers[idx].get().provision(assignPrereqs[idx]);
+      }
     }
+    indexProvisioned();
     HTDBG("All pre-requisities requests sent and responses received");
-    // TODO do the above asynchronously and await callback or timeout for all
 
     // For each which are now present, ask for activities (in descending priority order)
-    for (auto& prov : providers) {
-      auto maxActs = prov.get().requiredActivities();
-      // TODO sort by descending priority before actioning
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      if (skip[idx] || busy(idx)) { // busy as well if this iteration's provisioning timed out
+        continue;
+      }
+      auto maxActs = providers[idx].get().requiredActivities();
       for (auto& act : maxActs) {
-        std::string san("Activity ");
-        san += act.name;
-        HTDBG(san);
-        // HTDBG("Checking next desired activity for prereqs being satisfied");
-        // Filter requested by provisioned
-        bool allFound = true;
-        for (auto& pre : act.prerequisites) {
-          bool myFound = false;
-          for (auto& exists : provisioned) {
-            if (std::get<0>(pre) == std::get<0>(exists) &&
-                std::get<1>(pre) == std::get<2>(exists)) {
-              myFound = true;
-            }
-          }
-          allFound = allFound & myFound;
-          if (myFound) {
-            HTDBG(" - Prereq satisfied");
-          } else {
-            HTDBG(" - Prereq NOT SATISFIED");
-          }
-        }
-        // Carry out activities with completion callbacks passed in
-        if (allFound) {
-          HTDBG("All satisfied, calling activity");
-          // do activity
-
-          // FOR PLATFORMS WITH STD::ASYNC
-          // act.executor(act,[this] (Activity act, std::optional<Activity> followOn) -> void {
-          //   // TODO handle result
-          //   // TODO Carry out any follow up activities
-          //   HTDBG("Activity completion callback called");
-          // });
-
-          // FOR PLATFORMS WITHOUT
-          std::optional<Activity> followOn = act.executor(act);
-          // TODO carry out follow on activity until no more follow ons (or max follow on number hit)
-        }
-      }
-    }
-    // HTDBG("Leaving iteration");
+        activities.emplace_back(idx,std::move(act));
+      }
+    }
+    std::stable_sort(activities.begin(),activities.end(),
+      [] (const std::pair<std::size_t,Activity>& a, const std::pair<std::size_t,Activity>& b) -> bool {
+        return a.second.priority > b.second.priority;
+      });
+#ifdef HERALD_COORDINATOR_ASYNC
+    for (auto& acts : providerActivities) {
+      acts.clear();
+    }
+#endif
+    for (auto& [idx,act] : activities) {
+      HTDBG("Activity {}", act.name);
+      // Filter requested by provisioned
+      if (!satisfied(act)) {
+        continue;
+      }
+      // Carry out activities, and any follow-on activities they return
+#ifdef HERALD_COORDINATOR_ASYNC
+      if (CoordinatorExecution::asynchronous == mode) {
+        providerActivities[idx].push_back(std::move(act));
+        continue;
+      }
+#endif
+      HTDBG("All satisfied, calling activity");
+      runWithFollowOns(act);
+    }
+#ifdef HERALD_COORDINATOR_ASYNC
+    if (CoordinatorExecution::asynchronous == mode) {
+      actAsync();
+    }
+#endif
     HTDBG("#################    END    #################");
   }
   /// Closes out any existing connections/activities
+  ///
+  /// In asynchronous mode, waits for any provisioning and activities still running.
   void stop() {
     running = false;
+    waitForTasks();
   }
 
 private:
+  /// \brief Capacity reserved at start() for each planning container, to avoid early regrowth
+  static constexpr std::size_t InitialPlanningCapacity = 8;
+
+  void sizeProviderContainers() {
+    if (assignPrereqs.size() == providers.size()) {
+      return;
+    }
+    assignPrereqs.resize(providers.size());
+    providerProvisioned.resize(providers.size());
+    skip.resize(providers.size());
+#ifdef HERALD_COORDINATOR_ASYNC
+    provisionTasks.resize(providers.size());
+    activityTasks.resize(providers.size());
+    providerActivities.resize(providers.size());
+    launched.resize(providers.size());
+#endif
+  }
+
+  /// \brief The parts of a prerequisite that identify it (feature then target), without copying them
+  using PrerequisiteKey = std::tuple<const FeatureTag&,const std::optional<TargetIdentifier>&>;
+
+  static PrerequisiteKey key(const PrioritisedPrerequisite& p) {
+    return std::tie(std::get<0>(p),std::get<2>(p));
+  }
+
+  static PrerequisiteKey key(const Prerequisite& p) {
+    return std::tie(std::get<0>(p),std::get<1>(p));
+  }
+
+  static bool keyLess(const PrioritisedPrerequisite* p, const PrerequisiteKey& k) {
+    return key(*p) < k;
+  }
+
+  /// \brief Lists everything provisioned this iteration, sorted for lookup by satisfied()
+  void indexProvisioned() {
+    for (auto& myProvisioned : providerProvisioned) {
+      for (auto& exists : myProvisioned) {
+        provisioned.push_back(&exists);
+      }
+    }
+    std::sort(provisioned.begin(),provisioned.end(),
+      [] (const PrioritisedPrerequisite* a, const PrioritisedPrerequisite* b) -> bool {
+        return key(*a) < key(*b);
+      });
+  }
+
+  bool satisfied(const Activity& act) const {
+    for (auto& pre : act.prerequisites) {
+      auto pos = std::lower_bound(provisioned.begin(),provisioned.end(),key(pre),keyLess);
+      if (provisioned.end() == pos || key(pre) < key(**pos)) {
+        HTDBG(" - Prereq NOT SATISFIED");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// \brief Runs act, then each follow-on activity it (transitively) returns, up to MaxFollowOns.
+  /// A follow-on comes from an activity that has just run, so runs straight away without filtering.
+  static void runWithFollowOns(const Activity& act) {
+    std::optional<Activity> followOn = act.executor(act);
+    for (std::size_t count = 0;followOn.has_value() && count < MaxFollowOns;++count) {
+      Activity next = std::move(followOn.value());
+      followOn = next.executor(next);
+    }
+  }
+
+#ifdef HERALD_COORDINATOR_ASYNC
+  /// \brief Whether a provider still has provisioning or activities running from an earlier iteration
+  bool busy(std::size_t idx) const {
+    return inFlight(provisionTasks[idx]) || inFlight(activityTasks[idx]);
+  }
+
+  template <typename FutureT>
+  static bool inFlight(const FutureT& task) {
+    return task.valid() && std::future_status::ready != task.wait_for(std::chrono::seconds(0));
+  }
+
+  /// \brief Provisions every provider not skipped this iteration concurrently, collecting results that arrive in time
+  void provisionAsync() {
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      launched[idx] = !skip[idx];
+      if (!launched[idx]) {
+        continue; // still working on an earlier iteration's request
+      }
+      CoordinationProvider& provider = providers[idx].get();
+      provisionTasks[idx] = std::async(std::launch::async,
+        [&provider] (std::vector<PrioritisedPrerequisite> requested) -> std::vector<PrioritisedPrerequisite> {
+          return provider.provision(requested);
+        }, assignPrereqs[idx]);
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      auto& task = provisionTasks[idx];
+      if (!launched[idx]) {
+        continue;
+      }
+      if (std::future_status::ready == task.wait_until(deadline)) {
+        providerProvisioned[idx] = task.get();
+      } else {
+        HTDBG("Provisioning timed out for provider {}", idx);
+      }
+    }
+  }
+
+  /// \brief Runs each provider's satisfied activities (in priority order) on its own thread
+  void actAsync() {
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      launched[idx] = !providerActivities[idx].empty();
+      if (!launched[idx]) {
+        continue;
+      }
+      activityTasks[idx] = std::async(std::launch::async,
+        [] (std::vector<Activity> acts) -> void {
+          for (auto& act : acts) {
+            runWithFollowOns(act);
+          }
+        }, providerActivities[idx]);
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (std::size_t idx = 0;idx < providers.size();++idx) {
+      auto& task = activityTasks[idx];
+      if (!launched[idx]) {
+        continue;
+      }
+      if (std::future_status::ready == task.wait_until(deadline)) {
+        task.get();
+      } else {
+        HTDBG("Activities timed out for provider {}", idx);
+      }
+    }
+  }
+
+  void waitForTasks() {
+    for (auto& task : provisionTasks) {
+      if (task.valid()) {
+        task.wait();
+      }
+    }
+    for (auto& task : activityTasks) {
+      if (task.valid()) {
+        task.wait();
+      }
+    }
+  }
+#else
+  bool busy(std::size_t) const {
+    return false;
+  }
+
+  void waitForTasks() {
+    ;
+  }
+#endif
+
   ContextT& context;
 
   std::vector<std::reference_wrapper<CoordinationProvider>> providers;
-  std::map<FeatureTag,std::reference_wrapper<CoordinationProvider>> featureProviders;
+  std::unordered_map<FeatureTag,std::size_t> featureProviders; // index into providers
+
+  // Planning state reused by every iteration (cleared, never deallocated)
+  std::vector<std::vector<PrioritisedPrerequisite>> assignPrereqs; // indexed as providers
+  std::vector<PrioritisedPrerequisite> connsRequired;
+  std::vector<const PrioritisedPrerequisite*> uniquePrereqs; // into connsRequired, sorted by key()
+  std::vector<std::vector<PrioritisedPrerequisite>> providerProvisioned; // indexed as providers, as returned by them
+  std::vector<const PrioritisedPrerequisite*> provisioned; // into providerProvisioned, sorted by key()
+  std::vector<std::pair<std::size_t,Activity>> activities; // with the index of their provider
+  std::vector<bool> skip; // indexed as providers. Busy when the current iteration started
+
+  CoordinatorExecution mode;
+#ifdef HERALD_COORDINATOR_ASYNC
+  std::chrono::milliseconds timeout;
+  std::vector<std::future<std::vector<PrioritisedPrerequisite>>> provisionTasks; // indexed as providers
+  std::vector<std::future<void>> activityTasks; // indexed as providers
+  std::vector<std::vector<Activity>> providerActivities; // indexed as providers
+  std::vector<bool> launched; // whether each provider was given a task in the current phase
+#endif
 
   bool running;
 
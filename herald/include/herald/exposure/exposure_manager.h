@@ -8,7 +8,14 @@
 #include "../datatype/exposure.h"
 #include "../datatype/time_interval.h"
 #include "../datatype/date.h"
-
+#include "../clock.h"
+#include "../util/is_valid.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
 #include <functional>
 #include <optional>
 
@@ -273,6 +280,445 @@ private:
 };
 
 
+/**
+ * @brief Iterator over a SortedExposureArray. As for AllocatableArray iterators, moving forward
+ * stops at the end rather than passing it.
+ */
+template <typename ValueT>
+class SortedExposureArrayIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::remove_const_t<ValueT>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = ValueT*;
+  using reference = ValueT&;
+
+  SortedExposureArrayIterator(ValueT* current, ValueT* last) noexcept
+   : current(current),
+     last(last)
+  {
+    ;
+  }
+
+  reference operator*() const noexcept {
+    return *current;
+  }
+
+  pointer operator->() const noexcept {
+    return current;
+  }
+
+  SortedExposureArrayIterator& operator++() noexcept {
+    if (current != last) {
+      ++current;
+    }
+    return *this;
+  }
+
+  SortedExposureArrayIterator operator++(int) noexcept {
+    SortedExposureArrayIterator copy(*this);
+    ++(*this);
+    return copy;
+  }
+
+  SortedExposureArrayIterator& operator+=(std::size_t by) noexcept {
+    current = by > std::size_t(last - current) ? last : current + by;
+    return *this;
+  }
+
+  bool operator==(const SortedExposureArrayIterator& other) const noexcept {
+    return current == other.current;
+  }
+
+  bool operator!=(const SortedExposureArrayIterator& other) const noexcept {
+    return current != other.current;
+  }
+
+private:
+  ValueT* current;
+  ValueT* last;
+};
+
+/**
+ * @brief A fixed size array of Exposures kept in ascending periodStart order
+ * 
+ * Exposures are held contiguously, so access by position is constant time and a time range can be
+ * found by binary search. add() inserts in periodStart order, which is a simple append for the
+ * chronological exposures produced by the ExposureManager.
+ * 
+ * Values changed in place through operator[] or an iterator must keep their periodStart order, as the
+ * ExposureManager does when extending the latest period.
+ * 
+ * @tparam Size The maximum number of Exposures held
+ */
+template <std::size_t Size>
+class SortedExposureArray {
+public:
+  using value_type = Exposure;
+  using size_type = std::size_t;
+  using iterator = SortedExposureArrayIterator<Exposure>;
+  using const_iterator = SortedExposureArrayIterator<const Exposure>;
+
+  static constexpr std::size_t max_size = Size;
+
+  SortedExposureArray() noexcept
+   : count(0),
+     members()
+  {
+    ;
+  }
+
+  ~SortedExposureArray() noexcept = default;
+
+  /**
+   * @brief Adds an Exposure after any with the same or an earlier periodStart
+   * 
+   * @return false If the array is full
+   */
+  bool add(const Exposure& toAdd) noexcept {
+    if (count == max_size) {
+      return false;
+    }
+    std::size_t pos = count;
+    for (;pos > 0 && members[pos - 1].periodStart > toAdd.periodStart;--pos) {
+      members[pos] = members[pos - 1];
+    }
+    members[pos] = toAdd;
+    ++count;
+    return true;
+  }
+
+  void clear() noexcept {
+    count = 0;
+  }
+
+  std::size_t size() const noexcept {
+    return count;
+  }
+
+  Exposure& operator[](std::size_t pos) noexcept {
+    return members[pos];
+  }
+
+  const Exposure& operator[](std::size_t pos) const noexcept {
+    return members[pos];
+  }
+
+  iterator begin() noexcept {
+    return iterator(members.data(), members.data() + count);
+  }
+
+  iterator end() noexcept {
+    return iterator(members.data() + count, members.data() + count);
+  }
+
+  const_iterator begin() const noexcept {
+    return cbegin();
+  }
+
+  const_iterator end() const noexcept {
+    return cend();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return const_iterator(members.data(), members.data() + count);
+  }
+
+  const_iterator cend() const noexcept {
+    return const_iterator(members.data() + count, members.data() + count);
+  }
+
+private:
+  std::size_t count;
+  std::array<Exposure,Size> members;
+};
+
+/**
+ * @brief An in-memory store of Exposure information, indexed for fast queries
+ * 
+ * A drop in replacement for FixedMemoryExposureStore. Each source's exposures are kept in
+ * periodStart order, so aggregate() finds the exposures overlapping the requested period by binary
+ * search and then scans only those. The metadata is indexed by agent, sensor instance and model class,
+ * so each of the findMeta methods is also a binary search rather than a linear scan. This suits
+ * risk models, which aggregate over many agents and periods on every refresh.
+ * 
+ * The exposures of each source must not overlap one another (as for those produced by the
+ * ExposureManager), so that they are ordered by periodEnd as well as periodStart.
+ * 
+ * @tparam MaxInMemoryExposureSummaries The maximum number of exposure sources (ExposureMetadata) held
+ * @tparam MaxExposuresPerSource The maximum number of Exposure values held for each source
+ */
+template <std::size_t MaxInMemoryExposureSummaries, std::size_t MaxExposuresPerSource = MaxInMemoryExposureSummaries>
+class IndexedExposureStore {
+public:
+  /**
+   * @brief The maximum number of exposure sources this exposure store supports
+   * 
+   */
+  static constexpr std::size_t max_size = MaxInMemoryExposureSummaries;
+
+  using contents_type = SortedExposureArray<MaxExposuresPerSource>;
+
+  IndexedExposureStore() noexcept
+   : count(0),
+     tags(),
+     exposures(),
+     byAgent(),
+     bySensorInstance(),
+     byModelClass()
+  {
+    ;
+  }
+
+  ~IndexedExposureStore() noexcept = default;
+
+  /// MARK: Exposure array and elements access and size methods
+
+  /**
+   * @brief Provisions space, if available, for the given ExposureMetadata
+   * 
+   * @param meta The ExposureMetadata to provision storage for
+   * @return true If the metadata already has storage provisioned, or if provisioning of new storage succeeded
+   * @return false If storage could not be provisioned for this exposure metadata
+   */
+  bool add(ExposureMetadata meta) noexcept {
+    // Only identical metadata shares storage, as sources may differ by sensor instance alone
+    auto iter = lowerBound(bySensorInstance, meta.sensorInstanceId, [](const ExposureMetadata& m) -> const UUID& { return m.sensorInstanceId; });
+    for (;iter != bySensorInstance.cbegin() + count && tags[*iter].sensorInstanceId == meta.sensorInstanceId;++iter) {
+      if (tags[*iter] == meta) {
+        return true;
+      }
+    }
+    if (count >= max_size) {
+      return false;
+    }
+    const std::size_t pos = count;
+    tags[pos] = meta;
+    exposures[pos].clear();
+    ++count;
+    insertIndex(byAgent, pos, [](const ExposureMetadata& m) -> const UUID& { return m.agentId; });
+    insertIndex(bySensorInstance, pos, [](const ExposureMetadata& m) -> const UUID& { return m.sensorInstanceId; });
+    insertIndex(byModelClass, pos, [](const ExposureMetadata& m) -> const UUID& { return m.modelClassId; });
+    return true;
+  }
+
+  /**
+   * @brief Removes the whole set of exposure information for the given ExposureMetadata::instanceId value
+   * 
+   * @param instanceId The Instance ID (UUID) of the ExposureMetadata to remove from storage.
+   * @return true If the instanceId was found (and thus removed)
+   * @return false If the instanceId was not found
+   */
+  bool remove(const UUID& instanceId) noexcept {
+    std::size_t pos = findMetaBySensorInstanceId(instanceId);
+    if (pos >= max_size) {
+      return false;
+    }
+    for (std::size_t mp = pos;mp + 1 < count;++mp) {
+      tags[mp] = tags[mp + 1];
+      exposures[mp] = exposures[mp + 1];
+    }
+    --count;
+    removeIndex(byAgent, pos);
+    removeIndex(bySensorInstance, pos);
+    removeIndex(byModelClass, pos);
+    return true;
+  }
+
+  /**
+   * @brief Returns the number of currently allocated ExposureMetadata arrays
+   * 
+   * @return const std::size_t The number of arrays currently used. Always <= max_size.
+   */
+  const std::size_t size() const noexcept {
+    return count;
+  }
+
+  /**
+   * @brief Get the Contents for the given exposure position
+   * 
+   * WARNING: does not validate the pos value passed to it.
+   * 
+   * @param pos Position of the allocated exposure metadata to return the SortedExposureArray for
+   * @return auto& The contents (SortedExposureArray instance)
+   */
+  auto& getContents(std::size_t pos) noexcept {
+    return exposures[pos];
+  }
+
+  const auto& getContents(std::size_t pos) const noexcept {
+    return exposures[pos];
+  }
+
+  /**
+   * @brief Get the Tag object for the ExposureMetadata instance at the given pos position
+   * 
+   * WARNING: does not validate the pos value passed to it.
+   * 
+   * @param pos Position of the allocated exposure metadata to return the tag for
+   * @return auto& The Tag (ExposureMetadata instance) at the given position
+   */
+  const ExposureMetadata& getTag(std::size_t pos) const noexcept {
+    return tags[pos];
+  }
+
+  /// MARK: Methods used by querying external classes (E.g. Risk Scoring algorithms)
+
+  /**
+   * @brief Calls the given callable with the aggregate of the Exposures of the given Agent that overlap the given time bounds.
+   * 
+   * Results are the same as for FixedMemoryExposureStore::aggregate.
+   * 
+   * @tparam AggT The aggregate type to apply (E.g. an Analysis API or custom aggregation)
+   * @tparam CallableT The callable (E.g. Lambda) to call for each aggregated result
+   * @param agent The agent of interest
+   * @param periodStart Earliest time we're interested in (inclusive of overlaps)
+   * @param periodEnd Most recent time we're interested in (inclusive of overlaps)
+   * @param agg The aggregate to apply to the matching Exposures (from Analysis API, or custom)
+   * @param c The callable to call - once or multiple times depending on the output of the aggregate with signature  (const Exposure& cbValue) -> void
+   */
+  template <typename AggT, typename CallableT>
+  void aggregate(const Agent& agent, const Date& periodStart, const Date& periodEnd, 
+    AggT&& agg, CallableT callable) const noexcept {
+    agg.reset();
+    agg.beginRun(1); // TODO support multi-pass aggregations
+
+    auto pos = findMetaByAgentId(agent);
+    if (max_size == pos) {
+      return;
+    }
+    const auto& contents = exposures[pos];
+    if (0 == contents.size()) {
+      return;
+    }
+    const Exposure* first = &contents[0];
+    const Exposure* end = first + contents.size();
+    Date iterStart = first->periodStart;
+    Date iterEnd = (end - 1)->periodEnd;
+
+    // Exposures entirely before the period form a prefix, and those entirely after it a suffix
+    const Exposure* from = std::partition_point(first, end, [&periodStart] (const Exposure& score) {
+      return score.periodStart < periodStart && score.periodEnd <= periodStart;
+    });
+    const Exposure* to = std::partition_point(from, end, [&periodEnd] (const Exposure& score) {
+      return !(score.periodStart >= periodEnd && score.periodEnd > periodEnd);
+    });
+    for (;from != to;++from) {
+      agg.map(from->value);
+    }
+
+    callable(Exposure{
+      .periodStart = iterStart < periodStart ? iterStart : periodStart,
+      .periodEnd = iterEnd > periodEnd ? iterEnd : periodEnd,
+      .value = agg.reduce(),
+      .confidence = 1.0 // TODO get this from the aggregator itself
+    });
+  }
+
+  /// MARK: Search methods
+
+  /**
+   * @brief Returns the position of the given ExposureMetadata (by operator==() )
+   * 
+   * @param meta The ExposureMetadata to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMeta(const ExposureMetadata& meta) const noexcept {
+    // ExposureMetadata::operator==() compares the agent but not the sensor instance
+    auto iter = lowerBound(byAgent, meta.agentId, [](const ExposureMetadata& m) -> const UUID& { return m.agentId; });
+    for (;iter != byAgent.cbegin() + count && tags[*iter].agentId == meta.agentId;++iter) {
+      if (tags[*iter] == meta) {
+        return *iter;
+      }
+    }
+    return max_size;
+  }
+
+  /**
+   * @brief Returns the position of the first ExposureMetadata added with the given sensorInstanceId
+   * 
+   * @param sensorInstanceId The ExposureMetadata::sensorInstanceId (UUID) to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMetaBySensorInstanceId(const UUID& sensorInstanceId) const noexcept {
+    return find(bySensorInstance, sensorInstanceId, [](const ExposureMetadata& m) -> const UUID& { return m.sensorInstanceId; });
+  }
+
+  /**
+   * @brief Returns the position of the first ExposureMetadata added with the given agentId
+   * 
+   * @param agent The ExposureMetadata::agentId (Agent aka UUID) to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMetaByAgentId(const Agent& agent) const noexcept {
+    return find(byAgent, agent, [](const ExposureMetadata& m) -> const UUID& { return m.agentId; });
+  }
+
+  /**
+   * @brief Returns the position of the first ExposureMetadata added with the given modelClassId
+   * 
+   * @param modelClassId The ExposureMetadata::modelClassId (UUID) to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMetaByModelClassId(const UUID& modelClassId) const noexcept {
+    return find(byModelClass, modelClassId, [](const ExposureMetadata& m) -> const UUID& { return m.modelClassId; });
+  }
+
+  template <typename CallableT>
+  void over(std::size_t pos, CallableT callable) const noexcept {
+    for (const auto& exposure : exposures[pos]) {
+      callable(exposure);
+    }
+  }
+
+private:
+  using Index = std::array<std::size_t,max_size>; // positions, ordered by key then position
+
+  std::size_t count;
+  std::array<ExposureMetadata,max_size> tags;
+  std::array<contents_type,max_size> exposures;
+  Index byAgent;
+  Index bySensorInstance;
+  Index byModelClass;
+
+  template <typename KeyFn>
+  typename Index::const_iterator lowerBound(const Index& index, const UUID& key, KeyFn keyOf) const noexcept {
+    return std::lower_bound(index.cbegin(), index.cbegin() + count, key,
+      [this, &keyOf] (std::size_t pos, const UUID& value) { return keyOf(tags[pos]) < value; });
+  }
+
+  template <typename KeyFn>
+  std::size_t find(const Index& index, const UUID& key, KeyFn keyOf) const noexcept {
+    auto iter = lowerBound(index, key, keyOf);
+    if (iter == index.cbegin() + count || keyOf(tags[*iter]) != key) {
+      return max_size;
+    }
+    return *iter;
+  }
+
+  /// Indexes the newest position, after any others with the same key (so the earliest added is found first)
+  template <typename KeyFn>
+  void insertIndex(Index& index, std::size_t pos, KeyFn keyOf) noexcept {
+    const UUID& key = keyOf(tags[pos]);
+    std::size_t at = pos; // count - 1 entries are already indexed
+    for (;at > 0 && key < keyOf(tags[index[at - 1]]);--at) {
+      index[at] = index[at - 1];
+    }
+    index[at] = pos;
+  }
+
+  /// Removes a position from an index, renumbering the positions after it
+  void removeIndex(Index& index, std::size_t pos) noexcept {
+    std::size_t out = 0;
+    for (std::size_t in = 0;in <= count;++in) {
+      if (index[in] != pos) {
+        index[out++] = index[in] > pos ? index[in] - 1 : index[in];
+      }
+    }
+  }
+};
+
+
 
 
 
@@ -317,11 +763,16 @@ namespace {
    * @brief Represents an INTERNAL reference to a change that has occured. 
    * 
    * Used to efficiently cache change references until a notify action can be called.
+   * All changes to one sensor instance between notifications are merged into a single
+   * reference covering the earliest to the latest changed time.
    */
   struct ExposureChangeReference {
     UUID sensorInstanceId = UUID::unknown();
+    std::size_t position = 0; // store position when recorded. Re-validated before use.
     Date periodStart = Date{0};
     Date periodEnd = Date{0};
+    std::size_t from = 0; // the changed exposures, [from,to) within the store contents. Set when notifying.
+    std::size_t to = 0;
 
     bool operator==(const ExposureChangeReference& other) const noexcept {
       return sensorInstanceId == other.sensorInstanceId;
@@ -333,6 +784,61 @@ namespace {
 }
 using DefaultExposureManager = ExposureManager<DefaultNullExposureCallbackHandler,DefaultDevNullExposureStore>;
 
+/**
+ * @brief The exposures of every source that have changed since the last ExposureManager::notifyOfChanges() call
+ * 
+ * Passed to a callback handler's exposureLevelsChanged(const BatchT& batch) function, where it has one, so
+ * that all of the changes are delivered in a single call. Only valid for the duration of that call.
+ * 
+ * @tparam ExposureStoreT The ExposureManager's exposure store type
+ * @tparam ChangesT The ExposureManager's list of changes
+ */
+template <typename ExposureStoreT, typename ChangesT>
+class ExposureChangeBatch {
+public:
+  ExposureChangeBatch(ExposureStoreT& exposureStore, const ChangesT& changeList) noexcept
+   : store(exposureStore), changes(changeList)
+  {
+    ;
+  }
+
+  ~ExposureChangeBatch() noexcept = default;
+
+  /**
+   * @brief Calls the callable once per changed source, with only the exposures that overlap its changed period
+   * 
+   * @param callable With the signature (const ExposureMetadata& meta, IterT& iter, IterT& end) -> void, as for exposureLevelChanged()
+   */
+  template <typename CallableT>
+  void forEach(CallableT callable) const noexcept {
+    for (std::size_t changeIndex = 0;changeIndex < changes.size();++changeIndex) {
+      const auto& change = changes[changeIndex];
+      if (change.from == change.to) {
+        continue;
+      }
+      auto& contents = store.getContents(change.position);
+      auto iter = std::next(contents.begin(), change.from);
+      auto end = std::next(contents.begin(), change.to);
+      callable(store.getTag(change.position), iter, end);
+    }
+  }
+
+private:
+  ExposureStoreT& store;
+  const ChangesT& changes;
+};
+
+/// \brief Detects callback handlers that receive all changes in one exposureLevelsChanged(batch) call
+constexpr auto hasExposureLevelsChangedFunction = herald::util::isValid(
+  [](auto&& h, auto&& batch) -> decltype(((decltype(h))h).exposureLevelsChanged(batch)) {}
+);
+
+template <typename HandlerT, typename BatchT>
+using HasExposureLevelsChangedFunctionT = decltype(hasExposureLevelsChangedFunction(std::declval<HandlerT&>(),std::declval<const BatchT&>()));
+
+template <typename HandlerT, typename BatchT>
+constexpr auto HasExposureLevelsChangedFunctionV = HasExposureLevelsChangedFunctionT<HandlerT,BatchT>::value;
+
 /**
  * @brief Acts as a delegate to be informed when a raw Analysis API value has changed
  * 
@@ -411,11 +917,20 @@ template <typename CallbackHandlerT,
   typename ExposureStoreT>
 class ExposureManager {
 public:
+  /// \brief Anchors periods on the system clock's time at construction. Prefer passing the Context's clock.
   ExposureManager(CallbackHandlerT& initialHandler, ExposureStoreT& initialExposureStore) noexcept
+   : ExposureManager(initialHandler, initialExposureStore, defaultClockSource<SystemClock>())
+  {
+    ;
+  }
+
+  /// \brief Anchors periods on clock's now() at construction. E.g. Context::getClock(), or a FakeClock
+  template <typename ClockT>
+  ExposureManager(CallbackHandlerT& initialHandler, ExposureStoreT& initialExposureStore, ClockT& clock) noexcept
    : handler(initialHandler),
      store(initialExposureStore),
      changes(),
-     anchor(Date{}), // Default to instantiation DateTime
+     anchor(clock.now()), // Default to instantiation DateTime
      period(TimeInterval::hours(24)), // Default to one day interval
      running(false)
   {
@@ -528,6 +1043,15 @@ public:
   /**
    * @brief Notifies delegates of any changes that have occurred since the last time this method was called.
    * 
+   * Changes are coalesced per sensor instance, and only the exposures that overlap the changed time
+   * period are passed (not the whole array). If the handler has an exposureLevelsChanged(batch) function
+   * every changed source is passed to it in a single call (See ExposureChangeBatch). Otherwise its
+   * exposureLevelChanged(meta,iter,end) function is called once per changed source.
+   * 
+   * The exposures come from the store's getContents(). For a FileExposureStore this is only each source's
+   * latest MaxRecentExposures exposures (those held in memory). A change to an exposure already written to
+   * the file is not passed to the handler. Use the store's aggregate() to read the whole history.
+   * 
    * @return true If any notifications of changes occured
    * @return false If no notifications of changes occured
    */
@@ -537,15 +1061,16 @@ public:
     }
     bool anyNotified = false;
     for (std::size_t changeIndex = 0; changeIndex < changes.size(); ++changeIndex) {
-      std::size_t instancePos = store.findMetaBySensorInstanceId(changes[changeIndex].sensorInstanceId);
-      if (instancePos < ExposureStoreT::max_size) {
-        anyNotified = true;
-        auto& contents = store.getContents(instancePos);
-        auto exposureIter = contents.begin();
-        exposureIter += instancePos; // advance to the position of interest to the receiver
-        auto exposureEnd = contents.end();
-        handler.exposureLevelChanged(store.getTag(instancePos), exposureIter, exposureEnd); //exposures[instancePos].contents()[0]); // TODO replace this with a safety check
-        // TODO fire the above for only those items that have changed, not the whole array or first element, using periodStart and periodEnd in the change metadata
+      anyNotified = resolveChange(changes[changeIndex]) || anyNotified;
+    }
+    if (anyNotified) {
+      ExposureChangeBatch<ExposureStoreT,decltype(changes)> batch{store, changes};
+      if constexpr (HasExposureLevelsChangedFunctionV<CallbackHandlerT,decltype(batch)>) {
+        handler.exposureLevelsChanged(batch);
+      } else {
+        batch.forEach([this] (const ExposureMetadata& meta, auto& iter, auto& end) {
+          handler.exposureLevelChanged(meta, iter, end);
+        });
       }
     }
     // reset changes for the next run
@@ -558,6 +1083,9 @@ public:
   /**
    * @brief Get the Count of the number of exposure scores recorded for a given instance ID
    * 
+   * For a FileExposureStore this is only the number held in memory (at most MaxRecentExposures), not
+   * those also written to the file. Use FileExposureStore::count() for the whole history.
+   * 
    * @param sensorInstanceId The sensor instanceId we are interested in
    * @return std::size_t The number of current, in memory, exposure period values stored
    */
@@ -617,7 +1145,7 @@ private:
         .confidence = 1.0 // TODO pass through analysis API confidence, if supported (compilation option?)
       });
       // Record change for later notification
-      recordChange(store.getTag(pos).sensorInstanceId, sampleTaken, sampleTaken);
+      recordChange(pos, sampleTaken, sampleTaken);
     } else {
       // Ensure split by period is observed
       // TODO take into account of anchor time, rather than always rely upon startTime of previous element (which may not align exactly with anchor time + n*period)
@@ -626,48 +1154,90 @@ private:
       // determine if last start time plus this time is greater than window size
       if (last.periodStart + period <= sampleTaken) {
         // if so, set endTime to window size, and create new element
-        last.periodEnd = last.periodStart + period;
+        // Note: take a copy of the start, as some stores move their contents on add
+        Date lastStart = last.periodStart;
+        last.periodEnd = lastStart + period;
         exposureArray.add(Exposure{
-          .periodStart = (last.periodStart + period) >= sampleTaken ? (last.periodStart + period) : sampleTaken, // set to end time of previous period, to be sure, unless we've skipped 1 or more windows
+          .periodStart = (lastStart + period) >= sampleTaken ? (lastStart + period) : sampleTaken, // set to end time of previous period, to be sure, unless we've skipped 1 or more windows
           .periodEnd = sampleTaken,
           .value = sampleValue, // explicit conversion
           .confidence = 1.0 // TODO pass through analysis API confidence, if supported (compilation option?)
         });
         // Record change for later notification
-        recordChange(store.getTag(pos).sensorInstanceId, last.periodStart, sampleTaken);
+        recordChange(pos, lastStart, sampleTaken);
       } else {
         // if not, append
         // Append value to time period
-        exposureArray[exposureArray.size() - 1] += Exposure{
+        auto& latest = exposureArray[exposureArray.size() - 1];
+        latest += Exposure{
           .periodStart = sampleTaken,
           .periodEnd = sampleTaken,
           .value = sampleValue, // explicit conversion
           .confidence = 1.0 // TODO pass through analysis API confidence, if supported (compilation option?)
         };
         // Record change for later notification
-        recordChange(store.getTag(pos).sensorInstanceId, exposureArray[0].periodStart, exposureArray[0].periodEnd);
+        recordChange(pos, latest.periodStart, latest.periodEnd);
       }
     }
   }
 
-  void recordChange(const UUID& instanceId, const Date& periodStart, const Date& periodEnd) noexcept {
+  /// \brief Finds the exposures that overlap the change's period. Returns false if there are none.
+  bool resolveChange(ExposureChangeReference& change) noexcept {
+    std::size_t instancePos = change.position;
+    if (instancePos >= store.size() || store.getTag(instancePos).sensorInstanceId != change.sensorInstanceId) {
+      // Sources have been added or removed since the change was recorded
+      instancePos = store.findMetaBySensorInstanceId(change.sensorInstanceId);
+    }
+    change.from = 0;
+    change.to = 0;
+    if (instancePos >= ExposureStoreT::max_size) {
+      return false;
+    }
+    change.position = instancePos;
+    auto& contents = store.getContents(instancePos);
+    // Skip exposures entirely before the change (as for the stores' aggregate() overlap rules)
+    auto exposureIter = contents.begin();
+    auto contentsEnd = contents.end();
+    std::size_t from = 0;
+    while (exposureIter != contentsEnd &&
+           exposureIter->periodStart < change.periodStart && exposureIter->periodEnd <= change.periodStart) {
+      ++exposureIter;
+      ++from;
+    }
+    // Stop at the first exposure entirely after the change
+    std::size_t to = from;
+    while (exposureIter != contentsEnd &&
+           !(exposureIter->periodStart >= change.periodEnd && exposureIter->periodEnd > change.periodEnd)) {
+      ++exposureIter;
+      ++to;
+    }
+    change.from = from;
+    change.to = to;
+    return from != to;
+  }
+
+  void recordChange(std::size_t pos, const Date& periodStart, const Date& periodEnd) noexcept {
     if (!running) {
       return;
     }
+    const UUID& instanceId = store.getTag(pos).sensorInstanceId;
     // Note including start and end dates for efficiency
     // Check for an existing change for this instanceId, and modify its start and end times
     std::size_t cpos = ExposureStoreT::max_size;
     for (std::size_t i = 0;i < changes.size();++i) {
       if (changes[i].sensorInstanceId == instanceId) {
         cpos = i;
+        break;
       }
     }
     if (ExposureStoreT::max_size != cpos) {
       changes[cpos].periodStart = periodStart < changes[cpos].periodStart ? periodStart : changes[cpos].periodStart;
       changes[cpos].periodEnd = periodEnd > changes[cpos].periodEnd ? periodEnd : changes[cpos].periodEnd;
+      changes[cpos].position = pos;
     } else {
       changes.add(ExposureChangeReference{
         .sensorInstanceId = instanceId,
+        .position = pos,
         .periodStart = periodStart,
         .periodEnd = periodEnd
       });
@@ -0,0 +1,282 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_FILE_EXPOSURE_STORE_H
+#define HERALD_FILE_EXPOSURE_STORE_H
+
+#include "file_score_log.h"
+
+#include <string>
+
+namespace herald {
+namespace exposure {
+
+using namespace herald::datatype;
+
+/**
+ * @brief A store of Exposure information backed by an append only file, for long term history
+ *
+ * Has the same interface as FixedMemoryExposureStore, for use with the ExposureManager and
+ * RiskManager, but keeps every exposure of every source rather than a fixed number in memory.
+ * Only the MaxRecentExposures latest exposures of each source are held in memory, and returned by
+ * getContents(). aggregate() and over() also read older exposures from the file, through a memory
+ * mapping. See FileScoreLog for the file format, and when exposures are written and compacted.
+ *
+ * Call open() before use, and flush() or sync() periodically (E.g. after each notifyOfChanges()) so
+ * that the latest exposure of each source is written too. Only available on POSIX hosts.
+ *
+ * The exposures of each source must not overlap one another, as for those produced by the ExposureManager.
+ *
+ * @tparam MaxExposureSources The maximum number of exposure sources (ExposureMetadata) held
+ * @tparam MaxRecentExposures The number of each source's latest exposures held in memory
+ */
+template <std::size_t MaxExposureSources, std::size_t MaxRecentExposures = 16>
+class FileExposureStore {
+public:
+  using log_type = FileScoreLog<ExposureMetadata,filestore::ExposureMetadataCodec,MaxExposureSources,MaxRecentExposures>;
+  using contents_type = typename log_type::contents_type;
+
+  /**
+   * @brief The maximum number of exposure sources this exposure store supports
+   *
+   */
+  static constexpr std::size_t max_size = MaxExposureSources;
+
+  /**
+   * @brief Construct a new File Exposure Store object. The file is not opened until open() is called.
+   *
+   * @param path The file to store exposures in. Created if it does not exist.
+   */
+  explicit FileExposureStore(std::string path) noexcept
+   : exposures(std::move(path))
+  {
+    ;
+  }
+
+  ~FileExposureStore() noexcept = default;
+
+  /// MARK: File management methods
+
+  /**
+   * @brief Opens the file, loading the sources and exposures it already holds
+   */
+  bool open() noexcept {
+    return exposures.open();
+  }
+
+  /**
+   * @brief Writes every exposure, then closes the file. Called on destruction.
+   */
+  void close() noexcept {
+    exposures.close();
+  }
+
+  /**
+   * @brief Writes every exposure, including the latest of each source, compacting the file if more than half of it is superseded
+   */
+  bool flush() noexcept {
+    return exposures.flush();
+  }
+
+  /**
+   * @brief As flush(), then waits for the file to reach the storage device
+   */
+  bool sync() noexcept {
+    return exposures.sync();
+  }
+
+  /**
+   * @brief Rewrites the file with only the exposures of current sources
+   */
+  bool compact() noexcept {
+    return exposures.compact();
+  }
+
+  /// MARK: Exposure array and elements access and size methods
+
+  /**
+   * @brief Provisions space for the given ExposureMetadata
+   *
+   * @param meta The ExposureMetadata to provision storage for
+   * @return true If the metadata already has storage provisioned, or if provisioning of new storage succeeded
+   * @return false If storage could not be provisioned (E.g. the store is full, or not open)
+   */
+  bool add(ExposureMetadata meta) noexcept {
+    for (std::size_t pos = 0;pos < exposures.size();++pos) {
+      const auto& tag = exposures.tag(pos);
+      if (tag == meta && tag.sensorInstanceId == meta.sensorInstanceId) {
+        return true;
+      }
+    }
+    return exposures.add(meta);
+  }
+
+  /**
+   * @brief Removes the whole set of exposure information for the given ExposureMetadata::instanceId value
+   *
+   * @param instanceId The Instance ID (UUID) of the ExposureMetadata to remove from storage.
+   * @return true If the instanceId was found (and thus removed)
+   * @return false If the instanceId was not found
+   */
+  bool remove(const UUID& instanceId) noexcept {
+    return exposures.remove(findMetaBySensorInstanceId(instanceId));
+  }
+
+  /**
+   * @brief Returns the number of exposure sources held
+   *
+   * @return const std::size_t The number of sources. Always <= max_size.
+   */
+  std::size_t size() const noexcept {
+    return exposures.size();
+  }
+
+  /**
+   * @brief Get the latest exposures for the given exposure position
+   *
+   * Only the latest of these may be changed. Earlier exposures are written to the file, and there
+   * is always room to add one more.
+   *
+   * WARNING: does not validate the pos value passed to it.
+   *
+   * @param pos Position of the allocated exposure metadata to return the SortedExposureArray for
+   * @return auto& The contents (SortedExposureArray instance)
+   */
+  auto& getContents(std::size_t pos) noexcept {
+    return exposures.recent(pos);
+  }
+
+  const auto& getContents(std::size_t pos) const noexcept {
+    return exposures.recent(pos);
+  }
+
+  /**
+   * @brief Get the Tag object for the ExposureMetadata instance at the given pos position
+   *
+   * WARNING: does not validate the pos value passed to it.
+   *
+   * @param pos Position of the allocated exposure metadata to return the tag for
+   * @return auto& The Tag (ExposureMetadata instance) at the given position
+   */
+  const ExposureMetadata& getTag(std::size_t pos) const noexcept {
+    return exposures.tag(pos);
+  }
+
+  /**
+   * @brief Returns the number of exposures held for the given position, in memory and in the file
+   */
+  std::size_t count(std::size_t pos) const noexcept {
+    return exposures.count(pos);
+  }
+
+  /// MARK: Methods used by querying external classes (E.g. Risk Scoring algorithms)
+
+  /**
+   * @brief Calls the given callable with the aggregate of the Exposures of the given Agent that overlap the given time bounds.
+   *
+   * Results are the same as for FixedMemoryExposureStore::aggregate, over the whole history.
+   *
+   * @tparam AggT The aggregate type to apply (E.g. an Analysis API or custom aggregation)
+   * @tparam CallableT The callable (E.g. Lambda) to call for each aggregated result
+   * @param agent The agent of interest
+   * @param periodStart Earliest time we're interested in (inclusive of overlaps)
+   * @param periodEnd Most recent time we're interested in (inclusive of overlaps)
+   * @param agg The aggregate to apply to the matching Exposures (from Analysis API, or custom)
+   * @param c The callable to call - once or multiple times depending on the output of the aggregate with signature  (const Exposure& cbValue) -> void
+   */
+  template <typename AggT, typename CallableT>
+  void aggregate(const Agent& agent, const Date& periodStart, const Date& periodEnd,
+    AggT&& agg, CallableT callable) const noexcept {
+    agg.reset();
+    agg.beginRun(1); // TODO support multi-pass aggregations
+
+    auto pos = findMetaByAgentId(agent);
+    if (max_size == pos) {
+      return;
+    }
+    Date iterStart{0};
+    Date iterEnd{0};
+    if (!exposures.bounds(pos, iterStart, iterEnd)) {
+      return;
+    }
+    exposures.overlapping(pos, periodStart, periodEnd, [&agg] (const Exposure& score) {
+      agg.map(score.value);
+    });
+
+    callable(Exposure{
+      .periodStart = iterStart < periodStart ? iterStart : periodStart,
+      .periodEnd = iterEnd > periodEnd ? iterEnd : periodEnd,
+      .value = agg.reduce(),
+      .confidence = 1.0 // TODO get this from the aggregator itself
+    });
+  }
+
+  /// MARK: Search methods
+
+  /**
+   * @brief Returns the position of the given ExposureMetadata (by operator==() )
+   *
+   * @param meta The ExposureMetadata to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMeta(const ExposureMetadata& meta) const noexcept {
+    return find([&meta] (const ExposureMetadata& tag) { return tag == meta; });
+  }
+
+  /**
+   * @brief Returns the position of the given ExposureMetadata (by sensorInstanceId )
+   *
+   * @param sensorInstanceId The ExposureMetadata::sensorInstanceId (UUID) to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMetaBySensorInstanceId(const UUID& sensorInstanceId) const noexcept {
+    return find([&sensorInstanceId] (const ExposureMetadata& tag) { return tag.sensorInstanceId == sensorInstanceId; });
+  }
+
+  /**
+   * @brief Returns the position of the given ExposureMetadata (by agentId )
+   *
+   * @param agent The ExposureMetadata::agentId (Agent aka UUID) to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMetaByAgentId(const Agent& agent) const noexcept {
+    return find([&agent] (const ExposureMetadata& tag) { return tag.agentId == agent; });
+  }
+
+  /**
+   * @brief Returns the position of the given ExposureMetadata (by modelClassId )
+   *
+   * @param modelClassId The ExposureMetadata::modelClassId (UUID) to search for
+   * @return std::size_t The position of the ExposureMetadata, or max_size if not found
+   */
+  std::size_t findMetaByModelClassId(const UUID& modelClassId) const noexcept {
+    return find([&modelClassId] (const ExposureMetadata& tag) { return tag.modelClassId == modelClassId; });
+  }
+
+  /**
+   * @brief Calls the callable for every exposure of the given position, oldest first, including those only in the file
+   */
+  template <typename CallableT>
+  void over(std::size_t pos, CallableT callable) const noexcept {
+    exposures.over(pos, callable);
+  }
+
+private:
+  log_type exposures;
+
+  template <typename PredT>
+  std::size_t find(PredT matches) const noexcept {
+    for (std::size_t pos = 0;pos < exposures.size();++pos) {
+      if (matches(exposures.tag(pos))) {
+        return pos;
+      }
+    }
+    return max_size;
+  }
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,189 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_FILE_RISK_STORE_H
+#define HERALD_FILE_RISK_STORE_H
+
+#include "file_score_log.h"
+
+#include <string>
+
+namespace herald {
+namespace exposure {
+
+using namespace herald::datatype;
+
+/**
+ * @brief A store of Risk Score information backed by an append only file, for long term history
+ *
+ * Has the same interface as FixedMemoryRiskStore, for use with the RiskManager, but keeps every
+ * risk score rather than a fixed number in memory. Only the MaxRecentRiskScores latest scores of
+ * each model instance are held in memory, and returned by getContents(). over() also reads older
+ * scores from the file, through a memory mapping. See FileScoreLog for the file format.
+ *
+ * Call open() before use, and flush() or sync() periodically (E.g. after each refreshDirtyScores()).
+ * Only available on POSIX hosts.
+ *
+ * @tparam MaxRiskSources The maximum number of Risk Score sources (RiskScoreMetadata) held
+ * @tparam MaxRecentRiskScores The number of each source's latest scores held in memory
+ */
+template <std::size_t MaxRiskSources, std::size_t MaxRecentRiskScores = 16>
+class FileRiskStore {
+public:
+  using log_type = FileScoreLog<RiskScoreMetadata,filestore::RiskScoreMetadataCodec,MaxRiskSources,MaxRecentRiskScores>;
+  using contents_type = typename log_type::contents_type;
+
+  /**
+   * @brief The maximum number of risk score sources this risk store supports
+   *
+   */
+  static constexpr std::size_t max_size = MaxRiskSources;
+
+  /**
+   * @brief Construct a new File Risk Store object. The file is not opened until open() is called.
+   *
+   * @param path The file to store risk scores in. Created if it does not exist.
+   */
+  explicit FileRiskStore(std::string path) noexcept
+   : scores(std::move(path))
+  {
+    ;
+  }
+
+  ~FileRiskStore() noexcept = default;
+
+  /// MARK: File management methods
+
+  bool open() noexcept {
+    return scores.open();
+  }
+
+  void close() noexcept {
+    scores.close();
+  }
+
+  bool flush() noexcept {
+    return scores.flush();
+  }
+
+  bool sync() noexcept {
+    return scores.sync();
+  }
+
+  bool compact() noexcept {
+    return scores.compact();
+  }
+
+  /// MARK: Event driven scoring methods to add a score to our list:-
+  void score(const RiskScoreMetadata& addTo, herald::datatype::RiskScore&& toStore) noexcept {
+    std::size_t pos = findMeta(addTo);
+    if (max_size == pos) {
+      return;
+    }
+    scores.recent(pos).add(toStore);
+  }
+
+  /// MARK: Risk Score array and elements access and size methods
+
+  /**
+   * @brief Provisions space for the given RiskScoreMetadata
+   *
+   * @param meta The RiskScoreMetadata to provision storage for
+   * @return true If the metadata already has storage provisioned, or if provisioning of new storage succeeded
+   * @return false If storage could not be provisioned (E.g. the store is full, or not open)
+   */
+  bool add(RiskScoreMetadata meta) noexcept {
+    if (max_size != findMeta(meta)) {
+      return true;
+    }
+    return scores.add(meta);
+  }
+
+  /**
+   * @brief Removes the whole set of risk score information for the given RiskScoreMetadata::instanceId value
+   *
+   * @param instanceId The Instance ID (UUID) of the RiskScoreMetadata to remove from storage.
+   * @return true If the instanceId was found (and thus removed)
+   * @return false If the instanceId was not found
+   */
+  bool remove(const UUID& instanceId) noexcept {
+    return scores.remove(findMetaByModelInstanceId(instanceId));
+  }
+
+  /**
+   * @brief Returns the number of risk score sources held
+   *
+   * @return const std::size_t The number of sources. Always <= max_size.
+   */
+  std::size_t size() const noexcept {
+    return scores.size();
+  }
+
+  /**
+   * @brief Get the latest Risk Scores for the given position. Older scores are only in the file (see over()).
+   *
+   * WARNING: does not validate the pos value passed to it.
+   */
+  const auto& getContents(std::size_t pos) const noexcept {
+    return scores.recent(pos);
+  }
+
+  /**
+   * @brief Get the Tag object for the RiskScoreMetadata instance at the given pos position
+   *
+   * WARNING: does not validate the pos value passed to it.
+   */
+  const RiskScoreMetadata& getTag(std::size_t pos) const noexcept {
+    return scores.tag(pos);
+  }
+
+  /**
+   * @brief Returns the number of risk scores held for the given position, in memory and in the file
+   */
+  std::size_t count(std::size_t pos) const noexcept {
+    return scores.count(pos);
+  }
+
+  /**
+   * @brief Calls the callable for every risk score of the given position, oldest first, including those only in the file
+   */
+  template <typename CallableT>
+  void over(std::size_t pos, CallableT callable) const noexcept {
+    scores.over(pos, callable);
+  }
+
+  std::size_t findMeta(const RiskScoreMetadata& meta) const noexcept {
+    return find([&meta] (const RiskScoreMetadata& tag) { return tag == meta; });
+  }
+
+  std::size_t findMetaByAgentId(const Agent& agentId) const noexcept {
+    return find([&agentId] (const RiskScoreMetadata& tag) { return tag.agentId == agentId; });
+  }
+
+  std::size_t findMetaByAlgorithmId(const AlgorithmId& algoId) const noexcept {
+    return find([&algoId] (const RiskScoreMetadata& tag) { return tag.algorithmId == algoId; });
+  }
+
+  std::size_t findMetaByModelInstanceId(const UUID& riskModelInstanceId) const noexcept {
+    return find([&riskModelInstanceId] (const RiskScoreMetadata& tag) { return tag.instanceId == riskModelInstanceId; });
+  }
+
+private:
+  log_type scores;
+
+  template <typename PredT>
+  std::size_t find(PredT matches) const noexcept {
+    for (std::size_t pos = 0;pos < scores.size();++pos) {
+      if (matches(scores.tag(pos))) {
+        return pos;
+      }
+    }
+    return max_size;
+  }
+};
+
+}
+}
+
+#endif
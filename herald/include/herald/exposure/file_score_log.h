@@ -0,0 +1,517 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_FILE_SCORE_LOG_H
+#define HERALD_FILE_SCORE_LOG_H
+
+#include "exposure_manager.h"
+
+#include "../data/append_log.h"
+#include "../datatype/exposure_risk.h"
+#include "../datatype/date.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace herald {
+namespace exposure {
+
+using namespace herald::datatype;
+
+/// \brief Binary record layout of the file backed exposure and risk stores.
+///
+/// Every record starts with an 8 byte header: the record type, three zero bytes, and the
+/// number the store gave the source when it was added. Numbers are never reused in a file.
+/// Values are held in host byte order, so files are not portable between architectures.
+namespace filestore {
+
+enum class RecordType : std::uint8_t {
+  metadata = 1, // followed by the source's encoded metadata
+  score = 2, // followed by periodStart, periodEnd (uint64 seconds), value, confidence (double)
+  removed = 3 // the source and all of its scores were removed
+};
+
+constexpr std::size_t HeaderSize = 8;
+constexpr std::size_t ScoreSize = 32;
+
+inline void putUUID(std::uint8_t* to, const UUID& id) noexcept {
+  const auto bytes = id.data();
+  std::memcpy(to, bytes.data(), bytes.size());
+}
+
+inline UUID getUUID(const std::uint8_t* from) noexcept {
+  std::array<UUID::value_type,UUID::max_size> bytes;
+  std::memcpy(bytes.data(), from, bytes.size());
+  return UUID(bytes);
+}
+
+inline void putScore(std::uint8_t* to, const Score& score) noexcept {
+  const std::uint64_t start = score.periodStart.secondsSinceUnixEpoch();
+  const std::uint64_t end = score.periodEnd.secondsSinceUnixEpoch();
+  std::memcpy(to, &start, 8);
+  std::memcpy(to + 8, &end, 8);
+  std::memcpy(to + 16, &score.value, 8);
+  std::memcpy(to + 24, &score.confidence, 8);
+}
+
+inline Score getScore(const std::uint8_t* from) noexcept {
+  std::uint64_t start;
+  std::uint64_t end;
+  double value;
+  double confidence;
+  std::memcpy(&start, from, 8);
+  std::memcpy(&end, from + 8, 8);
+  std::memcpy(&value, from + 16, 8);
+  std::memcpy(&confidence, from + 24, 8);
+  // Not default constructed, as a default Date reads the clock
+  return Score{Date(start), Date(end), value, confidence};
+}
+
+/// \brief Encodes ExposureMetadata
+struct ExposureMetadataCodec {
+  static constexpr std::size_t size = 4 * UUID::max_size;
+
+  static void put(std::uint8_t* to, const ExposureMetadata& meta) noexcept {
+    putUUID(to, meta.agentId);
+    putUUID(to + UUID::max_size, meta.sensorClassId);
+    putUUID(to + 2 * UUID::max_size, meta.sensorInstanceId);
+    putUUID(to + 3 * UUID::max_size, meta.modelClassId);
+  }
+
+  static ExposureMetadata get(const std::uint8_t* from) noexcept {
+    return ExposureMetadata{
+      .agentId = Agent{getUUID(from)},
+      .sensorClassId = getUUID(from + UUID::max_size),
+      .sensorInstanceId = getUUID(from + 2 * UUID::max_size),
+      .modelClassId = getUUID(from + 3 * UUID::max_size)
+    };
+  }
+};
+
+/// \brief Encodes RiskScoreMetadata
+struct RiskScoreMetadataCodec {
+  static constexpr std::size_t size = 3 * UUID::max_size;
+
+  static void put(std::uint8_t* to, const RiskScoreMetadata& meta) noexcept {
+    putUUID(to, meta.agentId);
+    putUUID(to + UUID::max_size, meta.algorithmId);
+    putUUID(to + 2 * UUID::max_size, meta.instanceId);
+  }
+
+  static RiskScoreMetadata get(const std::uint8_t* from) noexcept {
+    return RiskScoreMetadata{
+      .agentId = Agent{getUUID(from)},
+      .algorithmId = AlgorithmId{getUUID(from + UUID::max_size)},
+      .instanceId = getUUID(from + 2 * UUID::max_size)
+    };
+  }
+};
+
+}
+
+/**
+ * @brief The file backed score history shared by FileExposureStore and FileRiskStore
+ *
+ * Each source (a metadata value) keeps its most recent scores in memory, in a SortedExposureArray,
+ * and every score in an append only AppendLog file. The log holds a source's metadata, then its
+ * scores in the order they were finalised. An in memory index of the record numbers of each
+ * source's scores lets historical scores be read through the log's memory mapping, and lets
+ * time range queries binary search them, without holding them in memory.
+ *
+ * Only the latest score of a source may be changed in place (as the ExposureManager does while
+ * its period is open). Earlier scores are written to the log when recent() is next called, and
+ * the latest when flush() is called. If the latest is changed after it has been written a
+ * replacement record is appended, and the earlier record is dead. Records of removed sources are
+ * dead too. flush() compacts the log, keeping only live records, once more than half are dead.
+ *
+ * Scores of a source must be added in time order, and must not overlap one another.
+ *
+ * @tparam MetaT The metadata type (ExposureMetadata or RiskScoreMetadata)
+ * @tparam CodecT Encodes MetaT in a record (see filestore)
+ * @tparam MaxSources The maximum number of sources held
+ * @tparam MaxRecent The number of recent scores held in memory for each source
+ */
+template <typename MetaT, typename CodecT, std::size_t MaxSources, std::size_t MaxRecent>
+class FileScoreLog {
+public:
+  static_assert(MaxRecent >= 2, "The latest score and at least one more must be held in memory");
+
+  static constexpr std::size_t max_size = MaxSources;
+  static constexpr std::size_t record_size = filestore::HeaderSize
+    + (CodecT::size > filestore::ScoreSize ? CodecT::size : filestore::ScoreSize);
+  /// \brief Compaction is not attempted below this many records
+  static constexpr std::size_t compact_after = 4096;
+
+  using contents_type = SortedExposureArray<MaxRecent>;
+
+  explicit FileScoreLog(std::string path) noexcept
+   : log(std::move(path), record_size),
+     sources(),
+     nextNumber(0),
+     dead(0)
+  {
+    ;
+  }
+
+  ~FileScoreLog() noexcept {
+    close();
+  }
+
+  /// \brief Opens the log file, creating it if needed, and loads any sources it holds
+  bool open() noexcept {
+    if (log.isOpen()) {
+      return true;
+    }
+    if (!log.open()) {
+      return false;
+    }
+    load();
+    return true;
+  }
+
+  /// \brief Writes every score, including the latest of each source, then closes the file
+  void close() noexcept {
+    if (!log.isOpen()) {
+      return;
+    }
+    flush();
+    log.close();
+    sources.clear();
+    nextNumber = 0;
+    dead = 0;
+  }
+
+  bool isOpen() const noexcept {
+    return log.isOpen();
+  }
+
+  /// \brief Writes every score to the file, including the latest of each source, compacting if worthwhile
+  bool flush() noexcept {
+    bool ok = log.isOpen();
+    for (auto& source : sources) {
+      ok = persistLatest(*source) && ok;
+    }
+    if (ok && log.size() >= compact_after && dead > log.size() - dead) {
+      return compact();
+    }
+    return ok && log.flush();
+  }
+
+  /// \brief As flush(), then waits for the file to reach the storage device
+  bool sync() noexcept {
+    return flush() && log.sync();
+  }
+
+  /// \brief Rewrites the file with only its live records
+  bool compact() noexcept {
+    if (!log.isOpen()) {
+      return false;
+    }
+    std::vector<std::uint8_t> live;
+    live.reserve((log.size() - dead) * record_size);
+    std::vector<std::vector<std::uint32_t>> renumbered(sources.size());
+    std::array<std::uint8_t,record_size> record;
+    std::uint32_t number = 0;
+    for (std::size_t pos = 0;pos < sources.size();++pos) {
+      encodeMetadata(record.data(), *sources[pos]);
+      live.insert(live.end(), record.begin(), record.end());
+      ++number;
+      for (auto entry : sources[pos]->history) {
+        const std::uint8_t* from = log.record(entry);
+        live.insert(live.end(), from, from + record_size);
+        renumbered[pos].push_back(number++);
+      }
+    }
+    if (!log.replace(live)) {
+      return false;
+    }
+    for (std::size_t pos = 0;pos < sources.size();++pos) {
+      sources[pos]->history.swap(renumbered[pos]);
+    }
+    dead = 0;
+    return true;
+  }
+
+  /// \brief Number of records in the file, live or dead, including those not yet written
+  std::size_t records() const noexcept {
+    return log.size();
+  }
+
+  /// \brief Number of records in the file that compaction would remove
+  std::size_t deadRecords() const noexcept {
+    return dead;
+  }
+
+  std::size_t size() const noexcept {
+    return sources.size();
+  }
+
+  bool add(const MetaT& meta) noexcept {
+    if (sources.size() >= max_size || !log.isOpen()) {
+      return false;
+    }
+    auto source = std::make_unique<Source>(nextNumber, meta);
+    std::array<std::uint8_t,record_size> record;
+    encodeMetadata(record.data(), *source);
+    if (!log.append(record.data())) {
+      return false;
+    }
+    ++nextNumber;
+    sources.push_back(std::move(source));
+    return true;
+  }
+
+  bool remove(std::size_t pos) noexcept {
+    if (pos >= sources.size()) {
+      return false;
+    }
+    std::array<std::uint8_t,record_size> record{};
+    record[0] = std::uint8_t(filestore::RecordType::removed);
+    std::memcpy(record.data() + 4, &sources[pos]->number, 4);
+    if (!log.append(record.data())) {
+      return false;
+    }
+    dead += sources[pos]->history.size() + 2; // its metadata and this record too
+    sources.erase(sources.begin() + pos);
+    return true;
+  }
+
+  const MetaT& tag(std::size_t pos) const noexcept {
+    return sources[pos]->meta;
+  }
+
+  /// \brief The recent scores of a source. Earlier scores are written first, so there is room to add one more.
+  contents_type& recent(std::size_t pos) noexcept {
+    Source& source = *sources[pos];
+    persistSealed(source);
+    if (source.recent.size() == MaxRecent && source.written == MaxRecent - 1) {
+      const Score latest = source.recent[MaxRecent - 1];
+      source.recent.clear();
+      source.recent.add(latest);
+      source.written = 0;
+    }
+    return source.recent;
+  }
+
+  const contents_type& recent(std::size_t pos) const noexcept {
+    return sources[pos]->recent;
+  }
+
+  /// \brief Number of scores held for a source, in memory and in the file
+  std::size_t count(std::size_t pos) const noexcept {
+    return historical(*sources[pos]) + sources[pos]->recent.size();
+  }
+
+  /// \brief Calls callable(const Score&) for every score of a source, oldest first
+  template <typename CallableT>
+  void over(std::size_t pos, CallableT callable) const noexcept {
+    const Source& source = *sources[pos];
+    const std::size_t inFile = historical(source);
+    for (std::size_t idx = 0;idx < inFile;++idx) {
+      callable(scoreAt(source.history[idx]));
+    }
+    for (const auto& score : source.recent) {
+      callable(score);
+    }
+  }
+
+  /// \brief Calls callable(const Score&) for every score of a source that overlaps [periodStart,periodEnd],
+  /// oldest first. Earlier and later scores are skipped by binary search.
+  template <typename CallableT>
+  void overlapping(std::size_t pos, const Date& periodStart, const Date& periodEnd, CallableT callable) const noexcept {
+    const Source& source = *sources[pos];
+    auto before = [&periodStart] (const Score& score) {
+      return score.periodStart < periodStart && score.periodEnd <= periodStart;
+    };
+    auto notAfter = [&periodEnd] (const Score& score) {
+      return !(score.periodStart >= periodEnd && score.periodEnd > periodEnd);
+    };
+    const auto first = source.history.cbegin();
+    const auto last = first + historical(source);
+    auto from = std::partition_point(first, last, [this, &before] (std::uint32_t entry) { return before(scoreAt(entry)); });
+    const auto to = std::partition_point(from, last, [this, &notAfter] (std::uint32_t entry) { return notAfter(scoreAt(entry)); });
+    for (;from != to;++from) {
+      callable(scoreAt(*from));
+    }
+    if (0 == source.recent.size()) {
+      return;
+    }
+    const Score* recentFirst = &source.recent[0];
+    const Score* recentLast = recentFirst + source.recent.size();
+    const Score* recentFrom = std::partition_point(recentFirst, recentLast, before);
+    const Score* recentTo = std::partition_point(recentFrom, recentLast, notAfter);
+    for (;recentFrom != recentTo;++recentFrom) {
+      callable(*recentFrom);
+    }
+  }
+
+  /// \brief The periodStart of a source's first score and the periodEnd of its last. False if it has none.
+  bool bounds(std::size_t pos, Date& firstStart, Date& lastEnd) const noexcept {
+    const Source& source = *sources[pos];
+    const std::size_t inFile = historical(source);
+    if (0 == inFile && 0 == source.recent.size()) {
+      return false;
+    }
+    firstStart = 0 != inFile ? scoreAt(source.history[0]).periodStart : source.recent[0].periodStart;
+    lastEnd = 0 != source.recent.size() ? source.recent[source.recent.size() - 1].periodEnd
+                                        : scoreAt(source.history[inFile - 1]).periodEnd;
+    return true;
+  }
+
+private:
+  struct Source {
+    Source(std::uint32_t number, const MetaT& meta) noexcept
+     : number(number), meta(meta), recent(), written(0), provisional(false), history()
+    {
+      ;
+    }
+
+    std::uint32_t number;
+    MetaT meta;
+    contents_type recent; // the latest scores
+    std::size_t written; // recent[0,written) are in the file, as history's last entries
+    bool provisional; // recent[written] is in the file too (as history's last entry), but may since have changed
+    std::vector<std::uint32_t> history; // record numbers of every score in the file, oldest first
+  };
+
+  herald::data::AppendLog log;
+  std::vector<std::unique_ptr<Source>> sources;
+  std::uint32_t nextNumber;
+  std::size_t dead;
+
+  /// Scores only held in the file, rather than also in recent
+  static std::size_t historical(const Source& source) noexcept {
+    return source.history.size() - source.written - (source.provisional ? 1 : 0);
+  }
+
+  Score scoreAt(std::uint32_t entry) const noexcept {
+    const std::uint8_t* record = log.record(entry);
+    return nullptr == record ? Score{Date(0), Date(0), 0.0, 0.0} : filestore::getScore(record + filestore::HeaderSize);
+  }
+
+  void encodeMetadata(std::uint8_t* record, const Source& source) const noexcept {
+    std::memset(record, 0, record_size);
+    record[0] = std::uint8_t(filestore::RecordType::metadata);
+    std::memcpy(record + 4, &source.number, 4);
+    CodecT::put(record + filestore::HeaderSize, source.meta);
+  }
+
+  /// Appends a score of source, replacing a provisional record of the same score if it has changed
+  bool writeScore(Source& source, const Score& score) noexcept {
+    if (source.provisional) {
+      if (scoreAt(source.history.back()) == score) {
+        return true;
+      }
+      source.history.pop_back();
+      ++dead;
+    }
+    std::array<std::uint8_t,record_size> record{};
+    record[0] = std::uint8_t(filestore::RecordType::score);
+    std::memcpy(record.data() + 4, &source.number, 4);
+    filestore::putScore(record.data() + filestore::HeaderSize, score);
+    if (!log.append(record.data())) {
+      return false;
+    }
+    source.history.push_back(std::uint32_t(log.size() - 1));
+    return true;
+  }
+
+  /// Writes the scores that can no longer change (all but the latest)
+  bool persistSealed(Source& source) noexcept {
+    const std::size_t sealed = 0 == source.recent.size() ? 0 : source.recent.size() - 1;
+    for (;source.written < sealed;++source.written) {
+      if (!writeScore(source, source.recent[source.written])) {
+        return false;
+      }
+      source.provisional = false;
+    }
+    return true;
+  }
+
+  bool persistLatest(Source& source) noexcept {
+    if (!persistSealed(source)) {
+      return false;
+    }
+    if (0 == source.recent.size()) {
+      return true;
+    }
+    if (!writeScore(source, source.recent[source.written])) {
+      return false;
+    }
+    source.provisional = true;
+    return true;
+  }
+
+  /// Rebuilds the sources from the file
+  void load() noexcept {
+    sources.clear();
+    nextNumber = 0;
+    dead = 0;
+    std::unordered_map<std::uint32_t,Source*> byNumber;
+    const std::size_t records = log.size();
+    for (std::size_t entry = 0;entry < records;++entry) {
+      const std::uint8_t* record = log.record(entry);
+      std::uint32_t number;
+      std::memcpy(&number, record + 4, 4);
+      nextNumber = std::max(nextNumber, number + 1);
+      auto found = byNumber.find(number);
+      switch (filestore::RecordType(record[0])) {
+        case filestore::RecordType::metadata:
+          if (sources.size() < max_size && found == byNumber.end()) {
+            sources.push_back(std::make_unique<Source>(number, CodecT::get(record + filestore::HeaderSize)));
+            byNumber.emplace(number, sources.back().get());
+          } else {
+            ++dead;
+          }
+          break;
+        case filestore::RecordType::score:
+          if (found == byNumber.end()) {
+            ++dead;
+          } else {
+            auto& history = found->second->history;
+            // A later record for the same period replaces the earlier
+            if (!history.empty() && scoreAt(history.back()).periodStart == filestore::getScore(record + filestore::HeaderSize).periodStart) {
+              history.back() = std::uint32_t(entry);
+              ++dead;
+            } else {
+              history.push_back(std::uint32_t(entry));
+            }
+          }
+          break;
+        case filestore::RecordType::removed:
+          if (found != byNumber.end()) {
+            dead += found->second->history.size() + 1;
+            sources.erase(std::find_if(sources.begin(), sources.end(),
+              [&found] (const std::unique_ptr<Source>& source) { return source.get() == found->second; }));
+            byNumber.erase(found);
+          }
+          ++dead;
+          break;
+        default:
+          ++dead;
+          break;
+      }
+    }
+    // The latest scores are held in memory again, the last of them open to change
+    for (auto& source : sources) {
+      const std::size_t held = std::min(source->history.size(), MaxRecent - 1);
+      for (std::size_t idx = source->history.size() - held;idx < source->history.size();++idx) {
+        source->recent.add(scoreAt(source->history[idx]));
+      }
+      source->written = 0 == held ? 0 : held - 1;
+      source->provisional = 0 != held;
+    }
+  }
+};
+
+}
+}
+
+#endif
@@ -10,9 +10,36 @@
 #include "../datatype/exposure_risk.h"
 #include "../datatype/date.h"
 #include "../datatype/time_interval.h"
+#include "../util/is_valid.h"
+
+#include <type_traits>
 
 namespace herald {
 namespace exposure {
+
+/// \brief Detects risk models that declare a static constexpr bool dependsOnAgentOnly member
+constexpr auto hasDependsOnAgentOnly = herald::util::isValid(
+  [](auto&& m) -> decltype(std::decay_t<decltype(m)>::dependsOnAgentOnly) {}
+);
+
+template <typename RiskModelT>
+using HasDependsOnAgentOnlyT = decltype(hasDependsOnAgentOnly(std::declval<RiskModelT&>()));
+
+/**
+ * @brief Whether a risk model's potentiallyDirty() result depends upon the Agent alone, not the Exposure passed
+ * 
+ * A risk model opts in by declaring static constexpr bool dependsOnAgentOnly = true. The RiskManager
+ * then calls its potentiallyDirty() once per Agent, rather than once per changed Exposure, and caches
+ * the result. Models without this member are asked about every changed Exposure.
+ */
+template <typename RiskModelT>
+constexpr bool dependsOnAgentOnly() noexcept {
+  if constexpr (HasDependsOnAgentOnlyT<RiskModelT>::value) {
+    return RiskModelT::dependsOnAgentOnly;
+  } else {
+    return false;
+  }
+}
   
 
 template <typename... RiskModelTs>
@@ -46,6 +73,38 @@ public:
     }
   }
 
+  /**
+   * @brief Returns the position of the first model with the given algorithmId, or Size if none match
+   * 
+   * Allows the linear search by AlgorithmId to be made once, E.g. when a risk model instance is added,
+   * rather than on every call. See forModelAt().
+   */
+  std::size_t indexOf(const AlgorithmId& algorithmId) const noexcept {
+    for (std::size_t idx = 0;idx < Size;++idx) {
+      bool found = false;
+      std::visit([&algorithmId,&found] (auto&& algo) {
+        found = (algo.algorithmId == algorithmId);
+      }, models[idx]);
+      if (found) {
+        return idx;
+      }
+    }
+    return Size;
+  }
+
+  /**
+   * @brief Calls the callback with the model at the given position (from indexOf()). Does nothing if index is out of range.
+   */
+  template <typename AlgoCallbackT>
+  void forModelAt(std::size_t index, AlgoCallbackT callback) noexcept {
+    if (index >= Size) {
+      return;
+    }
+    std::visit([&callback] (auto&& algo) {
+      callback((decltype(algo))algo);
+    }, models[index]);
+  }
+
 private:
   std::array<
     std::variant<RiskModelTs...>
@@ -80,6 +139,9 @@ struct SampleDiseaseScreeningRiskModel {
   //   }
   // }}; // WARNING: Generate a v4 UUID online, check it isn't used, and place it here for your class
 
+  /// \brief potentiallyDirty() only reads the agent (See dependsOnAgentOnly())
+  static constexpr bool dependsOnAgentOnly = true;
+
   // TODO later refine by also including start/end time and periodicity - incase an agent is only relevant at a particular time (MAY need ALL agents in that call though...)
   bool potentiallyDirty(const Agent& agent, const Exposure& exposure) const noexcept {
     return (
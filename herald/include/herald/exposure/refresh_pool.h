@@ -0,0 +1,61 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_REFRESH_POOL_H
+#define HERALD_REFRESH_POOL_H
+
+#include <cstddef>
+#include <memory>
+
+namespace herald {
+namespace exposure {
+
+/// \brief A fixed set of worker threads for running independent risk score calculations concurrently
+///
+/// Used by RiskManager::refreshDirtyScores() in RiskRefreshExecution::parallel mode. The threads are
+/// started once and reused by every run() call, so one pool may be shared by many RiskManagers (E.g.
+/// thousands of simulated people on a server) without creating threads on every refresh. run() calls
+/// from several threads at once are queued, one after another.
+///
+/// Only built for host (non embedded) platforms - see HERALD_SOURCES_SERVER.
+class RefreshPool {
+public:
+  /// \brief Starts the worker threads
+  /// \param threads The number of threads to run work on, including the calling thread. 0 means one per hardware thread.
+  explicit RefreshPool(unsigned int threads = 0);
+  RefreshPool(const RefreshPool&) = delete;
+  RefreshPool(RefreshPool&&) = delete;
+  /// \brief Stops and joins the worker threads
+  ~RefreshPool();
+
+  /// \brief The number of threads work is run on, including the calling thread
+  unsigned int threads() const noexcept;
+
+  /// \brief Calls work(item) once for every item in [0, items), returning when all calls have completed
+  ///
+  /// Items are handed out in ascending order but may complete in any order. The calling thread works too.
+  /// work must be safe to call from several threads at once for different items.
+  template <typename WorkT>
+  void run(std::size_t items, WorkT& work) {
+    runItems(items, &invoke<WorkT>, &work);
+  }
+
+private:
+  struct Workers;
+  std::unique_ptr<Workers> workers;
+
+  using ItemFunction = void (*)(void* work, std::size_t item);
+
+  template <typename WorkT>
+  static void invoke(void* work, std::size_t item) {
+    (*static_cast<WorkT*>(work))(item);
+  }
+
+  void runItems(std::size_t items, ItemFunction function, void* work);
+};
+
+}
+}
+
+#endif
@@ -11,11 +11,31 @@
 #include "../datatype/exposure.h"
 #include "../datatype/time_interval.h"
 #include "../datatype/date.h"
+#include "../clock.h"
 
 #include <functional>
+#include <limits>
 #include <optional>
 #include <utility>
 
+// Parallel refresh needs threads (see RefreshPool, built for hosts only). Risk models only
+// handle exposures and risk scores, never Data, so the memory arena need not be thread safe.
+#if !defined(__ZEPHYR__)
+#define HERALD_RISK_MANAGER_PARALLEL 1
+#include "refresh_pool.h"
+#include <vector>
+#endif
+
+// How many exposure Agents' dependent risk model positions RiskManager caches. Each slot holds
+// max_size positions and instance IDs, so small targets default to fewer. 0 disables the cache.
+#ifndef HERALD_RISK_DEPENDENCY_AGENTS_MAX
+#if defined(__ZEPHYR__)
+#define HERALD_RISK_DEPENDENCY_AGENTS_MAX 2
+#else
+#define HERALD_RISK_DEPENDENCY_AGENTS_MAX 16
+#endif
+#endif
+
 namespace herald {
 namespace exposure {
 
@@ -90,7 +110,7 @@ public:
    * @return false If the instanceId was not found
    */
   bool remove(const UUID& instanceId) noexcept {
-    std::size_t pos = findMetaBySensorInstanceId(instanceId);
+    std::size_t pos = findMetaByModelInstanceId(instanceId);
     if (pos >= max_size) {
       // agent not found - return false
       return false;
@@ -221,8 +241,42 @@ private:
   const RiskScoreMetadata& linked;
 };
 
+#ifdef HERALD_RISK_MANAGER_PARALLEL
+/**
+ * @brief A risk score sink that holds the scores of one model instance, for later merging into the RiskScoreStore
+ * 
+ * Used in place of WrappedRiskScoreStore when model instances are refreshed concurrently.
+ */
+class BufferedRiskScores {
+public:
+  explicit BufferedRiskScores(std::vector<herald::datatype::RiskScore>& into) noexcept
+   : scores(into)
+  {
+    ;
+  }
+
+  ~BufferedRiskScores() noexcept = default;
+
+  void score(herald::datatype::RiskScore&& toStore) noexcept {
+    scores.push_back(std::move(toStore));
+  }
+
+private:
+  std::vector<herald::datatype::RiskScore>& scores;
+};
+#endif
+
 } // end 'hidden' namespace
 
+/// \brief How RiskManager::refreshDirtyScores() runs the risk models of dirty model instances
+enum class RiskRefreshExecution : int {
+  /// \brief Each dirty model instance is refreshed in turn on the caller's thread (all platforms)
+  serial,
+  /// \brief Dirty model instances are refreshed concurrently on a RefreshPool, then their scores
+  /// are stored in position order, as for serial. Only available where HERALD_RISK_MANAGER_PARALLEL is defined.
+  parallel
+};
+
 
 // FWD DECL
 template <typename RiskModelsT, typename RiskParametersT,
@@ -249,6 +303,15 @@ public:
     riskManager.injectExposureChanges(exposureStore,meta,iter,end);
   }
 
+  /**
+   * @brief Receives every source's changes from ExposureManager::notifyOfChanges() in a single call
+   */
+  template <typename BatchT>
+  void exposureLevelsChanged(const BatchT& batch) noexcept
+  {
+    riskManager.injectExposureChanges(exposureStore,batch);
+  }
+
 private:
   RiskManagerT& riskManager;
   ExposureStoreT& exposureStore;
@@ -262,6 +325,19 @@ struct RiskModelInstanceMetadata {
   bool dirty = false;
   Date periodStart = Date{0};
   Date periodEnd = Date{0};
+  // The position of this instance's risk model within RiskModels, resolved from its AlgorithmId
+  std::size_t modelIndex = std::numeric_limits<std::size_t>::max();
+};
+
+/**
+ * @brief The risk model instance positions (and their instance IDs) whose scores depend upon exposures of one Agent
+ */
+template <std::size_t MaxSize>
+struct AgentDependents {
+  Agent agent = Agent{UUID::unknown()};
+  std::size_t count = 0;
+  std::array<std::size_t,MaxSize> positions = {};
+  std::array<std::optional<UUID>,MaxSize> instanceIds = {};
 };
 }
 
@@ -275,15 +351,37 @@ template <typename RiskModelsT, typename RiskParametersT,
 class RiskManager {
 public:
   static constexpr std::size_t max_size = MaxInMemoryRiskScoreSummaries;
+  /// \brief The number of distinct exposure Agents whose dependent risk models are cached.
+  /// \sa HERALD_RISK_DEPENDENCY_AGENTS_MAX
+  static constexpr std::size_t max_dependency_agents = HERALD_RISK_DEPENDENCY_AGENTS_MAX;
 
+  /// \brief Anchors periods on the system clock's time at construction. Prefer passing the Context's clock.
   RiskManager(RiskModelsT&& riskModelsToOwn, RiskParametersT&& riskParametersToOwn, RiskScoreStoreT& initialRiskScoreStore)
+   : RiskManager(std::move(riskModelsToOwn), std::move(riskParametersToOwn), initialRiskScoreStore, defaultClockSource<SystemClock>())
+  {
+    ;
+  }
+
+  /// \brief Anchors periods on clock's now() at construction. E.g. Context::getClock(), or a FakeClock
+  template <typename ClockT>
+  RiskManager(RiskModelsT&& riskModelsToOwn, RiskParametersT&& riskParametersToOwn, RiskScoreStoreT& initialRiskScoreStore, ClockT& clock)
    : models(std::move(riskModelsToOwn)),
      parameters(std::move(riskParametersToOwn)),
      store(initialRiskScoreStore),
-     anchor(Date{}), // Default to instantiation DateTime
+     anchor(clock.now()), // Default to instantiation DateTime
      period(TimeInterval::hours(24)), // Default to one day interval
     //  scores(),
-     instanceMetadata()
+     instanceMetadata(),
+     dependencies(),
+     dependencyCount(0),
+     exposureDependents(),
+     dependentsStoreSize(0),
+     mode(RiskRefreshExecution::serial)
+#ifdef HERALD_RISK_MANAGER_PARALLEL
+     ,
+     pool(nullptr),
+     buffers()
+#endif
   {
     // static asserts (if applicable)
     ;
@@ -307,6 +405,29 @@ public:
     return period;
   }
 
+  /// \brief Returns how refreshDirtyScores() runs the risk models
+  RiskRefreshExecution execution() const noexcept {
+    return mode;
+  }
+
+#ifdef HERALD_RISK_MANAGER_PARALLEL
+  /**
+   * @brief Selects how refreshDirtyScores() runs the risk models.
+   * 
+   * In parallel mode the models' produce() functions are called from several threads at once (for
+   * different model instances), so must not modify shared state. The exposure source passed to
+   * refreshDirtyScores() must support concurrent const access (E.g. FixedMemoryExposureStore or
+   * IndexedExposureStore). The RiskScoreStore is only written to from the calling thread.
+   * 
+   * @param newMode The execution mode
+   * @param refreshPool The threads to use in parallel mode. Must outlive this RiskManager, or the next call to execution().
+   */
+  void execution(RiskRefreshExecution newMode, RefreshPool* refreshPool = nullptr) noexcept {
+    mode = (RiskRefreshExecution::parallel == newMode && nullptr != refreshPool) ? newMode : RiskRefreshExecution::serial;
+    pool = refreshPool;
+  }
+#endif
+
   template <typename RiskModelT>
   bool addRiskModel(const UUID& riskModelInstanceId, const Agent& agent, const RiskModelT& modelRef) noexcept
   {
@@ -331,16 +452,29 @@ public:
         return false;
       }
       instanceMetadata[store.size() - 1] = RiskModelInstanceMetadata{}; // defaults (not dirty)
+      instanceMetadata[store.size() - 1].modelIndex = models.indexOf(modelRef.algorithmId);
+      clearDependents(); // the new model may depend upon any agent
     } else {
-      // Instance already exists
+      // Instance already exists (E.g. loaded from a file backed store)
       // update meta only
-      // None at the moment...
+      instanceMetadata[pos].modelIndex = models.indexOf(store.getTag(pos).algorithmId);
     }
     return true;
   }
 
   /// MARK: Event driven member functions
 
+  /**
+   * @brief Marks the risk models that depend upon the changed exposures as dirty, for refreshDirtyScores()
+   * 
+   * The exposures passed are those of a single source that have changed since the last notification.
+   * 
+   * Risk models that declare dependsOnAgentOnly (See herald::exposure::dependsOnAgentOnly()) are asked
+   * once per agent, with the first changed exposure, and the answer is cached until a risk model is
+   * added to or removed from the risk store. Those that depend upon the agent are marked over the whole
+   * changed period. Other risk models are asked about each changed exposure, and marked over the
+   * periods of those they depend upon.
+   */
   template <typename ExposureSrcT, typename IterT>
   void injectExposureChanges(
     const ExposureSrcT& src,
@@ -348,40 +482,90 @@ public:
     IterT& iter,
     IterT& end) noexcept
   {
+    if (iter == end) {
+      return;
+    }
+    const IterT changedBegin = iter;
+    const Exposure& first = *iter;
+    Date changedStart = first.periodStart;
+    Date changedEnd = first.periodEnd;
     for (; iter != end;++iter) {
-      auto& exposure = *iter;
-      // Find any matching algorithms for this exposure source
-      for (std::size_t pos = 0;pos < store.size();++pos) {
-        // Find linked model by algorithmId
-        const AlgorithmId& algorithmId = store.getTag(pos).algorithmId;
-        models.forMatchingAlgorithm([this, &pos, &meta, &exposure] (auto&& algo) {
-          if (algo.potentiallyDirty(meta.agentId, exposure)) {
-            // Mark each as dirty for this time period
-            if (instanceMetadata[pos].dirty) {
-              instanceMetadata[pos].periodStart = instanceMetadata[pos].periodStart < exposure.periodStart ? instanceMetadata[pos].periodStart : exposure.periodStart;
-              instanceMetadata[pos].periodEnd = instanceMetadata[pos].periodEnd > exposure.periodEnd ? instanceMetadata[pos].periodEnd : exposure.periodEnd;
-            } else {
-              instanceMetadata[pos].dirty = true;
-              instanceMetadata[pos].periodStart = exposure.periodStart;
-              instanceMetadata[pos].periodEnd = exposure.periodEnd;
-            }
-          }
-        }, algorithmId);
+      changedStart = iter->periodStart < changedStart ? iter->periodStart : changedStart;
+      changedEnd = iter->periodEnd > changedEnd ? iter->periodEnd : changedEnd;
+    }
+
+    if (store.size() != dependentsStoreSize) {
+      // Risk models were added to or removed from the store directly
+      clearDependents();
+    }
+    std::size_t dpos = findDependents(meta.agentId);
+    if (dependencyCount != dpos && !current(dependencies[dpos])) {
+      // Risk models have moved within the store
+      clearDependents();
+      dpos = 0;
+    }
+    if (dependencyCount == dpos) {
+      if (max_dependency_agents == dependencyCount) {
+        // Cache full - evaluate without caching
+        AgentDependents<max_size> uncached;
+        calculateDependents(meta.agentId, first, uncached);
+        markDirty(uncached, changedStart, changedEnd);
+      } else {
+        calculateDependents(meta.agentId, first, dependencies[dpos]);
+        ++dependencyCount;
+        markDirty(dependencies[dpos], changedStart, changedEnd);
+      }
+    } else {
+      markDirty(dependencies[dpos], changedStart, changedEnd);
+    }
+
+    for (std::size_t idx = 0;idx < exposureDependents.count;++idx) {
+      const std::size_t pos = exposureDependents.positions[idx];
+      for (IterT exposure = changedBegin; exposure != end;++exposure) {
+        bool dependent = false;
+        models.forModelAt(resolveModel(pos), [&meta, &exposure, &dependent] (auto&& algo) {
+          dependent = algo.potentiallyDirty(meta.agentId, *exposure);
+        });
+        if (dependent) {
+          markDirty(pos, exposure->periodStart, exposure->periodEnd);
+        }
       }
     }
   }
 
+  /**
+   * @brief Marks the risk models that depend upon any of a batch of changed exposures as dirty, for refreshDirtyScores()
+   * 
+   * The batch holds the changes of every source since the last notification (See ExposureChangeBatch).
+   * Each source's changes are handled as for injectExposureChanges(src,meta,iter,end).
+   */
+  template <typename ExposureSrcT, typename BatchT>
+  void injectExposureChanges(const ExposureSrcT& src, const BatchT& batch) noexcept
+  {
+    batch.forEach([this, &src] (const herald::datatype::ExposureMetadata& meta, auto& iter, auto& end) {
+      injectExposureChanges(src, meta, iter, end);
+    });
+  }
+
+  /**
+   * @brief Recalculates the risk scores of every model instance marked dirty by injectExposureChanges()
+   * 
+   * See execution() for running the models concurrently.
+   */
   template <typename ExposureSrcT>
   void refreshDirtyScores(const ExposureSrcT& src) {
+#ifdef HERALD_RISK_MANAGER_PARALLEL
+    if (RiskRefreshExecution::parallel == mode) {
+      refreshDirtyScoresParallel(src);
+      return;
+    }
+#endif
     // Now run through the relevant time period values, replacing the previous with the current values (or adding new ones)
     // Also Reset dirty flags
     for (std::size_t p = 0;p < store.size();++p) {
-      // Find linked model by algorithmId
-      const auto riskScoreMeta = store.getTag(p);
-      const AlgorithmId& algorithmId = riskScoreMeta.algorithmId;
-      bool ok = true;
       auto& instanceMetadataValue = instanceMetadata[p];
       if (instanceMetadataValue.dirty) { // prevent double/triple counting if algorithm has multiple variables
+        const auto riskScoreMeta = store.getTag(p);
         Date startTime{0};
         Date endTime{0};
         calculateOverlappingTimePeriod(
@@ -391,16 +575,7 @@ public:
         );
         // TODO consider adding an if for startTime != endTime to guard the below if there's no data (minor perf enhancement)
         WrappedRiskScoreStore rss{store,riskScoreMeta};
-        models.forMatchingAlgorithm([this, &src, &startTime, &endTime, &ok, &rss] (auto&& algo) {
-          ok = ok & algo.produce(
-            parameters,
-            src,
-            startTime,
-            endTime,
-            period, // TODO make this per risk score type, not global
-            rss // injects RiskScoreMetadata before invoking the underlying RiskStore
-          );
-        }, algorithmId);
+        produce(p, src, startTime, endTime, rss); // rss injects RiskScoreMetadata before invoking the underlying RiskStore
         instanceMetadataValue.dirty = false;
       }
     }
@@ -455,7 +630,170 @@ private:
   /// \brief In memory ephemeral cached RiskScores
   // RiskScoreSet<max_size> scores;
   std::array<RiskModelInstanceMetadata,max_size> instanceMetadata;
-  
+
+  /// \brief Cache of which dependsOnAgentOnly risk model instances depend upon each exposure Agent.
+  /// Reset when a model is added to or removed from the store.
+  std::array<AgentDependents<max_size>,max_dependency_agents> dependencies;
+  std::size_t dependencyCount;
+  /// \brief The risk model instances that are asked about each changed exposure (agent is unknown())
+  AgentDependents<max_size> exposureDependents;
+  /// \brief The store size when the caches were last reset
+  std::size_t dependentsStoreSize;
+
+  RiskRefreshExecution mode;
+#ifdef HERALD_RISK_MANAGER_PARALLEL
+  RefreshPool* pool;
+  /// \brief Scores produced by each dirty model instance in a parallel refresh. Reused to avoid reallocation.
+  std::array<std::vector<RiskScore>,max_size> buffers;
+
+  template <typename ExposureSrcT>
+  void refreshDirtyScoresParallel(const ExposureSrcT& src) {
+    // Decide what to calculate on this thread, as the store is not shared with the workers
+    struct DirtyInstance {
+      std::size_t pos = 0;
+      Date startTime = Date{0};
+      Date endTime = Date{0};
+    };
+    std::array<DirtyInstance,max_size> dirty;
+    std::size_t dirtyCount = 0;
+    for (std::size_t p = 0;p < store.size();++p) {
+      auto& instanceMetadataValue = instanceMetadata[p];
+      if (!instanceMetadataValue.dirty) {
+        continue;
+      }
+      auto& next = dirty[dirtyCount++];
+      next.pos = p;
+      calculateOverlappingTimePeriod(
+        instanceMetadataValue.periodStart, instanceMetadataValue.periodEnd,
+        store.getContents(p),
+        next.startTime, next.endTime
+      );
+      resolveModel(p); // not on the workers, as this writes instanceMetadata
+      instanceMetadataValue.dirty = false;
+    }
+
+    // Each instance writes only to its own buffer
+    auto work = [this, &src, &dirty] (std::size_t idx) {
+      auto& instance = dirty[idx];
+      buffers[idx].clear();
+      BufferedRiskScores sink{buffers[idx]};
+      produce(instance.pos, src, instance.startTime, instance.endTime, sink);
+    };
+    pool->run(dirtyCount, work);
+
+    // Merge in position order, so the store is the same as after a serial refresh
+    for (std::size_t idx = 0;idx < dirtyCount;++idx) {
+      const auto riskScoreMeta = store.getTag(dirty[idx].pos);
+      for (auto& score : buffers[idx]) {
+        store.score(riskScoreMeta, std::move(score));
+      }
+      buffers[idx].clear();
+    }
+  }
+#endif
+
+  /// \brief Returns the RiskModels position of the model instance at pos, resolving it if not already known
+  std::size_t resolveModel(std::size_t pos) noexcept {
+    auto& instance = instanceMetadata[pos];
+    if (std::numeric_limits<std::size_t>::max() == instance.modelIndex) {
+      instance.modelIndex = models.indexOf(store.getTag(pos).algorithmId);
+    }
+    return instance.modelIndex;
+  }
+
+  template <typename ExposureSrcT, typename RiskSinkT>
+  bool produce(std::size_t pos, const ExposureSrcT& src, const Date& startTime, const Date& endTime, RiskSinkT& sink) noexcept {
+    bool ok = true;
+    models.forModelAt(resolveModel(pos), [this, &src, &startTime, &endTime, &ok, &sink] (auto&& algo) {
+      ok = algo.produce(
+        parameters,
+        src,
+        startTime,
+        endTime,
+        period, // TODO make this per risk score type, not global
+        sink
+      );
+    });
+    return ok;
+  }
+
+  std::size_t findDependents(const Agent& agent) const noexcept {
+    for (std::size_t dpos = 0;dpos < dependencyCount;++dpos) {
+      if (dependencies[dpos].agent == agent) {
+        return dpos;
+      }
+    }
+    return dependencyCount;
+  }
+
+  /// \brief Empties the per agent cache, and finds the risk model instances that must be asked about each exposure instead
+  void clearDependents() noexcept {
+    dependencyCount = 0;
+    dependentsStoreSize = store.size();
+    exposureDependents.count = 0;
+    for (std::size_t pos = 0;pos < store.size();++pos) {
+      bool agentOnly = false;
+      models.forModelAt(resolveModel(pos), [&agentOnly] (auto&& algo) {
+        agentOnly = dependsOnAgentOnly<std::decay_t<decltype(algo)>>();
+      });
+      if (!agentOnly) {
+        addDependent(exposureDependents, pos);
+      }
+    }
+  }
+
+  /// \brief Whether each cached position still holds the same risk model instance
+  bool current(const AgentDependents<max_size>& dependents) const noexcept {
+    for (std::size_t idx = 0;idx < dependents.count;++idx) {
+      const std::size_t pos = dependents.positions[idx];
+      if (pos >= store.size() || store.getTag(pos).instanceId != *dependents.instanceIds[idx]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void addDependent(AgentDependents<max_size>& dependents, std::size_t pos) noexcept {
+    dependents.positions[dependents.count] = pos;
+    dependents.instanceIds[dependents.count].emplace(store.getTag(pos).instanceId);
+    ++dependents.count;
+  }
+
+  void calculateDependents(const Agent& agent, const Exposure& exposure, AgentDependents<max_size>& dependents) noexcept {
+    dependents.agent = agent;
+    dependents.count = 0;
+    for (std::size_t pos = 0;pos < store.size();++pos) {
+      bool dependent = false;
+      models.forModelAt(resolveModel(pos), [&agent, &exposure, &dependent] (auto&& algo) {
+        if constexpr (dependsOnAgentOnly<std::decay_t<decltype(algo)>>()) {
+          dependent = algo.potentiallyDirty(agent, exposure);
+        }
+      });
+      if (dependent) {
+        addDependent(dependents, pos);
+      }
+    }
+  }
+
+  void markDirty(const AgentDependents<max_size>& dependents, const Date& periodStart, const Date& periodEnd) noexcept {
+    for (std::size_t idx = 0;idx < dependents.count;++idx) {
+      markDirty(dependents.positions[idx], periodStart, periodEnd);
+    }
+  }
+
+  void markDirty(std::size_t pos, const Date& periodStart, const Date& periodEnd) noexcept {
+    auto& instance = instanceMetadata[pos];
+    // Mark as dirty for this time period
+    if (instance.dirty) {
+      instance.periodStart = instance.periodStart < periodStart ? instance.periodStart : periodStart;
+      instance.periodEnd = instance.periodEnd > periodEnd ? instance.periodEnd : periodEnd;
+    } else {
+      instance.dirty = true;
+      instance.periodStart = periodStart;
+      instance.periodEnd = periodEnd;
+    }
+  }
+
   template <typename RiskScoreArrayT>
   void calculateOverlappingTimePeriod(
     const Date& periodStart, const Date& periodEnd,
@@ -487,6 +825,10 @@ template <typename RiskModelsT, typename RiskParametersT, std::size_t MaxSize =
 explicit RiskManager(RiskModelsT&&,RiskParametersT&&,RiskScoreStoreT&) -> 
   RiskManager<RiskModelsT,RiskParametersT,MaxSize,RiskScoreStoreT>;
 
+template <typename RiskModelsT, typename RiskParametersT, std::size_t MaxSize = 8, typename RiskScoreStoreT, typename ClockT>
+explicit RiskManager(RiskModelsT&&,RiskParametersT&&,RiskScoreStoreT&,ClockT&) -> 
+  RiskManager<RiskModelsT,RiskParametersT,MaxSize,RiskScoreStoreT>;
+
 
 
 }
@@ -0,0 +1,94 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef HERALD_SIMPLE_CONTACT_IDENTIFIER_MATCHER_H
+#define HERALD_SIMPLE_CONTACT_IDENTIFIER_MATCHER_H
+
+#include "secret_key.h"
+#include "contact_identifier.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace herald {
+namespace payload {
+namespace simple {
+
+using namespace herald::datatype;
+
+/// \brief Server side matching of observed contact identifiers against published secret keys
+///
+/// build() expands every secret key into all of its contact identifiers over a range of days,
+/// deriving the same values as K::contactIdentifier but for many keys at once. Keys are
+/// hashed in lockstep with SHA256::digestBatch, and the work is shared over several threads.
+/// The identifiers are held in a table sorted by identifier and bucketed on the first byte.
+/// match() then looks up bulk observations in the table, also spread over the threads.
+///
+/// All working memory is heap allocated rather than taken from the Data memory arena, so the
+/// arena (which is not thread safe) is never touched from a worker thread.
+/// Only built for host (non embedded) platforms - see HERALD_SOURCES_SERVER.
+class ContactIdentifierMatcher {
+public:
+  static constexpr std::size_t IdentifierLength = 16;
+  using Identifier = std::array<std::uint8_t,IdentifierLength>;
+
+  /// \brief An observed identifier found in the table
+  struct Match {
+    std::size_t observation; // index into the observed identifiers
+    std::size_t key; // index into the secret keys given to build()
+    int day;
+    int period;
+  };
+
+  /// \brief daysFor and periodsInDay must equal those of the K instance the keys were used with.
+  /// A threads value of 0 uses every hardware thread.
+  ContactIdentifierMatcher(int daysFor = 2000, int periodsInDay = 240, unsigned int threads = 0) noexcept;
+  ~ContactIdentifierMatcher() noexcept = default;
+
+  /// \brief Replaces the table with the identifiers of keyCount secret keys, each keyLength
+  /// bytes and stored back to back in keys, for every period of days fromDay to toDay inclusive
+  void build(const std::uint8_t* keys, std::size_t keyLength, std::size_t keyCount, int fromDay, int toDay);
+  /// \brief As above, for secret keys held as Data. All keys must be the same length.
+  void build(const std::vector<SecretKey>& keys, int fromDay, int toDay);
+
+  /// \brief Number of identifiers in the table
+  std::size_t size() const noexcept;
+  /// \brief Number of worker threads used by build() and match()
+  unsigned int threads() const noexcept;
+
+  /// \brief Returns a match for every observed identifier present in the table, ordered by observation
+  std::vector<Match> match(const std::vector<Identifier>& observed) const;
+  /// \brief As above, for identifiers held as Data (as decoded from a simple payload)
+  std::vector<Match> match(const std::vector<ContactIdentifier>& observed) const;
+
+  /// \brief Copies the first IdentifierLength bytes of a ContactIdentifier (zero padded)
+  static Identifier toIdentifier(const ContactIdentifier& identifier) noexcept;
+
+private:
+  struct Entry {
+    Identifier identifier;
+    std::uint32_t key;
+    std::uint16_t day;
+    std::uint16_t period;
+  };
+
+  void expand(const std::uint8_t* keys, std::size_t keyLength, std::size_t firstKey,
+    std::size_t keyCount, int fromDay, int toDay, std::vector<Entry>& into) const;
+  void lookup(const std::vector<Identifier>& observed, std::size_t from, std::size_t to,
+    std::vector<Match>& into) const;
+
+  int daysFor;
+  int periodsInDay;
+  unsigned int threadCount;
+  std::vector<Entry> entries; // sorted by identifier
+  std::array<std::size_t,257> buckets; // entries[buckets[b]..buckets[b + 1]) have first byte b
+};
+
+}
+}
+}
+
+#endif
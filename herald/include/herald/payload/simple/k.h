@@ -12,12 +12,50 @@
 #include "../../datatype/data.h"
 #include "../../datatype/time_interval.h"
 
+#include <array>
+#include <cstdint>
+#include <vector>
+
 namespace herald {
 namespace payload {
 namespace simple {
 
 using namespace herald::datatype;
 
+/// \brief A reverse hash chain (seed[i] = h(t(seed[i + 1]))) with seeds checkpointed at a fixed interval
+///
+/// Once the checkpoints above an index have been filled, the seed at that index is derived
+/// in fewer than interval hashes rather than (top - index) hashes. The most recently derived
+/// seed is also remembered so that walking down the chain costs one hash per step.
+/// Checkpoints are held outside of the Data memory arena.
+class KeyChainCache {
+public:
+  using SeedBytes = std::array<std::uint8_t,32>;
+
+  explicit KeyChainCache(int interval) noexcept;
+  KeyChainCache(const KeyChainCache& other) = default;
+  ~KeyChainCache() noexcept = default;
+
+  /// \brief Whether this chain currently holds the chain starting from topSeed
+  bool matches(const Data& topSeed) const noexcept;
+  /// \brief Restarts the chain with topSeed as the seed at index top
+  void reset(const Data& topSeed, int top);
+  /// \brief Discards all cached seeds
+  void clear() noexcept;
+  /// \brief Returns the seed at index. Indexes above top return the top seed (as the uncached loop did).
+  Data seed(int index);
+  /// \brief Returns the number of checkpoints currently filled
+  std::size_t checkpoints() const noexcept;
+
+private:
+  int interval;
+  int top;
+  std::vector<SeedBytes> checkpointSeeds; // checkpointSeeds[c] is the seed at top - (c * interval)
+  bool hasLast;
+  int lastIndex;
+  SeedBytes last;
+};
+
 class K {
 public:
   K() noexcept;
@@ -25,8 +63,15 @@ public:
   K(K&&) = delete;
   K(int keyLength, int daysFor, int periodsInDay) noexcept;
   K(int keyLength, int daysFor, int periodsInDay, TimeInterval epochBeginning) noexcept;
+  /// \brief Specifies how many days (and periods) apart the cached key chain seeds are.
+  /// Larger intervals use less memory at the cost of more hashes per key change.
+  K(int keyLength, int daysFor, int periodsInDay, TimeInterval epochBeginning,
+    int dayCheckpointInterval, int periodCheckpointInterval) noexcept;
   ~K() noexcept;
 
+  static constexpr int DefaultDayCheckpointInterval = 64;
+  static constexpr int DefaultPeriodCheckpointInterval = 16;
+
   static TimeInterval getEpoch() noexcept;
 
   int day(Date on) const noexcept;
@@ -53,6 +98,15 @@ private:
   const int daysFor;
   const int periodsInDay;
   const TimeInterval epoch;
+
+  /// \brief Ensures the caches refer to secretKey, discarding them if the key has changed
+  void validateCache(const SecretKey& secretKey);
+
+  KeyChainCache matchingKeySeeds;
+  KeyChainCache contactKeySeeds; // for the day of the memoised matching key
+  bool hasMatchingKey;
+  int matchingKeyDay;
+  KeyChainCache::SeedBytes matchingKeyBytes; // memoised matching key for matchingKeyDay
 };
 
 }
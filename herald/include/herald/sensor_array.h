@@ -31,6 +31,22 @@ using namespace datatype;
 using namespace payload;
 using namespace engine;
 
+constexpr auto hasFlushFunction = herald::util::isValid(
+  [](auto&& s) -> decltype(((decltype(s))s).get().flush()) {}
+);
+template<typename T>
+using HasFlushFunctionT = decltype(hasFlushFunction(std::declval<T>()));
+template<typename T>
+constexpr auto HasFlushFunctionV = HasFlushFunctionT<T>::value;
+
+constexpr auto hasProcessAdvertsFunction = herald::util::isValid(
+  [](auto&& s) -> decltype(((decltype(s))s).get().processAdverts()) {}
+);
+template<typename T>
+using HasProcessAdvertsFunctionT = decltype(hasProcessAdvertsFunction(std::declval<T>()));
+template<typename T>
+constexpr auto HasProcessAdvertsFunctionV = HasProcessAdvertsFunctionT<T>::value;
+
 /// \brief Manages all Sensors and sensor delegates for Herald
 ///
 /// This is the Core logic and runtime class for all of Herald.
@@ -118,7 +134,24 @@ public:
   /// \brief Scheduling activities from external OS thread wakes - Since v1.2-beta3
   void iteration(const TimeInterval sinceLastCompleted) {
     // TODO ensure this works for continuous evaluation with minimal overhead or battery
+    mContext.getClock().refresh(); // one clock read per iteration, shared by all components via getNow()
+    for (auto& sensor: mSensorArray) {
+      std::visit([](auto&& arg) {
+        // Ingest adverts queued since the last iteration, even if the coordinator is busy this time
+        if constexpr (HasProcessAdvertsFunctionV<decltype(arg)>) {
+          ((decltype(arg))arg).get().processAdverts();
+        }
+      }, sensor);
+    }
     engine.iteration();
+    for (auto& sensor: mSensorArray) {
+      std::visit([](auto&& arg) {
+        // Deliver any events the sensor batched during the iteration
+        if constexpr (HasFlushFunctionV<decltype(arg)>) {
+          ((decltype(arg))arg).get().flush();
+        }
+      }, sensor);
+    }
   }
 
 private:
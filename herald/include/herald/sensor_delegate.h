@@ -14,8 +14,9 @@
 #include "datatype/sensor_state.h"
 #include "util/is_valid.h"
 
-#include <variant>
-#include <array>
+#include <cstddef>
+#include <functional>
+#include <tuple>
 
 namespace herald {
   
@@ -55,8 +56,8 @@ using namespace datatype;
 // };
 
 constexpr auto hasSensorFunction = herald::util::isValid(
-  [](auto&& s,auto&& sensor,auto&& didRead,auto&& fromTarget) ->
-    decltype(((decltype(s))s).get().sensor(sensor,didRead,fromTarget)) {}
+  [](auto&& s,auto&&... args) ->
+    decltype(((decltype(s))s).get().sensor(args...)) {}
 );
 // template<typename T,typename SE, typename DR, typename FT>
 // using HasSensorFunctionT = decltype(hasSensorFunction(std::declval<T>(),std::declval<SE>(),std::declval<DR>(),std::declval<FT>()));
@@ -65,152 +66,161 @@ using HasSensorFunctionT = decltype(hasSensorFunction(std::declval<T>(),std::dec
 template<typename T,typename... Args>
 constexpr auto HasSensorFunctionV = HasSensorFunctionT<T,Args...>::value;
 
-/// \brief A set of variant typed Sensor Delegate instances. Delegate callbacks can be invoked on the whole set, if supported by each.
+/// \brief One proximity measurement within a batch. See ProximityUpdates.
+///
+/// Refers to the identifier and payload held by the sensor (E.g. in the BLEDatabase),
+/// which are valid only for the duration of the callback. withPayload is empty
+/// if no payload has been read from the target yet.
+struct ProximityUpdate {
+  const TargetIdentifier* fromTarget;
+  Proximity didMeasure;
+  const PayloadData* withPayload;
+};
+
+/// \brief A contiguous range of ProximityUpdate, as delivered to delegates that opt in to batched events
+class ProximityUpdates {
+public:
+  ProximityUpdates(const ProximityUpdate* first, std::size_t count) noexcept
+    : first(first), count(count)
+  {
+    ;
+  }
+  ~ProximityUpdates() noexcept = default;
+
+  const ProximityUpdate* begin() const noexcept {
+    return first;
+  }
+
+  const ProximityUpdate* end() const noexcept {
+    return first + count;
+  }
+
+  std::size_t size() const noexcept {
+    return count;
+  }
+
+  bool empty() const noexcept {
+    return 0 == count;
+  }
+
+  const ProximityUpdate& operator[](std::size_t index) const noexcept {
+    return first[index];
+  }
+
+private:
+  const ProximityUpdate* first;
+  std::size_t count;
+};
+
+/// \brief A set of Sensor Delegate instances. Delegate callbacks can be invoked on the whole set, if supported by each.
+///
+/// Delegates are held as a tuple of references and each callback is expanded at compile time
+/// in to a direct call on each delegate that implements it. Delegates that do not implement a
+/// callback cost nothing for it.
+///
+/// Delegates may opt in to receiving proximity measurements in bulk by implementing
+/// sensor(SensorType, const ProximityUpdates&). If any delegate does, batchesProximity
+/// is true and sensors may call that method once per iteration rather than calling
+/// the single measurement methods per measurement. Delegates in the set that do not
+/// implement it receive the equivalent single measurement calls.
 template <typename... SensorDelegateTs>
 class SensorDelegateSet {
 public:
   static constexpr std::size_t Size = sizeof...(SensorDelegateTs);
 
-  SensorDelegateSet(SensorDelegateTs&... dels) noexcept : 
-    //delegates({std::variant<std::reference_wrapper<SensorDelegateTs&...>>(std::reference_wrapper<SensorDelegateTs&...>(dels...))}) {
-    // delegates(std::experimental::make_array({std::reference_wrapper<SensorDelegateTs&...>(dels...)})) {
-    delegates(std::array<
-      std::variant<std::reference_wrapper<SensorDelegateTs>...>
-      ,Size
-    >({std::variant<std::reference_wrapper<SensorDelegateTs>...>(dels)...})) {
-    // addDelegates(0,dels...);
+  /// \brief True if any delegate implements the batched proximity callback
+  static constexpr bool batchesProximity =
+    (HasSensorFunctionV<std::reference_wrapper<SensorDelegateTs>,SensorType,const ProximityUpdates&> || ...);
+
+  SensorDelegateSet(SensorDelegateTs&... dels) noexcept
+    : delegates(dels...)
+  {
+    ;
   }
   ~SensorDelegateSet() noexcept = default;
 
-  // auto begin() -> decltype(std::declval<std::array<
-  //     std::variant<std::reference_wrapper<SensorDelegateTs>...>
-  //     ,Size
-  //   >>().begin()) {
-  //   return delegates.begin();
-  // }
-
-  // auto end() -> decltype(std::declval<std::array<
-  //     std::variant<std::reference_wrapper<SensorDelegateTs>...>
-  //     ,Size
-  //   >>().end()) {
-  //   return delegates.end();
-  // }
-
   /// \brief Detection of a target with an ephemeral identifier, e.g. BLE central detecting a BLE peripheral.
   void sensor(SensorType sensor, const TargetIdentifier& didDetect) noexcept {
-        for (auto& delegateV : delegates) {
-      std::visit([sensor,didDetect](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didDetect)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didDetect); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didDetect);
   }
 
   /// \brief Read payload data from target, e.g. encrypted device identifier from BLE peripheral after successful connection.
   void sensor(SensorType sensor, const PayloadData& didRead, const TargetIdentifier& fromTarget) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didRead,fromTarget](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didRead),decltype(fromTarget)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didRead,fromTarget); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didRead,fromTarget);
   }
 
   /// \brief Receive written immediate send data from target, e.g. important timing signal.
   void sensor(SensorType sensor, const ImmediateSendData& didReceive, const TargetIdentifier& fromTarget) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didReceive,fromTarget](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didReceive),decltype(fromTarget)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didReceive,fromTarget); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didReceive,fromTarget);
   }
 
   /// \brief Read payload data of other targets recently acquired by a target, e.g. Android peripheral sharing payload data acquired from nearby iOS peripherals.
   void sensor(SensorType sensor, const DataSections<8>& didShare, const TargetIdentifier& fromTarget) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didShare,fromTarget](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didShare),decltype(fromTarget)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didShare,fromTarget); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didShare,fromTarget);
   }
 
   /// \brief Measure proximity to target, e.g. a sample of RSSI values from BLE peripheral.
   void sensor(SensorType sensor, const Proximity& didMeasure, const TargetIdentifier& fromTarget) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didMeasure,fromTarget](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didMeasure),decltype(fromTarget)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didMeasure,fromTarget); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didMeasure,fromTarget);
   }
 
   /// \brief Detection of time spent at location, e.g. at specific restaurant between 02/06/2020 19:00 and 02/06/2020 21:00
   template <typename LocationT>
   void sensor(SensorType sensor, const Location<LocationT>& didVisit) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didVisit](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didVisit)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didVisit); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didVisit);
   }
 
   /// \brief Measure proximity to target with payload data. Combines didMeasure and didRead into a single convenient delegate method
   void sensor(SensorType sensor, const Proximity& didMeasure, const TargetIdentifier& fromTarget, const PayloadData& withPayload) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didMeasure,fromTarget,withPayload](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didMeasure),decltype(fromTarget),decltype(withPayload)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didMeasure,fromTarget,withPayload); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didMeasure,fromTarget,withPayload);
+  }
+
+  /// \brief Several proximity measurements, E.g. all RSSI values received in one iteration.
+  ///
+  /// Equivalent to the didMeasure callback for each update, followed by the didMeasure withPayload
+  /// callback where the payload is known, for delegates that do not implement the batched callback.
+  void sensor(SensorType sensor, const ProximityUpdates& didMeasure) noexcept {
+    std::apply([sensor,&didMeasure](auto&... dels) {
+      (measureAll(dels,sensor,didMeasure), ...);
+    }, delegates);
   }
 
   /// \brief Sensor state update
   void sensor(SensorType sensor, const SensorState& didUpdateState) noexcept {
-    for (auto& delegateV : delegates) {
-      std::visit([sensor,didUpdateState](auto&& arg) {
-        // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
-        if constexpr (HasSensorFunctionV<decltype(arg),decltype(sensor),decltype(didUpdateState)>) {
-          ((decltype(arg))arg).get().sensor(sensor,didUpdateState); // cast to call derived class function
-        }
-      }, delegateV);
-    }
+    invoke(sensor,didUpdateState);
   }
 
 private:
-  std::array<
-    std::variant<std::reference_wrapper<SensorDelegateTs>...>
-    ,
-    Size
-  > delegates;
-
-  // template <typename LastT>
-  // constexpr void addDelegates(int nextPos,LastT& last) {
-  //   delegates[nextPos] = std::reference_wrapper<LastT>(last);
-  // }
-
-  // template <typename FirstT, typename SecondT, typename... RestT>
-  // constexpr void addDelegates(int nextPos,FirstT& first, SecondT& second, RestT&... rest) {
-  //   delegates[nextPos] = std::reference_wrapper<FirstT>(first);
-  //   ++nextPos;
-  //   addDelegates(nextPos,second,rest...);
-  // }
+  std::tuple<SensorDelegateTs&...> delegates;
+
+  template <typename... ArgTs>
+  void invoke(SensorType sensor, const ArgTs&... args) noexcept {
+    std::apply([sensor,&args...](auto&... dels) {
+      (invokeOne(dels,sensor,args...), ...);
+    }, delegates);
+  }
+
+  template <typename DelegateT, typename... ArgTs>
+  static void invokeOne(DelegateT& delegate, SensorType sensor, const ArgTs&... args) noexcept {
+    // ONLY INVOKE IF WE KNOW THIS FUNCTION EXISTS
+    if constexpr (HasSensorFunctionV<std::reference_wrapper<DelegateT>,SensorType,const ArgTs&...>) {
+      delegate.sensor(sensor,args...);
+    }
+  }
+
+  template <typename DelegateT>
+  static void measureAll(DelegateT& delegate, SensorType sensor, const ProximityUpdates& didMeasure) noexcept {
+    if constexpr (HasSensorFunctionV<std::reference_wrapper<DelegateT>,SensorType,const ProximityUpdates&>) {
+      delegate.sensor(sensor,didMeasure);
+    } else {
+      for (const auto& update : didMeasure) {
+        invokeOne(delegate,sensor,update.didMeasure,*update.fromTarget);
+        if (update.withPayload->size() > 0) {
+          invokeOne(delegate,sensor,update.didMeasure,*update.fromTarget,*update.withPayload);
+        }
+      }
+    }
+  }
 };
 
 
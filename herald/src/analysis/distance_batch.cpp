@@ -0,0 +1,226 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/analysis/distance_batch.h"
+#include "herald/analysis/distance_conversion.h"
+
+#include <array>
+#include <cmath>
+
+// Multi-source summaries use GCC/Clang vector extensions, with one source per double lane.
+// Only the accumulation is vectorised. Values are gathered into lanes one at a time.
+// On x86-64 Linux (GCC) the lane function is also cloned for AVX2 and picked at load time.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HERALD_FOWLER_MULTISOURCE 1
+#if defined(__linux__) && !defined(__clang__)
+#define HERALD_FOWLER_LANE_TARGETS __attribute__((target_clones("avx2","default")))
+#else
+#define HERALD_FOWLER_LANE_TARGETS
+#endif
+#if !defined(__clang__)
+// Vectors never cross a call boundary other than by pointer
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+#endif
+
+namespace herald {
+namespace analysis {
+namespace algorithms {
+namespace distance {
+
+namespace {
+
+constexpr int MinValid = -99; // as FowlerBasicAnalyser
+constexpr int MaxValid = -10;
+constexpr std::size_t Bins = MaxValid - MinValid + 1;
+
+bool isValid(std::int8_t value) noexcept {
+  return value >= MinValid && value <= MaxValid;
+}
+
+/// Count, mean and sample variance of a source's new valid values, as summarise<Count,Variance>
+struct Summary {
+  double count;
+  double variance;
+};
+
+Summary summariseOne(const std::int8_t* values, std::size_t from, std::size_t to) noexcept {
+  double sum = 0.0;
+  int count = 0;
+  for (std::size_t idx = from;idx < to;++idx) {
+    if (isValid(values[idx])) {
+      sum += double(values[idx]);
+      ++count;
+    }
+  }
+  const double mean = sum / count;
+  double squares = 0.0;
+  for (std::size_t idx = from;idx < to;++idx) {
+    if (isValid(values[idx])) {
+      const double dv = double(values[idx]);
+      squares += (dv - mean)*(dv - mean);
+    }
+  }
+  return Summary{double(count), count < 1 ? 0.0 : squares / (count - 1)};
+}
+
+#ifdef HERALD_FOWLER_MULTISOURCE
+typedef double Lanes __attribute__((vector_size(32)));
+constexpr std::size_t LaneCount = sizeof(Lanes) / sizeof(double);
+
+/// Summarises LaneCount sources together, one per vector lane. Invalid and padding values
+/// are weighted 0, so each lane adds exactly what summariseOne adds, in the same order.
+HERALD_FOWLER_LANE_TARGETS
+void summariseLanes(const std::int8_t* const* values, const std::size_t* lengths,
+  Summary* into) noexcept
+{
+  std::size_t longest = 0;
+  for (std::size_t lane = 0;lane < LaneCount;++lane) {
+    longest = lengths[lane] > longest ? lengths[lane] : longest;
+  }
+  // Gather each lane's next valid value, so lanes only step when they have one
+  std::array<std::size_t,LaneCount> position;
+  auto gather = [&](Lanes& value, Lanes& weight) {
+    for (std::size_t lane = 0;lane < LaneCount;++lane) {
+      while (position[lane] < lengths[lane] && !isValid(values[lane][position[lane]])) {
+        ++position[lane];
+      }
+      if (position[lane] < lengths[lane]) {
+        value[lane] = double(values[lane][position[lane]++]);
+        weight[lane] = 1.0;
+      } else {
+        value[lane] = 0.0;
+        weight[lane] = 0.0;
+      }
+    }
+  };
+
+  Lanes sum = Lanes() + 0.0;
+  Lanes count = Lanes() + 0.0;
+  Lanes value, weight;
+  position.fill(0);
+  for (std::size_t step = 0;step < longest;++step) {
+    gather(value, weight);
+    sum += value * weight;
+    count += weight;
+  }
+  const Lanes mean = sum / count;
+  Lanes squares = Lanes() + 0.0;
+  position.fill(0);
+  for (std::size_t step = 0;step < longest;++step) {
+    gather(value, weight);
+    const Lanes deviation = value - mean;
+    squares += deviation * deviation * weight;
+  }
+  const Lanes variance = squares / (count - 1.0);
+  for (std::size_t lane = 0;lane < LaneCount;++lane) {
+    into[lane] = Summary{count[lane], count[lane] < 1.0 ? 0.0 : variance[lane]};
+  }
+}
+#endif
+
+/// The mode of histogram counts for values within [min,max], as Mode and WindowedMode
+double modeOf(const std::array<int,Bins>& counts, double min, double max) noexcept {
+  double largest = 0;
+  int largestCount = 0;
+  for (std::size_t bin = 0;bin < Bins;++bin) {
+    const double value = double(MinValid + int(bin));
+    if (counts[bin] > largestCount && value >= min && value <= max) {
+      largestCount = counts[bin];
+      largest = value;
+    }
+  }
+  return largest;
+}
+
+}
+
+FowlerBatch::FowlerBatch(double intercept, double coefficient) noexcept
+  : intercept(intercept),
+    coefficient(coefficient),
+    values(),
+    windows()
+{
+  ;
+}
+
+void
+FowlerBatch::add(const std::int8_t* rssi, std::size_t length, std::size_t newFrom)
+{
+  const std::size_t offset = values.size();
+  values.insert(values.end(), rssi, rssi + length);
+  windows.push_back(Window{offset, length, newFrom < length ? newFrom : length});
+}
+
+void
+FowlerBatch::clear() noexcept
+{
+  values.clear();
+  windows.clear();
+}
+
+std::size_t
+FowlerBatch::size() const noexcept
+{
+  return windows.size();
+}
+
+void
+FowlerBatch::estimate(std::vector<FowlerEstimate>& into) const
+{
+  const std::size_t sources = windows.size();
+  std::vector<Summary> summaries(sources);
+  std::size_t index = 0;
+#ifdef HERALD_FOWLER_MULTISOURCE
+  const std::int8_t* laneValues[LaneCount];
+  std::size_t laneLengths[LaneCount];
+  for (;index + LaneCount <= sources;index += LaneCount) {
+    for (std::size_t lane = 0;lane < LaneCount;++lane) {
+      const Window& window = windows[index + lane];
+      laneValues[lane] = values.data() + window.offset + window.newFrom;
+      laneLengths[lane] = window.length - window.newFrom;
+    }
+    summariseLanes(laneValues, laneLengths, &summaries[index]);
+  }
+#endif
+  for (;index < sources;++index) {
+    const Window& window = windows[index];
+    summaries[index] = summariseOne(values.data() + window.offset, window.newFrom, window.length);
+  }
+
+  const FowlerBasic basic(intercept, coefficient);
+  std::array<int,Bins> newCounts;
+  std::array<int,Bins> allCounts;
+  into.resize(sources);
+  for (std::size_t source = 0;source < sources;++source) {
+    const Window& window = windows[source];
+    const Summary& summary = summaries[source];
+    if (0.0 == summary.count) {
+      into[source] = FowlerEstimate{false, 0.0};
+      continue;
+    }
+    newCounts.fill(0);
+    allCounts.fill(0);
+    const std::int8_t* rssi = values.data() + window.offset;
+    for (std::size_t idx = 0;idx < window.length;++idx) {
+      if (isValid(rssi[idx])) {
+        const std::size_t bin = std::size_t(rssi[idx] - MinValid);
+        ++allCounts[bin];
+        if (idx >= window.newFrom) {
+          ++newCounts[bin];
+        }
+      }
+    }
+    const double mode = modeOf(newCounts, MinValid, MaxValid);
+    const double sd = std::sqrt(summary.variance);
+    // NaN bounds (a single new value) select nothing, as in_range does
+    const double selected = modeOf(allCounts, mode - 2*sd, mode + 2*sd);
+    into[source] = FowlerEstimate{true, basic.fromMode(selected)};
+  }
+}
+
+}
+}
+}
+}
@@ -447,12 +447,21 @@ BLEDevice::BLEDevice(const BLEDevice& other)
 
 BLEDevice::~BLEDevice() = default;
 
+Date
+BLEDevice::now() const noexcept
+{
+  if (delegate.has_value()) {
+    return delegate->get().now();
+  }
+  return Date();
+}
+
 void
 BLEDevice::reset(const TargetIdentifier& newID, BLEDeviceDelegate& newDelegate)
 {
   delegate.emplace(std::reference_wrapper<BLEDeviceDelegate>(newDelegate));
   id = newID;
-  lastUpdated.setToNow();
+  lastUpdated = now();
   stateData = DiscoveredState();
   flags.reset();
   flags.internalState(BLEInternalState::discovered);
@@ -519,13 +528,19 @@ BLEDevice::operator std::string() const
 }
 
 // timing related getters
+const Date&
+BLEDevice::lastUpdatedAt() const noexcept
+{
+  return lastUpdated;
+}
+
 TimeInterval
 BLEDevice::timeIntervalSinceLastUpdate() const
 {
   // if (std::monostate == stateData) {
   //   return TimeInterval::zero();
   // }
-  return TimeInterval(lastUpdated, Date());;
+  return TimeInterval(lastUpdated, now());
   // if (!lastUpdated.has_value()) {
   //   return TimeInterval::zero(); // default to new, just seen rather than 'no activity'
   // }
@@ -550,7 +565,7 @@ BLEDevice::timeIntervalSinceLastPayloadDataUpdate() const
   if (BLEInternalState::identified != flags.internalState()) {
     return TimeInterval::never();
   }
-  return TimeInterval(std::get<RelevantState>(stateData).payloadUpdated,Date());
+  return TimeInterval(std::get<RelevantState>(stateData).payloadUpdated,now());
 }
 
 // TimeInterval
@@ -595,7 +610,7 @@ BLEDevice::timeIntervalUntilIgnoreExpired() const
   if (ignoreUntil == TimeInterval::never()) {
     return TimeInterval::never(); // Always ignore
   }
-  return TimeInterval(Date(),ignoreUntil);
+  return TimeInterval(now(),ignoreUntil);
 }
 
 // property getters and setters
@@ -626,7 +641,7 @@ BLEDevice::pseudoDeviceAddress(BLEMacAddress newAddress)
   const auto pa = pseudoDeviceAddress();
   if (!pa.has_value() || pa.value() != newAddress) {
     std::get<RelevantState>(stateData).pseudoAddress = newAddress;
-    lastUpdated.setToNow(); // Constructs Date as now
+    lastUpdated = now();
   }
 }
 
@@ -673,7 +688,7 @@ BLEDevice::state(BLEDeviceState newState)
   bool changed = curState != newState;
   if (changed) {
     flags.state(newState);
-    lastUpdated = Date(); // Constructs Date as now
+    lastUpdated = now();
     if (delegate.has_value()) {
       delegate->get().device(*this, BLEDeviceAttribute::state);
     }
@@ -721,7 +736,7 @@ BLEDevice::operatingSystem(BLEDeviceOperatingSystem newOS)
   }
   auto& rs = std::get<RelevantState>(stateData);
 
-  lastUpdated.setToNow();
+  lastUpdated = now();
   const auto os = operatingSystem();
   if (os != BLEDeviceOperatingSystem::unknown && os == BLEDeviceOperatingSystem::ignore) {
     if (TimeInterval::zero() == rs.ignoreForDuration) {
@@ -751,7 +766,7 @@ BLEDevice::operatingSystem(BLEDeviceOperatingSystem newOS)
   }
 }
 
-PayloadData
+const PayloadData&
 BLEDevice::payloadData() const
 {
   return payload;
@@ -767,9 +782,12 @@ BLEDevice::payloadData(PayloadData newPayloadData)
   }
   bool changed = payload.size() == 0 || payload != newPayloadData;
   if (changed) {
+    if (delegate.has_value()) {
+      delegate.value().get().deviceWillUpdate(*this, BLEDeviceAttribute::payloadData);
+    }
     payload = newPayloadData;
-    lastUpdated.setToNow(); // Constructs Date as now
-    std::get<RelevantState>(stateData).payloadUpdated.setToNow();
+    lastUpdated = now();
+    std::get<RelevantState>(stateData).payloadUpdated = lastUpdated;
     // payloadUpdated.emplace();
     if (delegate.has_value()) {
       delegate.value().get().device(*this, BLEDeviceAttribute::payloadData);
@@ -850,7 +868,7 @@ BLEDevice::txPower(BLETxPower newPower)
   bool changed = rs.txPower != newPower;
   if (changed) {
     rs.txPower = newPower;
-    lastUpdated.setToNow();
+    lastUpdated = now();
     delegate->get().device(*this, BLEDeviceAttribute::txPower);
   }
 }
@@ -892,7 +910,7 @@ BLEDevice::signalCharacteristic(UUID newChar)
   } else {
     flags.signalCharacteristic(false);
   }
-  lastUpdated.setToNow();
+  lastUpdated = now();
 }
 
 std::optional<UUID>
@@ -910,7 +928,7 @@ BLEDevice::payloadCharacteristic(UUID newChar)
   if (conf.payloadCharacteristicUUID == newChar) {
     flags.hasPayloadCharacteristic(true);
   }
-  lastUpdated.setToNow();
+  lastUpdated = now();
 }
 
 // State engine methods
@@ -931,7 +949,7 @@ BLEDevice::ignore() const
   if (0 == rs.ignoreUntil) {
     return false;
   }
-  if (Date() < rs.ignoreUntil) {
+  if (now() < rs.ignoreUntil) {
     return true;
   }
   return false;
@@ -945,7 +963,7 @@ BLEDevice::ignore(bool newIgnore) // set permanent ignore flag
     stateData = FilteredState(); // TODO determine if this breaks end of life detection for android devices with pseudo device address
     flags.internalState(BLEInternalState::filtered);
   }
-  lastUpdated.setToNow();
+  lastUpdated = now();
 }
 
 void
@@ -956,14 +974,14 @@ BLEDevice::invalidateCharacteristics()
   flags.hasPayloadCharacteristic(false);
   flags.legacyService(BLELegacyService::Unknown);
   flags.signalCharacteristic(SignalCharacteristicType::SpecCompliant); // Assume spec compliant
-  lastUpdated.setToNow();
+  lastUpdated = now();
 }
 
 void
 BLEDevice::registerDiscovery(Date at)
 {
   // lastDiscoveredAt.emplace(at);
-  lastUpdated = Date(); // TODO verify this shouldn't be 'at' instead (for continuity)
+  lastUpdated = at;
 }
 
 // void
@@ -1024,7 +1042,7 @@ BLEDevice::advertData(std::vector<BLEAdvertSegment> newSegments)
 void
 BLEDevice::services(std::vector<UUID> services)
 {
-  lastUpdated.setToNow();
+  lastUpdated = now();
   for (auto& svc : services) {
     if (svc == conf.serviceUUID) {
       flags.hasHeraldService(true);
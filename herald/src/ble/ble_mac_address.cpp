@@ -94,6 +94,12 @@ BLEMacAddress::operator!=(const BLEMacAddress& other) const
   return data != other.data;
 }
 
+std::size_t
+BLEMacAddress::hashCode() const
+{
+  return std::hash<Data>{}(data);
+}
+
 void
 BLEMacAddress::bytesBigEndian(std::uint8_t bytesBigEndian[6]) const
 {
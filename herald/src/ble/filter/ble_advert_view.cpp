@@ -0,0 +1,343 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/ble/filter/ble_advert_types.h"
+#include "herald/ble/filter/ble_advert_view.h"
+
+#include <string>
+#include <vector>
+
+namespace herald {
+namespace ble {
+namespace filter {
+
+using namespace herald::datatype;
+
+// MARK: BLEAdvertDataView
+
+BLEAdvertDataView::BLEAdvertDataView() noexcept
+  : start(nullptr),
+    length(0)
+{
+  ;
+}
+
+BLEAdvertDataView::BLEAdvertDataView(const std::uint8_t* startAt, std::size_t count) noexcept
+  : start(nullptr == startAt ? nullptr : startAt),
+    length(nullptr == startAt ? 0 : count)
+{
+  ;
+}
+
+BLEAdvertDataView::BLEAdvertDataView(const Data& from) noexcept
+  : start(from.rawMemoryStartAddress()),
+    length(nullptr == from.rawMemoryStartAddress() ? 0 : from.size())
+{
+  ;
+}
+
+bool
+BLEAdvertDataView::uint8(std::size_t fromIndex, std::uint8_t& into) const noexcept
+{
+  if (fromIndex >= length) {
+    return false;
+  }
+  into = start[fromIndex];
+  return true;
+}
+
+bool
+BLEAdvertDataView::uint16(std::size_t fromIndex, std::uint16_t& into) const noexcept
+{
+  if (length < 2 || fromIndex > length - 2) {
+    return false;
+  }
+  into = (std::uint16_t(start[fromIndex + 1]) << 8) | std::uint16_t(start[fromIndex]);
+  return true;
+}
+
+BLEAdvertDataView
+BLEAdvertDataView::subview(std::size_t offset, std::size_t count) const noexcept
+{
+  if (offset >= length) {
+    return BLEAdvertDataView();
+  }
+  const std::size_t available = length - offset;
+  return BLEAdvertDataView(start + offset, count > available ? available : count);
+}
+
+Data
+BLEAdvertDataView::toData() const
+{
+  if (0 == length) {
+    return Data();
+  }
+  return Data(start, length);
+}
+
+std::string
+BLEAdvertDataView::hexEncodedString() const
+{
+  static constexpr char hexChars[] {
+    '0','1','2','3','4','5','6','7',
+    '8','9','a','b','c','d','e','f'
+  };
+  std::string result;
+  result.reserve(length * 2);
+  for (std::size_t i = 0;i < length;++i) {
+    result += hexChars[0x0F & (start[i] >> 4)]; // MSB
+    result += hexChars[0x0F &  start[i]      ]; // LSB
+  }
+  return result;
+}
+
+bool
+BLEAdvertDataView::operator==(const Data& other) const noexcept
+{
+  if (other.size() != length) {
+    return false;
+  }
+  std::uint8_t value = 0;
+  for (std::size_t i = 0;i < length;++i) {
+    if (!other.uint8(i,value) || value != start[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+BLEAdvertDataView::operator!=(const Data& other) const noexcept
+{
+  return !(*this == other);
+}
+
+// MARK: BLEAdvertManufacturerDataView
+
+bool
+BLEAdvertManufacturerDataView::from(const BLEAdvertSegmentView& segment, BLEAdvertManufacturerDataView& into) noexcept
+{
+  if (segment.type != BLEAdvertSegmentType::manufacturerData) {
+    return false;
+  }
+  std::uint16_t code = 0;
+  if (!segment.data.uint16(0, code)) {
+    return false; // data area too short
+  }
+  into.manufacturer = code;
+  into.data = segment.data.subview(2, segment.data.size() - 2);
+  return true;
+}
+
+// MARK: BLEAdvertSegmentIterator
+
+BLEAdvertSegmentIterator::BLEAdvertSegmentIterator() noexcept
+  : raw(),
+    position(0),
+    atEnd(true),
+    current{BLEAdvertSegmentType::unknown, BLEAdvertDataView()}
+{
+  ;
+}
+
+BLEAdvertSegmentIterator::BLEAdvertSegmentIterator(const BLEAdvertDataView& rawData, std::size_t offset) noexcept
+  : raw(rawData),
+    position(offset),
+    atEnd(false),
+    current{BLEAdvertSegmentType::unknown, BLEAdvertDataView()}
+{
+  readSegment();
+}
+
+BLEAdvertSegmentIterator&
+BLEAdvertSegmentIterator::operator++() noexcept
+{
+  readSegment();
+  return *this;
+}
+
+BLEAdvertSegmentIterator
+BLEAdvertSegmentIterator::operator++(int) noexcept
+{
+  BLEAdvertSegmentIterator cp = *this;
+  readSegment();
+  return cp;
+}
+
+bool
+BLEAdvertSegmentIterator::operator==(const BLEAdvertSegmentIterator& other) const noexcept
+{
+  if (atEnd || other.atEnd) {
+    return atEnd == other.atEnd;
+  }
+  return raw.data() == other.raw.data() && position == other.position;
+}
+
+bool
+BLEAdvertSegmentIterator::operator!=(const BLEAdvertSegmentIterator& other) const noexcept
+{
+  return !(*this == other);
+}
+
+void
+BLEAdvertSegmentIterator::readSegment() noexcept
+{
+  std::uint8_t segmentLength = 0;
+  std::uint8_t segmentType = 0;
+  if (atEnd ||
+      !raw.uint8(position, segmentLength) ||
+      !raw.uint8(position + 1, segmentType) ||
+      0 == segmentLength ||
+      (position + 1 + segmentLength) > raw.size()) {
+    // end of data, padding, or error in data length
+    atEnd = true;
+    return;
+  }
+  // Note: Unsupported types are handled as 'unknown'
+  current.type = typeFor(segmentType);
+  current.data = raw.subview(position + 2, segmentLength - 1);
+  position += 1 + segmentLength;
+}
+
+// MARK: BLEAdvertView
+
+BLEAdvertView::BLEAdvertView(const Data& rawData, std::size_t from) noexcept
+  : raw(rawData),
+    offset(from)
+{
+  ;
+}
+
+BLEAdvertView::BLEAdvertView(const std::uint8_t* rawData, std::size_t length) noexcept
+  : raw(rawData, length),
+    offset(0)
+{
+  ;
+}
+
+BLEAdvertView::const_iterator
+BLEAdvertView::begin() const noexcept
+{
+  return BLEAdvertSegmentIterator(raw, offset);
+}
+
+BLEAdvertView::const_iterator
+BLEAdvertView::end() const noexcept
+{
+  return BLEAdvertSegmentIterator();
+}
+
+bool
+BLEAdvertView::txPower(std::uint8_t& into) const noexcept
+{
+  for (const auto& segment : *this) {
+    if (segment.type == BLEAdvertSegmentType::txPowerLevel && segment.data.uint8(0, into)) {
+      return true;
+    } // else see if theres a non malformed one...
+  }
+  return false;
+}
+
+bool
+BLEAdvertView::manufacturerData(std::uint16_t manufacturer, BLEAdvertManufacturerDataView& into) const noexcept
+{
+  BLEAdvertManufacturerDataView candidate;
+  for (const auto& segment : *this) {
+    if (BLEAdvertManufacturerDataView::from(segment, candidate) && candidate.manufacturer == manufacturer) {
+      into = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<BLEAdvertSegment>
+BLEAdvertView::toSegments() const
+{
+  std::vector<BLEAdvertSegment> segments;
+  for (const auto& segment : *this) {
+    segments.emplace_back(segment.type, segment.data.toData());
+  }
+  return segments;
+}
+
+// MARK: BLEAdvertAppleSegmentIterator
+
+BLEAdvertAppleSegmentIterator::BLEAdvertAppleSegmentIterator() noexcept
+  : raw(),
+    position(0),
+    atEnd(true),
+    current{0, BLEAdvertDataView()}
+{
+  ;
+}
+
+BLEAdvertAppleSegmentIterator::BLEAdvertAppleSegmentIterator(const BLEAdvertDataView& manufacturerData) noexcept
+  : raw(manufacturerData),
+    position(0),
+    atEnd(false),
+    current{0, BLEAdvertDataView()}
+{
+  readSegment();
+}
+
+BLEAdvertAppleSegmentIterator&
+BLEAdvertAppleSegmentIterator::operator++() noexcept
+{
+  readSegment();
+  return *this;
+}
+
+BLEAdvertAppleSegmentIterator
+BLEAdvertAppleSegmentIterator::operator++(int) noexcept
+{
+  BLEAdvertAppleSegmentIterator cp = *this;
+  readSegment();
+  return cp;
+}
+
+bool
+BLEAdvertAppleSegmentIterator::operator==(const BLEAdvertAppleSegmentIterator& other) const noexcept
+{
+  if (atEnd || other.atEnd) {
+    return atEnd == other.atEnd;
+  }
+  return raw.data() == other.raw.data() && position == other.position;
+}
+
+bool
+BLEAdvertAppleSegmentIterator::operator!=(const BLEAdvertAppleSegmentIterator& other) const noexcept
+{
+  return !(*this == other);
+}
+
+void
+BLEAdvertAppleSegmentIterator::readSegment() noexcept
+{
+  std::uint8_t typeValue = 0;
+  if (atEnd || !raw.uint8(position, typeValue)) {
+    atEnd = true;
+    return;
+  }
+  // "01" marks legacy service UUID encoding without length data
+  if (typeValue == 0x01) {
+    current.type = typeValue;
+    current.data = raw.subview(position + 1, raw.size() - position - 1);
+    position = raw.size();
+    return;
+  }
+  // Parse according to Type-Length-Data
+  std::uint8_t length = 0;
+  if (!raw.uint8(position + 1, length)) {
+    atEnd = true; // type without a length byte
+    return;
+  }
+  current.type = typeValue;
+  current.data = raw.subview(position + 2, length);
+  position += current.data.size() + 2;
+}
+
+}
+}
+}
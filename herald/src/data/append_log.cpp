@@ -0,0 +1,281 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/data/append_log.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HERALD_APPEND_LOG_POSIX 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace herald {
+namespace data {
+
+namespace {
+
+constexpr std::size_t PendingBytes = 64 * 1024; // written once this much is buffered
+constexpr std::size_t MinimumMappedBytes = 1024 * 1024;
+
+#ifdef HERALD_APPEND_LOG_POSIX
+bool writeAll(int fd, const std::uint8_t* from, std::size_t length) noexcept {
+  while (length > 0) {
+    const ssize_t done = ::write(fd, from, length);
+    if (done < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return false;
+    }
+    from += done;
+    length -= std::size_t(done);
+  }
+  return true;
+}
+
+/// \brief Best effort wait for the directory holding path to reach the storage device, so a rename is durable
+void syncDirectory(const std::string& path) noexcept {
+  const std::size_t slash = path.find_last_of('/');
+  const std::string directory = std::string::npos == slash ? std::string(".") :
+                                (0 == slash ? std::string("/") : path.substr(0, slash));
+  const int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirFd < 0) {
+    return;
+  }
+  ::fsync(dirFd);
+  ::close(dirFd);
+}
+#endif
+
+}
+
+AppendLog::AppendLog(std::string path, std::size_t recordSize) noexcept
+  : filePath(std::move(path)),
+    recordBytes(recordSize),
+    fd(-1),
+    written(0),
+    pending(),
+    mapping(nullptr),
+    mappedRecords(0)
+{
+  ;
+}
+
+AppendLog::~AppendLog() noexcept
+{
+  close();
+}
+
+bool
+AppendLog::open() noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  if (isOpen()) {
+    return true;
+  }
+  if (0 == recordBytes) {
+    return false;
+  }
+  fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (0 != ::fstat(fd, &info)) {
+    close();
+    return false;
+  }
+  written = std::size_t(info.st_size) / recordBytes;
+  if (std::size_t(info.st_size) != written * recordBytes) {
+    // Drop a record left incomplete by a crash
+    if (0 != ::ftruncate(fd, off_t(written * recordBytes))) {
+      close();
+      return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+AppendLog::close() noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  if (!isOpen()) {
+    return;
+  }
+  flush();
+  unmap();
+  ::close(fd);
+#endif
+  fd = -1;
+  written = 0;
+  pending.clear();
+}
+
+bool
+AppendLog::isOpen() const noexcept
+{
+  return fd >= 0;
+}
+
+const std::string&
+AppendLog::path() const noexcept
+{
+  return filePath;
+}
+
+std::size_t
+AppendLog::recordSize() const noexcept
+{
+  return recordBytes;
+}
+
+std::size_t
+AppendLog::size() const noexcept
+{
+  return written + pending.size() / recordBytes;
+}
+
+bool
+AppendLog::append(const std::uint8_t* record) noexcept
+{
+  if (!isOpen()) {
+    return false;
+  }
+  pending.insert(pending.end(), record, record + recordBytes);
+  if (pending.size() >= PendingBytes) {
+    return flush();
+  }
+  return true;
+}
+
+const std::uint8_t*
+AppendLog::record(std::size_t number) const noexcept
+{
+  if (number >= written) {
+    const std::size_t offset = (number - written) * recordBytes;
+    return offset < pending.size() ? pending.data() + offset : nullptr;
+  }
+  // Map beyond the end of the file, so the mapping need not change every time it grows
+  if (number >= mappedRecords && !remap(std::max(2 * written, MinimumMappedBytes / recordBytes))) {
+    return nullptr;
+  }
+  return mapping + number * recordBytes;
+}
+
+bool
+AppendLog::flush() noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  if (!isOpen()) {
+    return false;
+  }
+  if (pending.empty()) {
+    return true;
+  }
+  if (!writeAll(fd, pending.data(), pending.size())) {
+    // Keep the records that did not reach the file buffered, without repeating a partial one
+    struct stat info;
+    if (0 == ::fstat(fd, &info)) {
+      const std::size_t now = std::size_t(info.st_size) / recordBytes;
+      if (0 == ::ftruncate(fd, off_t(now * recordBytes)) && now > written) {
+        pending.erase(pending.begin(), pending.begin() + (now - written) * recordBytes);
+        written = now;
+      }
+    }
+    return false;
+  }
+  written += pending.size() / recordBytes;
+  pending.clear();
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+AppendLog::sync() noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  if (!flush()) {
+    return false;
+  }
+  return 0 == ::fsync(fd);
+#else
+  return false;
+#endif
+}
+
+bool
+AppendLog::replace(const std::vector<std::uint8_t>& records) noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  if (!isOpen() || 0 != records.size() % recordBytes) {
+    return false;
+  }
+  const std::string compacted = filePath + ".compact";
+  int newFd = ::open(compacted.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if (newFd < 0) {
+    return false;
+  }
+  if (!writeAll(newFd, records.data(), records.size()) || 0 != ::fsync(newFd)
+      || 0 != ::rename(compacted.c_str(), filePath.c_str())) {
+    ::close(newFd);
+    ::unlink(compacted.c_str());
+    return false;
+  }
+  unmap();
+  ::close(fd);
+  fd = newFd;
+  written = records.size() / recordBytes;
+  pending.clear();
+  // Without this a crash could bring back the old directory entry, and so the old file
+  syncDirectory(filePath);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+AppendLog::remap(std::size_t records) const noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  unmap();
+  // Pages past the end of the file are mapped but never read, until the file reaches them
+  void* mapped = ::mmap(nullptr, records * recordBytes, PROT_READ, MAP_SHARED, fd, 0);
+  if (MAP_FAILED == mapped) {
+    return false;
+  }
+  mapping = static_cast<const std::uint8_t*>(mapped);
+  mappedRecords = records;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+AppendLog::unmap() const noexcept
+{
+#ifdef HERALD_APPEND_LOG_POSIX
+  if (nullptr != mapping) {
+    ::munmap(const_cast<std::uint8_t*>(mapping), mappedRecords * recordBytes);
+  }
+#endif
+  mapping = nullptr;
+  mappedRecords = 0;
+}
+
+}
+}
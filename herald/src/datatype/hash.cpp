@@ -0,0 +1,38 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/datatype/hash.h"
+
+#ifdef __ZEPHYR__
+#include <random/rand32.h>
+#else
+#include <random>
+#endif
+
+namespace herald {
+namespace datatype {
+namespace hashing {
+
+std::uint64_t randomSeed() noexcept
+{
+#ifdef __ZEPHYR__
+  return ((std::uint64_t)sys_rand32_get() << 32) | (std::uint64_t)sys_rand32_get();
+#elif defined(__cpp_exceptions)
+  try {
+    std::random_device rd;
+    return ((std::uint64_t)rd() << 32) ^ (std::uint64_t)rd();
+  } catch (...) {
+    // No random device available. Differs between runs where the platform randomises addresses.
+    static const int local = 0;
+    return round(prime5, (std::uint64_t)reinterpret_cast<std::uintptr_t>(&local));
+  }
+#else
+  std::random_device rd;
+  return ((std::uint64_t)rd() << 32) ^ (std::uint64_t)rd();
+#endif
+}
+
+} // end namespace
+} // end namespace
+} // end namespace
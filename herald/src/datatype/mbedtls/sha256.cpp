@@ -39,27 +39,9 @@ SHA256::digest(const Data& with) noexcept
   mbedtls_sha256_init(&ctx2);
   mbedtls_sha256_starts(&ctx2, 0); /* SHA-256, not 224 */
 
-  /* Simulating multiple fragments */
-  unsigned char buffer[32]; // temp buffer
-  std::uint8_t temp;
-  std::size_t idx = 0; // index in original Data with object
-  std::size_t read = 0; // number of bytes read into buffer
-  while (idx < with.size()) {
-    // copy up to next 32 bytes to buffer
-    if (idx + 32 <= with.size()) {
-      read = 32;
-    } else {
-      // less than 32 bytes remain
-      read = with.size() - idx;
-    }
-    for (std::size_t ci = 0; ci < read;++ci) {
-      with.uint8(idx + ci, temp); // read one byte at a time
-      buffer[ci] = (unsigned char)temp;
-    }
-    // update sha
-    mbedtls_sha256_update(&ctx2, buffer, read);
-    // increment index
-    idx += read;
+  // Data is contiguous in its memory arena, so hash it in place with a single update
+  if (0 != with.size()) {
+    mbedtls_sha256_update(&ctx2, with.rawMemoryStartAddress(), with.size());
   }
   
   mbedtls_sha256_finish(&ctx2, output);
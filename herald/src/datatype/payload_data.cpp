@@ -12,35 +12,84 @@ namespace herald {
 namespace datatype {
 
 PayloadData::PayloadData()
-  : Data()
+  : Data(),
+    hash(0),
+    hashed(false)
 {
   ;
 }
 
 PayloadData::PayloadData(const Data& from)
-  : Data(from)
+  : Data(from),
+    hash(0),
+    hashed(false)
+{
+  ;
+}
+
+PayloadData::PayloadData(const PayloadData& from)
+  : Data(from),
+    hash(from.hash),
+    hashed(from.hashed)
 {
   ;
 }
 
 PayloadData::PayloadData(const std::byte* data, std::size_t length)
-  : Data(data,length)
+  : Data(data,length),
+    hash(0),
+    hashed(false)
 {
   ;
 }
 
 PayloadData::PayloadData(std::byte repeating, std::size_t count)
-  : Data(repeating,count)
+  : Data(repeating,count),
+    hash(0),
+    hashed(false)
 {
   ;
 }
 PayloadData&
 PayloadData::operator=(const PayloadData& other)
 {
-  Data::operator=((Data)other);
+  Data::operator=(other);
+  hash = other.hash;
+  hashed = other.hashed;
   return *this;
 }
 
+std::size_t
+PayloadData::hashCode() const noexcept
+{
+  if (!hashed) {
+    hash = Data::hashCode();
+    hashed = true;
+  }
+  return hash;
+}
+
+void
+PayloadData::appendReversed(const Data& rawData, std::size_t offset, std::size_t length)
+{
+  Data::appendReversed(rawData, offset, length);
+  hashed = false;
+}
+
+void
+PayloadData::assign(const Data& other)
+{
+  Data::assign(other);
+  hashed = false;
+}
+
+void
+PayloadData::clear() noexcept
+{
+  Data::clear();
+  hashed = false;
+}
+
 std::string
 PayloadData::shortName() const {
   if (size() == 0) {
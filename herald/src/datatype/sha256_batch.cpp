@@ -0,0 +1,215 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/datatype/sha256.h"
+
+#include <cstring>
+
+// Multi-buffer hashing uses GCC/Clang vector extensions, with one message per 32 bit lane.
+// On x86-64 Linux (GCC) the lane function is also cloned for AVX2 and picked at load time.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HERALD_SHA256_MULTIBUFFER 1
+#define HERALD_SHA256_INLINE inline __attribute__((always_inline))
+#if defined(__linux__) && !defined(__clang__)
+#define HERALD_SHA256_LANE_TARGETS __attribute__((target_clones("avx2","default")))
+#else
+#define HERALD_SHA256_LANE_TARGETS
+#endif
+#if !defined(__clang__)
+// Vector helpers are always inlined, so never pass vectors across a call boundary
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+#else
+#define HERALD_SHA256_INLINE inline
+#endif
+
+namespace herald {
+namespace datatype {
+
+namespace {
+
+constexpr std::uint32_t roundConstants[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr std::uint32_t initialState[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+constexpr std::size_t BlockLength = 64;
+
+/// Number of 64 byte blocks once length bytes are padded (0x80, zeros, 64 bit bit-length)
+std::size_t blockCount(std::size_t length) noexcept {
+  return (length + 8) / BlockLength + 1;
+}
+
+/// Reads block number block of the padded message as 16 big endian words
+void blockWords(const std::uint8_t* message, std::size_t length, std::size_t block,
+  std::size_t blocks, std::uint32_t* words) noexcept
+{
+  const std::size_t start = block * BlockLength;
+  std::uint8_t padded[BlockLength];
+  const std::uint8_t* bytes = padded;
+  if (start + BlockLength <= length) {
+    bytes = message + start; // a whole block of message, no copy needed
+  } else {
+    std::memset(padded, 0, BlockLength);
+    if (start < length) {
+      std::memcpy(padded, message + start, length - start);
+    }
+    if (start <= length) {
+      padded[length - start] = 0x80;
+    }
+    if (block + 1 == blocks) {
+      const std::uint64_t bits = std::uint64_t(length) * 8;
+      for (std::size_t i = 0;i < 8;++i) {
+        padded[BlockLength - 1 - i] = std::uint8_t(bits >> (8 * i));
+      }
+    }
+  }
+  for (std::size_t i = 0;i < 16;++i) {
+    words[i] = (std::uint32_t(bytes[4 * i]) << 24) | (std::uint32_t(bytes[4 * i + 1]) << 16) |
+               (std::uint32_t(bytes[4 * i + 2]) << 8) | std::uint32_t(bytes[4 * i + 3]);
+  }
+}
+
+void storeWord(std::uint32_t value, std::uint8_t* into) noexcept {
+  into[0] = std::uint8_t(value >> 24);
+  into[1] = std::uint8_t(value >> 16);
+  into[2] = std::uint8_t(value >> 8);
+  into[3] = std::uint8_t(value);
+}
+
+template <typename Word>
+HERALD_SHA256_INLINE Word rotr(Word x, int n) noexcept {
+  return (x >> n) | (x << (32 - n));
+}
+
+/// The SHA-256 compression function. Word is either std::uint32_t (one message) or a
+/// vector of std::uint32_t (one message per lane), so both paths share one implementation.
+template <typename Word>
+HERALD_SHA256_INLINE void compress(Word* state, const Word* block) noexcept {
+  Word w[64];
+  for (int t = 0;t < 16;++t) {
+    w[t] = block[t];
+  }
+  for (int t = 16;t < 64;++t) {
+    const Word s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+    const Word s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+    w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+  }
+  Word a = state[0], b = state[1], c = state[2], d = state[3];
+  Word e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int t = 0;t < 64;++t) {
+    const Word s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+    const Word choose = (e & f) ^ (~e & g);
+    const Word t1 = h + s1 + choose + roundConstants[t] + w[t];
+    const Word s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+    const Word majority = (a & b) ^ (a & c) ^ (b & c);
+    const Word t2 = s0 + majority;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void digestOne(const std::uint8_t* message, std::size_t length, std::uint8_t* digest) noexcept {
+  std::uint32_t state[8];
+  for (std::size_t i = 0;i < 8;++i) {
+    state[i] = initialState[i];
+  }
+  const std::size_t blocks = blockCount(length);
+  std::uint32_t words[16];
+  for (std::size_t b = 0;b < blocks;++b) {
+    blockWords(message, length, b, blocks, words);
+    compress(state, words);
+  }
+  for (std::size_t i = 0;i < 8;++i) {
+    storeWord(state[i], digest + 4 * i);
+  }
+}
+
+#ifdef HERALD_SHA256_MULTIBUFFER
+typedef std::uint32_t Lanes __attribute__((vector_size(32)));
+constexpr std::size_t LaneCount = sizeof(Lanes) / sizeof(std::uint32_t);
+
+/// Hashes LaneCount messages of the same length together, one per vector lane
+HERALD_SHA256_LANE_TARGETS
+void digestLanes(const std::uint8_t* const* messages, std::size_t length,
+  std::uint8_t* const* digests) noexcept
+{
+  Lanes state[8];
+  for (std::size_t i = 0;i < 8;++i) {
+    state[i] = Lanes() + initialState[i];
+  }
+  const std::size_t blocks = blockCount(length);
+  std::uint32_t words[LaneCount][16];
+  Lanes block[16];
+  for (std::size_t b = 0;b < blocks;++b) {
+    for (std::size_t lane = 0;lane < LaneCount;++lane) {
+      blockWords(messages[lane], length, b, blocks, words[lane]);
+    }
+    // Transpose so that block[i] holds word i of every lane's message
+    for (std::size_t i = 0;i < 16;++i) {
+      for (std::size_t lane = 0;lane < LaneCount;++lane) {
+        block[i][lane] = words[lane][i];
+      }
+    }
+    compress(state, block);
+  }
+  for (std::size_t lane = 0;lane < LaneCount;++lane) {
+    for (std::size_t i = 0;i < 8;++i) {
+      storeWord(state[i][lane], digests[lane] + 4 * i);
+    }
+  }
+}
+#endif
+
+}
+
+void
+SHA256::digestBatch(const std::uint8_t* messages, std::size_t messageLength,
+  std::size_t count, std::uint8_t* digests) noexcept
+{
+  std::size_t index = 0;
+#ifdef HERALD_SHA256_MULTIBUFFER
+  const std::uint8_t* laneMessages[LaneCount];
+  std::uint8_t* laneDigests[LaneCount];
+  std::uint8_t unusedDigests[LaneCount][DigestLength];
+  // A final group with idle lanes still beats hashing two or more messages one at a time
+  for (;index + 1 < count;index += LaneCount) {
+    for (std::size_t lane = 0;lane < LaneCount;++lane) {
+      const std::size_t message = index + lane;
+      if (message < count) {
+        laneMessages[lane] = messages + message * messageLength;
+        laneDigests[lane] = digests + message * DigestLength;
+      } else {
+        laneMessages[lane] = messages; // idle lane, result discarded
+        laneDigests[lane] = unusedDigests[lane];
+      }
+    }
+    digestLanes(laneMessages, messageLength, laneDigests);
+  }
+#endif
+  for (;index < count;++index) {
+    digestOne(messages + index * messageLength, messageLength, digests + index * DigestLength);
+  }
+}
+
+}
+}
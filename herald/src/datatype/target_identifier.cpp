@@ -43,19 +43,22 @@ namespace datatype {
 
 
 TargetIdentifier::TargetIdentifier()
- : value()
+ : value(),
+   hash(value.hashCode())
 {
   ; // TODO set value to random v4 UUID string
 }
 
 TargetIdentifier::TargetIdentifier(const Data& data)
-  : value(data)
+  : value(data),
+    hash(value.hashCode())
 {
   ;
 }
 
 TargetIdentifier::TargetIdentifier(const TargetIdentifier& from)
-  : value(from.value)
+  : value(from.value),
+    hash(from.hash)
 {
   ;
 }
@@ -66,12 +69,13 @@ TargetIdentifier&
 TargetIdentifier::operator=(const TargetIdentifier& from)
 {
   value = from.value;
+  hash = from.hash;
   return *this;
 }
 
 bool
 TargetIdentifier::operator==(const TargetIdentifier& other) const noexcept {
-  return hashCode() == other.hashCode();
+  return hash == other.hash && value == other.value;
 }
 
 bool
@@ -81,7 +85,7 @@ TargetIdentifier::operator==(const Data& other) const noexcept {
 
 bool
 TargetIdentifier::operator!=(const TargetIdentifier& other) const noexcept {
-  return hashCode() != other.hashCode();
+  return !(*this == other);
 }
 
 bool
@@ -100,7 +104,7 @@ TargetIdentifier::operator>(const TargetIdentifier& other) const noexcept {
 
 std::size_t
 TargetIdentifier::hashCode() const {
-  return std::hash<Data>{}(value);
+  return hash;
 }
 
 TargetIdentifier::operator std::string() const {
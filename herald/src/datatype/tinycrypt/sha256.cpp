@@ -32,27 +32,9 @@ SHA256::digest(const Data& with) noexcept
   struct tc_sha256_state_struct state;
 	(void)tc_sha256_init(&state);
 
-  /* Simulating multiple fragments */
-  uint8_t buffer[32]; // temp buffer
-  std::uint8_t temp = 0;
-  std::size_t idx = 0; // index in original Data with object
-  std::size_t read = 0; // number of bytes read into buffer
-  while (idx < with.size()) {
-    // copy up to next 32 bytes to buffer
-    if (idx + 32 <= with.size()) {
-      read = 32;
-    } else {
-      // less than 32 bytes remain
-      read = with.size() - idx;
-    }
-    for (std::size_t ci = 0; ci < read;ci++) {
-      with.uint8(idx + ci, temp); // read one byte at a time
-      buffer[ci] = temp;
-    }
-    // update sha
-	  tc_sha256_update(&state, buffer, read);
-    // increment index
-    idx += read;
+  // Data is contiguous in its memory arena, so hash it in place with a single update
+  if (0 != with.size()) {
+    tc_sha256_update(&state, with.rawMemoryStartAddress(), with.size());
   }
   
 	(void)tc_sha256_final(output, &state);
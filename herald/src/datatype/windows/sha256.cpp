@@ -9,6 +9,7 @@
 // Windows specific libraries
 #include <windows.h>
 #include <stdio.h>
+#include <cstring>
 #include <bcrypt.h>
 
 namespace herald {
@@ -113,8 +114,8 @@ SHA256::digest(const Data& with) noexcept {
   
   // copy over data
   message = (PBYTE)HeapAlloc (GetProcessHeap (), 0, with.size());
-  for (std::size_t i = 0;i < with.size();++i) {
-    message[i] = BYTE(with.at(i));
+  if (0 != with.size()) {
+    std::memcpy(message, with.rawMemoryStartAddress(), with.size());
   }
 
   //hash some data
@@ -0,0 +1,125 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/exposure/refresh_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace herald {
+namespace exposure {
+
+struct RefreshPool::Workers {
+  std::vector<std::thread> threads;
+
+  std::mutex runLock; // held for the whole of each run() call
+  std::mutex lock; // guards the below
+  std::condition_variable wake;
+  std::condition_variable finished;
+  ItemFunction function = nullptr;
+  void* work = nullptr;
+  std::size_t items = 0;
+  std::atomic<std::size_t> next{0};
+  std::size_t busy = 0; // worker threads yet to finish the current run
+  std::uint64_t generation = 0;
+  bool stopping = false;
+
+  void runAvailable(ItemFunction runFunction, void* runWork, std::size_t runItems) {
+    for (std::size_t item = next++;item < runItems;item = next++) {
+      runFunction(runWork, item);
+    }
+  }
+
+  void workerLoop() {
+    std::uint64_t seen = 0;
+    while (true) {
+      ItemFunction runFunction;
+      void* runWork;
+      std::size_t runItems;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        wake.wait(guard, [this, seen] { return stopping || generation != seen; });
+        if (stopping) {
+          return;
+        }
+        seen = generation;
+        runFunction = function;
+        runWork = work;
+        runItems = items;
+      }
+      runAvailable(runFunction, runWork, runItems);
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        if (0 == --busy) {
+          finished.notify_one();
+        }
+      }
+    }
+  }
+};
+
+RefreshPool::RefreshPool(unsigned int threads)
+  : workers(std::make_unique<Workers>())
+{
+  const unsigned int total = 0 != threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+  workers->threads.reserve(total - 1);
+  for (unsigned int idx = 1;idx < total;++idx) { // the thread calling run() is the first
+    workers->threads.emplace_back([w = workers.get()] { w->workerLoop(); });
+  }
+}
+
+RefreshPool::~RefreshPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(workers->lock);
+    workers->stopping = true;
+  }
+  workers->wake.notify_all();
+  for (auto& thread : workers->threads) {
+    thread.join();
+  }
+}
+
+unsigned int
+RefreshPool::threads() const noexcept
+{
+  return (unsigned int)(workers->threads.size() + 1);
+}
+
+void
+RefreshPool::runItems(std::size_t items, ItemFunction function, void* work)
+{
+  if (0 == items) {
+    return;
+  }
+  Workers& w = *workers;
+  if (1 == items || w.threads.empty()) {
+    for (std::size_t item = 0;item < items;++item) {
+      function(work, item);
+    }
+    return;
+  }
+  std::lock_guard<std::mutex> running(w.runLock);
+  {
+    std::lock_guard<std::mutex> guard(w.lock);
+    w.function = function;
+    w.work = work;
+    w.items = items;
+    w.next = 0;
+    w.busy = w.threads.size();
+    ++w.generation;
+  }
+  w.wake.notify_all();
+  w.runAvailable(function, work, items);
+  std::unique_lock<std::mutex> guard(w.lock);
+  w.finished.wait(guard, [&w] { return 0 == w.busy; });
+}
+
+}
+}
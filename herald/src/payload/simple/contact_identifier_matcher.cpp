@@ -0,0 +1,279 @@
+//  Copyright 2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "herald/payload/simple/contact_identifier_matcher.h"
+#include "herald/datatype/sha256.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace herald {
+namespace payload {
+namespace simple {
+
+using namespace herald::datatype;
+
+namespace {
+
+constexpr std::size_t SeedLength = SHA256::DigestLength;
+constexpr std::size_t TruncatedLength = SeedLength / 2; // F::t
+constexpr std::size_t KeysPerWorkItem = 64;
+constexpr std::size_t ObservationsPerWorkItem = 4096;
+
+/// Runs work(item) for every item in [0, items), spread over up to threads threads
+template <typename WorkT>
+void runParallel(unsigned int threads, std::size_t items, WorkT work) {
+  const std::size_t workers = std::min<std::size_t>(threads, items);
+  if (workers <= 1) {
+    for (std::size_t item = 0;item < items;++item) {
+      work(item);
+    }
+    return;
+  }
+  std::atomic<std::size_t> next(0);
+  std::vector<std::thread> pool;
+  pool.reserve(workers);
+  for (std::size_t w = 0;w < workers;++w) {
+    pool.emplace_back([&next, &work, items] {
+      for (std::size_t item = next++;item < items;item = next++) {
+        work(item);
+      }
+    });
+  }
+  for (auto& worker : pool) {
+    worker.join();
+  }
+}
+
+/// Moves count hash chains one step down: into = h(t(seeds)), as KeyChainCache does
+void stepChains(const std::vector<std::uint8_t>& seeds, std::vector<std::uint8_t>& truncated,
+  std::size_t count, std::vector<std::uint8_t>& into) noexcept
+{
+  for (std::size_t i = 0;i < count;++i) {
+    std::memcpy(truncated.data() + i * TruncatedLength, seeds.data() + i * SeedLength, TruncatedLength);
+  }
+  SHA256::digestBatch(truncated.data(), TruncatedLength, count, into.data());
+}
+
+/// Derives count keys as h(xor(seeds, minusOne)), as K does for matching and contact keys
+void deriveKeys(const std::vector<std::uint8_t>& seeds, const std::vector<std::uint8_t>& minusOne,
+  std::vector<std::uint8_t>& xored, std::size_t count, std::vector<std::uint8_t>& into) noexcept
+{
+  for (std::size_t i = 0;i < count * SeedLength;++i) {
+    xored[i] = seeds[i] ^ minusOne[i];
+  }
+  SHA256::digestBatch(xored.data(), SeedLength, count, into.data());
+}
+
+struct IdentifierOrder {
+  template <typename EntryT>
+  bool operator()(const EntryT& entry, const ContactIdentifierMatcher::Identifier& identifier) const noexcept {
+    return entry.identifier < identifier;
+  }
+  template <typename EntryT>
+  bool operator()(const ContactIdentifierMatcher::Identifier& identifier, const EntryT& entry) const noexcept {
+    return identifier < entry.identifier;
+  }
+};
+
+}
+
+ContactIdentifierMatcher::ContactIdentifierMatcher(int daysFor, int periodsInDay, unsigned int threads) noexcept
+  : daysFor(daysFor),
+    periodsInDay(periodsInDay),
+    threadCount(0 != threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+    entries(),
+    buckets()
+{
+  ;
+}
+
+std::size_t
+ContactIdentifierMatcher::size() const noexcept
+{
+  return entries.size();
+}
+
+unsigned int
+ContactIdentifierMatcher::threads() const noexcept
+{
+  return threadCount;
+}
+
+ContactIdentifierMatcher::Identifier
+ContactIdentifierMatcher::toIdentifier(const ContactIdentifier& identifier) noexcept
+{
+  Identifier result{};
+  const std::size_t length = std::min(identifier.size(), IdentifierLength);
+  if (0 != length) {
+    std::memcpy(result.data(), identifier.rawMemoryStartAddress(), length);
+  }
+  return result;
+}
+
+void
+ContactIdentifierMatcher::build(const std::vector<SecretKey>& keys, int fromDay, int toDay)
+{
+  // Keys of a different length to the first are skipped
+  const std::size_t keyLength = keys.empty() ? 0 : keys.front().size();
+  std::vector<std::uint8_t> contiguous;
+  contiguous.reserve(keys.size() * keyLength);
+  std::size_t keyCount = 0;
+  for (const auto& key : keys) {
+    if (key.size() == keyLength) {
+      contiguous.insert(contiguous.end(), key.rawMemoryStartAddress(), key.rawMemoryStartAddress() + keyLength);
+      ++keyCount;
+    }
+  }
+  build(contiguous.data(), keyLength, keyCount, fromDay, toDay);
+}
+
+void
+ContactIdentifierMatcher::build(const std::uint8_t* keys, std::size_t keyLength, std::size_t keyCount,
+  int fromDay, int toDay)
+{
+  entries.clear();
+  buckets.fill(0);
+  if (fromDay < 0) {
+    fromDay = 0;
+  }
+  if (0 == keyCount || toDay < fromDay || periodsInDay <= 0) {
+    return;
+  }
+
+  // Each work item expands a group of keys in lockstep
+  const std::size_t items = (keyCount + KeysPerWorkItem - 1) / KeysPerWorkItem;
+  std::vector<std::vector<Entry>> generated(items);
+  runParallel(threadCount, items, [&](std::size_t item) {
+    const std::size_t first = item * KeysPerWorkItem;
+    const std::size_t count = std::min(KeysPerWorkItem, keyCount - first);
+    generated[item].reserve(count * std::size_t(toDay - fromDay + 1) * std::size_t(periodsInDay));
+    expand(keys, keyLength, first, count, fromDay, toDay, generated[item]);
+  });
+
+  // Scatter into buckets on the first identifier byte, then sort the buckets in parallel
+  std::size_t total = 0;
+  for (const auto& group : generated) {
+    for (const auto& entry : group) {
+      ++buckets[std::size_t(entry.identifier[0]) + 1];
+    }
+    total += group.size();
+  }
+  for (std::size_t b = 1;b < buckets.size();++b) {
+    buckets[b] += buckets[b - 1];
+  }
+  entries.resize(total);
+  std::array<std::size_t,256> cursor;
+  std::copy(buckets.begin(), buckets.end() - 1, cursor.begin());
+  for (auto& group : generated) {
+    for (const auto& entry : group) {
+      entries[cursor[entry.identifier[0]]++] = entry;
+    }
+    std::vector<Entry>().swap(group); // release as we go to limit peak memory
+  }
+  runParallel(threadCount, cursor.size(), [this](std::size_t b) {
+    std::sort(entries.begin() + buckets[b], entries.begin() + buckets[b + 1],
+      [](const Entry& left, const Entry& right) { return left.identifier < right.identifier; });
+  });
+}
+
+void
+ContactIdentifierMatcher::expand(const std::uint8_t* keys, std::size_t keyLength, std::size_t firstKey,
+  std::size_t keyCount, int fromDay, int toDay, std::vector<Entry>& into) const
+{
+  const std::size_t n = keyCount;
+  std::vector<std::uint8_t> seed(n * SeedLength), nextSeed(n * SeedLength);
+  std::vector<std::uint8_t> matchingKey(n * SeedLength), contactSeed(n * SeedLength);
+  std::vector<std::uint8_t> nextContactSeed(n * SeedLength), contactKey(n * SeedLength);
+  std::vector<std::uint8_t> xored(n * SeedLength), truncated(n * TruncatedLength);
+
+  // Matching key seed for day daysFor is h(secretKey)
+  SHA256::digestBatch(keys + firstKey * keyLength, keyLength, n, seed.data());
+  int seedDay = daysFor;
+  int keyDay = -1; // day of the keys in matchingKey
+  for (int day = toDay;day >= fromDay;--day) {
+    // Days beyond daysFor reuse the top seed, as K does
+    const int effectiveDay = day < daysFor ? day : daysFor;
+    if (effectiveDay != keyDay) {
+      for (;seedDay > effectiveDay;--seedDay) {
+        stepChains(seed, truncated, n, nextSeed);
+        seed.swap(nextSeed);
+      }
+      stepChains(seed, truncated, n, nextSeed); // seed for effectiveDay - 1
+      deriveKeys(seed, nextSeed, xored, n, matchingKey);
+      seed.swap(nextSeed);
+      --seedDay;
+      keyDay = effectiveDay;
+    }
+
+    // Contact key seed for period periodsInDay is h(matchingKey)
+    SHA256::digestBatch(matchingKey.data(), SeedLength, n, contactSeed.data());
+    for (int period = periodsInDay;period >= 0;--period) {
+      stepChains(contactSeed, truncated, n, nextContactSeed); // seed for period - 1
+      if (period < periodsInDay) {
+        deriveKeys(contactSeed, nextContactSeed, xored, n, contactKey);
+        for (std::size_t k = 0;k < n;++k) {
+          Entry entry;
+          std::memcpy(entry.identifier.data(), contactKey.data() + k * SeedLength, IdentifierLength);
+          entry.key = std::uint32_t(firstKey + k);
+          entry.day = std::uint16_t(day);
+          entry.period = std::uint16_t(period);
+          into.push_back(entry);
+        }
+      }
+      contactSeed.swap(nextContactSeed);
+    }
+  }
+}
+
+std::vector<ContactIdentifierMatcher::Match>
+ContactIdentifierMatcher::match(const std::vector<ContactIdentifier>& observed) const
+{
+  std::vector<Identifier> identifiers;
+  identifiers.reserve(observed.size());
+  for (const auto& identifier : observed) {
+    identifiers.push_back(toIdentifier(identifier));
+  }
+  return match(identifiers);
+}
+
+std::vector<ContactIdentifierMatcher::Match>
+ContactIdentifierMatcher::match(const std::vector<Identifier>& observed) const
+{
+  const std::size_t items = (observed.size() + ObservationsPerWorkItem - 1) / ObservationsPerWorkItem;
+  std::vector<std::vector<Match>> found(items);
+  runParallel(threadCount, items, [&](std::size_t item) {
+    const std::size_t from = item * ObservationsPerWorkItem;
+    lookup(observed, from, std::min(from + ObservationsPerWorkItem, observed.size()), found[item]);
+  });
+  std::vector<Match> matches;
+  for (const auto& group : found) {
+    matches.insert(matches.end(), group.begin(), group.end());
+  }
+  return matches;
+}
+
+void
+ContactIdentifierMatcher::lookup(const std::vector<Identifier>& observed, std::size_t from, std::size_t to,
+  std::vector<Match>& into) const
+{
+  if (entries.empty()) {
+    return;
+  }
+  for (std::size_t i = from;i < to;++i) {
+    const Identifier& identifier = observed[i];
+    const std::size_t b = identifier[0];
+    auto range = std::equal_range(entries.begin() + buckets[b], entries.begin() + buckets[b + 1],
+      identifier, IdentifierOrder());
+    for (auto entry = range.first;entry != range.second;++entry) {
+      into.push_back(Match{i, entry->key, entry->day, entry->period});
+    }
+  }
+}
+
+}
+}
+}
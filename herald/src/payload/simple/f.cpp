@@ -32,10 +32,14 @@ Data t(const Data& data, int n) noexcept {
 
 [[maybe_unused]]
 Data xorData(const Data& left, const Data& right) noexcept {
-  Data result;
   // note: we're ensuring we don't have an out of bound index (has effect of XOR with 0 as we set value above)
-  for (std::size_t i = 0;i < right.size() && i < left.size();i++) {
-    result.append(std::byte(((int)left.at(i)) ^ ((int)right.at(i))));
+  const std::size_t length = right.size() < left.size() ? right.size() : left.size();
+  Data result(length); // allocate once, rather than per appended byte
+  const unsigned char* l = left.rawMemoryStartAddress();
+  const unsigned char* r = right.rawMemoryStartAddress();
+  unsigned char* to = result.rawMemoryStartAddress();
+  for (std::size_t i = 0;i < length;i++) {
+    to[i] = l[i] ^ r[i];
   }
   if (right.size() < left.size()) {
     for (std::size_t i = left.size();i < left.size();i++) {
@@ -19,8 +19,104 @@ namespace simple {
 
 using namespace herald::datatype;
 
+namespace {
+
+KeyChainCache::SeedBytes toSeedBytes(const Data& from) noexcept {
+  KeyChainCache::SeedBytes bytes{};
+  const std::size_t length = from.size() < bytes.size() ? from.size() : bytes.size();
+  for (std::size_t i = 0;i < length;++i) {
+    bytes[i] = std::uint8_t(from.at(i));
+  }
+  return bytes;
+}
+
+Data fromSeedBytes(const KeyChainCache::SeedBytes& bytes) {
+  return Data(bytes.data(), bytes.size());
+}
+
+}
+
+// MARK: KeyChainCache
+
+KeyChainCache::KeyChainCache(int interval) noexcept
+  : interval(interval < 1 ? 1 : interval),
+    top(0),
+    checkpointSeeds(),
+    hasLast(false),
+    lastIndex(0),
+    last()
+{
+  ;
+}
+
+bool
+KeyChainCache::matches(const Data& topSeed) const noexcept {
+  return !checkpointSeeds.empty() && checkpointSeeds.front() == toSeedBytes(topSeed);
+}
+
+void
+KeyChainCache::reset(const Data& topSeed, int newTop) {
+  clear();
+  top = newTop;
+  checkpointSeeds.reserve((newTop < 0 ? 0 : newTop / interval) + 1);
+  checkpointSeeds.push_back(toSeedBytes(topSeed));
+}
+
+void
+KeyChainCache::clear() noexcept {
+  checkpointSeeds.clear();
+  hasLast = false;
+}
+
+std::size_t
+KeyChainCache::checkpoints() const noexcept {
+  return checkpointSeeds.size();
+}
+
+Data
+KeyChainCache::seed(int index) {
+  if (checkpointSeeds.empty()) {
+    return Data();
+  }
+  const int target = index > top ? top : index;
+  // Nearest checkpoint at or above target (only checkpoints at index >= 0 are stored)
+  int checkpoint = (top - target) / interval;
+  const int lowestCheckpoint = (top < 0 ? 0 : top / interval);
+  if (checkpoint > lowestCheckpoint) {
+    checkpoint = lowestCheckpoint;
+  }
+  // Fill any missing checkpoints down to the one required
+  Data current;
+  if ((int)checkpointSeeds.size() <= checkpoint) {
+    current = fromSeedBytes(checkpointSeeds.back());
+    while ((int)checkpointSeeds.size() <= checkpoint) {
+      for (int i = 0;i < interval;++i) {
+        current = F::h(F::t(current));
+      }
+      checkpointSeeds.push_back(toSeedBytes(current));
+    }
+  }
+  int currentIndex = top - (checkpoint * interval);
+  if (hasLast && lastIndex >= target && lastIndex < currentIndex) {
+    // The last seed derived is closer
+    currentIndex = lastIndex;
+    current = fromSeedBytes(last);
+  } else {
+    current = fromSeedBytes(checkpointSeeds[checkpoint]);
+  }
+  for (;currentIndex > target;--currentIndex) {
+    current = F::h(F::t(current));
+  }
+  hasLast = true;
+  lastIndex = target;
+  last = toSeedBytes(current);
+  return current;
+}
+
+// MARK: K
+
 K::K() noexcept
-  : keyLength(2048),daysFor(2000),periodsInDay(240), epoch(K::getEpoch())
+  : K(2048,2000,240,K::getEpoch())
 {
   ;
 }
@@ -29,19 +125,37 @@ K::K(const K& other) noexcept
   : keyLength(other.keyLength), 
     daysFor(other.daysFor),
     periodsInDay(other.periodsInDay),
-    epoch(other.epoch)
+    epoch(other.epoch),
+    matchingKeySeeds(other.matchingKeySeeds),
+    contactKeySeeds(other.contactKeySeeds),
+    hasMatchingKey(other.hasMatchingKey),
+    matchingKeyDay(other.matchingKeyDay),
+    matchingKeyBytes(other.matchingKeyBytes)
 {
   ;
 }
 
 K::K(int keyLength, int daysFor, int periodsInDay) noexcept
-  : keyLength(keyLength),daysFor(daysFor),periodsInDay(periodsInDay), epoch(K::getEpoch())
+  : K(keyLength,daysFor,periodsInDay,K::getEpoch())
 {
   ;
 }
 
 K::K(int keyLength, int daysFor, int periodsInDay, TimeInterval epochBeginning) noexcept
-  : keyLength(keyLength),daysFor(daysFor),periodsInDay(periodsInDay), epoch(epochBeginning)
+  : K(keyLength,daysFor,periodsInDay,epochBeginning,
+      DefaultDayCheckpointInterval,DefaultPeriodCheckpointInterval)
+{
+  ;
+}
+
+K::K(int keyLength, int daysFor, int periodsInDay, TimeInterval epochBeginning,
+  int dayCheckpointInterval, int periodCheckpointInterval) noexcept
+  : keyLength(keyLength),daysFor(daysFor),periodsInDay(periodsInDay), epoch(epochBeginning),
+    matchingKeySeeds(dayCheckpointInterval),
+    contactKeySeeds(periodCheckpointInterval),
+    hasMatchingKey(false),
+    matchingKeyDay(0),
+    matchingKeyBytes()
 {
   ;
 }
@@ -64,41 +178,52 @@ K::period(Date at) const noexcept {
   return (seconds * periodsInDay) / 86400; // more accurate
 }
 
-/// Low memory version of the key generator - generates key for a specified day
-/// This saves memory use on Zephyr at the cost of CPU utilisation
+void
+K::validateCache(const SecretKey& secretKey) {
+  // The seed for the last day identifies the secret key the caches were built from
+  Data topSeed(F::h(secretKey));
+  if (matchingKeySeeds.matches(topSeed)) {
+    return;
+  }
+  matchingKeySeeds.reset(topSeed, daysFor);
+  contactKeySeeds.clear();
+  hasMatchingKey = false;
+}
+
+/// Generates the key for a specified day, from a checkpointed cache of the matching key seed chain.
+/// The cache is bounded by daysFor / dayCheckpointInterval seeds, held outside the Data arena.
 MatchingKey
 K::matchingKey(const SecretKey& secretKey, const int dayIdxFor) noexcept {
-  // lazy initialisation
-  MatchingKeySeed last(F::h(secretKey)); // value for day 2000
-  MatchingKeySeed newSeed(32);
-  for (int i = daysFor - 1;i >= dayIdxFor; --i) {
-    // Calculate 1999 based on 2000, and so on, until we reach the current day's seed
-    newSeed.assign(F::h(F::t(last)));
-    last.assign(newSeed);
+  validateCache(secretKey);
+  if (hasMatchingKey && matchingKeyDay == dayIdxFor) {
+    return MatchingKey(fromSeedBytes(matchingKeyBytes));
   }
-  // At this point newSeed is the same as last, and last holds the seed for day dayIdxFor
+  // Seed for day dayIdxFor, derived by hashing down from day 2000 (via the nearest checkpoint)
+  MatchingKeySeed last(matchingKeySeeds.seed(dayIdxFor));
   
   // matching key on day 0 is derived from matching key seed on day dayIdxFor and day dayIdxFor-1
   MatchingKeySeed minusOne(F::h(F::t(last)));
 
-  return MatchingKey(F::h(F::xorData(last,minusOne)));
+  MatchingKey result(F::h(F::xorData(last,minusOne)));
+  hasMatchingKey = true;
+  matchingKeyDay = dayIdxFor;
+  matchingKeyBytes = toSeedBytes(result);
+  return result;
 }
 
 
 
 ContactKey
 K::contactKey(const SecretKey& secretKey, const int dayFor, const int periodFor) noexcept {
-  const int n = periodsInDay;
-
   auto mk(matchingKey(secretKey,dayFor));
 
-  ContactKeySeed last(F::h(mk));
-  ContactKeySeed lastMinusOne(32);
-  for (int j = n - 1;j >= periodFor;j--) {
-    lastMinusOne.assign(F::h(F::t(last)));
-    last.assign(lastMinusOne);
+  // Period seeds only need rebuilding when the matching key (I.e. day) changes
+  Data topSeed(F::h(mk));
+  if (!contactKeySeeds.matches(topSeed)) {
+    contactKeySeeds.reset(topSeed, periodsInDay);
   }
-  // we now have lastMinusOne = contactKeySeed at periodFor
+  ContactKeySeed last(contactKeySeeds.seed(periodFor));
+  // we now have last = contactKeySeed at periodFor
 
   // Day 0 key now
   ContactKeySeed minusOne(F::h(F::t(last)));
@@ -0,0 +1,160 @@
+/*
+See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  Adam Fowler licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+#include "catch.hpp"
+#include "catch.hpp"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "heraldns/heraldns.h"
+
+TEST_CASE("population-index","[population][basic][datatypes]") {
+
+  SECTION("population-index-basic") {
+    heraldns::datatype::Grid grid(4, 3, 0.5);
+    heraldns::datatype::Population pop(grid, 5);
+    REQUIRE(pop.size() == 5);
+    REQUIRE(pop.width() == 4);
+    REQUIRE(pop.height() == 3);
+    // everyone starts in the first cell
+    REQUIRE(pop.present(0,0).size() == 5);
+    REQUIRE(pop.occupied().size() == 1);
+
+    pop.place(0, 3, 2);
+    pop.place(1, 1, 0);
+    pop.place(2, 3, 2);
+    pop.place(3, 0, 1);
+    pop.place(4, 1, 0);
+    // not visible until reindexed
+    REQUIRE(pop.present(0,0).size() == 5);
+    pop.reindex();
+
+    REQUIRE(pop.present(0,0).size() == 0);
+    std::vector<uint32_t> first(pop.present(1,0).begin(), pop.present(1,0).end());
+    REQUIRE(first == std::vector<uint32_t>{1, 4});
+    std::vector<uint32_t> middle(pop.present(0,1).begin(), pop.present(0,1).end());
+    REQUIRE(middle == std::vector<uint32_t>{3});
+    std::vector<uint32_t> last(pop.present(3,2).begin(), pop.present(3,2).end());
+    REQUIRE(last == std::vector<uint32_t>{0, 2});
+
+    REQUIRE(pop.occupied() == std::vector<uint32_t>{1, 4, 11});
+    REQUIRE(pop.occupiedBefore(0) == 0);
+    REQUIRE(pop.occupiedBefore(1) == 0);
+    REQUIRE(pop.occupiedBefore(2) == 1);
+    REQUIRE(pop.occupiedBefore(5) == 2);
+    REQUIRE(pop.occupiedBefore(11) == 2);
+    REQUIRE(pop.occupiedBefore(12) == 3);
+  }
+
+  SECTION("population-index-store") {
+    heraldns::datatype::Grid grid(4, 3, 0.5);
+    heraldns::datatype::PresenceManager pm(3);
+    heraldns::datatype::Population pop(grid, 3);
+    pop.place(0, 2, 1);
+    pop.place(1, 2, 1);
+    pop.place(2, 0, 2);
+    pop.states()[1] = heraldns::datatype::State::Ill;
+    pop.hasEverBeenIll()[1] = 1;
+    pop.lastFellIll()[1] = 7;
+    pop.risks()[2] = 0.25;
+    pop.highestRiskScores()[2] = 0.5;
+    pop.store(pm, grid);
+
+    REQUIRE(pm.get(0)->position()->x() == 2);
+    REQUIRE(pm.get(0)->position()->y() == 1);
+    REQUIRE(grid.cell(2,1)->present().size() == 2);
+    REQUIRE(grid.cell(0,2)->present().size() == 1);
+    REQUIRE(pm.get(1)->state() == heraldns::datatype::State::Ill);
+    REQUIRE(pm.get(1)->hasEverBeenIll());
+    REQUIRE(pm.get(1)->lastFellIll() == 7);
+    REQUIRE(pm.get(2)->risk() == 0.25);
+    REQUIRE(pm.get(2)->highestRiskScore() == 0.5);
+
+    // moves are reflected in the grid's cells
+    pop.place(0, 3, 2);
+    pop.store(pm, grid);
+    REQUIRE(grid.cell(2,1)->present().size() == 1);
+    REQUIRE(grid.cell(3,2)->present().size() == 1);
+  }
+}
+
+TEST_CASE("population-simulation","[population][simulator]") {
+
+  SECTION("population-simulation-infection") {
+    // A single cell, so no one can move away
+    std::shared_ptr<heraldns::datatype::Grid> grid = std::make_shared<heraldns::datatype::Grid>(1, 1, 0.5);
+    heraldns::datatype::PresenceManager pm(2);
+    heraldns::simulator::PopulationSimulation sim(grid, pm, {100, 1000, 1000, 1}, 42);
+    sim.runToCompletion(1, 60 * 5);
+
+    // 5 minutes at weight 1.0 is 20 per tick, over 60 on the fourth tick
+    REQUIRE(pm.get(0)->state() == heraldns::datatype::State::Ill);
+    REQUIRE(pm.get(1)->state() == heraldns::datatype::State::Ill);
+    REQUIRE(pm.get(1)->hasEverBeenIll());
+    REQUIRE(pm.get(1)->lastFellIll() == 3);
+    REQUIRE(pm.get(1)->transmissionModelScore() == 80);
+    REQUIRE(sim.casesPerDay() == std::vector<uint64_t>{1, 2});
+    REQUIRE(sim.recoveredPerDay() == std::vector<uint64_t>{0, 0});
+  }
+
+  SECTION("population-simulation-recovery") {
+    std::shared_ptr<heraldns::datatype::Grid> grid = std::make_shared<heraldns::datatype::Grid>(1, 1, 0.5);
+    heraldns::datatype::PresenceManager pm(1);
+    heraldns::simulator::PopulationSimulation sim(grid, pm, {100, 10, 1000, 1}, 42);
+    sim.runToCompletion(1, 60 * 5);
+
+    REQUIRE(pm.get(0)->state() == heraldns::datatype::State::Recovered);
+    REQUIRE(pm.get(0)->lastRecovered() == 10);
+    REQUIRE(sim.casesPerDay() == std::vector<uint64_t>{1, 0});
+    REQUIRE(sim.recoveredPerDay() == std::vector<uint64_t>{0, 1});
+  }
+
+  SECTION("population-simulation-neighbourhood") {
+    // One tick a day, so each score is a single tick's exposure to the initial cases
+    const uint64_t people = 400;
+    const uint64_t ill = 40;
+    std::shared_ptr<heraldns::datatype::Grid> grid = std::make_shared<heraldns::datatype::Grid>(150, 100, 0.5);
+    heraldns::datatype::PresenceManager pm(people);
+    heraldns::simulator::PopulationSimulation sim(grid, pm, {100, 1000, 1000, ill}, 7);
+    sim.runToCompletion(1, 60 * 60 * 24);
+
+    const heraldns::datatype::Population& pop = sim.population();
+    const int64_t radius = 16; // 8 metres
+    uint64_t exposed = 0;
+    for (uint64_t id = ill;id < people;id++) {
+      double expected = 0.0;
+      for (uint64_t other = 0;other < ill;other++) {
+        int64_t dx = (int64_t)pop.x(other) - (int64_t)pop.x(id);
+        int64_t dy = (int64_t)pop.y(other) - (int64_t)pop.y(id);
+        if (std::abs(dx) > radius || std::abs(dy) > radius) {
+          continue;
+        }
+        double distance = 0.5 * std::sqrt((double)((dx * dx) + (dy * dy)));
+        expected += 24 * 60 * 4.0 * (distance <= 1.0 ? 1.0 : 1.0 / (distance * distance));
+      }
+      REQUIRE(pop.transmissionModelScores()[id] == Approx(expected));
+      if (expected > 0) {
+        exposed++;
+      }
+    }
+    REQUIRE(exposed > 0);
+    REQUIRE(exposed < people - ill);
+  }
+}
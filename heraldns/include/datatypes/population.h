@@ -0,0 +1,121 @@
+//  Copyright 2020-2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include "grid.h"
+#include "presence.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace heraldns {
+namespace datatype {
+
+/**
+ * Contiguous range of Presence ids, as returned by Population::present()
+ */
+class CellMembers {
+public:
+  CellMembers(const uint32_t* first, const uint32_t* last);
+  ~CellMembers() = default;
+
+  const uint32_t* begin() const;
+  const uint32_t* end() const;
+  std::size_t size() const;
+
+private:
+  const uint32_t* m_first;
+  const uint32_t* m_last;
+};
+
+/**
+ * The state of every Presence on a Grid, held as one array per attribute
+ * (structure of arrays) indexed by Presence id, for populations too large to
+ * step through individual Presence instances.
+ *
+ * Grid occupancy is not maintained on every move. Instead reindex() counting
+ * sorts all ids by cell, after which present() returns a contiguous range and
+ * each grid row's occupied cells are contiguous in occupied().
+ *
+ * Use store() to copy the state back to Presence and Cell instances.
+ */
+class Population {
+public:
+  Population(const Grid& grid, uint64_t count);
+  ~Population() = default;
+
+  uint64_t size() const;
+
+  uint32_t width() const;
+  uint32_t height() const;
+
+  // POSITIONS
+  void place(uint64_t id, uint32_t x, uint32_t y); // takes effect in present() after reindex()
+  uint32_t x(uint64_t id) const;
+  uint32_t y(uint64_t id) const;
+
+  std::vector<uint32_t>& xs();
+  std::vector<uint32_t>& ys();
+  std::vector<uint32_t>& cells(); // x + (y * width), kept in step with xs() and ys() by the caller
+
+  // CELL INDEX (as of the last reindex())
+  void reindex();
+  CellMembers present(uint32_t x, uint32_t y) const;
+  CellMembers present(uint64_t cell) const;
+  const std::vector<uint32_t>& occupied() const; // ascending cell numbers with at least one Presence
+  uint32_t occupiedBefore(uint64_t cell) const; // number of occupied cells numbered lower than cell
+
+  // STATE TRACKING (as for the same named Presence methods)
+  std::vector<State>& states();
+  std::vector<double>& risks();
+  std::vector<double>& highestRiskScores();
+  std::vector<double>& transmittedRisks();
+  std::vector<double>& transmissionModelScores();
+  std::vector<uint64_t>& lastFellIll();
+  std::vector<uint64_t>& lastRecovered();
+  std::vector<uint8_t>& hasEverBeenIll();
+
+  const std::vector<State>& states() const;
+  const std::vector<double>& risks() const;
+  const std::vector<double>& highestRiskScores() const;
+  const std::vector<double>& transmittedRisks() const;
+  const std::vector<double>& transmissionModelScores() const;
+  const std::vector<uint64_t>& lastFellIll() const;
+  const std::vector<uint64_t>& lastRecovered() const;
+  const std::vector<uint8_t>& hasEverBeenIll() const;
+
+  // FRONT END
+  void store(const PresenceManager& pm, const Grid& grid) const; // committed state, and moves each Presence to its Cell
+
+private:
+  uint32_t m_width;
+  uint32_t m_height;
+
+  std::vector<uint32_t> m_x;
+  std::vector<uint32_t> m_y;
+  std::vector<uint32_t> m_cell;
+
+  std::vector<State> m_state;
+  std::vector<double> m_risk;
+  std::vector<double> m_highestRisk;
+  std::vector<double> m_transmittedRisk;
+  std::vector<double> m_transmissionModelScore;
+  std::vector<uint64_t> m_lastFellIll;
+  std::vector<uint64_t> m_lastRecovered;
+  std::vector<uint8_t> m_hasEverBeenIll;
+
+  // cell index
+  std::vector<uint32_t> m_cellStart; // cell count + 2. First member of each cell in m_members
+  std::vector<uint32_t> m_members; // ids, by cell then id
+  std::vector<uint32_t> m_occupied;
+  std::vector<uint32_t> m_occupiedBefore; // cell count + 1
+};
+
+} // end namespace
+} // end namespace
+
+#endif
@@ -20,6 +20,8 @@ enum class State : int {
   Well, Ill, Recovered, Dead
 };
 
+class Population; // fwd decl
+
 /**
  * Base class for people, static items, etc.
  */
@@ -74,6 +76,8 @@ public:
   void commitChanges(); // Move 'newRisk' to 'Risk' (at end of this sim 'turn')
 
 private:
+  friend class Population; // restores committed state in Population::store()
+
   const uint64_t m_id;
   
   double m_currentRisk;
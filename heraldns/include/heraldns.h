@@ -9,11 +9,13 @@
 
 // datatypes namespace
 #include "datatypes/grid.h"
+#include "datatypes/population.h"
 #include "datatypes/presence.h"
 #include "intermediate/stdout_intermediate_results.h"
 #include "mixing/direct_mixing.h"
 #include "providers/intermediate_results.h"
 #include "providers/social_mixing.h"
 #include "providers/transmission.h"
+#include "simulator/population_simulation.h"
 #include "simulator/simulator.h"
 #include "transmission/basic_transmission.h"
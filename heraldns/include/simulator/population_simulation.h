@@ -0,0 +1,108 @@
+//  Copyright 2020-2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef POPULATION_SIMULATION_H
+#define POPULATION_SIMULATION_H
+
+#include "../datatypes/presence.h"
+#include "../datatypes/grid.h"
+#include "../datatypes/population.h"
+#include "../providers/intermediate_results.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+
+namespace heraldns {
+namespace simulator {
+
+using namespace heraldns::datatype;
+using namespace heraldns::providers;
+
+/**
+ * Settings for the models PopulationSimulation applies. These match the
+ * parameters of DirectMixingScoreProvider and BasicTransmissionModelProvider.
+ */
+struct PopulationModel {
+  double initialRiskScore;
+  uint64_t ticksToRecover;
+  uint64_t ticksForImmunity;
+  uint64_t initialInfections;
+  double rangeMetres = 8.0; // how far away others contribute risk
+};
+
+/**
+ * Data oriented alternative to Simulation, for populations of a million or more.
+ *
+ * Rather than calling the providers for each Presence, this applies the direct
+ * social mixing and basic transmission models to a Population in one pass per
+ * tick. Cells are visited once per tick, not once per Presence: the risk each
+ * occupied cell receives from its neighbourhood is gathered first, and each
+ * Presence then takes its cell's total less its own contribution.
+ *
+ * The Grid and PresenceManager remain the front end. Their Presence and Cell
+ * instances are brought up to date before each intermediate results callback
+ * and at the end of a run, not on every tick.
+ */
+class PopulationSimulation {
+public:
+  PopulationSimulation(std::shared_ptr<Grid> grid, const PresenceManager& pm,
+                       PopulationModel model, uint64_t seed);
+  ~PopulationSimulation() = default;
+
+  void runToCompletion(uint64_t days, uint64_t secondsPerTick);
+  void runToCompletion(uint64_t days, uint64_t secondsPerTick,
+    std::shared_ptr<IntermediateResultsListener> callback, uint64_t ticksPerCallback);
+
+  bool writeStandardResults(std::string outputFolder) noexcept; // returns success = true
+
+  const Population& population() const;
+  const std::vector<uint64_t>& casesPerDay() const;
+  const std::vector<uint64_t>& recoveredPerDay() const;
+
+private:
+  // methods
+  void reset(uint64_t days, uint64_t secondsPerTick); // resets the sim before beginning
+  void tick(); // perform a single tick in the simulation
+  void move();
+  void gather();
+  uint64_t random();
+
+  // initial settings
+  std::shared_ptr<Grid> m_grid;
+  const PresenceManager& m_pm;
+  PopulationModel m_model;
+
+  // settings
+  uint64_t maxTicks;
+  double minutesPerTick;
+  int64_t radius; // in cells
+  std::vector<double> inverseSquare; // weight by cell offset, row then column, within radius
+
+  // Runtime variables
+  uint64_t currentTick;
+  uint64_t today; // day number. 0 = start
+  uint64_t rngState;
+
+  Population m_population;
+
+  // per occupied cell, in Population::occupied() order
+  std::vector<double> cellTransmitted; // sum of transmitted risk of those in the cell
+  std::vector<uint32_t> cellPresent;
+  std::vector<uint32_t> cellIll;
+  std::vector<double> nearRisk; // sums over the neighbourhood of each cell, weighted by inverseSquare
+  std::vector<double> nearTransmitted; // unweighted
+  std::vector<uint64_t> nearCount;
+  std::vector<double> nearIll; // weighted
+
+  // results variables/aggregations
+  std::vector<uint64_t> m_casesPerDay; // day 0 = initial values, day 1 = end of first day of simulation
+  std::vector<uint64_t> m_recoveredPerDay;
+};
+
+} // end namespace
+} // end namespace
+
+#endif
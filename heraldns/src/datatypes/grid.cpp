@@ -4,6 +4,7 @@
 
 #include "../../heraldns.h"
 
+#include <algorithm>
 #include <iostream>
 #include <random>
 
@@ -0,0 +1,283 @@
+//  Copyright 2020-2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include "../../heraldns.h"
+
+#include <algorithm>
+
+using namespace heraldns;
+
+namespace heraldns {
+namespace datatype {
+
+
+CellMembers::CellMembers(const uint32_t* first, const uint32_t* last)
+  : m_first(first), m_last(last)
+{
+  ;
+}
+
+const uint32_t*
+CellMembers::begin() const
+{
+  return m_first;
+}
+
+const uint32_t*
+CellMembers::end() const
+{
+  return m_last;
+}
+
+std::size_t
+CellMembers::size() const
+{
+  return m_last - m_first;
+}
+
+
+
+
+Population::Population(const Grid& grid, uint64_t count)
+  : m_width((uint32_t)grid.width()), m_height((uint32_t)grid.height()),
+    m_x(count, 0), m_y(count, 0), m_cell(count, 0),
+    m_state(count, State::Well), m_risk(count, 0.0), m_highestRisk(count, 0.0),
+    m_transmittedRisk(count, 0.0), m_transmissionModelScore(count, 0.0),
+    m_lastFellIll(count, 0), m_lastRecovered(count, 0), m_hasEverBeenIll(count, 0),
+    m_cellStart(grid.width() * grid.height() + 2, 0), m_members(count, 0),
+    m_occupied(), m_occupiedBefore(grid.width() * grid.height() + 1, 0)
+{
+  m_occupied.reserve(std::min<uint64_t>(count, grid.width() * grid.height()));
+  reindex();
+}
+
+uint64_t
+Population::size() const
+{
+  return m_x.size();
+}
+
+uint32_t
+Population::width() const
+{
+  return m_width;
+}
+
+uint32_t
+Population::height() const
+{
+  return m_height;
+}
+
+void
+Population::place(uint64_t id, uint32_t x, uint32_t y)
+{
+  m_x[id] = x;
+  m_y[id] = y;
+  m_cell[id] = x + (y * m_width);
+}
+
+uint32_t
+Population::x(uint64_t id) const
+{
+  return m_x[id];
+}
+
+uint32_t
+Population::y(uint64_t id) const
+{
+  return m_y[id];
+}
+
+std::vector<uint32_t>&
+Population::xs()
+{
+  return m_x;
+}
+
+std::vector<uint32_t>&
+Population::ys()
+{
+  return m_y;
+}
+
+std::vector<uint32_t>&
+Population::cells()
+{
+  return m_cell;
+}
+
+void
+Population::reindex()
+{
+  // Count into the slot two after each cell, so that after the prefix sum the
+  // slot one after each cell is its first member, and can be used as the
+  // insertion point. Once all ids are inserted that slot has become the first
+  // member of the next cell, which is where cell + 1 expects it.
+  const uint64_t cellCount = m_occupiedBefore.size() - 1;
+  std::fill(m_cellStart.begin(), m_cellStart.end(), 0);
+  for (auto cell : m_cell) {
+    m_cellStart[cell + 2]++;
+  }
+  m_occupied.clear();
+  for (uint64_t cell = 0;cell < cellCount;cell++) {
+    m_occupiedBefore[cell] = (uint32_t)m_occupied.size();
+    if (0 != m_cellStart[cell + 2]) {
+      m_occupied.push_back((uint32_t)cell);
+    }
+    m_cellStart[cell + 2] += m_cellStart[cell + 1];
+  }
+  m_occupiedBefore[cellCount] = (uint32_t)m_occupied.size();
+  for (uint32_t id = 0;id < m_cell.size();id++) {
+    m_members[m_cellStart[m_cell[id] + 1]++] = id;
+  }
+}
+
+CellMembers
+Population::present(uint32_t x, uint32_t y) const
+{
+  return present(x + ((uint64_t)y * m_width));
+}
+
+CellMembers
+Population::present(uint64_t cell) const
+{
+  return CellMembers(m_members.data() + m_cellStart[cell], m_members.data() + m_cellStart[cell + 1]);
+}
+
+const std::vector<uint32_t>&
+Population::occupied() const
+{
+  return m_occupied;
+}
+
+uint32_t
+Population::occupiedBefore(uint64_t cell) const
+{
+  return m_occupiedBefore[cell];
+}
+
+std::vector<State>&
+Population::states()
+{
+  return m_state;
+}
+
+std::vector<double>&
+Population::risks()
+{
+  return m_risk;
+}
+
+std::vector<double>&
+Population::highestRiskScores()
+{
+  return m_highestRisk;
+}
+
+std::vector<double>&
+Population::transmittedRisks()
+{
+  return m_transmittedRisk;
+}
+
+std::vector<double>&
+Population::transmissionModelScores()
+{
+  return m_transmissionModelScore;
+}
+
+std::vector<uint64_t>&
+Population::lastFellIll()
+{
+  return m_lastFellIll;
+}
+
+std::vector<uint64_t>&
+Population::lastRecovered()
+{
+  return m_lastRecovered;
+}
+
+std::vector<uint8_t>&
+Population::hasEverBeenIll()
+{
+  return m_hasEverBeenIll;
+}
+
+const std::vector<State>&
+Population::states() const
+{
+  return m_state;
+}
+
+const std::vector<double>&
+Population::risks() const
+{
+  return m_risk;
+}
+
+const std::vector<double>&
+Population::highestRiskScores() const
+{
+  return m_highestRisk;
+}
+
+const std::vector<double>&
+Population::transmittedRisks() const
+{
+  return m_transmittedRisk;
+}
+
+const std::vector<double>&
+Population::transmissionModelScores() const
+{
+  return m_transmissionModelScore;
+}
+
+const std::vector<uint64_t>&
+Population::lastFellIll() const
+{
+  return m_lastFellIll;
+}
+
+const std::vector<uint64_t>&
+Population::lastRecovered() const
+{
+  return m_lastRecovered;
+}
+
+const std::vector<uint8_t>&
+Population::hasEverBeenIll() const
+{
+  return m_hasEverBeenIll;
+}
+
+void
+Population::store(const PresenceManager& pm, const Grid& grid) const
+{
+  uint64_t count = std::min(pm.size(), size());
+  for (uint64_t id = 0;id < count;id++) {
+    std::shared_ptr<Presence> p = pm.get(id);
+    if (!p->m_position || (*p->m_position)->x() != m_x[id] || (*p->m_position)->y() != m_y[id]) {
+      p->moveTo(grid.cell(m_x[id], m_y[id]));
+    }
+    p->m_currentRisk = m_risk[id];
+    p->m_newRisk = 0.0;
+    p->m_currentTransmittedRisk = m_transmittedRisk[id];
+    p->m_newTransmittedRisk = m_transmittedRisk[id];
+    p->m_state = m_state[id];
+    p->m_newState = m_state[id];
+    p->m_transmissionModelScore = m_transmissionModelScore[id];
+    p->m_newTransmissionModelScore = m_transmissionModelScore[id];
+    p->m_lastFellIll = m_lastFellIll[id];
+    p->m_lastRecovered = m_lastRecovered[id];
+    p->m_hasEverBeenIll = 0 != m_hasEverBeenIll[id];
+    p->m_highestRiskScore = m_highestRisk[id];
+  }
+}
+
+
+}
+}
@@ -0,0 +1,331 @@
+//  Copyright 2020-2021 Herald Project Contributors
+//  SPDX-License-Identifier: Apache-2.0
+//
+
+#include <iostream>
+#include "../../heraldns.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace heraldns;
+using namespace heraldns::simulator;
+using namespace heraldns::datatype;
+
+namespace heraldns {
+namespace simulator {
+
+PopulationSimulation::PopulationSimulation(std::shared_ptr<Grid> grid, const PresenceManager& pm,
+                       PopulationModel model, uint64_t seed)
+ : m_grid(grid), m_pm(pm), m_model(model),
+   maxTicks(0), minutesPerTick(1.0), radius(0), inverseSquare(),
+   currentTick(0), today(0), rngState(seed),
+   m_population(*grid, pm.size()),
+   cellTransmitted(), cellPresent(), cellIll(), nearRisk(), nearTransmitted(), nearCount(), nearIll(),
+   m_casesPerDay(), m_recoveredPerDay()
+{
+  // Risk from another cell falls off with the inverse square of its distance,
+  // with everything under 1 m counting the same
+  radius = (int64_t)std::ceil(m_model.rangeMetres / m_grid->separation());
+  const int64_t span = (2 * radius) + 1;
+  inverseSquare.reserve(span * span);
+  for (int64_t dy = -radius;dy <= radius;dy++) {
+    for (int64_t dx = -radius;dx <= radius;dx++) {
+      double distance = m_grid->separation() * std::sqrt((double)((dx * dx) + (dy * dy)));
+      inverseSquare.push_back(distance <= 1.0 ? 1.0 : 1.0 / (distance * distance));
+    }
+  }
+}
+
+void
+PopulationSimulation::runToCompletion(uint64_t days, uint64_t secondsPerTick)
+{
+  reset(days, secondsPerTick);
+  for (uint64_t ticks = 0;ticks < maxTicks;ticks++) {
+    tick();
+  }
+  m_population.store(m_pm, *m_grid);
+}
+
+void
+PopulationSimulation::runToCompletion(uint64_t days, uint64_t secondsPerTick,
+  std::shared_ptr<IntermediateResultsListener> callback, uint64_t ticksPerCallback)
+{
+  reset(days, secondsPerTick);
+  uint64_t lastCbTicks = 0;
+  // NOTE: index 0 is the initial state, NOT the state after the first tick
+  for (uint64_t ticks = 0;ticks < maxTicks;ticks++) {
+    if (0 == (ticks % ticksPerCallback)) {
+      m_population.store(m_pm, *m_grid);
+      callback->intermediateResults(m_casesPerDay[today], m_recoveredPerDay[today], m_pm,
+        currentTick == 0 ? 0 : ticksPerCallback * minutesPerTick,
+        currentTick);
+      lastCbTicks = ticks;
+    }
+    tick();
+  }
+  // don't forget final callback
+  m_population.store(m_pm, *m_grid);
+  callback->intermediateResults(m_casesPerDay[today], m_recoveredPerDay[today], m_pm,
+    (maxTicks - lastCbTicks) * minutesPerTick,
+    maxTicks);
+}
+
+bool
+PopulationSimulation::writeStandardResults(std::string outputFolder) noexcept
+{
+  // TODO settings
+
+  // final state
+  const uint64_t count = m_population.size();
+  uint64_t totalInfectedEver = 0;
+  double totalHighestRiskScoreIll = 0.0;
+  double totalHighestRiskScoreNotIll = 0.0;
+  for (uint64_t id = 0;id < count;id++) {
+    if (m_population.hasEverBeenIll()[id]) {
+      totalInfectedEver++;
+      totalHighestRiskScoreIll += m_population.highestRiskScores()[id];
+    } else {
+      totalHighestRiskScoreNotIll += m_population.highestRiskScores()[id];
+    }
+  }
+  std::cout << "Total people infected: " << totalInfectedEver
+            << " (" << (100.0 * totalInfectedEver / count) << "%)"
+            << std::endl;
+  if (0 == totalInfectedEver) {
+    std::cout << "  Avg risk score for those who did fall ill    : N/A (No one fell ill)"
+              << std::endl;
+  } else {
+    std::cout << "  Avg risk score for those who did fall ill    : " << totalHighestRiskScoreIll / totalInfectedEver
+              << std::endl;
+  }
+  if (count == totalInfectedEver) {
+    std::cout << "  Avg risk score for those who did not fall ill: N/A (All were ill)"
+              << std::endl;
+  } else {
+    std::cout << "  Avg risk score for those who did not fall ill: " << totalHighestRiskScoreNotIll / (count - totalInfectedEver)
+              << std::endl;
+  }
+  return true;
+}
+
+const Population&
+PopulationSimulation::population() const
+{
+  return m_population;
+}
+
+const std::vector<uint64_t>&
+PopulationSimulation::casesPerDay() const
+{
+  return m_casesPerDay;
+}
+
+const std::vector<uint64_t>&
+PopulationSimulation::recoveredPerDay() const
+{
+  return m_recoveredPerDay;
+}
+
+// PRIVATE METHODS
+
+void
+PopulationSimulation::reset(uint64_t days, uint64_t secondsPerTick)
+{
+  currentTick = 0;
+  today = 0;
+  maxTicks = (uint64_t)std::ceil(days * ((60.0 / secondsPerTick) * 60 * 24));
+  minutesPerTick = secondsPerTick / 60.0;
+
+  // place everyone at random, then infect the first initialInfections
+  const uint64_t count = m_population.size();
+  const uint64_t cellCount = (uint64_t)m_population.width() * m_population.height();
+  uint64_t infected = 0;
+  for (uint64_t id = 0;id < count;id++) {
+    uint64_t cell = ((random() & 0xffffffff) * cellCount) >> 32;
+    m_population.place(id, (uint32_t)(cell % m_population.width()), (uint32_t)(cell / m_population.width()));
+    bool ill = id < m_model.initialInfections;
+    m_population.states()[id] = ill ? State::Ill : State::Well;
+    m_population.risks()[id] = m_model.initialRiskScore;
+    m_population.highestRiskScores()[id] = m_model.initialRiskScore;
+    m_population.transmittedRisks()[id] = 0.0;
+    m_population.transmissionModelScores()[id] = 0.0;
+    m_population.lastFellIll()[id] = 0;
+    m_population.lastRecovered()[id] = 0;
+    m_population.hasEverBeenIll()[id] = ill ? 1 : 0;
+    if (ill) {
+      infected++;
+    }
+  }
+  m_population.reindex();
+
+  m_casesPerDay.clear();
+  m_recoveredPerDay.clear();
+  m_casesPerDay.push_back(infected);
+  m_recoveredPerDay.push_back(0);
+}
+
+void
+PopulationSimulation::tick()
+{
+  move();
+  m_population.reindex();
+  gather();
+
+  // All reads below are of the previous tick's state (via the cell totals),
+  // so each Presence can be updated and committed in place
+  const uint64_t count = m_population.size();
+  const std::vector<uint32_t>& cells = m_population.cells();
+  State* states = m_population.states().data();
+  double* risks = m_population.risks().data();
+  double* highest = m_population.highestRiskScores().data();
+  double* transmitted = m_population.transmittedRisks().data();
+  double* scores = m_population.transmissionModelScores().data();
+  uint64_t* lastFellIll = m_population.lastFellIll().data();
+  uint64_t* lastRecovered = m_population.lastRecovered().data();
+  uint8_t* hasEverBeenIll = m_population.hasEverBeenIll().data();
+  const double exposurePerWeight = minutesPerTick *
+    4.0; // See risk-model-approximations for 4.0 coefficient explanation
+  uint64_t liveCases = 0;
+  uint64_t liveRecovered = 0;
+  for (uint64_t id = 0;id < count;id++) {
+    const uint32_t slot = m_population.occupiedBefore(cells[id]);
+    const double ownTransmitted = transmitted[id];
+    State state = states[id];
+
+    // social mixing: everyone else nearby, with those in our own cell at weight 1.0
+    double risk = nearRisk[slot] - ownTransmitted;
+    risks[id] = risk;
+    if (risk > highest[id]) {
+      highest[id] = risk;
+    }
+    const uint64_t others = nearCount[slot] - 1;
+    transmitted[id] = 0 == others ? 0.0 : (nearTransmitted[slot] - ownTransmitted) / others;
+
+    // transmission
+    if (state == State::Ill && lastFellIll[id] + m_model.ticksToRecover <= currentTick) {
+      state = State::Recovered;
+      lastRecovered[id] = currentTick;
+      transmitted[id] = 0.0;
+      scores[id] = 0.0; // reset and try to become ill again!
+    } else if (state == State::Recovered && lastRecovered[id] + m_model.ticksForImmunity <= currentTick) {
+      state = State::Well;
+    }
+    if (state == State::Well) {
+      scores[id] += exposurePerWeight * nearIll[slot];
+      if (scores[id] > 60) { // number for above if 15m @ 2m (4 * inv dist sq)
+        state = State::Ill;
+        lastFellIll[id] = currentTick;
+        hasEverBeenIll[id] = 1;
+      }
+    }
+    states[id] = state;
+    liveCases += state == State::Ill ? 1 : 0;
+    liveRecovered += state == State::Recovered ? 1 : 0;
+  }
+
+  // increment tick
+  currentTick++;
+  uint64_t newToday = (uint64_t)(currentTick * minutesPerTick) / (60 * 24);
+  if (newToday > today) {
+    m_casesPerDay.push_back(liveCases);
+    m_recoveredPerDay.push_back(liveRecovered);
+  }
+  today = newToday;
+}
+
+void
+PopulationSimulation::move()
+{
+  const uint64_t count = m_population.size();
+  const int64_t maxX = (int64_t)m_population.width() - 1;
+  const int64_t maxY = (int64_t)m_population.height() - 1;
+  uint32_t* xs = m_population.xs().data();
+  uint32_t* ys = m_population.ys().data();
+  uint32_t* cells = m_population.cells().data();
+  for (uint64_t id = 0;id < count;id++) {
+    // one draw gives both steps of -1, 0 or 1
+    uint64_t r = random();
+    int64_t newX = (int64_t)xs[id] + (int64_t)(((r & 0xffffffff) * 3) >> 32) - 1;
+    int64_t newY = (int64_t)ys[id] + (int64_t)(((r >> 32) * 3) >> 32) - 1;
+    newX = std::clamp<int64_t>(newX, 0, maxX);
+    newY = std::clamp<int64_t>(newY, 0, maxY);
+    xs[id] = (uint32_t)newX;
+    ys[id] = (uint32_t)newY;
+    cells[id] = (uint32_t)(newX + (newY * (maxX + 1)));
+  }
+}
+
+void
+PopulationSimulation::gather()
+{
+  const std::vector<uint32_t>& occupied = m_population.occupied();
+  const std::vector<State>& states = m_population.states();
+  const std::vector<double>& transmitted = m_population.transmittedRisks();
+  const std::size_t slots = occupied.size();
+  cellTransmitted.assign(slots, 0.0);
+  cellPresent.assign(slots, 0);
+  cellIll.assign(slots, 0);
+  nearRisk.assign(slots, 0.0);
+  nearTransmitted.assign(slots, 0.0);
+  nearCount.assign(slots, 0);
+  nearIll.assign(slots, 0.0);
+
+  // totals for each occupied cell
+  for (std::size_t slot = 0;slot < slots;slot++) {
+    for (auto id : m_population.present((uint64_t)occupied[slot])) {
+      cellTransmitted[slot] += transmitted[id];
+      cellIll[slot] += states[id] == State::Ill ? 1 : 0;
+      cellPresent[slot]++;
+    }
+  }
+
+  // Sum each occupied cell's neighbourhood. The occupied cells of each row in
+  // range are contiguous, so only occupied cells are visited.
+  const int64_t width = m_population.width();
+  const int64_t height = m_population.height();
+  const int64_t span = (2 * radius) + 1;
+  for (std::size_t slot = 0;slot < slots;slot++) {
+    const int64_t x = occupied[slot] % width;
+    const int64_t y = occupied[slot] / width;
+    const int64_t minX = std::max<int64_t>(x - radius, 0);
+    const int64_t maxX = std::min<int64_t>(x + radius, width - 1);
+    const int64_t minY = std::max<int64_t>(y - radius, 0);
+    const int64_t maxY = std::min<int64_t>(y + radius, height - 1);
+    double risk = 0.0;
+    double trans = 0.0;
+    uint64_t count = 0;
+    double ill = 0.0;
+    for (int64_t cy = minY;cy <= maxY;cy++) {
+      const int64_t rowStart = cy * width;
+      const double* weights = inverseSquare.data() + ((cy - y + radius) * span);
+      const int64_t offset = radius - x - rowStart;
+      const uint32_t last = m_population.occupiedBefore(rowStart + maxX + 1);
+      for (uint32_t other = m_population.occupiedBefore(rowStart + minX);other < last;other++) {
+        const double weight = weights[occupied[other] + offset];
+        risk += weight * cellTransmitted[other];
+        trans += cellTransmitted[other];
+        count += cellPresent[other];
+        ill += weight * cellIll[other];
+      }
+    }
+    nearRisk[slot] = risk;
+    nearTransmitted[slot] = trans;
+    nearCount[slot] = count;
+    nearIll[slot] = ill;
+  }
+}
+
+uint64_t
+PopulationSimulation::random()
+{
+  // splitmix64
+  uint64_t z = (rngState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+
+}
+}
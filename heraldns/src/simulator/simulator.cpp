@@ -140,9 +140,6 @@ Simulation::reset(uint64_t days, uint64_t secondsPerTick)
 void
 Simulation::tick()
 {
-  if (0 == currentTick % 100) {
-    std::cout << "Current Tick: " << currentTick << std::endl;
-  }
   // calculate any movements in position
   for (uint64_t id = 0;id < m_pm.size();id++) {
     auto actor = m_pm.get(id);